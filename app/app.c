@@ -0,0 +1,410 @@
+#include "app.h"
+
+#include "ov2640.h"
+#include "ov2640_regs.h"
+#include "stream_baud.h"
+#include "stream_compress.h"
+#include "stream_frame.h"
+
+#include <string.h>
+
+// Largest chunk of capture data read over SPI at once
+#define UART_OUT_CHUNK_LENGTH 1000
+
+// Number of buffers cycling between SPI reads and UART DMA sends; more buffers absorb jitter on either side
+#define UART_OUT_BUFFER_COUNT 3
+
+// How long to wait for a baud rate proposal from the host at boot (ms)
+#define BAUD_BOOT_WINDOW 2000
+// How long the host gets to send each echo test/confirmation after a switch before falling back (ms)
+#define BAUD_TRIAL_TIMEOUT 1000
+// UART receive errors tolerated before assuming the host lost the rate and falling back to the base rate
+#define BAUD_ERROR_LIMIT 8
+
+// Wait for an interrupt to change something. The target just spins; on the mock HAL, interrupts are events that only
+// happen once simulated time moves on to them (or a tick passes, for code watching HAL_GetTick).
+#ifdef USE_MOCK_HAL
+#define APP_IDLE() do { if(Mock_HAL_Run_Next_Event() == 0) { HAL_Delay(1); } } while(0)
+#else
+#define APP_IDLE() do { } while(0)
+#endif
+
+// Buffer that capture data is read into over SPI (or coded into, when compressing) and then sent out of over UART
+typedef struct uart_out_buffer {
+  uint8_t data[STREAM_COMPRESS_BOUND(UART_OUT_CHUNK_LENGTH)];
+  uint16_t length;
+} uart_out_buffer;
+
+// Peripherals from app_setup
+static app_config app;
+
+// UART output stage. Buffers are filled (by SPI) and sent (by UART DMA) in the same round-robin order:
+// uart_out_fill is the next buffer to fill, uart_out_send is the buffer being/to be sent,
+// and uart_out_queued counts buffers that are filled but not completely sent yet.
+static uart_out_buffer uart_out_buffers[UART_OUT_BUFFER_COUNT];
+static uint8_t uart_out_fill = 0;
+static volatile uint8_t uart_out_send = 0;
+static volatile uint8_t uart_out_queued = 0;
+
+// Capture data is read here first when it's compressed on its way to the output buffers.
+static uint8_t compress_in[UART_OUT_CHUNK_LENGTH];
+
+// Baud rate negotiation. Bytes from the host are put in a small ring by the UART RX interrupt.
+static uint8_t baud_rx_byte;
+static uint8_t baud_rx_ring[32];
+static volatile uint8_t baud_rx_head = 0;
+static uint8_t baud_rx_tail = 0;
+static volatile uint8_t baud_rx_errors = 0;
+static stream_baud_parser baud_parser;
+
+static ov2640 camera;
+// Framing state for sending captures through UART; see stream_frame.h for the protocol
+static stream_frame frame;
+static uint32_t frame_sequence = 0;
+
+// Optionally watch low-res previews for motion and only take (high-res) captures when something changes.
+static uint8_t use_motion_trigger = 0;
+static ov2640_motion motion;
+
+// Compress uncompressed (raw/YUV) captures on the fly; JPEG data is already compressed and would only grow.
+static uint8_t use_compression = 0;
+
+// Get the next free output buffer to fill, waiting for UART to finish sending one if all are queued.
+static uart_out_buffer * uart_out_acquire(void)
+{
+  while(uart_out_queued == UART_OUT_BUFFER_COUNT) {
+    APP_IDLE();
+  }
+  return &uart_out_buffers[uart_out_fill];
+}
+
+// Queue the buffer from uart_out_acquire to be sent; starts a UART DMA transfer if UART is idle.
+static void uart_out_submit(uint16_t length)
+{
+  uart_out_buffers[uart_out_fill].length = length;
+  uart_out_fill = (uart_out_fill + 1) % UART_OUT_BUFFER_COUNT;
+
+  // The TX complete callback also touches the queue, so keep it out while the buffer is added.
+  __disable_irq();
+  uart_out_queued++;
+  if(uart_out_queued == 1) {
+    HAL_UART_Transmit_DMA(app.uart, uart_out_buffers[uart_out_send].data, uart_out_buffers[uart_out_send].length);
+  }
+  __enable_irq();
+}
+
+// Queue a copy of a small block of data (e.g. frame header/trailer) to be sent.
+static void uart_out_write(const uint8_t data[], uint16_t length)
+{
+  uart_out_buffer * buffer = uart_out_acquire();
+  memcpy(buffer->data, data, length);
+  uart_out_submit(length);
+}
+
+// Wait until every queued buffer has been sent.
+static void uart_out_flush(void)
+{
+  while(uart_out_queued > 0) {
+    APP_IDLE();
+  }
+}
+
+// A buffer finished sending: release it back to the SPI side and start sending the next queued one.
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if(huart != app.uart) {
+    return;
+  }
+
+  uart_out_send = (uart_out_send + 1) % UART_OUT_BUFFER_COUNT;
+  uart_out_queued--;
+  if(uart_out_queued > 0) {
+    HAL_UART_Transmit_DMA(app.uart, uart_out_buffers[uart_out_send].data, uart_out_buffers[uart_out_send].length);
+  }
+}
+
+// Reconfigure the UART for a new baud rate and start listening for the host again.
+// Output must be flushed first, since this aborts any ongoing transfer.
+static void baud_set_rate(uint32_t rate)
+{
+  uint8_t over8 = 0;
+  stream_baud_supported(HAL_RCC_GetPCLK1Freq(), rate, &over8);
+
+  HAL_UART_Abort(app.uart);
+  app.uart->Init.BaudRate = rate;
+  app.uart->Init.OverSampling = (over8 == 1) ? UART_OVERSAMPLING_8 : UART_OVERSAMPLING_16;
+  if (HAL_UART_Init(app.uart) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  // Anything received so far was at the old rate.
+  stream_baud_parser_reset(&baud_parser);
+  baud_rx_tail = baud_rx_head;
+  baud_rx_errors = 0;
+
+  HAL_UART_Receive_IT(app.uart, &baud_rx_byte, 1);
+}
+
+// Send a negotiation message to the host; blocks, so output must be flushed first.
+static void baud_send(uint8_t cmd, uint32_t value)
+{
+  uint8_t msg[STREAM_BAUD_MSG_SIZE];
+  stream_baud_encode(msg, cmd, value);
+  HAL_UART_Transmit(app.uart, msg, STREAM_BAUD_MSG_SIZE, HAL_MAX_DELAY);
+}
+
+// Get the next negotiation message from the host, waiting up to timeout ms for it.
+// Returns 1 if a message was received.
+static uint8_t baud_receive(uint8_t *cmd, uint32_t *value, uint32_t timeout)
+{
+  uint32_t start = HAL_GetTick();
+
+  do {
+    while(baud_rx_tail != baud_rx_head) {
+      uint8_t byte = baud_rx_ring[baud_rx_tail];
+      baud_rx_tail = (baud_rx_tail + 1) % sizeof(baud_rx_ring);
+
+      if(stream_baud_parse(&baud_parser, byte, cmd, value)) {
+        return 1;
+      }
+    }
+    if(timeout > 0) {
+      APP_IDLE();
+    }
+  } while((HAL_GetTick() - start) < timeout);
+
+  return 0;
+}
+
+// Handle baud rate proposals from the host (see stream_baud.h), waiting up to timeout ms for the first one.
+// Returns once a switch is confirmed, or once the host goes quiet.
+static void baud_negotiate(uint32_t timeout)
+{
+  uint8_t cmd;
+  uint32_t rate;
+
+  // Lots of receive errors means the host is talking at another rate (e.g. it restarted), so go back to the base rate.
+  if((baud_rx_errors >= BAUD_ERROR_LIMIT) && (app.uart->Init.BaudRate != STREAM_BAUD_BASE_RATE)) {
+    uart_out_flush();
+    baud_set_rate(STREAM_BAUD_BASE_RATE);
+  }
+
+  while(baud_receive(&cmd, &rate, timeout)) {
+    // After the first proposal, the host sends the next one soon if this one fails.
+    timeout = BAUD_TRIAL_TIMEOUT;
+
+    if(cmd != STREAM_BAUD_CMD_SWITCH) {
+      continue;
+    }
+
+    // Nothing else can be sent while negotiating.
+    uart_out_flush();
+
+    uint8_t over8;
+    if(!stream_baud_supported(HAL_RCC_GetPCLK1Freq(), rate, &over8)) {
+      baud_send(STREAM_BAUD_CMD_NAK, rate);
+      continue;
+    }
+
+    uint32_t previous_rate = app.uart->Init.BaudRate;
+    baud_send(STREAM_BAUD_CMD_ACK, rate);
+    baud_set_rate(rate);
+
+    // Echo the host's test patterns back at the new rate until it confirms.
+    uint8_t confirmed = 0;
+    uint32_t value;
+    while((confirmed == 0) && baud_receive(&cmd, &value, BAUD_TRIAL_TIMEOUT)) {
+      if(cmd == STREAM_BAUD_CMD_ECHO) {
+        baud_send(STREAM_BAUD_CMD_ECHO, value);
+      }
+      else if(cmd == STREAM_BAUD_CMD_CONFIRM) {
+        baud_send(STREAM_BAUD_CMD_DONE, value);
+        confirmed = 1;
+      }
+    }
+
+    if(confirmed == 1) {
+      return;
+    }
+
+    // The host went quiet at the new rate, so it must have given up on it too.
+    baud_set_rate(previous_rate);
+  }
+}
+
+// A byte arrived from the host: store it and listen for the next one.
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if(huart != app.uart) {
+    return;
+  }
+
+  uint8_t next = (baud_rx_head + 1) % sizeof(baud_rx_ring);
+  if(next != baud_rx_tail) {
+    baud_rx_ring[baud_rx_head] = baud_rx_byte;
+    baud_rx_head = next;
+  }
+
+  HAL_UART_Receive_IT(app.uart, &baud_rx_byte, 1);
+}
+
+// Receive errors (framing, noise, overrun) stop the receive; count them and listen again.
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  if(huart != app.uart) {
+    return;
+  }
+
+  if(baud_rx_errors < 0xFF) {
+    baud_rx_errors++;
+  }
+
+  HAL_UART_Receive_IT(app.uart, &baud_rx_byte, 1);
+}
+
+void app_setup(const app_config * config)
+{
+  app = *config;
+
+  // Give the host a chance to move the link to a faster baud rate before anything is sent.
+  stream_baud_parser_reset(&baud_parser);
+  HAL_UART_Receive_IT(app.uart, &baud_rx_byte, 1);
+  baud_negotiate(BAUD_BOOT_WINDOW);
+
+  ov2640_register(&camera, app.spi_cs_port, app.spi_cs_pin, app.spi, app.i2c);
+
+  // Check the outcomes of these tests using the debugger to see if the camera works properly
+  uint8_t i2c_test = ov2640_test_i2c(&camera);
+  uint8_t spi_test = ov2640_test_spi(&camera);
+  ov2640_test_who_am_i(&camera);
+  (void)i2c_test;
+  (void)spi_test;
+
+  // Initialize ov2640 and set desired resolution for pictures
+  ov2640_jpeg_init(&camera);
+  ov2640_jpeg_set_res(&camera, OV2640_RES_320x240);
+
+  if(use_motion_trigger == 1) {
+    ov2640_motion_init(&camera, &motion, OV2640_RES_1600x1200, 15);
+  }
+
+  use_compression = (camera.image_type != OV2640_IMG_JPEG);
+}
+
+void app_loop(void)
+{
+  uint8_t frame_header[STREAM_FRAME_HEADER_SIZE];
+  uint8_t frame_trailer[STREAM_FRAME_TRAILER_SIZE];
+  // MCU timestamps (HAL ticks) for the latency breakdown sent with each frame
+  uint32_t frame_stamps[STREAM_FRAME_STAMP_COUNT];
+  uint8_t frame_timestamps[STREAM_FRAME_TIMESTAMPS_SIZE];
+
+  // Wait for motion in the previews, then switch to the capture resolution and capture right away.
+  if(use_motion_trigger == 1) {
+    while(ov2640_motion_watch(&camera, &motion) == 0);
+    frame_stamps[STREAM_FRAME_STAMP_TRIGGER] = HAL_GetTick();
+    ov2640_motion_capture(&camera, &motion);
+  }
+  else {
+    frame_stamps[STREAM_FRAME_STAMP_TRIGGER] = HAL_GetTick();
+  }
+
+  // Keep trying until a valid capture is taken.
+  while(camera.fifo_length == 0) {
+    ov2640_get_capture(&camera);
+  }
+  frame_stamps[STREAM_FRAME_STAMP_CAPTURED] = HAL_GetTick();
+
+  // Transfer and send out capture data as a binary frame, one buffer at a time.
+  uint8_t frame_flags = STREAM_FRAME_FLAG_TIMESTAMPS | ((use_compression == 1) ? STREAM_FRAME_FLAG_COMPRESSED : 0);
+  stream_frame_begin(&frame, frame_header, frame_flags, camera.image_res, frame_sequence++, camera.fifo_length);
+  // UART is idle between frames, so the header starts going out as soon as it's queued.
+  frame_stamps[STREAM_FRAME_STAMP_FIRST_OUT] = HAL_GetTick();
+  uart_out_write(frame_header, STREAM_FRAME_HEADER_SIZE);
+
+  ov2640_transfer_start(&camera);
+
+  // Buffer approach is done for the case where there isn't enough memory to hold the entire image at once.
+  // SPI reads into one output buffer while UART DMA sends the ones filled before it, so UART is kept busy.
+  while(camera.fifo_length > 0) {
+    uart_out_buffer * buffer = uart_out_acquire();
+    uint8_t * chunk = (use_compression == 1) ? compress_in : buffer->data;
+    uint16_t buffer_filled;
+    uint8_t read;
+
+    uint8_t use_dma = 1;
+    if(use_dma == 1) {
+      read = ov2640_transfer_step_dma(&camera, chunk, UART_OUT_CHUNK_LENGTH, &buffer_filled);
+
+      // update fifo_length when we know dma transfer is done.
+      if(read == 1) {
+        while (HAL_DMA_GetState(app.spi_dma_rx) != HAL_DMA_STATE_READY);
+        camera.fifo_length -= buffer_filled;
+      }
+    }
+    else {
+      read = ov2640_transfer_step(&camera, chunk, UART_OUT_CHUNK_LENGTH, &buffer_filled);
+    }
+
+    // A failed read has thrown the capture out, leaving the frame cut short.
+    if(read == 0) {
+      break;
+    }
+
+    // Queue the buffer data to be sent through Serial as a payload chunk, straight from the transfer buffer
+    // or coded into it. The CRC is always over the capture data itself.
+    stream_frame_update(&frame, chunk, buffer_filled);
+    if(use_compression == 1) {
+      uart_out_submit(stream_compress_chunk(compress_in, buffer_filled, buffer->data, sizeof(buffer->data)));
+    }
+    else {
+      uart_out_submit(buffer_filled);
+    }
+  }
+
+  ov2640_transfer_stop(&camera);
+
+  // If the transfer was cut short, pad the payload to the promised length so the receiver stays in sync.
+  // The frame is marked lost, so the receiver drops it.
+  if(frame.sent < frame.length) {
+    stream_frame_abort(&frame);
+  }
+  while(frame.sent < frame.length) {
+    uart_out_buffer * buffer = uart_out_acquire();
+    uint16_t padding = UART_OUT_CHUNK_LENGTH;
+    if(frame.length - frame.sent < padding) {
+      padding = frame.length - frame.sent;
+    }
+    if(use_compression == 1) {
+      memset(compress_in, 0, padding);
+      stream_frame_update(&frame, compress_in, padding);
+      uart_out_submit(stream_compress_chunk(compress_in, padding, buffer->data, sizeof(buffer->data)));
+    }
+    else {
+      memset(buffer->data, 0, padding);
+      stream_frame_update(&frame, buffer->data, padding);
+      uart_out_submit(padding);
+    }
+  }
+
+  // Wait for the payload to go out to stamp its last byte; only the tail of the frame is left to send by now.
+  uart_out_flush();
+  frame_stamps[STREAM_FRAME_STAMP_LAST_OUT] = HAL_GetTick();
+  stream_frame_timestamps(&frame, frame_timestamps, frame_stamps);
+  uart_out_write(frame_timestamps, STREAM_FRAME_TIMESTAMPS_SIZE);
+
+  stream_frame_end(&frame, frame_trailer);
+  uart_out_write(frame_trailer, STREAM_FRAME_TRAILER_SIZE);
+
+  // Handle a baud rate proposal if the host sent one during the frame (e.g. it started after boot).
+  baud_negotiate(0);
+
+  // Go back to watching previews, or delay between camera captures.
+  if(use_motion_trigger == 1) {
+    ov2640_motion_resume(&camera, &motion);
+  }
+  else {
+    HAL_Delay(app.capture_interval);
+  }
+}
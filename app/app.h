@@ -0,0 +1,39 @@
+#ifndef APP_H
+#define APP_H
+
+#include <stdint.h>
+
+#ifdef USE_MOCK_HAL
+#include "../mocks/hal_mock.h"
+#else
+#include "main.h"
+#endif
+
+// The camera application: captures with the OV2640 and streams them to the host over UART as binary frames
+// (see stream_frame.h), negotiating a faster baud rate with the host first (see stream_baud.h).
+//
+// main.c sets up the peripherals (CubeMX) and runs it; the host build in app_host.c runs the same code against the
+// mock HAL and the camera simulator, with the UART connected to a pseudo-terminal.
+//
+// The application owns the UART's callbacks (HAL_UART_TxCpltCallback, HAL_UART_RxCpltCallback, HAL_UART_ErrorCallback).
+
+// Peripherals the application runs on, set up beforehand
+typedef struct app_config {
+  I2C_HandleTypeDef * i2c;            // Camera sensor (SCCB)
+  SPI_HandleTypeDef * spi;            // Camera CPLD and FIFO
+  DMA_HandleTypeDef * spi_dma_rx;     // DMA stream linked to the SPI for receiving
+  GPIO_TypeDef * spi_cs_port;         // Camera chip select
+  uint16_t spi_cs_pin;
+  UART_HandleTypeDef * uart;          // Link to the host, with a DMA stream linked for transmitting
+  uint32_t capture_interval;          // Delay between captures when not triggered by motion (ms)
+} app_config;
+
+// Provided by whatever runs the application; called when a peripheral can't be set up
+void Error_Handler(void);
+
+// Negotiates the baud rate and sets up the camera
+void app_setup(const app_config * config);
+// Takes one capture and sends it out, then waits for the next one to be due
+void app_loop(void);
+
+#endif // APP_H
@@ -0,0 +1,275 @@
+// Firmware-in-the-loop host build: runs the camera application (app.c) against the mock HAL and the OV2640 simulator,
+// with its UART connected to a pseudo-terminal, so the host receiver can be pointed at it like at the Nucleo board:
+//
+//   app_host [--frames N] [--interval MS] [--jpeg FILE]... [--virtual]
+//            [--seed N] [--error-ppm PPM] [--stall-ppm PPM] [--flip-ppm PPM] [--trace FILE]
+//   python read_image.py --port <the pseudo-terminal it prints>
+//
+// Time runs at wall clock speed by default, so the link is as fast as the baud rate the host negotiates and the
+// receiver's figures are what the board would give (less the real camera). With --virtual, simulated time runs as
+// fast as the host can go once the application has booted, only held back by the receiver reading the pseudo-terminal
+// (a soak test). The boot still runs at wall clock speed, so start the receiver within its baud rate negotiation window.
+//
+// The fault options inject faults into the camera's SPI and I2C transfers once it's set up (see Mock_HAL_FaultsTypeDef):
+// transfers failing, the camera stalling them for FAULT_STALL_MS and bits it sends flipped, at the given rates in parts
+// per million, drawn from --seed, so runs with the same options are comparable when benchmarking error recovery.
+//
+// With --trace, every delay, chip select edge and bus transfer from the boot on is recorded to FILE with its simulated
+// time and the driver phase it was part of, for trace_report.py to break down.
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+
+#include "app.h"
+#include "ov2640_sim.h"
+
+// The board's peripherals, set up like MX_*_Init and HAL_*_MspInit in main.c
+static I2C_HandleTypeDef hi2c1;
+static SPI_HandleTypeDef hspi1;
+static DMA_HandleTypeDef hdma_spi1_rx;
+static DMA_HandleTypeDef hdma_spi1_tx;
+static UART_HandleTypeDef huart2;
+static DMA_HandleTypeDef hdma_usart2_tx;
+static GPIO_TypeDef gpioa;
+
+static ov2640_sim camera_sim;
+static Mock_HAL_FaultsTypeDef spi_faults;
+static Mock_HAL_FaultsTypeDef i2c_faults;
+
+// Longest to wait at the end for the receiver to read what's left in the pseudo-terminal, and how long to keep it open
+// after that, as a hangup in the middle of the receiver's read would lose the data it got (ms)
+#define PTY_DRAIN_TIMEOUT 1000
+#define PTY_LINGER 500
+
+// How long an injected stall holds up a camera transfer, unless the transfer times out first (ms)
+#define FAULT_STALL_MS 10
+
+// Set by SIGINT/SIGTERM to stop after the frame being sent
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int signum)
+{
+  (void)signum;
+  stop = 1;
+}
+
+void Error_Handler(void)
+{
+  fprintf(stderr, "app_host: peripheral setup failed\n");
+  exit(EXIT_FAILURE);
+}
+
+// Opens a pseudo-terminal for the UART and returns its master side; the slave side is left open (in raw mode) so the
+// line stays up between receivers
+static int open_pty(char * name, size_t name_size, int * slave)
+{
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if((master < 0) || (grantpt(master) != 0) || (unlockpt(master) != 0) || (ptsname(master) == NULL)) {
+    return -1;
+  }
+  snprintf(name, name_size, "%s", ptsname(master));
+
+  *slave = open(name, O_RDWR | O_NOCTTY);
+  if(*slave < 0) {
+    return -1;
+  }
+  struct termios tio;
+  tcgetattr(*slave, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(*slave, TCSANOW, &tio);
+
+  return master;
+}
+
+static void setup_peripherals(int pty)
+{
+  HAL_Init();
+
+  hi2c1.Init.ClockSpeed = 100000;
+  if (HAL_I2C_Init(&hi2c1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  hspi1.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+  if (HAL_SPI_Init(&hspi1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  __HAL_LINKDMA(&hspi1, hdmarx, hdma_spi1_rx);
+  __HAL_LINKDMA(&hspi1, hdmatx, hdma_spi1_tx);
+
+  huart2.Init.BaudRate = 115200;
+  huart2.Init.WordLength = UART_WORDLENGTH_8B;
+  huart2.Init.StopBits = UART_STOPBITS_1;
+  huart2.Init.Parity = UART_PARITY_NONE;
+  huart2.Init.Mode = UART_MODE_TX_RX;
+  huart2.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  huart2.Init.OverSampling = UART_OVERSAMPLING_16;
+  Mock_UART_Attach_Fd(&huart2, pty, pty);
+  if (HAL_UART_Init(&huart2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  __HAL_LINKDMA(&huart2, hdmatx, hdma_usart2_tx);
+
+  hdma_spi1_rx.State = HAL_DMA_STATE_READY;
+  hdma_spi1_tx.State = HAL_DMA_STATE_READY;
+  hdma_usart2_tx.State = HAL_DMA_STATE_READY;
+}
+
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    {"frames", required_argument, NULL, 'n'},
+    {"interval", required_argument, NULL, 'i'},
+    {"jpeg", required_argument, NULL, 'j'},
+    {"virtual", no_argument, NULL, 'v'},
+    {"seed", required_argument, NULL, 's'},
+    {"error-ppm", required_argument, NULL, 'e'},
+    {"stall-ppm", required_argument, NULL, 't'},
+    {"flip-ppm", required_argument, NULL, 'f'},
+    {"trace", required_argument, NULL, 'r'},
+    {NULL, 0, NULL, 0},
+  };
+  uint32_t frames = 0;
+  uint32_t interval = 0;
+  uint8_t virtual_time = 0;
+  Mock_HAL_FaultsTypeDef faults = {.StallMs = FAULT_STALL_MS};
+  const char * trace = NULL;
+
+  ov2640_sim_init(&camera_sim);
+
+  int opt;
+  while((opt = getopt_long(argc, argv, "n:i:j:vs:e:t:f:r:", options, NULL)) != -1) {
+    switch(opt) {
+      case 'n':
+        frames = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'i':
+        interval = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'j':
+        if(ov2640_sim_load_jpeg(&camera_sim, optarg) != HAL_OK) {
+          fprintf(stderr, "app_host: can't load %s as a capture\n", optarg);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'v':
+        virtual_time = 1;
+        break;
+      case 's':
+        faults.Seed = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'e':
+        faults.ErrorPpm[MOCK_HAL_FAULT_WRITE] = (uint32_t)strtoul(optarg, NULL, 0);
+        faults.ErrorPpm[MOCK_HAL_FAULT_READ] = faults.ErrorPpm[MOCK_HAL_FAULT_WRITE];
+        break;
+      case 't':
+        faults.StallPpm = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'f':
+        faults.BitFlipPpm = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+      case 'r':
+        trace = optarg;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [--frames N] [--interval MS] [--jpeg FILE]... [--virtual]\n"
+                        "         [--seed N] [--error-ppm PPM] [--stall-ppm PPM] [--flip-ppm PPM] [--trace FILE]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+
+  if((trace != NULL) && (Mock_HAL_Trace_Start(trace) != HAL_OK)) {
+    fprintf(stderr, "app_host: can't write a trace to %s\n", trace);
+    return EXIT_FAILURE;
+  }
+
+  char pty_name[64];
+  int pty_slave;
+  int pty = open_pty(pty_name, sizeof(pty_name), &pty_slave);
+  if(pty < 0) {
+    perror("app_host: can't open a pseudo-terminal");
+    return EXIT_FAILURE;
+  }
+  printf("Camera UART on %s\n", pty_name);
+  fflush(stdout);
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  // A receiver going away mid-write must not kill the run
+  signal(SIGPIPE, SIG_IGN);
+
+  // The receiver answers baud rate negotiation in real time, so boot in real time either way
+  hal_board->RealTime = 1;
+  setup_peripherals(pty);
+  if(ov2640_sim_attach(&camera_sim, &hspi1, &gpioa, GPIO_PIN_8, &hi2c1) != HAL_OK) {
+    Error_Handler();
+  }
+
+  app_config config = {
+    .i2c = &hi2c1,
+    .spi = &hspi1,
+    .spi_dma_rx = &hdma_spi1_rx,
+    .spi_cs_port = &gpioa,
+    .spi_cs_pin = GPIO_PIN_8,
+    .uart = &huart2,
+    .capture_interval = interval,
+  };
+
+  app_setup(&config);
+  hal_board->RealTime = !virtual_time;
+
+  // Faults only start once the camera is set up, as the application gives up on a camera it can't set up.
+  // Each bus gets its own generator, so faults on one don't move the other's on.
+  spi_faults = faults;
+  i2c_faults = faults;
+  i2c_faults.Seed = faults.Seed + 1U;
+  Mock_SPI_Set_Faults(&hspi1, &spi_faults);
+  Mock_I2C_Set_Faults(&hi2c1, &i2c_faults);
+
+  // Throughput is measured over the frames, leaving out the boot (baud rate negotiation, camera setup)
+  struct timespec wall_start, wall_end;
+  clock_gettime(CLOCK_MONOTONIC, &wall_start);
+  uint32_t sim_start = HAL_GetTick();
+
+  uint32_t sent = 0;
+  while((stop == 0) && ((frames == 0) || (sent < frames))) {
+    app_loop();
+    sent++;
+  }
+
+  // Let the last trailer go out before reporting
+  while((hdma_usart2_tx.State == HAL_DMA_STATE_BUSY) && Mock_HAL_Run_Next_Event());
+  clock_gettime(CLOCK_MONOTONIC, &wall_end);
+  Mock_HAL_Trace_Stop();
+
+  double sim_s = (double)(HAL_GetTick() - sim_start) / 1000.0;
+  double wall_s = (double)(wall_end.tv_sec - wall_start.tv_sec) + (double)(wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+  printf("%u frames at %u baud in %.3f s simulated (%.2f fps), %.3f s wall clock\n", sent, huart2.Init.BaudRate,
+         sim_s, (sim_s > 0) ? sent / sim_s : 0.0, wall_s);
+  if((faults.ErrorPpm[MOCK_HAL_FAULT_READ] != 0) || (faults.StallPpm != 0) || (faults.BitFlipPpm != 0)) {
+    printf("Faults injected: SPI %u errors, %u stalls, %u bit flips; I2C %u errors, %u stalls, %u bit flips\n",
+           spi_faults.Errors, spi_faults.Stalls, spi_faults.BitFlips, i2c_faults.Errors, i2c_faults.Stalls, i2c_faults.BitFlips);
+  }
+
+  // Closing the pseudo-terminal throws away what the receiver hasn't read yet
+  int unread = 0;
+  for(uint32_t waited = 0; (waited < PTY_DRAIN_TIMEOUT) && (ioctl(pty_slave, FIONREAD, &unread) == 0) && (unread > 0); waited++) {
+    usleep(1000);
+  }
+  usleep(PTY_LINGER * 1000);
+
+  ov2640_sim_deinit(&camera_sim);
+  close(pty_slave);
+  close(pty);
+  return EXIT_SUCCESS;
+}
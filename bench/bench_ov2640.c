@@ -0,0 +1,378 @@
+// Driver benchmark: runs the OV2640 driver through a capture cycle (ov2640_jpeg_init, ov2640_jpeg_set_res,
+// ov2640_get_capture, then the transfer functions) against the OV2640 simulator, for every resolution and a sweep of
+// transfer buffer sizes, and reports the simulated time each step takes and the bus transactions it makes:
+//
+//   bench_ov2640 [--res WxH]... [--chunk BYTES]... [--dma] [--json FILE]
+//
+// Every run starts from a board of its own at simulated time 0, and time is virtual, so the figures only depend on the
+// driver and the simulator: run it before and after a driver change and compare. --res and --chunk narrow the sweep down
+// to the resolutions and transfer buffer sizes given; --dma reads the FIFO with ov2640_transfer_step_dma, waiting for each
+// DMA transfer like the application does, instead of ov2640_transfer_step.
+//
+// After the cycle, the motion_capture step measures the preview/trigger pipeline's latency with the resolution as its
+// capture resolution: from a preview showing motion (ov2640_motion_watch returning 1) to the capture being in the FIFO,
+// i.e. ov2640_motion_capture switching over with the register delta and capturing; compare it with set_res + capture.
+//
+// The init, set_res, capture and motion_capture steps don't depend on the buffer size, so they're reported once per
+// resolution; the transfer (from ov2640_transfer_start to ov2640_transfer_stop) once per buffer size, with the rate the
+// frame came in at.
+//
+// With --json, the results are also written to FILE ("-": stdout, instead of the table) for bench_compare.py to check
+// against a baseline. Results are one object per line, keyed by resolution, step and chunk (null for the steps that
+// don't depend on it):
+//
+//   {"version": 1, "dma": false, "results": [
+//     {"resolution": "320x240", "step": "transfer", "chunk": 8192, "time_ns": ..., "i2c_transfers": ...,
+//      "i2c_bytes": ..., "spi_transfers": ..., "spi_bytes_read": ..., "failed": ..., "bytes_per_s": ...},
+//     ...]}
+//
+// The bench_check target runs the full sweep and checks it against bench/baseline.json.
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ov2640.h"
+#include "ov2640_sim.h"
+
+// Transfer buffer sizes swept by default (bytes), up to the most a single transfer step takes
+static const uint16_t default_chunks[] = {256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65535};
+#define MAX_CHUNKS 16
+
+// Resolutions the driver supports, in ov2640_image_res_t order
+static const struct {
+  ov2640_image_res_t res;
+  const char * name;
+} resolutions[] = {
+  {OV2640_RES_160x120, "160x120"},
+  {OV2640_RES_176x144, "176x144"},
+  {OV2640_RES_320x240, "320x240"},
+  {OV2640_RES_352x288, "352x288"},
+  {OV2640_RES_640x480, "640x480"},
+  {OV2640_RES_800x600, "800x600"},
+  {OV2640_RES_1024x768, "1024x768"},
+  {OV2640_RES_1280x1024, "1280x1024"},
+  {OV2640_RES_1600x1200, "1600x1200"},
+};
+#define NUM_RESOLUTIONS (sizeof(resolutions) / sizeof(resolutions[0]))
+
+// Steps of the capture cycle measured
+enum {
+  STEP_INIT,
+  STEP_SET_RES,
+  STEP_CAPTURE,
+  STEP_MOTION_CAPTURE,
+  STEP_TRANSFER,
+  NUM_STEPS
+};
+static const char * const step_names[NUM_STEPS] = {"init", "set_res", "capture", "motion_capture", "transfer"};
+
+// Change in preview size that counts as motion (%), as in the application; the benchmark never watches for it
+#define MOTION_THRESHOLD 15
+
+#define JSON_VERSION 1
+
+// What a step took: simulated time, and the transfers it made on each bus
+typedef struct {
+  uint64_t ns;
+  Mock_HAL_BusStatsTypeDef i2c;
+  Mock_HAL_BusStatsTypeDef spi;
+} bench_step;
+
+// A board with a camera on it, set up like MX_*_Init in main.c
+typedef struct {
+  Mock_HAL_BoardTypeDef board;
+  GPIO_TypeDef gpioa;
+  I2C_HandleTypeDef hi2c1;
+  SPI_HandleTypeDef hspi1;
+  DMA_HandleTypeDef hdma_spi1_rx;
+  ov2640 camera;
+  ov2640_sim sim;
+} bench_board;
+
+// The whole FIFO, so the frame can be checked against what the simulated camera captured
+static uint8_t frame[OV2640_SIM_FIFO_SIZE];
+
+static void Error_Handler(void)
+{
+  fprintf(stderr, "bench_ov2640: peripheral setup failed\n");
+  exit(EXIT_FAILURE);
+}
+
+static void board_setup(bench_board * b, uint8_t use_dma)
+{
+  memset(b, 0, sizeof(*b));
+  Mock_HAL_Board_Init(&b->board);
+  Mock_HAL_Board_Select(&b->board);
+  HAL_Init();
+
+  b->hi2c1.Init.ClockSpeed = 100000;
+  if (HAL_I2C_Init(&b->hi2c1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+
+  b->hspi1.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+  if (HAL_SPI_Init(&b->hspi1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if(use_dma) {
+    __HAL_LINKDMA(&b->hspi1, hdmarx, b->hdma_spi1_rx);
+    b->hdma_spi1_rx.State = HAL_DMA_STATE_READY;
+  }
+
+  ov2640_sim_init(&b->sim);
+  if(ov2640_sim_attach(&b->sim, &b->hspi1, &b->gpioa, GPIO_PIN_8, &b->hi2c1) != HAL_OK) {
+    Error_Handler();
+  }
+  ov2640_register(&b->camera, &b->gpioa, GPIO_PIN_8, &b->hspi1, &b->hi2c1);
+}
+
+static void board_teardown(bench_board * b)
+{
+  Mock_SPI_Detach_Slave(&b->hspi1);
+  Mock_I2C_Detach_Slave(&b->hi2c1);
+  ov2640_sim_deinit(&b->sim);
+  Mock_HAL_Board_Select(NULL);
+  Mock_HAL_Board_DeInit(&b->board);
+}
+
+static void stats_sub(Mock_HAL_BusStatsTypeDef * to, const Mock_HAL_BusStatsTypeDef * from)
+{
+  for(uint32_t type = 0; type < MOCK_HAL_FAULT_TYPES; type++) {
+    to->Transfers[type] -= from->Transfers[type];
+    to->Bytes[type] -= from->Bytes[type];
+  }
+  to->Failed -= from->Failed;
+  to->BusNs -= from->BusNs;
+}
+
+static void step_begin(bench_board * b, bench_step * step)
+{
+  step->ns = Mock_HAL_GetTimeNs();
+  step->i2c = b->hi2c1.Stats;
+  step->spi = b->hspi1.Stats;
+}
+
+// Turns what step_begin took into what the step took since
+static void step_end(bench_board * b, bench_step * step)
+{
+  Mock_HAL_BusStatsTypeDef i2c = b->hi2c1.Stats;
+  Mock_HAL_BusStatsTypeDef spi = b->hspi1.Stats;
+  stats_sub(&i2c, &step->i2c);
+  stats_sub(&spi, &step->spi);
+  step->ns = Mock_HAL_GetTimeNs() - step->ns;
+  step->i2c = i2c;
+  step->spi = spi;
+}
+
+// Runs a capture cycle at res, transferring the frame chunk bytes at a time, and returns the frame size (0: the frame
+// didn't come through intact)
+static uint32_t bench_run(ov2640_image_res_t res, uint16_t chunk, uint8_t use_dma, bench_step steps[NUM_STEPS])
+{
+  static bench_board b;
+  board_setup(&b, use_dma);
+  ov2640 * camera = &b.camera;
+
+  step_begin(&b, &steps[STEP_INIT]);
+  ov2640_jpeg_init(camera);
+  step_end(&b, &steps[STEP_INIT]);
+
+  step_begin(&b, &steps[STEP_SET_RES]);
+  ov2640_jpeg_set_res(camera, res);
+  step_end(&b, &steps[STEP_SET_RES]);
+
+  // Keep trying until a valid capture is taken.
+  step_begin(&b, &steps[STEP_CAPTURE]);
+  while(camera->fifo_length == 0) {
+    ov2640_get_capture(camera);
+  }
+  step_end(&b, &steps[STEP_CAPTURE]);
+
+  uint32_t length = camera->fifo_length;
+  uint32_t received = 0;
+  step_begin(&b, &steps[STEP_TRANSFER]);
+  ov2640_transfer_start(camera);
+  while(camera->fifo_length > 0) {
+    uint16_t buffer_filled;
+    if(use_dma) {
+      if(ov2640_transfer_step_dma(camera, &frame[received], chunk, &buffer_filled) == 1) {
+        while (HAL_DMA_GetState(&b.hdma_spi1_rx) != HAL_DMA_STATE_READY);
+        camera->fifo_length -= buffer_filled;
+      }
+    }
+    else {
+      ov2640_transfer_step(camera, &frame[received], chunk, &buffer_filled);
+    }
+    received += buffer_filled;
+  }
+  ov2640_transfer_stop(camera);
+  step_end(&b, &steps[STEP_TRANSFER]);
+
+  if((received != length) || (b.sim.capture_frame == NULL) || (b.sim.capture_frame->length != length) ||
+     (memcmp(frame, b.sim.capture_frame->data, length) != 0)) {
+    length = 0;
+  }
+
+  // Switch to previews and seed the motion baseline with one, then take the capture as if the next one showed motion
+  ov2640_motion motion;
+  ov2640_motion_init(camera, &motion, res, MOTION_THRESHOLD);
+  ov2640_motion_watch(camera, &motion);
+  step_begin(&b, &steps[STEP_MOTION_CAPTURE]);
+  ov2640_motion_capture(camera, &motion);
+  step_end(&b, &steps[STEP_MOTION_CAPTURE]);
+  if((b.sim.capture_frame == NULL) || (camera->fifo_length != b.sim.capture_frame->length)) {
+    length = 0;
+  }
+  board_teardown(&b);
+  return length;
+}
+
+// Rate bytes came in at over a step (bytes/s)
+static double step_rate(const bench_step * step, uint32_t bytes)
+{
+  return (step->ns > 0) ? (double)bytes * 1e9 / (double)step->ns : 0.0;
+}
+
+// Reports a step: in the table to out, and as a result to json (NULL: none); chunk 0 is for steps that don't depend on it
+static void report_step(FILE * out, FILE * json, const char * res, uint16_t chunk, uint32_t s, const bench_step * step,
+                        uint32_t bytes)
+{
+  static uint8_t first = 1;
+  uint32_t i2c = step->i2c.Transfers[MOCK_HAL_FAULT_WRITE] + step->i2c.Transfers[MOCK_HAL_FAULT_READ];
+  uint32_t spi = step->spi.Transfers[MOCK_HAL_FAULT_WRITE] + step->spi.Transfers[MOCK_HAL_FAULT_READ];
+
+  if(out != NULL) {
+    char chunk_name[8] = "-";
+    if(chunk != 0) {
+      snprintf(chunk_name, sizeof(chunk_name), "%u", chunk);
+    }
+    fprintf(out, "%-10s %6s  %-14s %11.3f %10u %10u %10u %12.0f\n", res, chunk_name, step_names[s], (double)step->ns / 1e6,
+            i2c, spi, step->spi.Bytes[MOCK_HAL_FAULT_READ], step_rate(step, bytes));
+  }
+
+  if(json != NULL) {
+    char chunk_value[8] = "null";
+    if(chunk != 0) {
+      snprintf(chunk_value, sizeof(chunk_value), "%u", chunk);
+    }
+    fprintf(json, "%s\n  {\"resolution\": \"%s\", \"step\": \"%s\", \"chunk\": %s, \"time_ns\": %llu, "
+            "\"i2c_transfers\": %u, \"i2c_bytes\": %u, \"spi_transfers\": %u, \"spi_bytes_read\": %u, "
+            "\"failed\": %u, \"bytes_per_s\": %.0f}",
+            first ? "" : ",", res, step_names[s], chunk_value, (unsigned long long)step->ns, i2c,
+            step->i2c.Bytes[MOCK_HAL_FAULT_WRITE] + step->i2c.Bytes[MOCK_HAL_FAULT_READ], spi,
+            step->spi.Bytes[MOCK_HAL_FAULT_READ], step->i2c.Failed + step->spi.Failed, step_rate(step, bytes));
+    first = 0;
+  }
+}
+
+int main(int argc, char * argv[])
+{
+  static const struct option options[] = {
+    {"res", required_argument, NULL, 'r'},
+    {"chunk", required_argument, NULL, 'c'},
+    {"dma", no_argument, NULL, 'd'},
+    {"json", required_argument, NULL, 'j'},
+    {NULL, 0, NULL, 0},
+  };
+  uint8_t use_res[NUM_RESOLUTIONS] = {0};
+  uint8_t any_res = 0;
+  uint16_t chunks[MAX_CHUNKS];
+  uint32_t num_chunks = 0;
+  uint8_t use_dma = 0;
+  const char * json_path = NULL;
+
+  int opt;
+  while((opt = getopt_long(argc, argv, "r:c:dj:", options, NULL)) != -1) {
+    switch(opt) {
+      case 'r': {
+        uint32_t i = 0;
+        while((i < NUM_RESOLUTIONS) && (strcmp(resolutions[i].name, optarg) != 0)) {
+          i++;
+        }
+        if(i == NUM_RESOLUTIONS) {
+          fprintf(stderr, "bench_ov2640: no resolution %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+        use_res[i] = 1;
+        any_res = 1;
+        break;
+      }
+      case 'c': {
+        unsigned long chunk = strtoul(optarg, NULL, 0);
+        if((chunk == 0) || (chunk > UINT16_MAX) || (num_chunks == MAX_CHUNKS)) {
+          fprintf(stderr, "bench_ov2640: buffer size must be 1 to %u bytes, at most %u of them\n", UINT16_MAX, MAX_CHUNKS);
+          return EXIT_FAILURE;
+        }
+        chunks[num_chunks++] = (uint16_t)chunk;
+        break;
+      }
+      case 'd':
+        use_dma = 1;
+        break;
+      case 'j':
+        json_path = optarg;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [--res WxH]... [--chunk BYTES]... [--dma] [--json FILE]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if(num_chunks == 0) {
+    num_chunks = sizeof(default_chunks) / sizeof(default_chunks[0]);
+    memcpy(chunks, default_chunks, sizeof(default_chunks));
+  }
+
+  FILE * out = stdout;
+  FILE * json = NULL;
+  if(json_path != NULL) {
+    if(strcmp(json_path, "-") == 0) {
+      out = NULL;
+      json = stdout;
+    }
+    else if((json = fopen(json_path, "w")) == NULL) {
+      fprintf(stderr, "bench_ov2640: can't write results to %s\n", json_path);
+      return EXIT_FAILURE;
+    }
+    fprintf(json, "{\"version\": %u, \"dma\": %s, \"results\": [", JSON_VERSION, use_dma ? "true" : "false");
+  }
+
+  if(out != NULL) {
+    fprintf(out, "%-10s %6s  %-14s %11s %10s %10s %10s %12s\n", "resolution", "chunk", "step", "time ms", "i2c xfers",
+            "spi xfers", "spi bytes", "bytes/s");
+  }
+
+  int status = EXIT_SUCCESS;
+  for(uint32_t r = 0; r < NUM_RESOLUTIONS; r++) {
+    if(any_res && !use_res[r]) {
+      continue;
+    }
+
+    for(uint32_t c = 0; c < num_chunks; c++) {
+      bench_step steps[NUM_STEPS];
+      uint32_t length = bench_run(resolutions[r].res, chunks[c], use_dma, steps);
+      if(length == 0) {
+        fprintf(stderr, "bench_ov2640: %s frame read %u bytes at a time came through wrong\n", resolutions[r].name, chunks[c]);
+        status = EXIT_FAILURE;
+        continue;
+      }
+
+      // Every run goes through the same init, set_res, capture and motion_capture, so report them from the first
+      if(c == 0) {
+        for(uint32_t s = STEP_INIT; s < STEP_TRANSFER; s++) {
+          report_step(out, json, resolutions[r].name, 0, s, &steps[s], 0);
+        }
+      }
+      report_step(out, json, resolutions[r].name, chunks[c], STEP_TRANSFER, &steps[STEP_TRANSFER], length);
+    }
+  }
+
+  if(json != NULL) {
+    fprintf(json, "\n]}\n");
+    if(json != stdout) {
+      fclose(json);
+    }
+  }
+  return status;
+}
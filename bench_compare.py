@@ -0,0 +1,151 @@
+import argparse
+import json
+import os
+import sys
+
+# Checks driver benchmark results (bench_ov2640 --json) against a checked-in baseline, exiting non-zero on a regression:
+#
+#   bench_ov2640 --json - | python bench_compare.py -
+#   python bench_compare.py results.json --baseline bench/baseline.json [--tolerance time_ns=2]...
+#   python bench_compare.py results.json --update     (after a change that is meant to move the numbers)
+#
+# The baseline is a results file plus the tolerance of each metric, in percent of the baseline value; a result is
+# a regression when a metric is worse than that by more than its tolerance. Simulated time is deterministic, so
+# tolerances only need to absorb intended small changes, and the transaction counts default to none at all.
+# Results are matched by resolution, step and chunk; one missing from the results is a regression too (the sweep
+# shrank or a run failed), as only a full run can stand in for the baseline.
+
+RESULTS_VERSION = 1
+
+DEFAULT_BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "bench", "baseline.json")
+
+# metric: (default tolerance in percent, whether higher is better)
+METRICS = {
+    "time_ns": (1.0, False),
+    "i2c_transfers": (0.0, False),
+    "i2c_bytes": (0.0, False),
+    "spi_transfers": (0.0, False),
+    "spi_bytes_read": (0.0, False),
+    "failed": (0.0, False),
+    "bytes_per_s": (1.0, True),
+}
+
+# exit statuses: no regression, a regression, results that can't be compared
+EXIT_OK = 0
+EXIT_REGRESSION = 1
+EXIT_MISMATCH = 2
+
+
+def load_results(path):
+    if path == "-":
+        data = json.load(sys.stdin)
+    else:
+        with open(path) as f:
+            data = json.load(f)
+    if data.get("version") != RESULTS_VERSION:
+        raise ValueError(f"{path}: not version {RESULTS_VERSION} benchmark results")
+    return data
+
+
+def key(result):
+    return result["resolution"], result["step"], result["chunk"]
+
+
+def describe(k):
+    resolution, step, chunk = k
+    return f"{resolution} {step}" + (f" {chunk}" if chunk is not None else "")
+
+
+def compare(results, baseline, tolerances):
+    """Returns the regressions and the improvements past tolerance, as (key, metric, baseline, current, tolerance)"""
+    current = {key(r): r for r in results["results"]}
+    regressions = []
+    improvements = []
+
+    for expected in baseline["results"]:
+        k = key(expected)
+        if k not in current:
+            regressions.append((k, None, None, None, None))
+            continue
+        for metric, (_, higher_is_better) in METRICS.items():
+            was, now = expected[metric], current[k][metric]
+            allowed = abs(was) * tolerances[metric] / 100.0
+            worse = (was - now) if higher_is_better else (now - was)
+            if worse > allowed:
+                regressions.append((k, metric, was, now, tolerances[metric]))
+            elif -worse > allowed:
+                improvements.append((k, metric, was, now, tolerances[metric]))
+
+    return regressions, improvements
+
+
+def print_change(label, change):
+    k, metric, was, now, tolerance = change
+    if metric is None:
+        print(f"{label} {describe(k)}: missing from the results")
+        return
+    delta = f"{100.0 * (now - was) / was:+.2f}%" if was else "new"
+    print(f"{label} {describe(k)} {metric}: {was} -> {now} ({delta}, tolerance {tolerance:g}%)")
+
+
+def write_baseline(path, results, tolerances):
+    # one result per line, like bench_ov2640 writes them, so baseline changes diff by result
+    lines = [json.dumps(r) for r in results["results"]]
+    with open(path, "w") as f:
+        f.write(f'{{"version": {RESULTS_VERSION}, "dma": {json.dumps(results["dma"])}, '
+                f'"tolerances": {json.dumps(tolerances)}, "results": [\n  ')
+        f.write(",\n  ".join(lines))
+        f.write("\n]}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check driver benchmark results against a baseline.")
+    parser.add_argument("results", help="results written by bench_ov2640 --json (- for stdin)")
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE, help="baseline to compare with (default: %(default)s)")
+    parser.add_argument("--tolerance", action="append", default=[], metavar="METRIC=PERCENT",
+                        help=f"override a metric's tolerance for this run, one of: {', '.join(METRICS)}")
+    parser.add_argument("--update", action="store_true",
+                        help="write the results as the new baseline, keeping its tolerances, instead of comparing")
+    args = parser.parse_args()
+
+    results = load_results(args.results)
+    baseline = load_results(args.baseline) if os.path.exists(args.baseline) else None
+
+    tolerances = {metric: default for metric, (default, _) in METRICS.items()}
+    if baseline is not None:
+        tolerances.update(baseline.get("tolerances", {}))
+    overrides = {}
+    for tolerance in args.tolerance:
+        metric, _, percent = tolerance.partition("=")
+        if metric not in METRICS:
+            parser.error(f"no metric {metric}")
+        overrides[metric] = float(percent)
+
+    if args.update:
+        # overrides given along with --update become the baseline's own
+        tolerances.update(overrides)
+        write_baseline(args.baseline, results, tolerances)
+        print(f"Wrote {len(results['results'])} results to {args.baseline}")
+        return EXIT_OK
+
+    if baseline is None:
+        print(f"No baseline at {args.baseline}; write one with --update")
+        return EXIT_MISMATCH
+    if results["dma"] != baseline["dma"]:
+        print(f"Results were taken with dma {results['dma']}, the baseline with dma {baseline['dma']}")
+        return EXIT_MISMATCH
+    tolerances.update(overrides)
+
+    regressions, improvements = compare(results, baseline, tolerances)
+    for change in improvements:
+        print_change("improved  ", change)
+    for change in regressions:
+        print_change("REGRESSION", change)
+
+    print(f"{len(baseline['results'])} baseline results: {len(regressions)} regressions, {len(improvements)} improvements"
+          + (" (update the baseline with --update once they're intended)" if improvements and not regressions else ""))
+    return EXIT_REGRESSION if regressions else EXIT_OK
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,190 @@
+import mmap
+import os
+import struct
+import zlib
+from bisect import bisect_left
+from collections import namedtuple
+
+# Append-only container for received frames, one data file plus an index:
+#
+#   <name>.frames  file header, then one record per frame:
+#                  record header (magic, session, sequence, host timestamp in ns, resolution, flags, payload length,
+#                  payload CRC32), then the payload
+#   <name>.idx     file header, then one fixed-size entry per record: session, sequence, timestamp, record offset
+#
+# Index entries are in record order, which is also timestamp order and (session, sequence) order: the session
+# counts firmware restarts, spotted as a sequence number that doesn't go up. That lets a reader mmap the index
+# and binary search it for a time or sequence instead of walking the data file (time lookups assume the host
+# clock the timestamps come from doesn't step backwards).
+# The data file is the source of truth; an index left short by a crash is rebuilt from it when the store is
+# next opened for writing, and a record torn off at the end of the data file is dropped then.
+
+DATA_MAGIC = b"OVFD"
+INDEX_MAGIC = b"OVFI"
+STORE_VERSION = 1
+FILE_HEADER = struct.Struct("<4sI")
+
+RECORD_MAGIC = b"FREC"
+RECORD_HEADER = struct.Struct("<4sIIqBBHII")
+INDEX_ENTRY = struct.Struct("<IIqQ")
+
+Frame = namedtuple("Frame", "session sequence timestamp_ns res flags payload")
+
+
+def _check_header(f, magic):
+    header = f.read(FILE_HEADER.size)
+    if len(header) != FILE_HEADER.size or FILE_HEADER.unpack(header) != (magic, STORE_VERSION):
+        raise ValueError(f"{f.name}: not a version {STORE_VERSION} frame store file")
+
+
+def _map(f):
+    # mmap can't map an empty file; nothing past the file header means no entries anyway
+    size = os.fstat(f.fileno()).st_size
+    return mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) if size else None
+
+
+class FrameStoreWriter:
+    # Appends frames to a store, creating it if it doesn't exist yet.
+
+    def __init__(self, name):
+        self.data = self._open(name + ".frames", DATA_MAGIC)
+        self.index = self._open(name + ".idx", INDEX_MAGIC)
+        self.session = 0
+        self.sequence = None
+        self._recover()
+
+    @staticmethod
+    def _open(path, magic):
+        f = open(path, "a+b")
+        f.seek(0)
+        if os.fstat(f.fileno()).st_size == 0:
+            f.write(FILE_HEADER.pack(magic, STORE_VERSION))
+            f.flush()
+        else:
+            _check_header(f, magic)
+        return f
+
+    def _recover(self):
+        # drop a torn index entry, then index any records the index is missing (e.g. after a crash)
+        index_size = os.fstat(self.index.fileno()).st_size
+        entries = (index_size - FILE_HEADER.size) // INDEX_ENTRY.size
+        self.index.truncate(FILE_HEADER.size + entries * INDEX_ENTRY.size)
+
+        offset = FILE_HEADER.size
+        if entries:
+            self.index.seek(FILE_HEADER.size + (entries - 1) * INDEX_ENTRY.size)
+            self.session, self.sequence, _, offset = INDEX_ENTRY.unpack(self.index.read(INDEX_ENTRY.size))
+            self.data.seek(offset)
+            offset += RECORD_HEADER.size + RECORD_HEADER.unpack(self.data.read(RECORD_HEADER.size))[7]
+
+        data_size = os.fstat(self.data.fileno()).st_size
+        self.data.seek(offset)
+        while offset + RECORD_HEADER.size <= data_size:
+            record = RECORD_HEADER.unpack(self.data.read(RECORD_HEADER.size))
+            magic, session, sequence, timestamp_ns, _, _, _, length, crc = record
+            payload = self.data.read(length)
+            if magic != RECORD_MAGIC or len(payload) != length or zlib.crc32(payload) != crc:
+                break
+            self.index.write(INDEX_ENTRY.pack(session, sequence, timestamp_ns, offset))
+            self.session, self.sequence = session, sequence
+            offset += RECORD_HEADER.size + length
+
+        self.data.truncate(offset)
+        self.data.flush()
+        self.index.flush()
+
+    def append(self, sequence, timestamp_ns, res, flags, payload):
+        if self.sequence is not None and sequence <= self.sequence:
+            self.session += 1
+        self.sequence = sequence
+
+        self.data.seek(0, os.SEEK_END)
+        offset = self.data.tell()
+        record = RECORD_HEADER.pack(RECORD_MAGIC, self.session, sequence, timestamp_ns, res, flags, 0,
+                                    len(payload), zlib.crc32(payload))
+        self.data.write(record)
+        self.data.write(payload)
+        # the record has to be in the data file before the index points at it
+        self.data.flush()
+        self.index.write(INDEX_ENTRY.pack(self.session, sequence, timestamp_ns, offset))
+        self.index.flush()
+
+    def close(self):
+        self.data.close()
+        self.index.close()
+
+
+class FrameStore:
+    # Read-only view of a store through mmap. Frames appended after opening show up after refresh().
+
+    def __init__(self, name):
+        self.data_file = open(name + ".frames", "rb")
+        self.index_file = open(name + ".idx", "rb")
+        _check_header(self.data_file, DATA_MAGIC)
+        _check_header(self.index_file, INDEX_MAGIC)
+        self.data = None
+        self.index = None
+        self.refresh()
+
+    def refresh(self):
+        self._unmap()
+        self.data = _map(self.data_file)
+        self.index = _map(self.index_file)
+        entries = ((len(self.index) - FILE_HEADER.size) // INDEX_ENTRY.size) if self.index else 0
+        # a writer may have indexed records past the end of the data mapped here; ignore them until the next refresh
+        while entries and not self._mapped(self._entry(entries - 1)[3]):
+            entries -= 1
+        self.entries = entries
+
+    def _mapped(self, offset):
+        if offset + RECORD_HEADER.size > len(self.data):
+            return False
+        return offset + RECORD_HEADER.size + RECORD_HEADER.unpack_from(self.data, offset)[7] <= len(self.data)
+
+    def _unmap(self):
+        for m in (self.data, self.index):
+            if m is not None:
+                m.close()
+
+    def _entry(self, i):
+        return INDEX_ENTRY.unpack_from(self.index, FILE_HEADER.size + i * INDEX_ENTRY.size)
+
+    def __len__(self):
+        return self.entries
+
+    def __getitem__(self, i):
+        if i < 0:
+            i += self.entries
+        if not 0 <= i < self.entries:
+            raise IndexError("frame index out of range")
+        offset = self._entry(i)[3]
+        _, session, sequence, timestamp_ns, res, flags, _, length, _ = RECORD_HEADER.unpack_from(self.data, offset)
+        start = offset + RECORD_HEADER.size
+        return Frame(session, sequence, timestamp_ns, res, flags, memoryview(self.data)[start:start + length])
+
+    def verify(self, i):
+        # check a stored payload against its CRC
+        offset = self._entry(i)[3]
+        record = RECORD_HEADER.unpack_from(self.data, offset)
+        start = offset + RECORD_HEADER.size
+        return zlib.crc32(memoryview(self.data)[start:start + record[7]]) == record[8]
+
+    def find_time(self, timestamp_ns):
+        # position of the first frame received at or after timestamp_ns (len(self) if none)
+        return bisect_left(range(self.entries), timestamp_ns, key=lambda i: self._entry(i)[2])
+
+    def find_sequence(self, sequence, session=None):
+        # position of the frame with this sequence number in a session (the last session by default), or None
+        if not self.entries:
+            return None
+        if session is None:
+            session = self._entry(self.entries - 1)[0]
+        i = bisect_left(range(self.entries), (session, sequence), key=lambda i: self._entry(i)[:2])
+        if i < self.entries and self._entry(i)[:2] == (session, sequence):
+            return i
+        return None
+
+    def close(self):
+        self._unmap()
+        self.data_file.close()
+        self.index_file.close()
@@ -22,11 +22,7 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 
-#include "ov2640.h"
-#include "ov2640_regs.h"
-
-#include <String.h>
-#include "stdio.h"
+#include "app.h"
 
 /* USER CODE END Includes */
 
@@ -37,6 +33,9 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+
+// Delay between camera captures (ms)
+#define CAPTURE_INTERVAL 5000
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -52,6 +51,7 @@ DMA_HandleTypeDef hdma_spi1_rx;
 DMA_HandleTypeDef hdma_spi1_tx;
 
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USER CODE BEGIN PV */
 
@@ -107,20 +107,17 @@ int main(void)
   MX_SPI1_Init();
   /* USER CODE BEGIN 2 */
 
-  ov2640 camera;
-  // buffer for UART transfers
-  char msg[6];
-
-  ov2640_register(&camera, GPIOA, GPIO_PIN_8, &hspi1, &hi2c1);
-
-  // Check the outcomes of these tests using the debugger to see if the camera works properly
-  uint8_t i2c_test = ov2640_test_i2c(&camera);
-  uint8_t spi_test = ov2640_test_spi(&camera);
-  ov2640_test_who_am_i(&camera);
-
-  // Initialize ov2640 and set desired resolution for pictures
-  ov2640_jpeg_init(&camera);
-  ov2640_jpeg_set_res(&camera, OV2640_RES_320x240);
+  // The capture/transfer loop lives in app.c, so it can also run on the host against the mock HAL (see app_host.c).
+  app_config config = {
+    .i2c = &hi2c1,
+    .spi = &hspi1,
+    .spi_dma_rx = &hdma_spi1_rx,
+    .spi_cs_port = GPIOA,
+    .spi_cs_pin = GPIO_PIN_8,
+    .uart = &huart2,
+    .capture_interval = CAPTURE_INTERVAL,
+  };
+  app_setup(&config);
 
   /* USER CODE END 2 */
 
@@ -132,49 +129,7 @@ int main(void)
 
     /* USER CODE BEGIN 3 */
 
-	// Keep trying until a valid capture is taken.
-	while(camera.fifo_length == 0) {
-	  ov2640_get_capture(&camera);
-	}
-
-	// Transfer and print out capture data, one buffer at a time.
-	ov2640_transfer_start(&camera);
-
-	// Can change buffer_length to camera.fifo_length if the resolution isn't HUGE.
-	// Buffer approach is done for the case where there isn't enough memory to hold the entire image at once.
-	uint16_t buffer_length = 1000;
-
-	while(camera.fifo_length > 0) {
-		uint8_t buffer[buffer_length];
-		uint16_t buffer_filled;
-
-		uint8_t use_dma = 1;
-		if(use_dma == 1) {
-			ov2640_transfer_step_dma(&camera, buffer, buffer_length, &buffer_filled);
-
-			// Do other things while DMA transfer happens.
-			HAL_Delay(100);
-
-			// update fifo_length when we know dma transfer is done.
-			while (HAL_DMA_GetState(&hdma_spi1_rx) != HAL_DMA_STATE_READY);
-			camera.fifo_length -= buffer_filled;
-		}
-		else {
-			ov2640_transfer_step(&camera, buffer, buffer_length, &buffer_filled);
-		}
-
-		// print out buffer data through Serial.
-		for(uint32_t i=0; i<buffer_filled; ++i) {
-			sprintf(msg, "%02X\r\n", buffer[i]);
-			HAL_UART_Transmit(&huart2, (uint8_t*)msg, strlen(msg), HAL_MAX_DELAY);
-		}
-	}
-
-	ov2640_transfer_stop(&camera);
-
-	// Delay between camera captures.
-	HAL_Delay(5000);
-
+    app_loop();
   }
   /* USER CODE END 3 */
 }
@@ -337,9 +292,13 @@ static void MX_DMA_Init(void)
 {
 
   /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
   __HAL_RCC_DMA2_CLK_ENABLE();
 
   /* DMA interrupt init */
+  /* DMA1_Stream6_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
   /* DMA2_Stream0_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
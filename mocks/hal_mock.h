@@ -4,8 +4,10 @@
 
 // Specific types of mocks to include
 #include "hal_mock_general.h"
+#include "hal_mock_dma.h"
 #include "hal_mock_gpio.h"
 #include "hal_mock_i2c.h"
 #include "hal_mock_spi.h"
+#include "hal_mock_uart.h"
 
 #endif  // HAL_MOCK_H
\ No newline at end of file
@@ -0,0 +1,42 @@
+// hal_mock_dma.c
+#include "hal_mock_dma.h"
+
+// Ends the transfer in flight like the stream's transfer complete interrupt, handing over to the peripheral
+static void dma_complete(void *Context) {
+  DMA_HandleTypeDef *hdma = (DMA_HandleTypeDef *)Context;
+  hdma->State = HAL_DMA_STATE_READY;
+  if(hdma->XferCpltCallback != NULL) {
+    hdma->XferCpltCallback(hdma);
+  }
+}
+
+// Returns the state of the stream
+// Polling a busy stream stands for the CPU spinning on it, so it moves simulated time on to the next scheduled event
+// (e.g. this transfer or another one completing); a loop polling until the stream is ready ends once its transfer is done.
+HAL_DMA_StateTypeDef HAL_DMA_GetState(DMA_HandleTypeDef *hdma) {
+  Mock_HAL_Run_Events();
+  if(hdma->State == HAL_DMA_STATE_BUSY) {
+    Mock_HAL_Run_Next_Event();
+  }
+  return hdma->State;
+}
+
+// Stops the transfer in flight without completing it
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma) {
+  if(hdma->State != HAL_DMA_STATE_BUSY) {
+    return HAL_ERROR;
+  }
+  Mock_HAL_Event_Cancel(&hdma->Complete);
+  hdma->State = HAL_DMA_STATE_READY;
+  return HAL_OK;
+}
+
+// Starts timing a transfer of the peripheral: the stream is busy for DurationNs of simulated time from now, then
+// completes through XferCpltCallback
+void Mock_DMA_Start(DMA_HandleTypeDef *hdma, uint64_t DurationNs) {
+  hdma->State = HAL_DMA_STATE_BUSY;
+  hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+  hdma->Complete.Fire = dma_complete;
+  hdma->Complete.Context = hdma;
+  Mock_HAL_Event_Schedule(&hdma->Complete, Mock_HAL_GetTimeNs() + DurationNs);
+}
@@ -0,0 +1,44 @@
+// hal_mock_dma.h
+#ifndef HAL_MOCK_DMA_H
+#define HAL_MOCK_DMA_H
+
+#include "hal_mock_general.h"
+
+#define HAL_DMA_ERROR_NONE                0x00000000U    // No error
+
+// Links a DMA handle to the peripheral handle using it, as done in HAL_PPP_MspInit
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__)  \
+  do {                                                                \
+    (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__);              \
+    (__DMA_HANDLE__).Parent = (__HANDLE__);                           \
+  } while(0U)
+
+// Mocked DMA typedefs
+typedef enum
+{
+  HAL_DMA_STATE_RESET      = 0x00U,  /*!< DMA not yet initialized or disabled */
+  HAL_DMA_STATE_READY      = 0x01U,  /*!< DMA initialized and ready for use   */
+  HAL_DMA_STATE_BUSY       = 0x02U,  /*!< DMA process is ongoing              */
+  HAL_DMA_STATE_TIMEOUT    = 0x03U,  /*!< DMA timeout state                   */
+  HAL_DMA_STATE_ERROR      = 0x04U,  /*!< DMA error state                     */
+  HAL_DMA_STATE_ABORT      = 0x05U,  /*!< DMA Abort state                     */
+} HAL_DMA_StateTypeDef;
+
+// A DMA stream; the mock doesn't move data itself, it only times transfers the peripheral mocks start on it
+typedef struct __DMA_HandleTypeDef
+{
+  __IO HAL_DMA_StateTypeDef  State;                                          // DMA transfer state
+  void                       *Parent;                                        // Peripheral handle using the stream
+  void                       (*XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);  // Transfer complete, set by the peripheral
+  __IO uint32_t              ErrorCode;                                      // DMA Error code
+  Mock_HAL_EventTypeDef      Complete;                                       // Completion of the transfer in flight
+} DMA_HandleTypeDef;
+
+// Mocked DMA functions
+HAL_DMA_StateTypeDef HAL_DMA_GetState(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma);
+
+// Functions for mock peripherals transferring through DMA
+void Mock_DMA_Start(DMA_HandleTypeDef *hdma, uint64_t DurationNs);
+
+#endif  // HAL_MOCK_DMA_H
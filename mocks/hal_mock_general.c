@@ -1,29 +1,370 @@
 // hal_mock_general.c
 #include "hal_mock_general.h"
+#include <errno.h>
+#include <string.h>
 
-// Simulate the initialization status of HAL as a global variable
-uint8_t hal_initialized = 0;
-// Simulate the passage of time as a global variable
-uint32_t hal_current_time = 0;
+// Board that threads run on until they select one, standing in for the single board there used to be
+static Mock_HAL_BoardTypeDef hal_default_board = MOCK_HAL_BOARD_DEFAULTS;
+_Thread_local Mock_HAL_BoardTypeDef *hal_board = &hal_default_board;
+
+// Sleeps until the wall clock has caught up with simulated time moving on from Now to Ns (running in real time)
+// Sleeps are paced from a common anchor rather than one after the other, so the overhead of many short ones (e.g. one per
+// UART frame) doesn't add up; the anchor moves up to Now once the simulation falls more than MOCK_HAL_REAL_TIME_SLACK
+// behind the wall clock (e.g. blocked on the host), rather than rushing to catch up.
+static void hal_sleep_through(uint64_t Now, uint64_t Ns) {
+  struct timespec wall;
+  clock_gettime(CLOCK_MONOTONIC, &wall);
+  int64_t wall_elapsed = (int64_t)(wall.tv_sec - hal_board->AnchorWall.tv_sec) * 1000000000LL + (wall.tv_nsec - hal_board->AnchorWall.tv_nsec);
+  if((Now < hal_board->AnchorNs) || (wall_elapsed - (int64_t)(Now - hal_board->AnchorNs) > (int64_t)MOCK_HAL_REAL_TIME_SLACK * 1000000LL)) {
+    hal_board->AnchorNs = Now;
+    hal_board->AnchorWall = wall;
+  }
+
+  uint64_t until = (uint64_t)hal_board->AnchorWall.tv_nsec + (Ns - hal_board->AnchorNs);
+  struct timespec deadline = {hal_board->AnchorWall.tv_sec + (time_t)(until / 1000000000ULL), (long)(until % 1000000000ULL)};
+  while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);
+}
+
+// Moves simulated time on to Ns (never back), sleeping through it if running in real time
+static void hal_advance_to(uint64_t Ns) {
+  uint64_t now = Mock_HAL_GetTimeNs();
+  if(Ns <= now) {
+    return;
+  }
+  if(hal_board->RealTime) {
+    hal_sleep_through(now, Ns);
+  }
+  hal_board->CurrentTime = (uint32_t)(Ns / 1000000U);
+  hal_board->CurrentTimeNs = (uint32_t)(Ns % 1000000U);
+}
+
+// Takes the first scheduled event off the queue if it's due by Ns, moving simulated time on to it, and fires it
+static uint8_t hal_run_event_by(uint64_t Ns) {
+  Mock_HAL_EventTypeDef *event = hal_board->Events;
+  if((event == NULL) || (event->DueNs > Ns)) {
+    return 0;
+  }
+  hal_board->Events = event->Next;
+  event->Next = NULL;
+  event->Scheduled = 0;
+  hal_advance_to(event->DueNs);
+  event->Fire(event->Context);
+  return 1;
+}
+
+// Sets up a board as it powers up: uninitialized, at simulated time 0, with nothing scheduled and no trace
+void Mock_HAL_Board_Init(Mock_HAL_BoardTypeDef *board) {
+  *board = (Mock_HAL_BoardTypeDef)MOCK_HAL_BOARD_DEFAULTS;
+}
+
+// Stops the board's bus trace, if it's recording one; run it on no thread afterwards
+void Mock_HAL_Board_DeInit(Mock_HAL_BoardTypeDef *board) {
+  if(board->Trace != NULL) {
+    fclose(board->Trace);
+    board->Trace = NULL;
+  }
+  pthread_mutex_destroy(&board->TraceLock);
+}
+
+// Runs the calling thread on board from now on (NULL: the default board)
+void Mock_HAL_Board_Select(Mock_HAL_BoardTypeDef *board) {
+  hal_board = (board != NULL) ? board : &hal_default_board;
+}
 
 void HAL_Init(void) {
   // Mock implementation for HAL_Init
-  hal_initialized = 1;
+  hal_board->Initialized = 1;
+  // Start over without anything scheduled by a previous user of the mock peripherals
+  hal_board->Events = NULL;
 }
 
 void HAL_Delay(uint32_t Delay) {
   // Check if the HAL has been left uninitialized
-  if(!hal_initialized) {
+  if(!hal_board->Initialized) {
     // Mock implementation: Handle uninitialized HAL as needed (exit early).
     return;  // Exit for an uninitialized HAL
   }
 
   // Mock implementation for HAL_Delay
 
-  uint32_t startTime = hal_current_time;
+  // Simulate the passage of time, with events due meanwhile happening at their time (like interrupts during the delay)
+  // Sleep for the duration of the delay if running in real time
+  uint64_t start = Mock_HAL_GetTimeNs();
+  uint64_t end = start + (uint64_t)Delay * 1000000U;
+  while(hal_run_event_by(end));
+  hal_advance_to(end);
+  Mock_HAL_Trace_Record(MOCK_HAL_TRACE_DELAY, HAL_OK, 0, start, end - start);
+}
+
+// Provides a tick value in milliseconds, the simulated time
+uint32_t HAL_GetTick(void) {
+  return hal_board->CurrentTime;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) {
+  return hal_board->Pclk1Freq;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void) {
+  return hal_board->Pclk2Freq;
+}
+
+// Starts a wait of up to Timeout ms on another thread (e.g. a slave device), which signals cond whenever the awaited state may have changed
+// In real time, the wait gives up after Timeout ms like the original polling mock did.
+// In virtual time, a wait that's satisfied costs no simulated time, while one that times out costs the full Timeout;
+// it still gives up after MOCK_HAL_VIRTUAL_WAIT_LIMIT real ms (or Timeout if shorter) as nothing answered by then.
+void Mock_HAL_Wait_Start(Mock_HAL_WaitTypeDef *wait, uint32_t Timeout) {
+  wait->Timeout = Timeout;
+
+  uint32_t limit = Timeout;
+  if(!hal_board->RealTime && (limit > MOCK_HAL_VIRTUAL_WAIT_LIMIT)) {
+    limit = MOCK_HAL_VIRTUAL_WAIT_LIMIT;
+  }
+  clock_gettime(CLOCK_REALTIME, &wait->Deadline);
+  wait->Deadline.tv_sec += limit / 1000;
+  wait->Deadline.tv_nsec += (long)(limit % 1000) * 1000000L;
+  if(wait->Deadline.tv_nsec >= 1000000000L) {
+    wait->Deadline.tv_sec++;
+    wait->Deadline.tv_nsec -= 1000000000L;
+  }
+}
+
+// Blocks (with lock held) until cond is signalled, or returns HAL_TIMEOUT once the wait has timed out
+// Call each time the awaited state isn't there yet.
+HAL_StatusTypeDef Mock_HAL_Wait_Step(Mock_HAL_WaitTypeDef *wait, pthread_cond_t *cond, pthread_mutex_t *lock) {
+  if(wait->Timeout == HAL_MAX_DELAY) {
+    pthread_cond_wait(cond, lock);
+    return HAL_OK;
+  }
+
+  if(pthread_cond_timedwait(cond, lock, &wait->Deadline) == ETIMEDOUT) {
+    if(!hal_board->RealTime) {
+      hal_board->CurrentTime += wait->Timeout;
+    }
+    return HAL_TIMEOUT;
+  }
+  return HAL_OK;
+}
+
+// Charges the time a peripheral spends on its bus: Bits at BitRate (bits/s), plus OverheadNs for setting up the transaction
+// A BitRate of 0 means the bus isn't timed. In real time, the transfer is also slept through.
+void Mock_HAL_Bus_Time(uint32_t Bits, uint32_t BitRate, uint32_t OverheadNs) {
+  if(BitRate == 0) {
+    return;
+  }
+
+  uint64_t ns = Mock_HAL_Bus_Ns(Bits, BitRate, OverheadNs);
+  if(hal_board->RealTime) {
+    uint64_t now = Mock_HAL_GetTimeNs();
+    hal_sleep_through(now, now + ns);
+  }
+
+  ns += hal_board->CurrentTimeNs;
+  hal_board->CurrentTime += (uint32_t)(ns / 1000000U);
+  hal_board->CurrentTimeNs = (uint32_t)(ns % 1000000U);
+}
+
+// Simulated time in ns, including what bus transfers have added since the last tick
+uint64_t Mock_HAL_GetTimeNs(void) {
+  return (uint64_t)hal_board->CurrentTime * 1000000U + hal_board->CurrentTimeNs;
+}
+
+// Time a peripheral spends on Bits at BitRate (bits/s) plus OverheadNs, in ns, without charging it (e.g. for a DMA transfer)
+uint64_t Mock_HAL_Bus_Ns(uint32_t Bits, uint32_t BitRate, uint32_t OverheadNs) {
+  if(BitRate == 0) {
+    return 0;
+  }
+  return ((uint64_t)Bits * 1000000000ULL) / BitRate + OverheadNs;
+}
+
+// Counts a transfer of Size bytes (Type: MOCK_HAL_FAULT_WRITE/READ) that took DurationNs in a bus's stats
+void Mock_HAL_Bus_Count(Mock_HAL_BusStatsTypeDef *stats, uint8_t Type, HAL_StatusTypeDef Status, uint16_t Size, uint64_t DurationNs) {
+  stats->Transfers[Type]++;
+  stats->Bytes[Type] += Size;
+  if(Status != HAL_OK) {
+    stats->Failed++;
+  }
+  stats->BusNs += DurationNs;
+}
+
+// Schedules an event to happen once simulated time reaches DueNs, after any other event due by then
+// Events happen when time is moved on by HAL_Delay or Mock_HAL_Run_Next_Event, or when Mock_HAL_Run_Events finds them due;
+// not in the middle of other HAL calls, so they can start new work on the peripherals like interrupt handlers would.
+// The event must stay in place until it has happened or been cancelled.
+void Mock_HAL_Event_Schedule(Mock_HAL_EventTypeDef *event, uint64_t DueNs) {
+  Mock_HAL_Event_Cancel(event);
+  event->DueNs = DueNs;
+  event->Scheduled = 1;
+
+  Mock_HAL_EventTypeDef **link = &hal_board->Events;
+  while((*link != NULL) && ((*link)->DueNs <= DueNs)) {
+    link = &(*link)->Next;
+  }
+  event->Next = *link;
+  *link = event;
+}
+
+// Takes an event off the queue without it happening, if it's scheduled
+void Mock_HAL_Event_Cancel(Mock_HAL_EventTypeDef *event) {
+  if(!event->Scheduled) {
+    return;
+  }
+  for(Mock_HAL_EventTypeDef **link = &hal_board->Events; *link != NULL; link = &(*link)->Next) {
+    if(*link == event) {
+      *link = event->Next;
+      break;
+    }
+  }
+  event->Next = NULL;
+  event->Scheduled = 0;
+}
+
+// Runs the events due by the current simulated time, e.g. from a main loop polling for what they do
+void Mock_HAL_Run_Events(void) {
+  while(hal_run_event_by(Mock_HAL_GetTimeNs()));
+}
 
-  // Simulate the passage of time
-  hal_current_time += Delay;
-  // Sleep for the duration of the delay
-  usleep(Delay * 1000);
-}
\ No newline at end of file
+// Moves simulated time on to the next scheduled event and runs it, standing for the CPU idling until then
+// Returns 0 if nothing is scheduled
+uint8_t Mock_HAL_Run_Next_Event(void) {
+  return hal_run_event_by(UINT64_MAX);
+}
+
+// Starts the fault generator over from its seed and clears the counts of injected faults
+void Mock_HAL_Faults_Reset(Mock_HAL_FaultsTypeDef *faults) {
+  // xorshift32 never leaves state 0, so seed 0 gets a fixed nonzero state instead
+  faults->Rand = (faults->Seed != 0) ? faults->Seed : 0x9E3779B9U;
+  faults->Errors = 0;
+  faults->Stalls = 0;
+  faults->BitFlips = 0;
+}
+
+// Returns 1 with a chance of Ppm parts per million, drawing from the fault generator (nothing drawn for a rate of 0)
+uint8_t Mock_HAL_Fault_Roll(Mock_HAL_FaultsTypeDef *faults, uint32_t Ppm) {
+  if(Ppm == 0) {
+    return 0;
+  }
+
+  uint32_t x = faults->Rand;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  faults->Rand = x;
+  return (x % 1000000U) < Ppm;
+}
+
+// Flips each bit of the Size bytes in pData with a chance of BitFlipPpm, as noise on the line would
+void Mock_HAL_Faults_Flip_Bits(Mock_HAL_FaultsTypeDef *faults, uint8_t *pData, uint16_t Size) {
+  if(faults->BitFlipPpm == 0) {
+    return;
+  }
+
+  for(uint16_t i = 0; i < Size; i++) {
+    for(uint8_t bit = 0; bit < 8; bit++) {
+      if(Mock_HAL_Fault_Roll(faults, faults->BitFlipPpm)) {
+        pData[i] ^= (uint8_t)(1U << bit);
+        faults->BitFlips++;
+      }
+    }
+  }
+}
+
+// Charges Ms of a peripheral waiting on a stalled device, like Mock_HAL_Bus_Time (no events happen meanwhile)
+void Mock_HAL_Stall(uint32_t Ms) {
+  uint64_t now = Mock_HAL_GetTimeNs();
+  if(hal_board->RealTime) {
+    hal_sleep_through(now, now + (uint64_t)Ms * 1000000U);
+  }
+  hal_board->CurrentTime += Ms;
+}
+
+// Starts recording a bus trace to the file at Path (replacing it): every delay, pin level change and bus transfer
+// the mock peripherals see from now on, with the phases code marks with Mock_HAL_Trace_Phase_Begin/End.
+// Stop it with Mock_HAL_Trace_Stop to have it all written out.
+HAL_StatusTypeDef Mock_HAL_Trace_Start(const char *Path) {
+  Mock_HAL_Trace_Stop();
+
+  FILE *trace = fopen(Path, "wb");
+  if(trace == NULL) {
+    return HAL_ERROR;
+  }
+  const uint32_t header[2] = {MOCK_HAL_TRACE_VERSION, sizeof(Mock_HAL_TraceRecordTypeDef)};
+  fwrite(MOCK_HAL_TRACE_MAGIC, 1, strlen(MOCK_HAL_TRACE_MAGIC), trace);
+  fwrite(header, sizeof(header), 1, trace);
+
+  pthread_mutex_lock(&hal_board->TraceLock);
+  hal_board->Trace = trace;
+  hal_board->TracePhaseCount = 0;
+  pthread_mutex_unlock(&hal_board->TraceLock);
+  return HAL_OK;
+}
+
+// Stops recording the bus trace, if one is being recorded, and closes its file
+void Mock_HAL_Trace_Stop(void) {
+  pthread_mutex_lock(&hal_board->TraceLock);
+  if(hal_board->Trace != NULL) {
+    fclose(hal_board->Trace);
+    hal_board->Trace = NULL;
+  }
+  pthread_mutex_unlock(&hal_board->TraceLock);
+}
+
+// Writes a record to the bus trace (with hal_board->TraceLock held), splitting durations that don't fit a record
+static void hal_trace_write(uint8_t Type, uint8_t Status, uint16_t Size, uint64_t StartNs, uint64_t DurationNs) {
+  do {
+    Mock_HAL_TraceRecordTypeDef record = {
+      .TimeNs = StartNs,
+      .DurationNs = (DurationNs > UINT32_MAX) ? UINT32_MAX : (uint32_t)DurationNs,
+      .Size = Size,
+      .Type = Type,
+      .Status = Status,
+    };
+    fwrite(&record, sizeof(record), 1, hal_board->Trace);
+    StartNs += record.DurationNs;
+    DurationNs -= record.DurationNs;
+  } while(DurationNs > 0);
+}
+
+// Records something a mock peripheral did (MOCK_HAL_TRACE_x), which started at StartNs and took DurationNs of
+// simulated time, in the bus trace if one is being recorded
+void Mock_HAL_Trace_Record(uint8_t Type, uint8_t Status, uint16_t Size, uint64_t StartNs, uint64_t DurationNs) {
+  pthread_mutex_lock(&hal_board->TraceLock);
+  if(hal_board->Trace != NULL) {
+    hal_trace_write(Type, Status, Size, StartNs, DurationNs);
+  }
+  pthread_mutex_unlock(&hal_board->TraceLock);
+}
+
+// Records a phase mark in the bus trace, naming the phase the first time it's seen
+// Phases are told apart by name, so a string literal per phase does; names past MOCK_HAL_TRACE_MAX_PHASES are dropped.
+static void hal_trace_phase(uint8_t Type, const char *Name) {
+  pthread_mutex_lock(&hal_board->TraceLock);
+  if(hal_board->Trace != NULL) {
+    uint8_t id = 0;
+    while((id < hal_board->TracePhaseCount) && (strcmp(hal_board->TracePhases[id], Name) != 0)) {
+      id++;
+    }
+    if((id == hal_board->TracePhaseCount) && (id < MOCK_HAL_TRACE_MAX_PHASES)) {
+      hal_board->TracePhases[id] = Name;
+      hal_board->TracePhaseCount++;
+      uint16_t length = (uint16_t)strlen(Name);
+      hal_trace_write(MOCK_HAL_TRACE_PHASE_NAME, id, length, Mock_HAL_GetTimeNs(), 0);
+      fwrite(Name, 1, length, hal_board->Trace);
+    }
+    if(id < hal_board->TracePhaseCount) {
+      hal_trace_write(Type, id, 0, Mock_HAL_GetTimeNs(), 0);
+    }
+  }
+  pthread_mutex_unlock(&hal_board->TraceLock);
+}
+
+// Marks the start of a phase of the code using the mock peripherals (e.g. a driver's init) in the bus trace
+// Phases nest: what the peripherals do counts towards the innermost phase begun and not yet ended.
+void Mock_HAL_Trace_Phase_Begin(const char *Name) {
+  hal_trace_phase(MOCK_HAL_TRACE_PHASE_BEGIN, Name);
+}
+
+// Marks the end of the phase begun with Name
+void Mock_HAL_Trace_Phase_End(const char *Name) {
+  hal_trace_phase(MOCK_HAL_TRACE_PHASE_END, Name);
+}
@@ -4,15 +4,35 @@
 
 // Common STD libraries to include
 #include <stdint.h>
+#include <stdio.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <time.h>
 
 // Mocked general HAL defines/macros
 #define     __I     volatile const       /*!< Defines 'read only' permissions */
 #define     __O     volatile             /*!< Defines 'write only' permissions */
 #define     __IO    volatile             /*!< Defines 'read / write' permissions */
 
+#define __weak  __attribute__((weak))   /*!< Callbacks the application may override */
+
 #define HAL_MAX_DELAY      0xFFFFFFFFU
 
+// Mock interrupts (events) only happen when simulated time is moved on, never in the middle of other code,
+// so there's nothing to mask
+#define __disable_irq()    do { } while(0)
+#define __enable_irq()     do { } while(0)
+
+// APB clocks set up by SystemClock_Config in main.c (60 MHz HCLK, APB1 divided by 2), feeding the peripherals' bit rates
+#define MOCK_HAL_PCLK1_FREQ   30000000U
+#define MOCK_HAL_PCLK2_FREQ   60000000U
+
+// Furthest simulated time may fall behind the wall clock when running in real time before it stops catching up (ms)
+#define MOCK_HAL_REAL_TIME_SLACK      100U
+
+// Longest a mock wait on another thread (e.g. a slave device) really waits before timing out in virtual time (ms)
+#define MOCK_HAL_VIRTUAL_WAIT_LIMIT   20U
+
 // Mocked general HAL typedefs
 typedef enum
 {
@@ -34,12 +54,152 @@ typedef enum
   HAL_LOCKED   = 0x01U  
 } HAL_LockTypeDef;
 
-// Global variables
-extern uint8_t hal_initialized;
-extern uint32_t hal_current_time;
+// State of a mock wait on another thread, see Mock_HAL_Wait_Start
+typedef struct
+{
+  uint32_t Timeout;          // Timeout given to the waiting HAL function (ms)
+  struct timespec Deadline;  // When to give up waiting (CLOCK_REALTIME, as used by pthread_cond_timedwait)
+} Mock_HAL_WaitTypeDef;
+
+// Something a mock peripheral has set to happen at a point in simulated time (e.g. a DMA transfer completing),
+// like an interrupt firing. See Mock_HAL_Event_Schedule
+typedef struct Mock_HAL_EventTypeDef
+{
+  uint64_t DueNs;                      // Simulated time it happens at (ns, see Mock_HAL_GetTimeNs)
+  void (*Fire)(void *Context);         // What happens, run on the thread that moves simulated time past DueNs
+  void *Context;
+  uint8_t Scheduled;                   // 1 while it's waiting to happen
+  struct Mock_HAL_EventTypeDef *Next;  // Next scheduled event, in order of DueNs
+} Mock_HAL_EventTypeDef;
+
+// Transaction types with their own fault rates (see Mock_HAL_FaultsTypeDef)
+#define MOCK_HAL_FAULT_WRITE          0U    // Master sending (SPI transmit, I2C master transmit)
+#define MOCK_HAL_FAULT_READ           1U    // Master receiving (SPI receive, I2C master receive)
+#define MOCK_HAL_FAULT_TYPES          2U
+
+// Faults a mock bus injects into the transfers of its attached slave device, so error recovery can be benchmarked
+// Rates are in parts per million. Faults are drawn from a generator seeded with Seed (see Mock_HAL_Faults_Reset),
+// so the same seed and the same transfers give the same faults.
+typedef struct
+{
+  uint32_t ErrorPpm[MOCK_HAL_FAULT_TYPES];  // Chance a transfer fails on the bus (I2C: NACK, SPI: error flag), per type
+  uint32_t StallPpm;                        // Chance the slave stalls a transfer, which times out after StallMs
+  uint32_t StallMs;                         //   (or the transfer's own timeout, if shorter)
+  uint32_t BitFlipPpm;                      // Chance each bit the master receives is flipped
+  uint32_t Seed;
+  // Kept by the mock: generator state and counts of faults injected since the last reset
+  uint32_t Rand;
+  uint32_t Errors;
+  uint32_t Stalls;
+  uint32_t BitFlips;
+} Mock_HAL_FaultsTypeDef;
+
+// What a mock bus has carried since its handle was last initialized, kept in the handle for benchmarks and tests
+typedef struct
+{
+  uint32_t Transfers[MOCK_HAL_FAULT_TYPES];  // Transfers the master started, per transaction type, failed ones included
+  uint32_t Bytes[MOCK_HAL_FAULT_TYPES];      // Bytes those transfers were for
+  uint32_t Failed;                           // Transfers that didn't return HAL_OK
+  uint64_t BusNs;                            // Simulated time they took (DMA transfers: the time their stream takes)
+} Mock_HAL_BusStatsTypeDef;
+
+// Kinds of records in a bus trace (see Mock_HAL_Trace_Start)
+#define MOCK_HAL_TRACE_DELAY          1U    // HAL_Delay
+#define MOCK_HAL_TRACE_GPIO           2U    // Pin written to a new level (Size: pin mask, Status: level)
+#define MOCK_HAL_TRACE_SPI_TX         3U    // Blocking SPI transfers (Size: bytes, Status: HAL_StatusTypeDef)
+#define MOCK_HAL_TRACE_SPI_RX         4U
+#define MOCK_HAL_TRACE_SPI_TX_DMA     5U    // SPI DMA transfers, recorded when started with the time the stream takes
+#define MOCK_HAL_TRACE_SPI_RX_DMA     6U
+#define MOCK_HAL_TRACE_I2C_TX         7U    // Blocking I2C master transfers (Size: bytes, Status: HAL_StatusTypeDef)
+#define MOCK_HAL_TRACE_I2C_RX         8U
+#define MOCK_HAL_TRACE_PHASE_NAME     9U    // Names phase Status, followed by its Size bytes of name (not terminated)
+#define MOCK_HAL_TRACE_PHASE_BEGIN    10U   // Phase Status entered or left, see Mock_HAL_Trace_Phase_Begin
+#define MOCK_HAL_TRACE_PHASE_END      11U
+
+#define MOCK_HAL_TRACE_MAGIC          "HALTRACE"
+#define MOCK_HAL_TRACE_VERSION        1U
+#define MOCK_HAL_TRACE_MAX_PHASES     32U   // Most phase names a trace tells apart
+
+// A bus trace is a header (MOCK_HAL_TRACE_MAGIC, then the version and the record size as 32-bit words) followed by
+// records in the order the calls they stand for returned, in host byte order
+typedef struct
+{
+  uint64_t TimeNs;      // Simulated time the call started at (ns, see Mock_HAL_GetTimeNs)
+  uint32_t DurationNs;  // Simulated time it took (longer delays are split over several records)
+  uint16_t Size;
+  uint8_t Type;         // MOCK_HAL_TRACE_x
+  uint8_t Status;
+} Mock_HAL_TraceRecordTypeDef;
+
+// A simulated board: what the general mock keeps for the code running on it (initialization, simulated time, scheduled
+// events, bus trace), so several boards can run in one process, each on its own thread.
+// A thread runs on the board it last selected with Mock_HAL_Board_Select; threads that never select one share a default
+// board, so code and tests that only ever run one board needn't know about boards. Mock peripherals and devices belong
+// to the board of the thread using them: a thread standing in for a device on a board (e.g. a slave thread) selects
+// that board too.
+typedef struct
+{
+  uint8_t Initialized;                                       // Set by HAL_Init
+  uint32_t CurrentTime;                                      // Simulated time (ms)
+  uint32_t CurrentTimeNs;                                    // Simulated time below a ms (ns), carried between bus transfers
+  uint8_t RealTime;                                          // 1: delays and timeouts are also slept through in real time
+  uint32_t Pclk1Freq;                                        // APB clock frequencies (Hz), which mock peripherals derive
+  uint32_t Pclk2Freq;                                        //   their bit rates from
+  Mock_HAL_EventTypeDef *Events;                             // Events scheduled by mock peripherals, in order of DueNs
+  uint64_t AnchorNs;                                         // Where simulated time and the wall clock (CLOCK_MONOTONIC)
+  struct timespec AnchorWall;                                //   were lined up when last running in real time
+  FILE *Trace;                                               // Bus trace being recorded (NULL: none)
+  const char *TracePhases[MOCK_HAL_TRACE_MAX_PHASES];        // Phase names the trace has seen, numbered in order of first use
+  uint8_t TracePhaseCount;
+  pthread_mutex_t TraceLock;                                 // Held while writing to the trace (master and slave threads)
+} Mock_HAL_BoardTypeDef;
+
+// A board as it powers up, for initializing one statically (see also Mock_HAL_Board_Init)
+#define MOCK_HAL_BOARD_DEFAULTS       {.Pclk1Freq = MOCK_HAL_PCLK1_FREQ, .Pclk2Freq = MOCK_HAL_PCLK2_FREQ, \
+                                       .TraceLock = PTHREAD_MUTEX_INITIALIZER}
+
+// Board the calling thread runs on
+extern _Thread_local Mock_HAL_BoardTypeDef *hal_board;
 
 // Mocked general HAL functions
 void HAL_Init(void);
 void HAL_Delay(uint32_t Delay);
+uint32_t HAL_GetTick(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+
+// Functions for running several simulated boards
+void Mock_HAL_Board_Init(Mock_HAL_BoardTypeDef *board);
+void Mock_HAL_Board_DeInit(Mock_HAL_BoardTypeDef *board);
+void Mock_HAL_Board_Select(Mock_HAL_BoardTypeDef *board);
+
+// Functions for mock peripherals waiting on another thread
+void Mock_HAL_Wait_Start(Mock_HAL_WaitTypeDef *wait, uint32_t Timeout);
+HAL_StatusTypeDef Mock_HAL_Wait_Step(Mock_HAL_WaitTypeDef *wait, pthread_cond_t *cond, pthread_mutex_t *lock);
+
+// Functions for mock peripherals taking time on their bus
+void Mock_HAL_Bus_Time(uint32_t Bits, uint32_t BitRate, uint32_t OverheadNs);
+uint64_t Mock_HAL_GetTimeNs(void);
+uint64_t Mock_HAL_Bus_Ns(uint32_t Bits, uint32_t BitRate, uint32_t OverheadNs);
+void Mock_HAL_Bus_Count(Mock_HAL_BusStatsTypeDef *stats, uint8_t Type, HAL_StatusTypeDef Status, uint16_t Size, uint64_t DurationNs);
+
+// Functions for mock peripherals doing work in the background of the code using them
+void Mock_HAL_Event_Schedule(Mock_HAL_EventTypeDef *event, uint64_t DueNs);
+void Mock_HAL_Event_Cancel(Mock_HAL_EventTypeDef *event);
+void Mock_HAL_Run_Events(void);
+uint8_t Mock_HAL_Run_Next_Event(void);
+
+// Functions for recording a trace of what the mock peripherals do
+HAL_StatusTypeDef Mock_HAL_Trace_Start(const char *Path);
+void Mock_HAL_Trace_Stop(void);
+void Mock_HAL_Trace_Record(uint8_t Type, uint8_t Status, uint16_t Size, uint64_t StartNs, uint64_t DurationNs);
+void Mock_HAL_Trace_Phase_Begin(const char *Name);
+void Mock_HAL_Trace_Phase_End(const char *Name);
+
+// Functions for mock peripherals injecting faults
+void Mock_HAL_Faults_Reset(Mock_HAL_FaultsTypeDef *faults);
+uint8_t Mock_HAL_Fault_Roll(Mock_HAL_FaultsTypeDef *faults, uint32_t Ppm);
+void Mock_HAL_Faults_Flip_Bits(Mock_HAL_FaultsTypeDef *faults, uint8_t *pData, uint16_t Size);
+void Mock_HAL_Stall(uint32_t Ms);
 
 #endif  // HAL_MOCK_GENERAL_H
@@ -1,5 +1,18 @@
 #include "hal_mock_gpio.h"
 
+// Pins watched by mock devices (a GPIO_TypeDef stands in for registers, so the watches are kept here instead)
+// Watches of all boards share the table, told apart by their port; gpio_lock keeps board threads from racing on it.
+typedef struct
+{
+    GPIO_TypeDef* GPIOx;
+    uint16_t GPIO_Pin;
+    Mock_GPIO_WatchCallbackTypeDef Callback;
+    void *Context;
+} gpio_watch;
+
+static gpio_watch gpio_watches[MOCK_GPIO_MAX_WATCHES];
+static pthread_mutex_t gpio_lock = PTHREAD_MUTEX_INITIALIZER;
+
 HAL_StatusTypeDef HAL_GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_Init)
 {
     if(GPIO_Init == NULL || GPIOx == NULL) {
@@ -8,7 +21,7 @@ HAL_StatusTypeDef HAL_GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_Init
     }
 
     // Check if the HAL has been left uninitialized
-    if(!hal_initialized) {
+    if(!hal_board->Initialized) {
       // Mock implementation: Handle uninitialized HAL as needed (return error value).
       return HAL_ERROR;  // Return error value for an uninitialized HAL
     }
@@ -31,7 +44,7 @@ GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
     }
 
     // Check if the HAL has been left uninitialized
-    if(!hal_initialized) {
+    if(!hal_board->Initialized) {
       // Mock implementation: Handle uninitialized HAL as needed (return a default value).
       return GPIO_PIN_RESET;  // Return a default value for an uninitialized HAL.
     }
@@ -66,7 +79,7 @@ void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState Pin
     }
 
     // Check if the HAL has been left uninitialized
-    if(!hal_initialized) {
+    if(!hal_board->Initialized) {
       // Mock implementation: Handle uninitialized HAL as needed (exit early).
       return;  // Exit early for an uninitialized HAL.
     }
@@ -78,6 +91,7 @@ void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState Pin
     }
 
     // Mock implementation of HAL_GPIO_WritePin.
+    uint32_t odr_before = GPIOx->ODR;
 
     // Simulate writing to ODR
     if (PinState != GPIO_PIN_RESET)
@@ -98,4 +112,67 @@ void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState Pin
       // Set IDR to match ODR after some delay (skipped for brevity).
       GPIOx->IDR &= ~GPIO_Pin;
     }
-}
\ No newline at end of file
+    // Pins changing level are edges on the wire, recorded in the bus trace
+    if((odr_before ^ GPIOx->ODR) & GPIO_Pin) {
+      Mock_HAL_Trace_Record(MOCK_HAL_TRACE_GPIO, (uint8_t)PinState, GPIO_Pin, Mock_HAL_GetTimeNs(), 0);
+    }
+    // Notify watchers of the pins written (also when the level stays the same, as a pin's power-up level is arbitrary)
+    // Callbacks run without gpio_lock held, as they may well write pins themselves
+    gpio_watch notify[MOCK_GPIO_MAX_WATCHES];
+    uint32_t notify_count = 0;
+    pthread_mutex_lock(&gpio_lock);
+    for(uint32_t i = 0; i < MOCK_GPIO_MAX_WATCHES; i++) {
+      if((gpio_watches[i].Callback != NULL) && (gpio_watches[i].GPIOx == GPIOx) && (gpio_watches[i].GPIO_Pin & GPIO_Pin)) {
+        notify[notify_count++] = gpio_watches[i];
+      }
+    }
+    pthread_mutex_unlock(&gpio_lock);
+    for(uint32_t i = 0; i < notify_count; i++) {
+      notify[i].Callback(notify[i].Context, PinState);
+    }
+}
+
+// Calls Callback with Context whenever GPIO_Pin of GPIOx is written through HAL_GPIO_WritePin
+// A pin has at most one watch; watching it again replaces the callback.
+HAL_StatusTypeDef Mock_GPIO_Watch(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, Mock_GPIO_WatchCallbackTypeDef Callback, void *Context)
+{
+    if(GPIOx == NULL || Callback == NULL || !IS_GPIO_PIN(GPIO_Pin)) {
+      return HAL_ERROR;
+    }
+
+    // Reuse the pin's watch if it has one, otherwise take a free slot
+    pthread_mutex_lock(&gpio_lock);
+    gpio_watch *slot = NULL;
+    for(uint32_t i = 0; i < MOCK_GPIO_MAX_WATCHES; i++) {
+      if((gpio_watches[i].Callback != NULL) && (gpio_watches[i].GPIOx == GPIOx) && (gpio_watches[i].GPIO_Pin == GPIO_Pin)) {
+        slot = &gpio_watches[i];
+        break;
+      }
+      if((slot == NULL) && (gpio_watches[i].Callback == NULL)) {
+        slot = &gpio_watches[i];
+      }
+    }
+    if(slot == NULL) {
+      pthread_mutex_unlock(&gpio_lock);
+      return HAL_ERROR;  // All watches in use
+    }
+
+    slot->GPIOx = GPIOx;
+    slot->GPIO_Pin = GPIO_Pin;
+    slot->Callback = Callback;
+    slot->Context = Context;
+    pthread_mutex_unlock(&gpio_lock);
+    return HAL_OK;
+}
+
+// Stops watching GPIO_Pin of GPIOx
+void Mock_GPIO_Unwatch(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
+{
+    pthread_mutex_lock(&gpio_lock);
+    for(uint32_t i = 0; i < MOCK_GPIO_MAX_WATCHES; i++) {
+      if((gpio_watches[i].GPIOx == GPIOx) && (gpio_watches[i].GPIO_Pin == GPIO_Pin)) {
+        gpio_watches[i].Callback = NULL;
+      }
+    }
+    pthread_mutex_unlock(&gpio_lock);
+}
@@ -50,9 +50,18 @@ typedef enum
   GPIO_PIN_SET
 } GPIO_PinState;
 
+#define MOCK_GPIO_MAX_WATCHES      32U  // Maximum number of pins watched at once, over all boards
+
+// Called when a watched pin is written through HAL_GPIO_WritePin (e.g. to let a mock slave device see its chip select)
+typedef void (*Mock_GPIO_WatchCallbackTypeDef)(void *Context, GPIO_PinState PinState);
+
 // Mocked GPIO functions
 HAL_StatusTypeDef HAL_GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_Init);
 GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
 void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
 
+// Functions for mock devices listening to pins
+HAL_StatusTypeDef Mock_GPIO_Watch(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, Mock_GPIO_WatchCallbackTypeDef Callback, void *Context);
+void Mock_GPIO_Unwatch(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
+
 #endif // HAL_MOCK_GPIO_H
@@ -3,6 +3,17 @@
 
 #include <string.h>
 
+// Master and slave sides run on different threads: every I2C state change is made under i2c_lock,
+// and i2c_state_changed wakes whoever is waiting on one (shared by all I2C handles, as handles may be uninitialized)
+static pthread_mutex_t i2c_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t i2c_state_changed = PTHREAD_COND_INITIALIZER;
+
+// Makes a state change visible to the other side and releases i2c_lock
+static void i2c_unlock_changed(void) {
+    pthread_cond_broadcast(&i2c_state_changed);
+    pthread_mutex_unlock(&i2c_lock);
+}
+
 // Check for common errors in the I2C HAL before proceeding with a I2C HAL function
 static HAL_StatusTypeDef common_i2c_checks(I2C_HandleTypeDef *hi2c) {
     // Catch invalid I2C handle
@@ -11,7 +22,7 @@ static HAL_StatusTypeDef common_i2c_checks(I2C_HandleTypeDef *hi2c) {
     }
     
     // Catch uninitialized HAL
-    if (!hal_initialized) {
+    if (!hal_board->Initialized) {
         hi2c->ErrorCode = HAL_I2C_ERROR_HAL_UNINITIALIZED;
         return HAL_ERROR;
     }
@@ -54,15 +65,19 @@ HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c) {
         return status;
     }
 
+    pthread_mutex_lock(&i2c_lock);
+
     // Clear data relating to any previous messages
     hi2c->XferAddress = 0;
     memset(hi2c->MsgBuff, 0, sizeof(hi2c->MsgBuff));
     hi2c->MsgSize = 0;
+    memset(&hi2c->Stats, 0, sizeof(hi2c->Stats));
 
     // Set I2C to a ready state; can perform transactions now
     hi2c->State = HAL_I2C_STATE_READY;
     hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
 
+    i2c_unlock_changed();
     return HAL_OK;
 }
 
@@ -74,6 +89,8 @@ HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c) {
         return status;
     }
 
+    pthread_mutex_lock(&i2c_lock);
+
     // Clear data relating to any previous messages
     hi2c->XferAddress = 0;
     memset(hi2c->MsgBuff, 0, sizeof(hi2c->MsgBuff));
@@ -83,11 +100,62 @@ HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c) {
     hi2c->State = HAL_I2C_STATE_RESET;
     hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
 
+    i2c_unlock_changed();
     return HAL_OK;
 }
 
-// Transmit in master mode an amount of data in blocking mode
-HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+// Charges the time a transfer of Size data bytes takes at the configured clock speed:
+// 9 clocks (8 bits and ACK) for the address byte and every data byte, plus the start and stop conditions
+static void i2c_bus_time(I2C_HandleTypeDef *hi2c, uint16_t Size) {
+    Mock_HAL_Bus_Time(((uint32_t)Size + 1U) * 9U + 2U, hi2c->Init.ClockSpeed, MOCK_I2C_TRANSACTION_NS);
+}
+
+// Records a transfer the master made in the bus trace and the handle's stats
+static void i2c_record(I2C_HandleTypeDef *hi2c, uint8_t TraceType, uint8_t Type, HAL_StatusTypeDef status, uint16_t Size, uint64_t start, uint64_t duration) {
+    Mock_HAL_Trace_Record(TraceType, status, Size, start, duration);
+    if(hi2c != NULL) {
+        Mock_HAL_Bus_Count(&hi2c->Stats, Type, status, Size, duration);
+    }
+}
+
+// Runs a transfer on an attached slave device: NACKed if nothing answers to DevAddress or the device refuses it
+// A NACKed transfer only takes the bus for its address byte
+static HAL_StatusTypeDef i2c_slave_transfer(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t Size, HAL_StatusTypeDef device_status) {
+    hi2c->XferAddress = DevAddress;
+    if(device_status != HAL_OK) {
+        hi2c->ErrorCode = HAL_I2C_ERROR_NACK;
+        i2c_bus_time(hi2c, 0);
+        return HAL_ERROR;
+    }
+    hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+    i2c_bus_time(hi2c, Size);
+    return HAL_OK;
+}
+
+// Injects the faults set with Mock_I2C_Set_Faults into a transfer with the attached slave device, before the device sees it
+// A stalled transfer (the slave holding the clock low) takes the stall (up to Timeout) and returns HAL_TIMEOUT.
+// Otherwise returns the status the device should answer with: HAL_ERROR NACKs the transfer.
+static HAL_StatusTypeDef i2c_device_fault(I2C_HandleTypeDef *hi2c, uint8_t Type, uint32_t Timeout) {
+    Mock_HAL_FaultsTypeDef *faults = hi2c->Faults;
+    if(faults == NULL) {
+        return HAL_OK;
+    }
+
+    if(Mock_HAL_Fault_Roll(faults, faults->StallPpm)) {
+        faults->Stalls++;
+        Mock_HAL_Stall((faults->StallMs < Timeout) ? faults->StallMs : Timeout);
+        hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+        return HAL_TIMEOUT;
+    }
+    if(Mock_HAL_Fault_Roll(faults, faults->ErrorPpm[Type])) {
+        faults->Errors++;
+        return HAL_ERROR;
+    }
+    return HAL_OK;
+}
+
+// Does the work of HAL_I2C_Master_Transmit
+static HAL_StatusTypeDef i2c_master_transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout)
 {
     // Check for common errors
     HAL_StatusTypeDef status = common_i2c_checks(hi2c);
@@ -101,15 +169,32 @@ HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevA
         return transaction_status;
     }
 
+    // An attached slave device takes the data straight away, unless a fault is injected
+    if(hi2c->Slave != NULL) {
+        HAL_StatusTypeDef device_status = i2c_device_fault(hi2c, MOCK_HAL_FAULT_WRITE, Timeout);
+        if(device_status == HAL_TIMEOUT) {
+            return HAL_ERROR;
+        }
+        if(DevAddress != hi2c->SlaveAddress) {
+            device_status = HAL_ERROR;
+        }
+        if((device_status == HAL_OK) && (hi2c->Slave->on_write != NULL)) {
+            device_status = hi2c->Slave->on_write(hi2c->SlaveContext, pData, Size);
+        }
+        return i2c_slave_transfer(hi2c, DevAddress, Size, device_status);
+    }
+
     // Wait for any ongoing I2C transactions to finish before transmitting data
     // Time out if the waiting process takes too long
+    pthread_mutex_lock(&i2c_lock);
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, Timeout);
     while(hi2c->State != HAL_I2C_STATE_READY) {
-        if(Timeout == 0) {
+        if(Mock_HAL_Wait_Step(&wait, &i2c_state_changed, &i2c_lock) != HAL_OK) {
             hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+            pthread_mutex_unlock(&i2c_lock);
             return HAL_ERROR;
         }
-        usleep(1000);
-        Timeout--;
     }
 
     // Simulate transaction by copying data to the message buffer, access using MsgBuff and MsgSize
@@ -122,11 +207,22 @@ HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevA
     // Clear error code to indicate successful transfer
     hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
 
+    i2c_unlock_changed();
+    i2c_bus_time(hi2c, Size);
     return HAL_OK;
 }
 
-// Receive in master mode an amount of data in blocking mode
-HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+// Transmit in master mode an amount of data in blocking mode
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    uint64_t start = Mock_HAL_GetTimeNs();
+    HAL_StatusTypeDef status = i2c_master_transmit(hi2c, DevAddress, pData, Size, Timeout);
+    i2c_record(hi2c, MOCK_HAL_TRACE_I2C_TX, MOCK_HAL_FAULT_WRITE, status, Size, start, Mock_HAL_GetTimeNs() - start);
+    return status;
+}
+
+// Does the work of HAL_I2C_Master_Receive
+static HAL_StatusTypeDef i2c_master_receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout)
 {
     // Check for common errors
     HAL_StatusTypeDef status = common_i2c_checks(hi2c);
@@ -140,18 +236,44 @@ HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAd
         return transaction_status;
     }
 
-    // Indicate through MsgSize the amount of data requested
+    // An attached slave device answers straight away, unless a fault is injected; injected bit flips corrupt its answer
+    if(hi2c->Slave != NULL) {
+        HAL_StatusTypeDef device_status = i2c_device_fault(hi2c, MOCK_HAL_FAULT_READ, Timeout);
+        if(device_status == HAL_TIMEOUT) {
+            return HAL_ERROR;
+        }
+        if(DevAddress != hi2c->SlaveAddress) {
+            device_status = HAL_ERROR;
+        }
+        if(device_status == HAL_OK) {
+            if(hi2c->Slave->on_read != NULL) {
+                device_status = hi2c->Slave->on_read(hi2c->SlaveContext, pData, Size);
+            }
+            else {
+                memset(pData, 0xFF, Size);
+            }
+            if(hi2c->Faults != NULL) {
+                Mock_HAL_Faults_Flip_Bits(hi2c->Faults, pData, Size);
+            }
+        }
+        return i2c_slave_transfer(hi2c, DevAddress, Size, device_status);
+    }
+
+    // Indicate through MsgSize the amount of data requested, letting a waiting slave know
+    pthread_mutex_lock(&i2c_lock);
     hi2c->MsgSize = Size;
+    pthread_cond_broadcast(&i2c_state_changed);
 
     // Wait for slave to send data to I2C before receiving data
     // Time out if the waiting process takes too long
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, Timeout);
     while(hi2c->State != HAL_I2C_STATE_BUSY_RX) {
-        if(Timeout == 0) {
+        if(Mock_HAL_Wait_Step(&wait, &i2c_state_changed, &i2c_lock) != HAL_OK) {
             hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+            pthread_mutex_unlock(&i2c_lock);
             return HAL_ERROR;
         }
-        usleep(1000);
-        Timeout--;
     }
 
     // Simulate transaction by copying data from the message buffer to the input buffer, access using pData and MsgSize
@@ -165,11 +287,23 @@ HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAd
     // Clear MsgSize to indicate that the requested data has been received
     hi2c->MsgSize = 0;
 
+    i2c_unlock_changed();
+    i2c_bus_time(hi2c, Size);
     return HAL_OK;
 }
 
+// Receive in master mode an amount of data in blocking mode
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    uint64_t start = Mock_HAL_GetTimeNs();
+    HAL_StatusTypeDef status = i2c_master_receive(hi2c, DevAddress, pData, Size, Timeout);
+    i2c_record(hi2c, MOCK_HAL_TRACE_I2C_RX, MOCK_HAL_FAULT_READ, status, Size, start, Mock_HAL_GetTimeNs() - start);
+    return status;
+}
+
 // Transmit data from mock slave device for master to receive
 // Is called before HAL_I2C_Master_Receive
+// Gives up if the I2C is deinitialized while waiting for the master
 HAL_StatusTypeDef Mock_I2C_Slave_Transmit(I2C_HandleTypeDef *hi2c, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
     // Check for common errors
     HAL_StatusTypeDef status = common_i2c_checks(hi2c);
@@ -185,18 +319,26 @@ HAL_StatusTypeDef Mock_I2C_Slave_Transmit(I2C_HandleTypeDef *hi2c, uint8_t *pDat
 
     // Wait for any ongoing I2C transactions to finish before transmitting data
     // Time out if the waiting process takes too long
+    pthread_mutex_lock(&i2c_lock);
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, Timeout);
     while(hi2c->State != HAL_I2C_STATE_READY) {
-        if(Timeout == 0) {
+        if(hi2c->State == HAL_I2C_STATE_RESET) {
+            hi2c->ErrorCode = HAL_I2C_ERROR_UNINITIALIZED;
+            pthread_mutex_unlock(&i2c_lock);
+            return HAL_ERROR;
+        }
+        if(Mock_HAL_Wait_Step(&wait, &i2c_state_changed, &i2c_lock) != HAL_OK) {
             hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+            pthread_mutex_unlock(&i2c_lock);
             return HAL_ERROR;
         }
-        usleep(1000);
-        Timeout--;
     }
 
     // Check that the size of the message to be sent is the one requested by the master
     if(Size != hi2c->MsgSize) {
         hi2c->ErrorCode = HAL_I2C_ERROR_SIZE_MISMATCH;
+        pthread_mutex_unlock(&i2c_lock);
         return HAL_ERROR;
     }
 
@@ -207,11 +349,13 @@ HAL_StatusTypeDef Mock_I2C_Slave_Transmit(I2C_HandleTypeDef *hi2c, uint8_t *pDat
     // Clear error code to indicate successful transfer
     hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
 
+    i2c_unlock_changed();
     return HAL_OK;
 }
 
 // Receive data on mock slave device from master transmit
 // Is called after HAL_I2C_Master_Transmit
+// Gives up if the I2C is deinitialized while waiting for the master
 HAL_StatusTypeDef Mock_I2C_Slave_Receive(I2C_HandleTypeDef *hi2c, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
     // Check for common errors
     HAL_StatusTypeDef status = common_i2c_checks(hi2c);
@@ -227,18 +371,26 @@ HAL_StatusTypeDef Mock_I2C_Slave_Receive(I2C_HandleTypeDef *hi2c, uint8_t *pData
 
     // Wait for master to send data to I2C before receiving data
     // Time out if the waiting process takes too long
+    pthread_mutex_lock(&i2c_lock);
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, Timeout);
     while(hi2c->State != HAL_I2C_STATE_BUSY_TX) {
-        if(Timeout == 0) {
+        if(hi2c->State == HAL_I2C_STATE_RESET) {
+            hi2c->ErrorCode = HAL_I2C_ERROR_UNINITIALIZED;
+            pthread_mutex_unlock(&i2c_lock);
+            return HAL_ERROR;
+        }
+        if(Mock_HAL_Wait_Step(&wait, &i2c_state_changed, &i2c_lock) != HAL_OK) {
             hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+            pthread_mutex_unlock(&i2c_lock);
             return HAL_ERROR;
         }
-        usleep(1000);
-        Timeout--;
     }
 
     // Check that the size of the message to be received is the one sent by the master
     if(Size != hi2c->MsgSize) {
         hi2c->ErrorCode = HAL_I2C_ERROR_SIZE_MISMATCH;
+        pthread_mutex_unlock(&i2c_lock);
         return HAL_ERROR;
     }
 
@@ -249,5 +401,72 @@ HAL_StatusTypeDef Mock_I2C_Slave_Receive(I2C_HandleTypeDef *hi2c, uint8_t *pData
     // Clear error code to indicate successful transfer
     hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
 
+    i2c_unlock_changed();
     return HAL_OK;
-}
\ No newline at end of file
+}
+
+// Block the mock slave device until the master transmits (returns straight away while a transmit is waiting to be received)
+// Returns HAL_ERROR if the I2C is deinitialized meanwhile (e.g. to stop a slave thread) or the wait times out
+HAL_StatusTypeDef Mock_I2C_Slave_Wait(I2C_HandleTypeDef *hi2c, uint32_t Timeout) {
+    // Check for common errors
+    HAL_StatusTypeDef status = common_i2c_checks(hi2c);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    pthread_mutex_lock(&i2c_lock);
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, Timeout);
+    while(hi2c->State != HAL_I2C_STATE_BUSY_TX) {
+        if(hi2c->State == HAL_I2C_STATE_RESET) {
+            hi2c->ErrorCode = HAL_I2C_ERROR_UNINITIALIZED;
+            pthread_mutex_unlock(&i2c_lock);
+            return HAL_ERROR;
+        }
+        if(Mock_HAL_Wait_Step(&wait, &i2c_state_changed, &i2c_lock) != HAL_OK) {
+            hi2c->ErrorCode = HAL_I2C_ERROR_TIMEOUT;
+            pthread_mutex_unlock(&i2c_lock);
+            return HAL_ERROR;
+        }
+    }
+    pthread_mutex_unlock(&i2c_lock);
+
+    return HAL_OK;
+}
+
+// Attach a slave device answering to DevAddress, that the master-side functions call directly instead of handing
+// transactions to a slave thread; transfers to any other address are NACKed
+// The handle keeps the attachment across HAL_I2C_Init/HAL_I2C_DeInit, like the wiring it stands for.
+HAL_StatusTypeDef Mock_I2C_Attach_Slave(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, const Mock_I2C_SlaveTypeDef *Slave, void *Context) {
+    if((hi2c == NULL) || (Slave == NULL)) {
+        return HAL_ERROR;
+    }
+
+    hi2c->Slave = Slave;
+    hi2c->SlaveContext = Context;
+    hi2c->SlaveAddress = DevAddress;
+    return HAL_OK;
+}
+
+// Detach the slave device, handing transactions to a slave thread again
+void Mock_I2C_Detach_Slave(I2C_HandleTypeDef *hi2c) {
+    if(hi2c == NULL) {
+        return;
+    }
+
+    hi2c->Slave = NULL;
+    hi2c->SlaveContext = NULL;
+}
+
+// Inject Faults into the transfers with the attached slave device from now on, starting its generator over from its seed
+// NULL stops injecting faults. Faults stay set until changed, like the attachment itself.
+void Mock_I2C_Set_Faults(I2C_HandleTypeDef *hi2c, Mock_HAL_FaultsTypeDef *Faults) {
+    if(hi2c == NULL) {
+        return;
+    }
+
+    if(Faults != NULL) {
+        Mock_HAL_Faults_Reset(Faults);
+    }
+    hi2c->Faults = Faults;
+}
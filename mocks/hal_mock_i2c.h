@@ -14,9 +14,13 @@
 #define HAL_I2C_ERROR_MSG_TOO_BIG         104U    // I2C message too big error
 #define HAL_I2C_ERROR_TIMEOUT             105U    // I2C timeout error
 #define HAL_I2C_ERROR_SIZE_MISMATCH       106U    // I2C size mismatch error
+#define HAL_I2C_ERROR_NACK                107U    // I2C not acknowledged by a slave device
 
 #define MOCK_I2C_MAX_MSG_SIZE             256U    // Maximum I2C transfer size
 
+// Time the master spends setting up and finishing each blocking transfer besides clocking bits (HAL call, event polling), in ns
+#define MOCK_I2C_TRANSACTION_NS           5000U
+
 // I2C state enumeration
 typedef enum
 {
@@ -27,13 +31,32 @@ typedef enum
   HAL_I2C_STATE_ERROR             = 4U    /*!< Error                                     */
 } HAL_I2C_StateTypeDef;
 
+// Slave device answering the master from within the master-side HAL functions, without a slave thread
+// Callbacks run on the master's thread and get back the Context given to Mock_I2C_Attach_Slave; either may be NULL
+// Returning anything but HAL_OK NACKs the transfer.
+typedef struct {
+    HAL_StatusTypeDef (*on_write)(void *Context, const uint8_t *pData, uint16_t Size);  // Master transmitted Size bytes from pData
+    HAL_StatusTypeDef (*on_read)(void *Context, uint8_t *pData, uint16_t Size);         // Master receives Size bytes, to be put in pData
+} Mock_I2C_SlaveTypeDef;
+
+// I2C configuration; only what the mock makes use of
+typedef struct {
+    uint32_t ClockSpeed;    // Bus clock in Hz (e.g. 100000 for standard mode); 0 leaves the bus untimed
+} I2C_InitTypeDef;
+
 // I2C handle structure
 typedef struct {
+    I2C_InitTypeDef             Init;                               // I2C communication parameters
     uint16_t                    XferAddress;                        // I2C target device address
     uint8_t                     MsgBuff[MOCK_I2C_MAX_MSG_SIZE];     // I2C transfer message buffer
     uint16_t                    MsgSize;                            // I2C transfer message size
     __IO HAL_I2C_StateTypeDef   State;                              // I2C communication state
     __IO uint32_t               ErrorCode;                          // I2C Error code
+    const Mock_I2C_SlaveTypeDef *Slave;                             // Attached slave device (NULL: slave side is a thread)
+    void                        *SlaveContext;                      // Context passed to the slave device's callbacks
+    uint16_t                    SlaveAddress;                       // Address the slave device answers to
+    Mock_HAL_FaultsTypeDef      *Faults;                            // Faults injected into the slave device's transfers (NULL: none)
+    Mock_HAL_BusStatsTypeDef    Stats;                              // Transfers made since HAL_I2C_Init
 } I2C_HandleTypeDef;
 
 // Mock function declarations
@@ -45,5 +68,9 @@ HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAd
 // Functions for slave device interactivity with the mock I2C
 HAL_StatusTypeDef Mock_I2C_Slave_Transmit(I2C_HandleTypeDef *hi2c, uint8_t *pData, uint16_t Size, uint32_t Timeout);
 HAL_StatusTypeDef Mock_I2C_Slave_Receive(I2C_HandleTypeDef *hi2c, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef Mock_I2C_Slave_Wait(I2C_HandleTypeDef *hi2c, uint32_t Timeout);
+HAL_StatusTypeDef Mock_I2C_Attach_Slave(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, const Mock_I2C_SlaveTypeDef *Slave, void *Context);
+void Mock_I2C_Detach_Slave(I2C_HandleTypeDef *hi2c);
+void Mock_I2C_Set_Faults(I2C_HandleTypeDef *hi2c, Mock_HAL_FaultsTypeDef *Faults);
 
 #endif // HAL_MOCK_I2C_H
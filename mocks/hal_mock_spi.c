@@ -2,6 +2,113 @@
 #include "hal_mock_spi.h"
 #include <string.h>
 
+// Master and slave sides run on different threads: every SPI state change is made under spi_lock,
+// and spi_state_changed wakes whoever is waiting on one (shared by all SPI handles, as handles may be uninitialized)
+static pthread_mutex_t spi_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t spi_state_changed = PTHREAD_COND_INITIALIZER;
+
+// Makes a state change visible to the other side and releases spi_lock
+static void spi_unlock_changed(void) {
+    pthread_cond_broadcast(&spi_state_changed);
+    pthread_mutex_unlock(&spi_lock);
+}
+
+// Bit rate the master clocks the bus at, set by its prescaler
+static uint32_t spi_bit_rate(SPI_HandleTypeDef *hspi) {
+    uint32_t divider = 2U << ((hspi->Init.BaudRatePrescaler >> 3) & 0x07U);
+    return HAL_RCC_GetPCLK2Freq() / divider;
+}
+
+// Charges the time the master takes to clock Size bytes
+static void spi_bus_time(SPI_HandleTypeDef *hspi, uint16_t Size) {
+    Mock_HAL_Bus_Time((uint32_t)Size * 8U, spi_bit_rate(hspi), MOCK_SPI_TRANSACTION_NS);
+}
+
+// Records a transfer the master made in the bus trace and the handle's stats
+static void spi_record(SPI_HandleTypeDef *hspi, uint8_t TraceType, uint8_t Type, HAL_StatusTypeDef status, uint16_t Size, uint64_t start, uint64_t duration) {
+    Mock_HAL_Trace_Record(TraceType, status, Size, start, duration);
+    if(hspi != NULL) {
+        Mock_HAL_Bus_Count(&hspi->Stats, Type, status, Size, duration);
+    }
+}
+
+// Drops any transfer offered by the master
+static void spi_clear_transfers(SPI_HandleTypeDef *hspi) {
+    hspi->pTxBuffPtr = NULL;
+    hspi->TxXferSize = 0;
+    hspi->TxXferCount = 0;
+    hspi->pRxBuffPtr = NULL;
+    hspi->RxXferSize = 0;
+    hspi->RxXferCount = 0;
+}
+
+// Injects the faults set with Mock_SPI_Set_Faults into a transfer of Size bytes with the attached slave device
+// A stalled transfer times out, taking the stall (up to Timeout); a failing one takes its bus time, but the slave never
+// sees it. Either way, returns HAL_ERROR without the transfer happening.
+static HAL_StatusTypeDef spi_device_fault(SPI_HandleTypeDef *hspi, uint8_t Type, uint16_t Size, uint32_t Timeout) {
+    Mock_HAL_FaultsTypeDef *faults = hspi->Faults;
+    if(faults == NULL) {
+        return HAL_OK;
+    }
+
+    if(Mock_HAL_Fault_Roll(faults, faults->StallPpm)) {
+        faults->Stalls++;
+        Mock_HAL_Stall((faults->StallMs < Timeout) ? faults->StallMs : Timeout);
+        hspi->ErrorCode = HAL_SPI_ERROR_TIMEOUT;
+        return HAL_ERROR;
+    }
+    if(Mock_HAL_Fault_Roll(faults, faults->ErrorPpm[Type])) {
+        faults->Errors++;
+        spi_bus_time(hspi, Size);
+        hspi->ErrorCode = HAL_SPI_ERROR_FAULT;
+        return HAL_ERROR;
+    }
+    return HAL_OK;
+}
+
+// Hands data from the master to the attached slave device, unless a DMA transfer is still in flight or a fault is injected
+static HAL_StatusTypeDef spi_device_transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    if(hspi->State != HAL_SPI_STATE_READY) {
+        hspi->ErrorCode = HAL_SPI_ERROR_BUSY;
+        return HAL_BUSY;
+    }
+    if(spi_device_fault(hspi, MOCK_HAL_FAULT_WRITE, Size, Timeout) != HAL_OK) {
+        return HAL_ERROR;
+    }
+
+    if(hspi->Slave->on_write != NULL) {
+        hspi->Slave->on_write(hspi->SlaveContext, pData, Size);
+    }
+    hspi->TxXferSize = Size;
+    hspi->ErrorCode = HAL_SPI_ERROR_NONE;
+    return HAL_OK;
+}
+
+// Gets data for the master from the attached slave device (an idle MISO line reads as 0xFF), unless a DMA transfer is still in flight
+// or a fault is injected. Injected bit flips corrupt the data on its way to the master.
+static HAL_StatusTypeDef spi_device_receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    if(hspi->State != HAL_SPI_STATE_READY) {
+        hspi->ErrorCode = HAL_SPI_ERROR_BUSY;
+        return HAL_BUSY;
+    }
+    if(spi_device_fault(hspi, MOCK_HAL_FAULT_READ, Size, Timeout) != HAL_OK) {
+        return HAL_ERROR;
+    }
+
+    if(hspi->Slave->on_read != NULL) {
+        hspi->Slave->on_read(hspi->SlaveContext, pData, Size);
+    }
+    else {
+        memset(pData, 0xFF, Size);
+    }
+    if(hspi->Faults != NULL) {
+        Mock_HAL_Faults_Flip_Bits(hspi->Faults, pData, Size);
+    }
+    hspi->RxXferSize = Size;
+    hspi->ErrorCode = HAL_SPI_ERROR_NONE;
+    return HAL_OK;
+}
+
 // Check for common errors in the SPI HAL before proceeding with a SPI HAL function
 static HAL_StatusTypeDef common_spi_checks(SPI_HandleTypeDef *hspi) {
   // Catch invalid SPI handle
@@ -10,7 +117,7 @@ static HAL_StatusTypeDef common_spi_checks(SPI_HandleTypeDef *hspi) {
   }
 
   // Catch uninitialized HAL
-  if(!hal_initialized) {
+  if(!hal_board->Initialized) {
     hspi->ErrorCode = HAL_SPI_ERROR_HAL_UNINITIALIZED;
     return HAL_ERROR;
   }
@@ -20,8 +127,8 @@ static HAL_StatusTypeDef common_spi_checks(SPI_HandleTypeDef *hspi) {
 
 // Check for common errors in the SPI HAL before proceeding with a SPI HAL function that involves a transaction
 static HAL_StatusTypeDef common_spi_transaction_checks(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size) {
-  // Catch null pData
-  if(pData == NULL) {
+  // Catch null or empty pData
+  if((pData == NULL) || (Size == 0)) {
     hspi->ErrorCode = HAL_SPI_ERROR_NULL_PARAM;
     return HAL_ERROR;
   }
@@ -36,18 +143,12 @@ static HAL_StatusTypeDef common_spi_transaction_checks(SPI_HandleTypeDef *hspi,
     return HAL_ERROR;
   }
 
-  // Check if the size of the message is too big for the mock msg buffer
-  if(Size >= MOCK_SPI_MAX_MSG_SIZE) {
-    hspi->ErrorCode = HAL_SPI_ERROR_MSG_TOO_BIG;
-    return HAL_ERROR;
-  }
-
   return HAL_OK; // No error
 }
 
 // Initializes the SPI peripheral
 // Assumes a default configuration (master, 8-bit data size, 2 lines, low polarity, 1 edge phase, software NSS, MSB first, TI mode disabled, and CRC calculation disabled) to focus on logic
-// Baudrate is omitted for this implementation for similar reasons
+// Init.BaudRatePrescaler is used: each transfer takes the time its bytes need at PCLK2 over the prescaler (see spi_bit_rate)
 HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi) {
     // Check for common errors
     HAL_StatusTypeDef status = common_spi_checks(hspi);
@@ -55,16 +156,17 @@ HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi) {
         return status;
     }
 
-    // Clear data relating to any previous messages
-    memset(hspi->TxMsgBuff, 0, sizeof(hspi->TxMsgBuff));
-    hspi->TxMsgSize = 0;
-    memset(hspi->RxMsgBuff, 0, sizeof(hspi->RxMsgBuff));
-    hspi->RxMsgSize = 0;
+    pthread_mutex_lock(&spi_lock);
+
+    // Forget any previous transfers
+    spi_clear_transfers(hspi);
+    memset(&hspi->Stats, 0, sizeof(hspi->Stats));
 
     // Set SPI to a ready state; can perform transactions now
     hspi->State = HAL_SPI_STATE_READY;
     hspi->ErrorCode = HAL_SPI_ERROR_NONE;
 
+    spi_unlock_changed();
     return HAL_OK;
 }
 
@@ -76,22 +178,73 @@ HAL_StatusTypeDef HAL_SPI_DeInit(SPI_HandleTypeDef *hspi) {
         return status;
     }
 
-    // Clear data relating to any previous messages
-    memset(hspi->TxMsgBuff, 0, sizeof(hspi->TxMsgBuff));
-    hspi->TxMsgSize = 0;
-    memset(hspi->RxMsgBuff, 0, sizeof(hspi->RxMsgBuff));
-    hspi->RxMsgSize = 0;
+    // Stop any DMA transfer in flight, it won't complete anymore
+    if(hspi->hdmatx != NULL) {
+        HAL_DMA_Abort(hspi->hdmatx);
+    }
+    if(hspi->hdmarx != NULL) {
+        HAL_DMA_Abort(hspi->hdmarx);
+    }
+
+    pthread_mutex_lock(&spi_lock);
+
+    // Forget any previous transfers
+    spi_clear_transfers(hspi);
 
     // Set SPI to a reset state; cannot perform transactions now
     hspi->State = HAL_SPI_STATE_RESET;
     hspi->ErrorCode = HAL_SPI_ERROR_NONE;
 
+    spi_unlock_changed();
     return HAL_OK;
 }
 
-// Transmit an amount of data in blocking mode
-// Call Mock_SPI_Slave_Receive on slave end after calling this function to finish transaction
-HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+// Waits (with spi_lock held) until the SPI is in the given state, for a master or slave function
+// On failure, sets the error code and releases spi_lock: the SPI was deinitialized, or the wait timed out
+static HAL_StatusTypeDef spi_wait_for(SPI_HandleTypeDef *hspi, HAL_SPI_StateTypeDef State, Mock_HAL_WaitTypeDef *wait) {
+    while(hspi->State != State) {
+        if(hspi->State == HAL_SPI_STATE_RESET) {
+            hspi->ErrorCode = HAL_SPI_ERROR_UNINITIALIZED;
+            pthread_mutex_unlock(&spi_lock);
+            return HAL_ERROR;
+        }
+        if(Mock_HAL_Wait_Step(wait, &spi_state_changed, &spi_lock) != HAL_OK) {
+            hspi->ErrorCode = HAL_SPI_ERROR_TIMEOUT;
+            pthread_mutex_unlock(&spi_lock);
+            return HAL_ERROR;
+        }
+    }
+    return HAL_OK;
+}
+
+// Offers the master transfer set up in the handle to the slave thread, and waits (with spi_lock held) until the slave has done all of it
+// The slave streams straight from/to the master's buffer, so the transfer can't outlive this call: if it fails, what's left of it is withdrawn.
+static HAL_StatusTypeDef spi_master_transfer(SPI_HandleTypeDef *hspi, HAL_SPI_StateTypeDef State, Mock_HAL_WaitTypeDef *wait) {
+    // Change state to indicate that a master transfer has started
+    hspi->State = State;
+    pthread_cond_broadcast(&spi_state_changed);
+
+    if(spi_wait_for(hspi, HAL_SPI_STATE_READY, wait) != HAL_OK) {
+        pthread_mutex_lock(&spi_lock);
+        spi_clear_transfers(hspi);
+        if(hspi->State == State) {
+            hspi->State = HAL_SPI_STATE_READY;
+        }
+        spi_unlock_changed();
+        return HAL_ERROR;
+    }
+
+    // Clear error code to indicate successful transfer
+    hspi->ErrorCode = HAL_SPI_ERROR_NONE;
+    uint16_t size = (State == HAL_SPI_STATE_BUSY_TX) ? hspi->TxXferSize : hspi->RxXferSize;
+
+    spi_unlock_changed();
+    spi_bus_time(hspi, size);
+    return HAL_OK;
+}
+
+// Does the work of HAL_SPI_Transmit
+static HAL_StatusTypeDef spi_transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
     // Check for common errors
     HAL_StatusTypeDef status = common_spi_checks(hspi);
     if (status != HAL_OK) {
@@ -104,38 +257,125 @@ HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint
         return transaction_status;
     }
 
-    // Wait for any ongoing SPI transactions to finish before transmitting data
-    // Time out if the waiting process takes too long
-    while(hspi->State != HAL_SPI_STATE_READY) {
-        if(Timeout == 0) {
-            hspi->ErrorCode = HAL_SPI_ERROR_TIMEOUT;
-            return HAL_ERROR;
+    // An attached slave device takes the data straight away
+    if(hspi->Slave != NULL) {
+        status = spi_device_transmit(hspi, pData, Size, Timeout);
+        if(status == HAL_OK) {
+            spi_bus_time(hspi, Size);
         }
-        usleep(1000);
-        Timeout--;
+        return status;
     }
 
-    // Simulate transaction by copying data to the message buffer, access using TxMsgBuff and TxMsgSize
-    memcpy(hspi->TxMsgBuff, pData, Size);
-    // Record size of the message to be used in slave receive
-    hspi->TxMsgSize = Size;
-    // Change state to indicate that a master transmit has started
-    hspi->State = HAL_SPI_STATE_BUSY_TX;
-    // Clear error code to indicate successful initiation of transfer
-    hspi->ErrorCode = HAL_SPI_ERROR_NONE;
+    // Wait for any ongoing SPI transactions to finish before transmitting data
+    // Time out if the waiting process (including the slave taking the data) takes too long
+    pthread_mutex_lock(&spi_lock);
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, Timeout);
+    if(spi_wait_for(hspi, HAL_SPI_STATE_READY, &wait) != HAL_OK) {
+        return HAL_ERROR;
+    }
+
+    // Simulate transaction by letting the slave read straight from pData, access using pTxBuffPtr, TxXferSize and TxXferCount
+    hspi->pTxBuffPtr = pData;
+    hspi->TxXferSize = Size;
+    hspi->TxXferCount = Size;
+
+    return spi_master_transfer(hspi, HAL_SPI_STATE_BUSY_TX, &wait);
+}
+
+// Transmit an amount of data in blocking mode
+// Returns once the slave has received all of it through Mock_SPI_Slave_Receive, or straight away if a slave device is attached
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    uint64_t start = Mock_HAL_GetTimeNs();
+    HAL_StatusTypeDef status = spi_transmit(hspi, pData, Size, Timeout);
+    spi_record(hspi, MOCK_HAL_TRACE_SPI_TX, MOCK_HAL_FAULT_WRITE, status, Size, start, Mock_HAL_GetTimeNs() - start);
+    return status;
+}
+
+// Ends a DMA transfer of the SPI once its stream completes, like the real HAL's DMA complete handlers
+static void spi_dma_transmit_cplt(DMA_HandleTypeDef *hdma) {
+    SPI_HandleTypeDef *hspi = (SPI_HandleTypeDef *)hdma->Parent;
+    pthread_mutex_lock(&spi_lock);
+    hspi->State = HAL_SPI_STATE_READY;
+    spi_unlock_changed();
+    HAL_SPI_TxCpltCallback(hspi);
+}
+
+static void spi_dma_receive_cplt(DMA_HandleTypeDef *hdma) {
+    SPI_HandleTypeDef *hspi = (SPI_HandleTypeDef *)hdma->Parent;
+    pthread_mutex_lock(&spi_lock);
+    hspi->State = HAL_SPI_STATE_READY;
+    spi_unlock_changed();
+    HAL_SPI_RxCpltCallback(hspi);
+}
+
+// Starts timing a DMA transfer of the SPI on hdma, which completes through Cplt after DurationNs of simulated time
+static void spi_dma_start(SPI_HandleTypeDef *hspi, DMA_HandleTypeDef *hdma, void (*Cplt)(DMA_HandleTypeDef *hdma), uint64_t DurationNs) {
+    hdma->Parent = hspi;
+    hdma->XferCpltCallback = Cplt;
+    Mock_DMA_Start(hdma, DurationNs);
+}
+
+// Check for errors in the SPI HAL before starting a DMA transfer on hdma
+static HAL_StatusTypeDef common_spi_dma_checks(SPI_HandleTypeDef *hspi, DMA_HandleTypeDef *hdma, uint8_t *pData, uint16_t Size) {
+    // Check for common errors
+    HAL_StatusTypeDef status = common_spi_checks(hspi);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    // Check for common transaction errors
+    HAL_StatusTypeDef transaction_status = common_spi_transaction_checks(hspi, pData, Size);
+    if (transaction_status != HAL_OK) {
+        return transaction_status;
+    }
+
+    // Catch a stream still busy with the previous transfer
+    if(hdma->State == HAL_DMA_STATE_BUSY) {
+        hspi->ErrorCode = HAL_SPI_ERROR_BUSY;
+        return HAL_BUSY;
+    }
 
     return HAL_OK;
 }
 
 // Transmit an amount of data in DMA mode
-// Is the same as HAL_SPI_Transmit for the purpose of our mock
+// With a DMA stream linked (hdmatx), the transfer completes in the background of the caller, calling HAL_SPI_TxCpltCallback:
+// an attached slave device takes the data straight away, then the SPI stays busy until the stream is done in simulated time.
+// A slave thread takes the data before this returns (it streams straight from pData), so the stream completes straight away.
+// Without a stream linked, this is the same as HAL_SPI_Transmit.
 HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size) {
-    return HAL_SPI_Transmit(hspi, pData, Size, HAL_MAX_DELAY);
+    if((hspi == NULL) || (hspi->hdmatx == NULL)) {
+        return HAL_SPI_Transmit(hspi, pData, Size, HAL_MAX_DELAY);
+    }
+
+    HAL_StatusTypeDef status = common_spi_dma_checks(hspi, hspi->hdmatx, pData, Size);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    if(hspi->Slave == NULL) {
+        status = HAL_SPI_Transmit(hspi, pData, Size, HAL_MAX_DELAY);
+        if(status == HAL_OK) {
+            spi_dma_start(hspi, hspi->hdmatx, spi_dma_transmit_cplt, 0);
+        }
+        return status;
+    }
+
+    uint64_t start = Mock_HAL_GetTimeNs();
+    status = spi_device_transmit(hspi, pData, Size, HAL_MAX_DELAY);
+    uint64_t duration = Mock_HAL_GetTimeNs() - start;
+    if(status == HAL_OK) {
+        hspi->State = HAL_SPI_STATE_BUSY_TX;
+        duration = Mock_HAL_Bus_Ns((uint32_t)Size * 8U, spi_bit_rate(hspi), MOCK_SPI_TRANSACTION_NS);
+        spi_dma_start(hspi, hspi->hdmatx, spi_dma_transmit_cplt, duration);
+    }
+    spi_record(hspi, MOCK_HAL_TRACE_SPI_TX_DMA, MOCK_HAL_FAULT_WRITE, status, Size, start, duration);
+    return status;
 }
 
-// Receive an amount of data in blocking mode
-// Call Mock_SPI_Slave_Transmit on slave end after calling this function to finish transaction
-HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+// Does the work of HAL_SPI_Receive
+static HAL_StatusTypeDef spi_receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
     // Check for common errors
     HAL_StatusTypeDef status = common_spi_checks(hspi);
     if (status != HAL_OK) {
@@ -148,40 +388,89 @@ HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint1
         return transaction_status;
     }
 
-    // Indicate through RxMsgSize the amount of data requested
-    hspi->RxMsgSize = Size;
-
-    // Wait for slave to send data to SPI before receiving data
-    // Time out if the waiting process takes too long
-    while(hspi->State != HAL_SPI_STATE_BUSY_RX) {
-        if(Timeout == 0) {
-            hspi->ErrorCode = HAL_SPI_ERROR_TIMEOUT;
-            return HAL_ERROR;
+    // An attached slave device answers straight away
+    if(hspi->Slave != NULL) {
+        status = spi_device_receive(hspi, pData, Size, Timeout);
+        if(status == HAL_OK) {
+            spi_bus_time(hspi, Size);
         }
-        usleep(1000);
-        Timeout--;
+        return status;
     }
 
-    // Simulate transaction by copying data from the message buffer, access using pData and Size
-    memcpy(pData, hspi->RxMsgBuff, Size);
-    // Change state to indicate that the data sent from slave has been received
-    hspi->State = HAL_SPI_STATE_READY;
-    // Clear error code to indicate successful transfer
-    hspi->ErrorCode = HAL_SPI_ERROR_NONE;
-    // Clear RxMsgSize to indicate that the requested data has been received
-    hspi->RxMsgSize = 0;
+    // Wait for any ongoing SPI transactions to finish before receiving data
+    // Time out if the waiting process (including the slave sending the data) takes too long
+    pthread_mutex_lock(&spi_lock);
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, Timeout);
+    if(spi_wait_for(hspi, HAL_SPI_STATE_READY, &wait) != HAL_OK) {
+        return HAL_ERROR;
+    }
 
-    return HAL_OK;
+    // Simulate transaction by letting the slave write straight to pData, access using pRxBuffPtr, RxXferSize and RxXferCount
+    hspi->pRxBuffPtr = pData;
+    hspi->RxXferSize = Size;
+    hspi->RxXferCount = Size;
+
+    return spi_master_transfer(hspi, HAL_SPI_STATE_BUSY_RX, &wait);
+}
+
+// Receive an amount of data in blocking mode
+// Returns once the slave has sent all of it through Mock_SPI_Slave_Transmit, or straight away if a slave device is attached
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    uint64_t start = Mock_HAL_GetTimeNs();
+    HAL_StatusTypeDef status = spi_receive(hspi, pData, Size, Timeout);
+    spi_record(hspi, MOCK_HAL_TRACE_SPI_RX, MOCK_HAL_FAULT_READ, status, Size, start, Mock_HAL_GetTimeNs() - start);
+    return status;
 }
 
 // Receive an amount of data in DMA mode
-// Is the same as HAL_SPI_Receive for the purpose of our mock
+// With a DMA stream linked (hdmarx), the transfer completes in the background of the caller, calling HAL_SPI_RxCpltCallback:
+// an attached slave device puts the data in pData straight away, then the SPI stays busy until the stream is done in
+// simulated time. A slave thread sends the data before this returns, so the stream completes straight away.
+// Without a stream linked, this is the same as HAL_SPI_Receive.
 HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size) {
-    return HAL_SPI_Receive(hspi, pData, Size, HAL_MAX_DELAY);
+    if((hspi == NULL) || (hspi->hdmarx == NULL)) {
+        return HAL_SPI_Receive(hspi, pData, Size, HAL_MAX_DELAY);
+    }
+
+    HAL_StatusTypeDef status = common_spi_dma_checks(hspi, hspi->hdmarx, pData, Size);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    if(hspi->Slave == NULL) {
+        status = HAL_SPI_Receive(hspi, pData, Size, HAL_MAX_DELAY);
+        if(status == HAL_OK) {
+            spi_dma_start(hspi, hspi->hdmarx, spi_dma_receive_cplt, 0);
+        }
+        return status;
+    }
+
+    uint64_t start = Mock_HAL_GetTimeNs();
+    status = spi_device_receive(hspi, pData, Size, HAL_MAX_DELAY);
+    uint64_t duration = Mock_HAL_GetTimeNs() - start;
+    if(status == HAL_OK) {
+        hspi->State = HAL_SPI_STATE_BUSY_RX;
+        duration = Mock_HAL_Bus_Ns((uint32_t)Size * 8U, spi_bit_rate(hspi), MOCK_SPI_TRANSACTION_NS);
+        spi_dma_start(hspi, hspi->hdmarx, spi_dma_receive_cplt, duration);
+    }
+    spi_record(hspi, MOCK_HAL_TRACE_SPI_RX_DMA, MOCK_HAL_FAULT_READ, status, Size, start, duration);
+    return status;
+}
+
+// Transfer complete callbacks, called from the DMA stream's completion; override them to act on it, as with the real HAL
+__weak void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+    (void)hspi;
+}
+
+__weak void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi) {
+    (void)hspi;
 }
 
 // Transmit data from mock slave device for master to receive
-// Is called before HAL_SPI_Receive or HAL_SPI_Receive_DMA
+// Waits for HAL_SPI_Receive or HAL_SPI_Receive_DMA, then copies straight into the master's buffer
+// A receive can be answered in several pieces; the master returns once it has all the data it asked for
+// Gives up if the SPI is deinitialized while waiting for the master
 HAL_StatusTypeDef Mock_SPI_Slave_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
     // Check for common errors
     HAL_StatusTypeDef status = common_spi_checks(hspi);
@@ -195,35 +484,40 @@ HAL_StatusTypeDef Mock_SPI_Slave_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pDat
         return transaction_status;
     }
 
-    // Wait for any ongoing SPI transactions to finish before transmitting data
+    // Wait for the master to request data before transmitting data
     // Time out if the waiting process takes too long
-    while(hspi->State != HAL_SPI_STATE_READY) {
-        if(Timeout == 0) {
-            hspi->ErrorCode = HAL_SPI_ERROR_TIMEOUT;
-            return HAL_ERROR;
-        }
-        usleep(1000);
-        Timeout--;
+    pthread_mutex_lock(&spi_lock);
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, Timeout);
+    if(spi_wait_for(hspi, HAL_SPI_STATE_BUSY_RX, &wait) != HAL_OK) {
+        return HAL_ERROR;
     }
 
-    // Check that the size of the message to be sent is the one requested by the master
-    if(Size != hspi->RxMsgSize) {
+    // Check that the message to be sent fits in what's left of the master's request
+    if(Size > hspi->RxXferCount) {
         hspi->ErrorCode = HAL_SPI_ERROR_SIZE_MISMATCH;
+        pthread_mutex_unlock(&spi_lock);
         return HAL_ERROR;
     }
 
-    // Simulate transaction by copying data to the message buffer, access using RxMsgBuff and RxMsgSize
-    memcpy(hspi->RxMsgBuff, pData, Size);
-    // Change state to indicate that a master receive is expected
-    hspi->State = HAL_SPI_STATE_BUSY_RX;
+    // Simulate transaction by copying data straight to the master's buffer
+    memcpy(hspi->pRxBuffPtr + (hspi->RxXferSize - hspi->RxXferCount), pData, Size);
+    hspi->RxXferCount -= Size;
+    // Change state to indicate that the master has received all the data it asked for
+    if(hspi->RxXferCount == 0) {
+        hspi->State = HAL_SPI_STATE_READY;
+    }
     // Clear error code to indicate successful transfer
     hspi->ErrorCode = HAL_SPI_ERROR_NONE;
 
+    spi_unlock_changed();
     return HAL_OK;
 }
 
 // Receive data on mock slave device from master transmit
-// Is called after HAL_SPI_Transmit or HAL_SPI_Transmit_DMA
+// Waits for HAL_SPI_Transmit or HAL_SPI_Transmit_DMA, then copies straight from the master's buffer
+// A transmit can be taken in several pieces; the master returns once all of its data has been taken
+// Gives up if the SPI is deinitialized while waiting for the master
 HAL_StatusTypeDef Mock_SPI_Slave_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
     // Check for common errors
     HAL_StatusTypeDef status = common_spi_checks(hspi);
@@ -239,27 +533,113 @@ HAL_StatusTypeDef Mock_SPI_Slave_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData
 
     // Wait for master to send data to SPI before receiving data
     // Time out if the waiting process takes too long
-    while(hspi->State != HAL_SPI_STATE_BUSY_TX) {
-        if(Timeout == 0) {
-            hspi->ErrorCode = HAL_SPI_ERROR_TIMEOUT;
-            return HAL_ERROR;
-        }
-        usleep(1000);
-        Timeout--;
+    pthread_mutex_lock(&spi_lock);
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, Timeout);
+    if(spi_wait_for(hspi, HAL_SPI_STATE_BUSY_TX, &wait) != HAL_OK) {
+        return HAL_ERROR;
     }
 
-    // Check that the size of the message to be received is the one sent by the master
-    if(Size != hspi->TxMsgSize) {
+    // Check that the message to be received doesn't go past what's left of the master's data
+    if(Size > hspi->TxXferCount) {
         hspi->ErrorCode = HAL_SPI_ERROR_SIZE_MISMATCH;
+        pthread_mutex_unlock(&spi_lock);
         return HAL_ERROR;
     }
 
-    // Simulate transaction by copying data from the message buffer, access using pData and Size
-    memcpy(pData, hspi->TxMsgBuff, Size);
-    // Change state to indicate that the data sent from master has been received
-    hspi->State = HAL_SPI_STATE_READY;
+    // Simulate transaction by copying data straight from the master's buffer
+    memcpy(pData, hspi->pTxBuffPtr + (hspi->TxXferSize - hspi->TxXferCount), Size);
+    hspi->TxXferCount -= Size;
+    // Change state to indicate that all data sent from master has been received
+    if(hspi->TxXferCount == 0) {
+        hspi->State = HAL_SPI_STATE_READY;
+    }
     // Clear error code to indicate successful transfer
     hspi->ErrorCode = HAL_SPI_ERROR_NONE;
 
+    spi_unlock_changed();
+    return HAL_OK;
+}
+
+// Block the mock slave device until the master starts a transaction: a transmit to receive, or a receive to answer
+// Returns HAL_ERROR if the SPI is deinitialized meanwhile (e.g. to stop a slave thread) or the wait times out
+HAL_StatusTypeDef Mock_SPI_Slave_Wait(SPI_HandleTypeDef *hspi, uint32_t Timeout) {
+    // Check for common errors
+    HAL_StatusTypeDef status = common_spi_checks(hspi);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    pthread_mutex_lock(&spi_lock);
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, Timeout);
+    while((hspi->State != HAL_SPI_STATE_BUSY_TX) && (hspi->State != HAL_SPI_STATE_BUSY_RX)) {
+        if(hspi->State == HAL_SPI_STATE_RESET) {
+            hspi->ErrorCode = HAL_SPI_ERROR_UNINITIALIZED;
+            pthread_mutex_unlock(&spi_lock);
+            return HAL_ERROR;
+        }
+        if(Mock_HAL_Wait_Step(&wait, &spi_state_changed, &spi_lock) != HAL_OK) {
+            hspi->ErrorCode = HAL_SPI_ERROR_TIMEOUT;
+            pthread_mutex_unlock(&spi_lock);
+            return HAL_ERROR;
+        }
+    }
+    pthread_mutex_unlock(&spi_lock);
+
     return HAL_OK;
-}
\ No newline at end of file
+}
+
+// Forwards writes to the chip select of an attached slave device
+static void spi_slave_cs_written(void *Context, GPIO_PinState PinState) {
+    SPI_HandleTypeDef *hspi = Context;
+    if(hspi->Slave->on_cs != NULL) {
+        hspi->Slave->on_cs(hspi->SlaveContext, PinState == GPIO_PIN_RESET);
+    }
+}
+
+// Attach a slave device that the master-side functions call directly, instead of handing transactions to a slave thread
+// If CsPort isn't NULL, the device is told about every write to its (active-low) chip select CsPin.
+// The handle keeps the attachment across HAL_SPI_Init/HAL_SPI_DeInit, like the wiring it stands for.
+HAL_StatusTypeDef Mock_SPI_Attach_Slave(SPI_HandleTypeDef *hspi, const Mock_SPI_SlaveTypeDef *Slave, void *Context, GPIO_TypeDef *CsPort, uint16_t CsPin) {
+    if((hspi == NULL) || (Slave == NULL)) {
+        return HAL_ERROR;
+    }
+
+    if((CsPort != NULL) && (Mock_GPIO_Watch(CsPort, CsPin, spi_slave_cs_written, hspi) != HAL_OK)) {
+        return HAL_ERROR;
+    }
+
+    hspi->Slave = Slave;
+    hspi->SlaveContext = Context;
+    hspi->SlaveCsPort = CsPort;
+    hspi->SlaveCsPin = CsPin;
+    return HAL_OK;
+}
+
+// Detach the slave device, handing transactions to a slave thread again
+void Mock_SPI_Detach_Slave(SPI_HandleTypeDef *hspi) {
+    if(hspi == NULL) {
+        return;
+    }
+
+    if(hspi->SlaveCsPort != NULL) {
+        Mock_GPIO_Unwatch(hspi->SlaveCsPort, hspi->SlaveCsPin);
+    }
+    hspi->Slave = NULL;
+    hspi->SlaveContext = NULL;
+    hspi->SlaveCsPort = NULL;
+}
+
+// Inject Faults into the transfers with the attached slave device from now on, starting its generator over from its seed
+// NULL stops injecting faults. Faults stay set until changed, like the attachment itself.
+void Mock_SPI_Set_Faults(SPI_HandleTypeDef *hspi, Mock_HAL_FaultsTypeDef *Faults) {
+    if(hspi == NULL) {
+        return;
+    }
+
+    if(Faults != NULL) {
+        Mock_HAL_Faults_Reset(Faults);
+    }
+    hspi->Faults = Faults;
+}
@@ -3,6 +3,8 @@
 #define HAL_MOCK_SPI_H
 
 #include "hal_mock_general.h"
+#include "hal_mock_dma.h"
+#include "hal_mock_gpio.h"
 
 #define HAL_SPI_ERROR_NONE                0U    // No error
 #define HAL_SPI_ERROR_HAL_UNINITIALIZED   10U    // HAL uninitialized error
@@ -11,11 +13,22 @@
 #define HAL_SPI_ERROR_UNINITIALIZED       101U    // SPI uninitialized error
 #define HAL_SPI_ERROR_BUSY                102U    // SPI busy error
 #define HAL_SPI_ERROR_FAILSTATE           103U    // SPI failstate error
-#define HAL_SPI_ERROR_MSG_TOO_BIG         104U    // SPI message too big error
 #define HAL_SPI_ERROR_TIMEOUT             105U    // SPI timeout error
 #define HAL_SPI_ERROR_SIZE_MISMATCH       106U    // SPI size mismatch error
+#define HAL_SPI_ERROR_FAULT               107U    // SPI transfer failed on the bus (injected fault, e.g. overrun)
 
-#define MOCK_SPI_MAX_MSG_SIZE             256U    // Maximum I2C transfer size
+// SPI clock prescalers (from the APB2 clock), with the same values as the real HAL
+#define SPI_BAUDRATEPRESCALER_2           0x00000000U
+#define SPI_BAUDRATEPRESCALER_4           0x00000008U
+#define SPI_BAUDRATEPRESCALER_8           0x00000010U
+#define SPI_BAUDRATEPRESCALER_16          0x00000018U
+#define SPI_BAUDRATEPRESCALER_32          0x00000020U
+#define SPI_BAUDRATEPRESCALER_64          0x00000028U
+#define SPI_BAUDRATEPRESCALER_128         0x00000030U
+#define SPI_BAUDRATEPRESCALER_256         0x00000038U
+
+// Time the master spends setting up and finishing each blocking transfer besides clocking bytes (HAL call, flag polling), in ns
+#define MOCK_SPI_TRANSACTION_NS           2000U
 
 // Mocked SPI typedefs
 typedef enum
@@ -27,14 +40,40 @@ typedef enum
   HAL_SPI_STATE_ERROR      = 4U,    /*!< SPI error state                                    */
 } HAL_SPI_StateTypeDef;
 
+// Slave device answering the master from within the master-side HAL functions, without a slave thread
+// Callbacks run on the master's thread and get back the Context given to Mock_SPI_Attach_Slave; any of them may be NULL
+typedef struct
+{
+  void (*on_cs)(void *Context, uint8_t Selected);                       // Chip select written: asserted (1, pin low) or released (0)
+  void (*on_write)(void *Context, const uint8_t *pData, uint16_t Size);  // Master transmitted Size bytes from pData
+  void (*on_read)(void *Context, uint8_t *pData, uint16_t Size);         // Master receives Size bytes, to be put in pData
+} Mock_SPI_SlaveTypeDef;
+
+// SPI configuration; only what the mock makes use of
+typedef struct
+{
+  uint32_t BaudRatePrescaler;  // SPI_BAUDRATEPRESCALER_x, dividing the APB2 clock into the bus bit rate
+} SPI_InitTypeDef;
+
 typedef struct __SPI_HandleTypeDef
 {
-  uint8_t                    TxMsgBuff[MOCK_SPI_MAX_MSG_SIZE];     // SPI TX transfer message buffer
-  uint16_t                   TxMsgSize;                            // SPI TX transfer message size
-  uint8_t                    RxMsgBuff[MOCK_SPI_MAX_MSG_SIZE];     // SPI RX transfer message buffer
-  uint16_t                   RxMsgSize;                            // SPI RX transfer message size
+  SPI_InitTypeDef            Init;                                 // SPI communication parameters
+  uint8_t                    *pTxBuffPtr;                          // Master's data being transmitted, read by the slave in place
+  uint16_t                   TxXferSize;                           // SPI TX transfer size
+  __IO uint16_t              TxXferCount;                          // SPI TX bytes the slave has yet to receive
+  uint8_t                    *pRxBuffPtr;                          // Master's buffer being received into, written by the slave in place
+  uint16_t                   RxXferSize;                           // SPI RX transfer size
+  __IO uint16_t              RxXferCount;                          // SPI RX bytes the slave has yet to transmit
   __IO HAL_SPI_StateTypeDef  State;                                // SPI communication state
   __IO uint32_t              ErrorCode;                            // SPI Error code
+  DMA_HandleTypeDef          *hdmatx;                              // SPI Tx DMA stream (NULL: DMA transfers are blocking)
+  DMA_HandleTypeDef          *hdmarx;                              // SPI Rx DMA stream (NULL: DMA transfers are blocking)
+  const Mock_SPI_SlaveTypeDef *Slave;                              // Attached slave device (NULL: slave side is a thread)
+  void                       *SlaveContext;                        // Context passed to the slave device's callbacks
+  GPIO_TypeDef               *SlaveCsPort;                         // Chip select of the slave device (NULL: none)
+  uint16_t                   SlaveCsPin;
+  Mock_HAL_FaultsTypeDef     *Faults;                              // Faults injected into the slave device's transfers (NULL: none)
+  Mock_HAL_BusStatsTypeDef   Stats;                                // Transfers made since HAL_SPI_Init
 } SPI_HandleTypeDef;
 
 // Mocked SPI functions
@@ -44,9 +83,15 @@ HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint
 HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
 HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
 HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi);
 
 // Functions for slave device interactivity with the mock SPI
 HAL_StatusTypeDef Mock_SPI_Slave_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
 HAL_StatusTypeDef Mock_SPI_Slave_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef Mock_SPI_Slave_Wait(SPI_HandleTypeDef *hspi, uint32_t Timeout);
+HAL_StatusTypeDef Mock_SPI_Attach_Slave(SPI_HandleTypeDef *hspi, const Mock_SPI_SlaveTypeDef *Slave, void *Context, GPIO_TypeDef *CsPort, uint16_t CsPin);
+void Mock_SPI_Detach_Slave(SPI_HandleTypeDef *hspi);
+void Mock_SPI_Set_Faults(SPI_HandleTypeDef *hspi, Mock_HAL_FaultsTypeDef *Faults);
 
 #endif  // HAL_MOCK_SPI_H
@@ -0,0 +1,365 @@
+// hal_mock_uart.c
+#include "hal_mock_uart.h"
+#include <errno.h>
+#include <poll.h>
+
+// The line is connected to the host through file descriptors (see Mock_UART_Attach_Fd): transmitted bytes are written to
+// TxFd once they're out on the line, received bytes are read from RxFd as they come in. Frames take their time at the
+// configured baud rate, so transfers are only as fast as the real UART's.
+
+// Check for common errors in the UART HAL before proceeding with a UART HAL function
+static HAL_StatusTypeDef common_uart_checks(UART_HandleTypeDef *huart) {
+    // Catch invalid UART handle
+    if(huart == NULL) {
+        return HAL_ERROR;
+    }
+
+    // Catch uninitialized HAL
+    if(!hal_board->Initialized) {
+        huart->ErrorCode = HAL_UART_ERROR_HAL_UNINITIALIZED;
+        return HAL_ERROR;
+    }
+
+    return HAL_OK; // No error
+}
+
+// Check for common errors in the UART HAL before starting a transfer in the given direction (its state is State)
+static HAL_StatusTypeDef common_uart_transfer_checks(UART_HandleTypeDef *huart, HAL_UART_StateTypeDef State, const uint8_t *pData, uint16_t Size) {
+    // Check for common errors
+    HAL_StatusTypeDef status = common_uart_checks(huart);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    // Catch null or empty pData
+    if((pData == NULL) || (Size == 0)) {
+        huart->ErrorCode = HAL_UART_ERROR_NULL_PARAM;
+        return HAL_ERROR;
+    }
+
+    // Catch UART not initialized, or still busy in that direction
+    if(State == HAL_UART_STATE_RESET) {
+        huart->ErrorCode = HAL_UART_ERROR_UNINITIALIZED;
+        return HAL_ERROR;
+    }
+    if(State != HAL_UART_STATE_READY) {
+        huart->ErrorCode = HAL_UART_ERROR_BUSY;
+        return HAL_BUSY;
+    }
+
+    return HAL_OK; // No error
+}
+
+// Writes bytes that went out on the line to the host, if a file descriptor is attached
+static HAL_StatusTypeDef uart_write_fd(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size) {
+    if(!huart->FdAttached || (huart->TxFd < 0)) {
+        return HAL_OK;
+    }
+
+    while(Size > 0) {
+        ssize_t written = write(huart->TxFd, pData, Size);
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            huart->ErrorCode = HAL_UART_ERROR_FD;
+            return HAL_ERROR;
+        }
+        pData += written;
+        Size -= (uint16_t)written;
+    }
+    return HAL_OK;
+}
+
+// Time Size frames take on the line, plus Overhead, in ns
+static uint64_t uart_frames_ns(UART_HandleTypeDef *huart, uint16_t Size, uint32_t OverheadNs) {
+    return Mock_HAL_Bus_Ns((uint32_t)Size * Mock_UART_Frame_Bits(huart), huart->Init.BaudRate, OverheadNs);
+}
+
+// Ends a background transmit once its last frame is out, like the real HAL's transmit complete handlers
+static void uart_transmit_cplt(UART_HandleTypeDef *huart) {
+    HAL_StatusTypeDef status = uart_write_fd(huart, huart->pTxBuffPtr, huart->TxXferSize);
+    huart->gState = HAL_UART_STATE_READY;
+    if(status != HAL_OK) {
+        HAL_UART_ErrorCallback(huart);
+        return;
+    }
+    HAL_UART_TxCpltCallback(huart);
+}
+
+static void uart_it_transmit_cplt(void *Context) {
+    uart_transmit_cplt((UART_HandleTypeDef *)Context);
+}
+
+static void uart_dma_transmit_cplt(DMA_HandleTypeDef *hdma) {
+    uart_transmit_cplt((UART_HandleTypeDef *)hdma->Parent);
+}
+
+// Schedules the next look at the line for a background receive, a frame time from now (every tick for an untimed line)
+// An idle line is looked at no more often than every MOCK_UART_IDLE_LOOK_NS, which keeps a receive waiting on a fast line
+// from flooding the event queue; bytes that are already there still come in a frame time apart.
+static void uart_receive_next_frame(UART_HandleTypeDef *huart, uint8_t Idle) {
+    uint64_t frame_ns = uart_frames_ns(huart, 1, 0);
+    if((frame_ns == 0) || (Idle && (frame_ns < MOCK_UART_IDLE_LOOK_NS))) {
+        frame_ns = MOCK_UART_IDLE_LOOK_NS;
+    }
+    Mock_HAL_Event_Schedule(&huart->RxFrame, Mock_HAL_GetTimeNs() + frame_ns);
+}
+
+static void uart_receive_frame(void *Context);
+
+// A frame time of a background receive passed: takes the byte that came in meanwhile, if any
+// Ends the receive once all bytes are in, otherwise waits for the next frame time.
+static void uart_receive_frame(void *Context) {
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)Context;
+    struct pollfd pfd = {huart->RxFd, POLLIN, 0};
+    uint8_t idle = 1;
+
+    if((poll(&pfd, 1, 0) > 0) && (pfd.revents & (POLLIN | POLLHUP | POLLERR))) {
+        idle = 0;
+        if(read(huart->RxFd, &huart->pRxBuffPtr[huart->RxXferSize - huart->RxXferCount], 1) != 1) {
+            // The host closed the line: nothing will come in anymore
+            huart->RxState = HAL_UART_STATE_READY;
+            huart->ErrorCode = HAL_UART_ERROR_FD;
+            HAL_UART_ErrorCallback(huart);
+            return;
+        }
+        huart->RxXferCount--;
+    }
+
+    if(huart->RxXferCount == 0) {
+        huart->RxState = HAL_UART_STATE_READY;
+        HAL_UART_RxCpltCallback(huart);
+        return;
+    }
+
+    uart_receive_next_frame(huart, idle);
+}
+
+// Drops any background transfer without it completing
+static void uart_stop_transfers(UART_HandleTypeDef *huart) {
+    Mock_HAL_Event_Cancel(&huart->TxComplete);
+    Mock_HAL_Event_Cancel(&huart->RxFrame);
+    if((huart->hdmatx != NULL) && (huart->hdmatx->State == HAL_DMA_STATE_BUSY)) {
+        HAL_DMA_Abort(huart->hdmatx);
+    }
+}
+
+// Waits until a byte can be read from the host, or returns HAL_TIMEOUT once the wait has timed out
+// Timeouts work like Mock_HAL_Wait_Step: in virtual time, a wait that times out costs its full Timeout.
+static HAL_StatusTypeDef uart_wait_readable(UART_HandleTypeDef *huart, Mock_HAL_WaitTypeDef *wait) {
+    struct pollfd pfd = {(huart->FdAttached ? huart->RxFd : -1), POLLIN, 0};
+    int timeout_ms = -1;
+    if(wait->Timeout != HAL_MAX_DELAY) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        int64_t left = (int64_t)(wait->Deadline.tv_sec - now.tv_sec) * 1000 + (wait->Deadline.tv_nsec - now.tv_nsec) / 1000000;
+        timeout_ms = (left > 0) ? (int)left : 0;
+    }
+
+    if(poll(&pfd, 1, timeout_ms) > 0) {
+        return HAL_OK;
+    }
+    if(!hal_board->RealTime) {
+        hal_board->CurrentTime += wait->Timeout;
+    }
+    return HAL_TIMEOUT;
+}
+
+// Initializes the UART peripheral with the configuration in Init, keeping the attached file descriptors
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart) {
+    // Check for common errors
+    HAL_StatusTypeDef status = common_uart_checks(huart);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    // Forget any previous transfers
+    uart_stop_transfers(huart);
+
+    // Set UART to a ready state; can perform transfers now
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+
+    return HAL_OK;
+}
+
+// Deinitializes the UART peripheral
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart) {
+    // Check for common errors
+    HAL_StatusTypeDef status = common_uart_checks(huart);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    HAL_UART_Abort(huart);
+
+    // Set UART to a reset state; cannot perform transfers now
+    huart->gState = HAL_UART_STATE_RESET;
+    huart->RxState = HAL_UART_STATE_RESET;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+
+    return HAL_OK;
+}
+
+// Transmit an amount of data in blocking mode
+// Returns once the last frame is out, having written the data to the host
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    // Check for common transfer errors
+    HAL_StatusTypeDef status = common_uart_transfer_checks(huart, (huart != NULL) ? huart->gState : HAL_UART_STATE_RESET, pData, Size);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    Mock_HAL_Bus_Time((uint32_t)Size * Mock_UART_Frame_Bits(huart), huart->Init.BaudRate, MOCK_UART_TRANSACTION_NS);
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    return uart_write_fd(huart, pData, Size);
+}
+
+// Transmit an amount of data in interrupt mode
+// Returns straight away; the data goes to the host once the last frame is out in simulated time, then
+// HAL_UART_TxCpltCallback is called. pData must stay in place until then.
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size) {
+    // Check for common transfer errors
+    HAL_StatusTypeDef status = common_uart_transfer_checks(huart, (huart != NULL) ? huart->gState : HAL_UART_STATE_RESET, pData, Size);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    huart->pTxBuffPtr = pData;
+    huart->TxXferSize = Size;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+
+    huart->TxComplete.Fire = uart_it_transmit_cplt;
+    huart->TxComplete.Context = huart;
+    Mock_HAL_Event_Schedule(&huart->TxComplete, Mock_HAL_GetTimeNs() + uart_frames_ns(huart, Size, MOCK_UART_TRANSACTION_NS));
+    return HAL_OK;
+}
+
+// Transmit an amount of data in DMA mode
+// Works like HAL_UART_Transmit_IT, with the linked DMA stream (hdmatx, if any) busy until the transfer completes
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size) {
+    if((huart == NULL) || (huart->hdmatx == NULL)) {
+        return HAL_UART_Transmit_IT(huart, pData, Size);
+    }
+
+    // Check for common transfer errors
+    HAL_StatusTypeDef status = common_uart_transfer_checks(huart, huart->gState, pData, Size);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    huart->pTxBuffPtr = pData;
+    huart->TxXferSize = Size;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+
+    huart->hdmatx->Parent = huart;
+    huart->hdmatx->XferCpltCallback = uart_dma_transmit_cplt;
+    Mock_DMA_Start(huart->hdmatx, uart_frames_ns(huart, Size, MOCK_UART_TRANSACTION_NS));
+    return HAL_OK;
+}
+
+// Receive an amount of data in blocking mode
+// Each byte read from the host takes a frame time; gives up once Timeout ms have passed without all of them
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    // Check for common transfer errors
+    HAL_StatusTypeDef status = common_uart_transfer_checks(huart, (huart != NULL) ? huart->RxState : HAL_UART_STATE_RESET, pData, Size);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, Timeout);
+    for(uint16_t i = 0; i < Size; i++) {
+        if(uart_wait_readable(huart, &wait) != HAL_OK) {
+            huart->ErrorCode = HAL_UART_ERROR_TIMEOUT;
+            return HAL_TIMEOUT;
+        }
+        if(read(huart->RxFd, &pData[i], 1) != 1) {
+            huart->ErrorCode = HAL_UART_ERROR_FD;
+            return HAL_ERROR;
+        }
+        Mock_HAL_Bus_Time(Mock_UART_Frame_Bits(huart), huart->Init.BaudRate, 0);
+    }
+
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    return HAL_OK;
+}
+
+// Receive an amount of data in interrupt mode
+// Returns straight away; a byte can come in from the host every frame time, and HAL_UART_RxCpltCallback is called
+// once all of them did. Without a file descriptor to read from, nothing ever comes in.
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+    // Check for common transfer errors
+    HAL_StatusTypeDef status = common_uart_transfer_checks(huart, (huart != NULL) ? huart->RxState : HAL_UART_STATE_RESET, pData, Size);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->RxXferCount = Size;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+
+    if(huart->FdAttached && (huart->RxFd >= 0)) {
+        huart->RxFrame.Fire = uart_receive_frame;
+        huart->RxFrame.Context = huart;
+        uart_receive_next_frame(huart, 0);
+    }
+    return HAL_OK;
+}
+
+// Stops any transfer in progress, without calling callbacks; data not out on the line yet is dropped
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart) {
+    // Check for common errors
+    HAL_StatusTypeDef status = common_uart_checks(huart);
+    if (status != HAL_OK) {
+        return status;
+    }
+
+    uart_stop_transfers(huart);
+
+    if(huart->gState != HAL_UART_STATE_RESET) {
+        huart->gState = HAL_UART_STATE_READY;
+        huart->RxState = HAL_UART_STATE_READY;
+    }
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    return HAL_OK;
+}
+
+// Transfer callbacks, called when a background transfer ends; override them to act on it, as with the real HAL
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    (void)huart;
+}
+
+__weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
+    (void)huart;
+}
+
+__weak void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+    (void)huart;
+}
+
+// Connects the line to the host: transmitted bytes are written to TxFd, received ones read from RxFd (either may be -1)
+// The file descriptors may be the two ends of a pipe, a pty or a socket; they stay attached through HAL_UART_Init.
+void Mock_UART_Attach_Fd(UART_HandleTypeDef *huart, int TxFd, int RxFd) {
+    if(huart == NULL) {
+        return;
+    }
+
+    huart->TxFd = TxFd;
+    huart->RxFd = RxFd;
+    huart->FdAttached = 1;
+}
+
+// Bits each byte takes on the line with the configured frame format: start bit, data (and parity) bits, stop bits
+// That's 10 for the usual 8N1.
+uint32_t Mock_UART_Frame_Bits(UART_HandleTypeDef *huart) {
+    uint32_t data_bits = (huart->Init.WordLength == UART_WORDLENGTH_9B) ? 9U : 8U;
+    uint32_t stop_bits = (huart->Init.StopBits == UART_STOPBITS_2) ? 2U : 1U;
+    return 1U + data_bits + stop_bits;
+}
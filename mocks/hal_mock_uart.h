@@ -0,0 +1,97 @@
+// hal_mock_uart.h
+#ifndef HAL_MOCK_UART_H
+#define HAL_MOCK_UART_H
+
+#include "hal_mock_general.h"
+#include "hal_mock_dma.h"
+
+// Mocked UART defines/macros
+#define HAL_UART_ERROR_NONE               0U      // No error
+#define HAL_UART_ERROR_HAL_UNINITIALIZED  10U     // HAL uninitialized error
+
+#define HAL_UART_ERROR_NULL_PARAM         100U    // UART null parameter error
+#define HAL_UART_ERROR_UNINITIALIZED      101U    // UART uninitialized error
+#define HAL_UART_ERROR_BUSY               102U    // UART busy error
+#define HAL_UART_ERROR_TIMEOUT            105U    // UART timeout error
+#define HAL_UART_ERROR_FD                 108U    // UART file descriptor couldn't be written or read
+
+// Frame format and configuration values, the same as the real HAL's
+#define UART_WORDLENGTH_8B                0x00000000U
+#define UART_WORDLENGTH_9B                0x00001000U
+#define UART_STOPBITS_1                   0x00000000U
+#define UART_STOPBITS_2                   0x00002000U
+#define UART_PARITY_NONE                  0x00000000U
+#define UART_PARITY_EVEN                  0x00000400U
+#define UART_PARITY_ODD                   0x00000600U
+#define UART_MODE_RX                      0x00000004U
+#define UART_MODE_TX                      0x00000008U
+#define UART_MODE_TX_RX                   0x0000000CU
+#define UART_HWCONTROL_NONE               0x00000000U
+#define UART_OVERSAMPLING_16              0x00000000U
+#define UART_OVERSAMPLING_8               0x00008000U
+
+// Time the CPU spends setting up each blocking transfer besides sending frames (HAL call, flag polling), in ns
+#define MOCK_UART_TRANSACTION_NS          2000U
+// Longest a background receive goes between looks at an idle line, in ns
+#define MOCK_UART_IDLE_LOOK_NS            1000000U
+
+// UART state enumeration (gState for transmitting, RxState for receiving)
+typedef enum
+{
+  HAL_UART_STATE_RESET             = 0x00U,   /*!< Peripheral is not yet Initialized         */
+  HAL_UART_STATE_READY             = 0x20U,   /*!< Peripheral Initialized and ready for use  */
+  HAL_UART_STATE_BUSY              = 0x24U,   /*!< An internal process is ongoing            */
+  HAL_UART_STATE_BUSY_TX           = 0x21U,   /*!< Data Transmission process is ongoing      */
+  HAL_UART_STATE_BUSY_RX           = 0x22U,   /*!< Data Reception process is ongoing         */
+  HAL_UART_STATE_ERROR             = 0xE0U    /*!< Error                                     */
+} HAL_UART_StateTypeDef;
+
+// UART configuration; the mock times frames from BaudRate (0: untimed), WordLength and StopBits
+typedef struct
+{
+  uint32_t BaudRate;
+  uint32_t WordLength;    // UART_WORDLENGTH_x, parity bit included
+  uint32_t StopBits;      // UART_STOPBITS_x
+  uint32_t Parity;        // UART_PARITY_x
+  uint32_t Mode;          // UART_MODE_x
+  uint32_t HwFlowCtl;     // UART_HWCONTROL_x
+  uint32_t OverSampling;  // UART_OVERSAMPLING_x
+} UART_InitTypeDef;
+
+typedef struct __UART_HandleTypeDef
+{
+  UART_InitTypeDef           Init;          // UART communication parameters
+  const uint8_t              *pTxBuffPtr;   // Data being transmitted in the background
+  uint16_t                   TxXferSize;    // UART Tx transfer size
+  uint8_t                    *pRxBuffPtr;   // Buffer being received into in the background
+  uint16_t                   RxXferSize;    // UART Rx transfer size
+  __IO uint16_t              RxXferCount;   // UART Rx bytes left to receive
+  DMA_HandleTypeDef          *hdmatx;       // UART Tx DMA stream (NULL: DMA transmits complete like IT ones)
+  __IO HAL_UART_StateTypeDef gState;        // Transmit (and global) state
+  __IO HAL_UART_StateTypeDef RxState;       // Receive state
+  __IO uint32_t              ErrorCode;     // UART Error code
+  uint8_t                    FdAttached;    // 1 once Mock_UART_Attach_Fd gave the line's file descriptors
+  int                        TxFd;          // Where transmitted bytes are written (-1: dropped)
+  int                        RxFd;          // Where received bytes are read from (-1: nothing arrives)
+  Mock_HAL_EventTypeDef      TxComplete;    // Completion of a background transmit without a DMA stream
+  Mock_HAL_EventTypeDef      RxFrame;       // Next frame time of a background receive, when a byte may come in
+} UART_HandleTypeDef;
+
+// Mocked UART functions
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+
+// Functions for connecting the mock UART to the host
+void Mock_UART_Attach_Fd(UART_HandleTypeDef *huart, int TxFd, int RxFd);
+uint32_t Mock_UART_Frame_Bits(UART_HandleTypeDef *huart);
+
+#endif  // HAL_MOCK_UART_H
@@ -23,26 +23,35 @@ void ov2640_spi_deselect(ov2640 *camera) {
 // Writes a specified byte of data to the OV2640 FIFO buffer through SPI
 void ov2640_fifo_write(ov2640 *camera, uint8_t addr, uint8_t data) {
     ov2640_spi_select(camera);
-    HAL_Delay(10);
+    HAL_Delay(OV2640_FIFO_GUARD_MS);
     addr |= 0x80;  // Set write bit
     HAL_SPI_Transmit(camera->spi_handler, &addr, 1, HAL_MAX_DELAY);
     HAL_SPI_Transmit(camera->spi_handler, &data, 1, HAL_MAX_DELAY);
-    HAL_Delay(10);
+    HAL_Delay(OV2640_FIFO_GUARD_MS);
     ov2640_spi_deselect(camera);
 }
 
-// Reads a specified byte of data from the OV2640 FIFO buffer through SPI
-// Requested byte is written to the address of p_rx_data
-void ov2640_fifo_read(ov2640 *camera, uint8_t addr, uint8_t *p_rx_data) {
+// Reads a byte from the OV2640 FIFO registers, keeping the SPI selected for guard_ms before and after the access
+static void ov2640_fifo_read_guarded(ov2640 *camera, uint8_t addr, uint8_t *p_rx_data, uint32_t guard_ms) {
     ov2640_spi_select(camera);
-    HAL_Delay(10);
+    if (guard_ms > 0) {
+        HAL_Delay(guard_ms);
+    }
     addr &= 0x7F;  // Clear write bit
     HAL_SPI_Transmit(camera->spi_handler, &addr, 1, HAL_MAX_DELAY);
     HAL_SPI_Receive(camera->spi_handler, p_rx_data, 1, HAL_MAX_DELAY);
-    HAL_Delay(10);
+    if (guard_ms > 0) {
+        HAL_Delay(guard_ms);
+    }
     ov2640_spi_deselect(camera);
 }
 
+// Reads a specified byte of data from the OV2640 FIFO buffer through SPI
+// Requested byte is written to the address of p_rx_data
+void ov2640_fifo_read(ov2640 *camera, uint8_t addr, uint8_t *p_rx_data) {
+    ov2640_fifo_read_guarded(camera, addr, p_rx_data, OV2640_FIFO_GUARD_MS);
+}
+
 // Clear all data from the OV2640 FIFO buffer 
 void ov2640_fifo_clear(ov2640 *camera) {
     ov2640_fifo_write(camera, OV2640_FIFO_CONTROL, OV2640_FIFO_CLEAR_MASK);
@@ -62,17 +71,26 @@ uint8_t ov2640_fifo_check_bit(ov2640 *camera, uint8_t addr, uint8_t mask) {
     return (temp & mask);
 }
 
-// Reads the current length of the FIFO buffer and stores it in the ov2640 struct.
-void ov2640_fifo_read_length(ov2640 *camera) {
+// Reads the current length of the FIFO buffer into the ov2640 struct, guarding each register read by guard_ms.
+static void ov2640_fifo_read_length_guarded(ov2640 *camera, uint32_t guard_ms) {
+    OV2640_PHASE_BEGIN("length_read");
+
     // The length of the FIFO buffer is stored as three bytes in the OV2640; need to put them together.
     uint8_t len1, len2, len3 = 0;
-    ov2640_fifo_read(camera, OV2640_FIFO_SIZE1, &len1);
-    ov2640_fifo_read(camera, OV2640_FIFO_SIZE2, &len2);
-    ov2640_fifo_read(camera, OV2640_FIFO_SIZE3, &len3);
+    ov2640_fifo_read_guarded(camera, OV2640_FIFO_SIZE1, &len1, guard_ms);
+    ov2640_fifo_read_guarded(camera, OV2640_FIFO_SIZE2, &len2, guard_ms);
+    ov2640_fifo_read_guarded(camera, OV2640_FIFO_SIZE3, &len3, guard_ms);
     len3 = len3 & 0x7F;  // Ensure the highest bit is not considered.
 
     // Combine the three bytes to obtain the FIFO length.
     camera->fifo_length = ((len3 << 16) | (len2 << 8) | len1) & 0x07FFFFF;
+
+    OV2640_PHASE_END("length_read");
+}
+
+// Reads the current length of the FIFO buffer and stores it in the ov2640 struct.
+void ov2640_fifo_read_length(ov2640 *camera) {
+    ov2640_fifo_read_length_guarded(camera, OV2640_FIFO_GUARD_MS);
 }
 
 // Writes a specified byte of data to a register of the OV2640 sensor through I2C.
@@ -109,9 +127,79 @@ void ov2640_sensor_read_byte(ov2640 * camera, uint8_t reg, uint8_t * p_rx_data)
 	HAL_I2C_Master_Receive(camera->i2c_handler, OV2640_SENSOR_ADDR, p_rx_data, 1, HAL_MAX_DELAY);
 }
 
+// Computes the register writes needed to go from the sensor state left by reglist "from" to the state left by reglist "to".
+// Writes from "to" are kept in order, but any write that wouldn't change the register value is dropped,
+// and bank selects are only emitted when a kept write needs a different bank.
+// The delta is terminated by {0xff, 0xff} so it can be passed to ov2640_sensor_write_bytes.
+// Returns the number of writes in the delta (excluding the terminator), or 0 if it doesn't fit in delta_size.
+uint16_t ov2640_sensor_reglist_delta(const struct sensor_reg from[], const struct sensor_reg to[], struct sensor_reg delta[], uint16_t delta_size)
+{
+	// Shadow copy of both register banks (0 = DSP, 1 = sensor) and which of their registers have a known value.
+	uint8_t shadow[2][256];
+	uint8_t known[2][256 / 8] = {{0}};
+	uint8_t bank = 0xff;  // Unknown until the first bank select.
+
+	// Replay "from" into the shadow registers.
+	for (const struct sensor_reg *next = from; (next->reg != 0xff) || (next->val != 0xff); next++) {
+		if (next->reg == OV2640_SENSOR_BANK_SELECT) {
+			bank = next->val & 0x01;
+		}
+		else if (bank != 0xff) {
+			shadow[bank][next->reg] = next->val;
+			known[bank][next->reg / 8] |= (1 << (next->reg % 8));
+		}
+	}
+
+	// Walk "to", keeping only the writes that change a register (or touch one with an unknown value).
+	uint8_t target_bank = 0xff;
+	uint8_t delta_bank = 0xff;  // Always start the delta with an explicit bank select.
+	uint16_t length = 0;
+
+	for (const struct sensor_reg *next = to; (next->reg != 0xff) || (next->val != 0xff); next++) {
+		if (next->reg == OV2640_SENSOR_BANK_SELECT) {
+			target_bank = next->val & 0x01;
+			continue;
+		}
+
+		// Writes before any bank select go to whatever bank is active, so they can't be filtered.
+		if (target_bank != 0xff) {
+			uint8_t is_known = known[target_bank][next->reg / 8] & (1 << (next->reg % 8));
+			if (is_known && shadow[target_bank][next->reg] == next->val) {
+				continue;
+			}
+		}
+
+		// Room is needed for this write, a possible bank select and the terminator.
+		if ((length + 3) > delta_size) {
+			return 0;
+		}
+
+		if (target_bank != delta_bank) {
+			delta[length].reg = OV2640_SENSOR_BANK_SELECT;
+			delta[length].val = target_bank;
+			length++;
+			delta_bank = target_bank;
+		}
+
+		delta[length++] = *next;
+
+		if (target_bank != 0xff) {
+			shadow[target_bank][next->reg] = next->val;
+			known[target_bank][next->reg / 8] |= (1 << (next->reg % 8));
+		}
+	}
+
+	delta[length].reg = 0xff;
+	delta[length].val = 0xff;
+
+	return length;
+}
+
 // Initialize the OV2640 to take captures as JPEG images with a default resolution of 320x240.
 void ov2640_jpeg_init(ov2640 * camera)
 {
+	OV2640_PHASE_BEGIN("init");
+
 	// Should explicitly start with deslected camera.
 	ov2640_spi_deselect(camera);
 
@@ -148,79 +236,195 @@ void ov2640_jpeg_init(ov2640 * camera)
 	// Keep track of the type and resolution of image being captured for future reference.
 	camera->image_type = OV2640_IMG_JPEG;
 	camera->image_res = OV2640_RES_320x240;
+
+	OV2640_PHASE_END("init");
 }
 
 // Set the resolution of OV2640 JPEG image captures
 void ov2640_jpeg_set_res(ov2640* camera, ov2640_image_res_t image_res)
+{
+	OV2640_PHASE_BEGIN("set_res");
+
+	ov2640_sensor_write_bytes(camera, ov2640_jpeg_res_reglist(image_res));
+
+	// Keep track of the resolution of image being captured for future reference.
+	camera->image_res = image_res;
+
+	OV2640_PHASE_END("set_res");
+}
+
+// Get the reglist that configures the OV2640 for JPEG captures of a given resolution.
+// Unknown resolutions fall back to the default resolution (320x240).
+const struct sensor_reg * ov2640_jpeg_res_reglist(ov2640_image_res_t image_res)
 {
 	switch (image_res)
 	{
 		case OV2640_RES_160x120:
-			ov2640_sensor_write_bytes(camera, OV2640_160x120_JPEG);
-			break;
+			return OV2640_160x120_JPEG;
 		case OV2640_RES_176x144:
-			ov2640_sensor_write_bytes(camera, OV2640_176x144_JPEG);
-			break;
+			return OV2640_176x144_JPEG;
 		case OV2640_RES_352x288:
-			ov2640_sensor_write_bytes(camera, OV2640_352x288_JPEG);
-			break;
+			return OV2640_352x288_JPEG;
 		case OV2640_RES_640x480:
-			ov2640_sensor_write_bytes(camera, OV2640_640x480_JPEG);
-			break;
+			return OV2640_640x480_JPEG;
 		case OV2640_RES_800x600:
-			ov2640_sensor_write_bytes(camera, OV2640_800x600_JPEG);
-			break;
+			return OV2640_800x600_JPEG;
 		case OV2640_RES_1024x768:
-			ov2640_sensor_write_bytes(camera, OV2640_1024x768_JPEG);
-			break;
+			return OV2640_1024x768_JPEG;
 		case OV2640_RES_1280x1024:
-			ov2640_sensor_write_bytes(camera, OV2640_1280x1024_JPEG);
-			break;
+			return OV2640_1280x1024_JPEG;
 		case OV2640_RES_1600x1200:
-			ov2640_sensor_write_bytes(camera, OV2640_1600x1200_JPEG);
-			break;
+			return OV2640_1600x1200_JPEG;
 		default:
-			ov2640_sensor_write_bytes(camera, OV2640_320x240_JPEG);
-			break;
+			return OV2640_320x240_JPEG;
 	}
-
-	// Keep track of the resolution of image being captured for future reference.
-	camera->image_res = image_res;
 }
 
-// Take a capture using the OV2640.
+// Loads a capture into a cleared FIFO buffer and waits for it: settle_ms first, then polls the capture done bit every
+// poll_ms until it's set or OV2640_CAPTURE_TIMEOUT_MS have passed, then reads the length. The polls and the length
+// read are guarded by guard_ms (see ov2640_fifo_read_guarded).
 // If the capture is obviously invalid, discard it (indicated by the length being reset to 0).
-void ov2640_get_capture(ov2640 *camera) {
+static void ov2640_capture(ov2640 *camera, uint32_t settle_ms, uint32_t poll_ms, uint32_t guard_ms) {
+    OV2640_PHASE_BEGIN("capture");
+
     // Load the capture into a cleared FIFO buffer.
     ov2640_fifo_clear(camera);
     ov2640_fifo_start(camera);
 
-    // Minimum settling time for capture to load.
-    HAL_Delay(100);
+    OV2640_PHASE_BEGIN("capture_wait");
+    uint32_t start = HAL_GetTick();
+    if (settle_ms > 0) {
+        HAL_Delay(settle_ms);
+    }
 
-    // We can't wait indefinitely for the capture to settle, so a maximum timeout is necessary; set to 1 second for simplicity.
-    // If we time out, fifo_length will stay at 0, resulting in discarding the capture.
-    for (uint8_t i = 0; i < 10; ++i) {
-        if (ov2640_fifo_check_bit(camera, OV2640_CAPTURE_TRIGGER, OV2640_CAPTURE_DONE_MASK)) {
-            ov2640_fifo_read_length(camera);
+    // We can't wait indefinitely for the capture to settle, so a maximum timeout is necessary.
+    // If we time out, the length read below is that of an unfinished capture, which gets discarded if it's obviously invalid.
+    uint8_t status = 0;
+    ov2640_fifo_read_guarded(camera, OV2640_CAPTURE_TRIGGER, &status, guard_ms);
+    while (!(status & OV2640_CAPTURE_DONE_MASK)) {
+        if ((HAL_GetTick() - start) >= OV2640_CAPTURE_TIMEOUT_MS) {
             break;
         }
-        HAL_Delay(100);
+        HAL_Delay(poll_ms);
+        ov2640_fifo_read_guarded(camera, OV2640_CAPTURE_TRIGGER, &status, guard_ms);
     }
+    OV2640_PHASE_END("capture_wait");
 
-    // Read and save the length of the capture in the FIFO buffer.
-    ov2640_fifo_read_length(camera);
+    // Read and save the length of the capture in the FIFO buffer (once: every FIFO register read is a pair of SPI transfers).
+    ov2640_fifo_read_length_guarded(camera, guard_ms);
 
     // Discard a capture by clearing the FIFO buffer if it is obviously invalid based on FIFO length.
     if ((camera->fifo_length > OV2640_CAPTURE_MAX_LENGTH) || (camera->fifo_length < OV2640_CAPTURE_MIN_LENGTH)) {
         ov2640_fifo_clear(camera);
     }
+
+    OV2640_PHASE_END("capture");
+}
+
+// Take a capture using the OV2640.
+// If the capture is obviously invalid, discard it (indicated by the length being reset to 0).
+void ov2640_get_capture(ov2640 *camera) {
+    // Minimum settling time for capture to load, then check on it every 100 ms.
+    ov2640_capture(camera, OV2640_CAPTURE_SETTLE_MS, OV2640_CAPTURE_POLL_MS, OV2640_FIFO_GUARD_MS);
+}
+
+// Set up the preview/trigger pipeline: the camera is switched to low-res preview captures,
+// and the register deltas to switch to and from capture_res are computed once up front.
+// threshold is the change in preview JPEG size (in percent) that counts as motion.
+void ov2640_motion_init(ov2640 * camera, ov2640_motion * motion, ov2640_image_res_t capture_res, uint8_t threshold)
+{
+	const struct sensor_reg * preview_regs = ov2640_jpeg_res_reglist(OV2640_MOTION_PREVIEW_RES);
+	const struct sensor_reg * capture_regs = ov2640_jpeg_res_reglist(capture_res);
+
+	motion->capture_res = capture_res;
+	motion->threshold = threshold;
+	motion->baseline_length = 0;
+
+	motion->preview_to_capture_length = ov2640_sensor_reglist_delta(preview_regs, capture_regs, motion->preview_to_capture, OV2640_DELTA_MAX_LENGTH);
+	motion->capture_to_preview_length = ov2640_sensor_reglist_delta(capture_regs, preview_regs, motion->capture_to_preview, OV2640_DELTA_MAX_LENGTH);
+
+	ov2640_jpeg_set_res(camera, OV2640_MOTION_PREVIEW_RES);
+}
+
+// Take a preview capture and compare its JPEG size against the running baseline.
+// JPEG size tracks scene content closely and only costs the FIFO length read, so no image data is transferred.
+// Returns 1 if motion was detected; the caller should then call ov2640_motion_capture.
+uint8_t ov2640_motion_watch(ov2640 * camera, ov2640_motion * motion)
+{
+	ov2640_get_capture(camera);
+
+	uint32_t length = camera->fifo_length;
+
+	// The preview capture is never transferred; the next ov2640_get_capture clears the FIFO anyway.
+	camera->fifo_length = 0;
+
+	if (length == 0) {
+		return 0;
+	}
+
+	// The first preview capture after starting (or resuming) seeds the baseline.
+	if (motion->baseline_length == 0) {
+		motion->baseline_length = length;
+		return 0;
+	}
+
+	uint32_t change = (length > motion->baseline_length) ? (length - motion->baseline_length) : (motion->baseline_length - length);
+	if ((change * 100) > ((uint32_t)motion->threshold * motion->baseline_length)) {
+		return 1;
+	}
+
+	// Slowly follow gradual scene changes (e.g. lighting) so they don't trigger captures.
+	motion->baseline_length = motion->baseline_length - (motion->baseline_length / 4) + (length / 4);
+
+	return 0;
+}
+
+// Switch to the capture resolution with the minimum number of register writes and capture right away.
+// On return, camera->fifo_length is non-zero if a capture is ready to be transferred.
+void ov2640_motion_capture(ov2640 * camera, ov2640_motion * motion)
+{
+	OV2640_PHASE_BEGIN("set_res");
+	if (motion->preview_to_capture_length > 0) {
+		ov2640_sensor_write_bytes(camera, motion->preview_to_capture);
+	}
+	else {
+		ov2640_sensor_write_bytes(camera, ov2640_jpeg_res_reglist(motion->capture_res));
+	}
+	camera->image_res = motion->capture_res;
+	OV2640_PHASE_END("set_res");
+
+	// Motion was just seen, so don't sit out a fixed settling time: poll closely, without guard delays that would make
+	// each poll take longer than the poll interval, and have the capture as soon as it's done (one to two sensor frames
+	// after the switch).
+	for (uint8_t i = 0; (i < OV2640_MOTION_CAPTURE_ATTEMPTS) && (camera->fifo_length == 0); ++i) {
+		ov2640_capture(camera, 0, OV2640_MOTION_POLL_MS, 0);
+	}
+}
+
+// Switch back to preview captures once the high-res capture has been transferred.
+// The baseline is re-learned, since the scene has likely changed.
+void ov2640_motion_resume(ov2640 * camera, ov2640_motion * motion)
+{
+	OV2640_PHASE_BEGIN("set_res");
+	if (motion->capture_to_preview_length > 0) {
+		ov2640_sensor_write_bytes(camera, motion->capture_to_preview);
+	}
+	else {
+		ov2640_sensor_write_bytes(camera, ov2640_jpeg_res_reglist(OV2640_MOTION_PREVIEW_RES));
+	}
+	camera->image_res = OV2640_MOTION_PREVIEW_RES;
+	OV2640_PHASE_END("set_res");
+
+	motion->baseline_length = 0;
 }
 
 // Set the OV2640 to enable reading the capture data in the FIFO buffer to be transferred out.
 // Call ov2640_transfer_step to transfer the data out to pre-defined buffers, and call ov2640_transfer_stop when done.
 void ov2640_transfer_start(ov2640 * camera)
 {
+	// The burst read phase lasts until ov2640_transfer_stop, including whatever the caller does with the data meanwhile.
+	OV2640_PHASE_BEGIN("burst_read");
+
 	// SPI must stay selected for the entire duration of the burst read.
 	ov2640_spi_select(camera);
 
@@ -230,7 +434,8 @@ void ov2640_transfer_start(ov2640 * camera)
 
 // Copies data from the SPI FIFO buffer into a user buffer.
 // buffer_filled is the number of elements in the buffer that actually belong to the image; user buffer is not guaranteed to be 100% filled.
-void ov2640_transfer_step(ov2640 * camera, uint8_t buffer[], uint16_t buffer_size, uint16_t *buffer_filled) 
+// Returns 1 if the data was read, or 0 if the read failed; the capture is then thrown out and buffer_filled is 0.
+uint8_t ov2640_transfer_step(ov2640 * camera, uint8_t buffer[], uint16_t buffer_size, uint16_t *buffer_filled) 
 {
 	// Determine whether the buffer can get 100% filled and update buffer_filled accordingly
 	if(camera->fifo_length > buffer_size) {
@@ -244,17 +449,20 @@ void ov2640_transfer_step(ov2640 * camera, uint8_t buffer[], uint16_t buffer_siz
 	// If the receive succeeds, update the length of the fifo buffer and move on.
 	if(HAL_SPI_Receive(camera->spi_handler, buffer, *buffer_filled, HAL_MAX_DELAY) == HAL_OK) {
 		camera->fifo_length -= *buffer_filled;
+		return 1;
 	}
+
 	// If the receive fails, throw out the capture data
-	else {
-		ov2640_fifo_clear(camera);
-	}	
+	ov2640_fifo_clear(camera);
+	*buffer_filled = 0;
+	return 0;
 }
 
 // Copies data from the SPI FIFO buffer into a user buffer.
 // buffer_filled is the number of elements in the buffer that actually belong to the image; user buffer is not guaranteed to be 100% filled.
 // This function uses DMA so the transferring can happen asynchronously. Subtract buffer_filled from camera->fifo_length externally once DMA finishes.
-void ov2640_transfer_step_dma(ov2640 * camera, uint8_t buffer[], uint16_t buffer_size, uint16_t *buffer_filled)
+// Returns 1 if the transfer started, or 0 if it couldn't; the capture is then thrown out and buffer_filled is 0, so there's nothing to wait for.
+uint8_t ov2640_transfer_step_dma(ov2640 * camera, uint8_t buffer[], uint16_t buffer_size, uint16_t *buffer_filled)
 {
 	// Determine whether the buffer can get 100% filled and update buffer_filled accordingly
 	if(camera->fifo_length > buffer_size) {
@@ -265,9 +473,15 @@ void ov2640_transfer_step_dma(ov2640 * camera, uint8_t buffer[], uint16_t buffer
 	}
 
 	// Receive the maximum amount of data from the SPI FIFO buffer into the user buffer.
-	HAL_SPI_Receive_DMA(camera->spi_handler, buffer, *buffer_filled);
-
 	// camera->fifo_length should be updated externally when the transfer is complete. Use buffer_filled to do so.
+	if(HAL_SPI_Receive_DMA(camera->spi_handler, buffer, *buffer_filled) == HAL_OK) {
+		return 1;
+	}
+
+	// If the receive can't start, throw out the capture data
+	ov2640_fifo_clear(camera);
+	*buffer_filled = 0;
+	return 0;
 }
 
 // Perform cleanup after data from FIFO buffer is transferred.
@@ -276,6 +490,8 @@ void ov2640_transfer_stop(ov2640 * camera)
 	// SPI must stay selected from calling ov2640_transfer_start up until this point.
 	ov2640_spi_deselect(camera);
 	ov2640_fifo_clear(camera);
+
+	OV2640_PHASE_END("burst_read");
 }
 
 // Test I2C by writing a value to a register and reading it back.
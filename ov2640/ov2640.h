@@ -17,6 +17,15 @@ struct sensor_reg {
 
 #include "ov2640_regs.h"
 
+// Marks the driver's phases (init, capture wait, burst read, ...) in the mock HAL's bus trace, see Mock_HAL_Trace_Start.
+// Compiles to nothing on the target.
+#ifdef USE_MOCK_HAL
+#define OV2640_PHASE_BEGIN(name)		Mock_HAL_Trace_Phase_Begin(name)
+#define OV2640_PHASE_END(name)			Mock_HAL_Trace_Phase_End(name)
+#else
+#define OV2640_PHASE_BEGIN(name)
+#define OV2640_PHASE_END(name)
+#endif
 
 #define OV2640_CPLD_ADDR              	0x07
 #define OV2640_CPLD_REG               	0x80
@@ -42,6 +51,20 @@ struct sensor_reg {
 #define OV2640_CAPTURE_MIN_LENGTH     	1
 #define OV2640_CAPTURE_MAX_LENGTH     	0x5FFFE
 
+// Capture wait (ms): ov2640_get_capture lets a capture settle, then polls for it to be done, up to the timeout
+#define OV2640_CAPTURE_SETTLE_MS		100
+#define OV2640_CAPTURE_POLL_MS			100
+#define OV2640_CAPTURE_TIMEOUT_MS		1000
+// How long ov2640_fifo_read and ov2640_fifo_write keep the SPI selected around each register access (ms)
+#define OV2640_FIFO_GUARD_MS			10
+
+#define OV2640_SENSOR_BANK_SELECT		0xFF
+
+#define OV2640_DELTA_MAX_LENGTH			64
+#define OV2640_MOTION_PREVIEW_RES		OV2640_RES_160x120
+#define OV2640_MOTION_CAPTURE_ATTEMPTS	3
+#define OV2640_MOTION_POLL_MS			2	// ov2640_motion_capture polls for its capture this often, with no settling time
+
 typedef enum ov2640_image_type
 {
 	OV2640_IMG_ERR,
@@ -81,6 +104,25 @@ typedef struct ov2640 {
 	uint8_t pid;
 } ov2640;
 
+// State of the preview/trigger pipeline: watch low-res captures for a change, then grab a high-res capture.
+typedef struct ov2640_motion {
+	// Resolution captured once motion is detected.
+	ov2640_image_res_t capture_res;
+
+	// Minimum register writes to switch between the preview and capture resolutions; terminated by {0xff, 0xff}.
+	// A zero length means the delta didn't fit, so the full reglist is written instead.
+	struct sensor_reg preview_to_capture[OV2640_DELTA_MAX_LENGTH];
+	struct sensor_reg capture_to_preview[OV2640_DELTA_MAX_LENGTH];
+	uint16_t preview_to_capture_length;
+	uint16_t capture_to_preview_length;
+
+	// Change in preview JPEG size (as a percentage of the baseline) that counts as motion.
+	uint8_t threshold;
+
+	// Running average of the preview JPEG size; 0 until the first preview frame is seen.
+	uint32_t baseline_length;
+} ov2640_motion;
+
 // Setup functions
 void ov2640_register(ov2640 *camera, GPIO_TypeDef *spi_cs_port, uint16_t spi_cs_pin, SPI_HandleTypeDef * spi_handler, I2C_HandleTypeDef * i2c_handler);
 
@@ -100,18 +142,26 @@ void ov2640_fifo_read_length(ov2640 * camera);
 void ov2640_sensor_write_byte(ov2640 * camera, uint8_t reg, uint8_t data);
 void ov2640_sensor_write_bytes(ov2640 * camera, const struct sensor_reg reglist[]);
 void ov2640_sensor_read_byte(ov2640 * camera, uint8_t reg, uint8_t * p_rx_data);
+uint16_t ov2640_sensor_reglist_delta(const struct sensor_reg from[], const struct sensor_reg to[], struct sensor_reg delta[], uint16_t delta_size);
 
 // Initialization functions
 void ov2640_jpeg_init(ov2640 * camera);
 void ov2640_jpeg_set_res(ov2640* camera, ov2640_image_res_t image_res);
+const struct sensor_reg * ov2640_jpeg_res_reglist(ov2640_image_res_t image_res);
 
 // Image capture functions
 void ov2640_get_capture(ov2640 * camera);
 
+// Preview/trigger (motion) pipeline functions
+void ov2640_motion_init(ov2640 * camera, ov2640_motion * motion, ov2640_image_res_t capture_res, uint8_t threshold);
+uint8_t ov2640_motion_watch(ov2640 * camera, ov2640_motion * motion);
+void ov2640_motion_capture(ov2640 * camera, ov2640_motion * motion);
+void ov2640_motion_resume(ov2640 * camera, ov2640_motion * motion);
+
 // Image handling functions
 void ov2640_transfer_start(ov2640 * camera);
-void ov2640_transfer_step(ov2640 * camera, uint8_t buffer[], uint16_t buffer_size, uint16_t * buffer_filled);
-void ov2640_transfer_step_dma(ov2640 * camera, uint8_t buffer[], uint16_t buffer_size, uint16_t *buffer_filled);
+uint8_t ov2640_transfer_step(ov2640 * camera, uint8_t buffer[], uint16_t buffer_size, uint16_t * buffer_filled);
+uint8_t ov2640_transfer_step_dma(ov2640 * camera, uint8_t buffer[], uint16_t buffer_size, uint16_t *buffer_filled);
 void ov2640_transfer_stop(ov2640 * camera);
 
 // Sanity testing functions to be used at runtime
@@ -0,0 +1,67 @@
+import threading
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+# Live preview of received JPEG frames as multipart MJPEG on http://localhost:<port>/, which browsers (and most video
+# tools) show as a video. Frames are served from memory as they're published; a viewer that can't keep up just skips
+# to the latest frame rather than queueing them.
+
+BOUNDARY = b"frame"
+
+
+class PreviewServer:
+    def __init__(self, port):
+        self.jpeg = None
+        self.count = 0
+        self.closed = False
+        self.cond = threading.Condition()
+
+        preview = self
+
+        class Handler(BaseHTTPRequestHandler):
+            def do_GET(self):
+                if self.path != "/":
+                    self.send_error(404)
+                    return
+                self.send_response(200)
+                self.send_header("Content-Type", "multipart/x-mixed-replace; boundary=" + BOUNDARY.decode())
+                self.send_header("Cache-Control", "no-cache")
+                self.end_headers()
+
+                seen = 0
+                try:
+                    while True:
+                        seen, jpeg = preview.wait(seen)
+                        if jpeg is None:
+                            break
+                        self.wfile.write(b"--" + BOUNDARY + b"\r\nContent-Type: image/jpeg\r\n"
+                                         b"Content-Length: %d\r\n\r\n" % len(jpeg) + jpeg + b"\r\n")
+                except (BrokenPipeError, ConnectionResetError):
+                    pass
+
+            def log_message(self, format, *args):
+                # keep the receiver's console for frame messages
+                pass
+
+        # localhost only, it's meant for the operator at the capture host
+        self.server = ThreadingHTTPServer(("127.0.0.1", port), Handler)
+        self.server.daemon_threads = True
+        threading.Thread(target=self.server.serve_forever, daemon=True).start()
+
+    def publish(self, jpeg):
+        with self.cond:
+            self.jpeg = jpeg
+            self.count += 1
+            self.cond.notify_all()
+
+    def wait(self, seen):
+        # block until there's a frame newer than the seen'th one; returns (its count, the frame), or a None frame once closed
+        with self.cond:
+            self.cond.wait_for(lambda: self.count != seen or self.closed)
+            return self.count, (None if self.closed else self.jpeg)
+
+    def close(self):
+        with self.cond:
+            self.closed = True
+            self.cond.notify_all()
+        self.server.shutdown()
+        self.server.server_close()
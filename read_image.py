@@ -1,54 +1,421 @@
-import serial
-from binascii import unhexlify
-import random
+import argparse
+import struct
+import time
+import zlib
+from collections import namedtuple
+from itertools import accumulate
 
-# change COM port to wherever it's coming from
-camera = serial.Serial(port='COM5', baudrate=115200, bytesize=8)
+from frame_store import FrameStoreWriter
+from preview_server import PreviewServer
 
-i = 0
+# rate the firmware starts at and falls back to (STREAM_BAUD_BASE_RATE)
+BASE_BAUDRATE = 115200
 
-# continuously read in images from serial and write them to desktop
-while True:
-    # current image data is most easily stored as an array
-    img = []
+# rates to propose to the firmware, it NAKs any its UART can't reach; empty to stay at BASE_BAUDRATE
+BAUDRATES = [2000000, 1000000, 921600, 460800, 230400]
 
-    prevByte = b""
-    currByte = b""
+# frames are appended to <STORE_NAME>.frames, with an index in <STORE_NAME>.idx (see frame_store.py)
+STORE_NAME = "test_images/captures"
 
-    # the ending pattern for jpeg images is {\xff, \xd9}, use this to know when to stop reading for current image
-    while (prevByte == b"\xff" and currByte == b"\xd9") == False:
-        byte = camera.readline().strip()
+# change COM port to wherever it's coming from (or pass --port)
+PORT = "COM5"
 
-        prevByte = currByte
+# Frame protocol, must match stream/stream_frame.h:
+#   header  (16 bytes): sync word, version, flags, resolution, header check, sequence (LE32), payload length (LE32)
+#   payload (length bytes)
+#   trailer (4 bytes):  CRC32 (LE32) over the header after the sync word and the payload
+FRAME_SYNC = b"\xa5\x5a\x0f\xf0"
+FRAME_VERSION = 1
+FRAME_HEADER = struct.Struct("<4sBBBBII")
+FRAME_TRAILER = struct.Struct("<I")
 
-        if len(byte) == 1:
-            currByte = unhexlify(b'0' + byte)
+# payload sent as coded chunks that decode to the payload length, the CRC is over the decoded payload
+FRAME_FLAG_COMPRESSED = 0x01
+# timestamp block (STREAM_FRAME_STAMP_COUNT MCU timestamps, LE32 ms) between the payload and the trailer, in the CRC
+FRAME_FLAG_TIMESTAMPS = 0x02
+FRAME_TIMESTAMPS = struct.Struct("<4I")
 
-            # handle start of image pattern by discarding current image and starting a new one
-            if (prevByte == b"\xff" and currByte == b"\xd8"):
-                img = [b"\xff", b"\xd8"]
-            else:
-                img.append(currByte)
+# Coded chunks, must match stream/stream_compress.h:
+#   raw length (LE16), coded length (LE16), coded bytes (raw bytes if both lengths are equal)
+CHUNK_HEADER = struct.Struct("<HH")
+CHUNK_DELTA_STRIDE = 2
+CHUNK_MIN_RUN = 3
+
+# how much a replayed dump hands out per read; the serial port hands out whatever it has
+READ_BLOCK_SIZE = 64 * 1024
+
+# largest capture the OV2640 FIFO can hold (OV2640_CAPTURE_MAX_LENGTH), anything bigger is a false sync
+FRAME_MAX_LENGTH = 0x5FFFE
+
+# ov2640_image_res_t values sent in the header
+RESOLUTIONS = {
+    1: "160x120",
+    2: "176x144",
+    3: "320x240",
+    4: "352x288",
+    5: "640x480",
+    6: "800x600",
+    7: "1024x768",
+    8: "1280x1024",
+    9: "1600x1200",
+}
+
+
+# Baud rate negotiation messages, must match stream/stream_baud.h:
+#   magic ("BD"), command, check, value (LE32); all bytes sum to zero
+BAUD_MSG = struct.Struct("<2sBBI")
+BAUD_SWITCH = 0x01
+BAUD_ACK = 0x02
+BAUD_NAK = 0x03
+BAUD_ECHO = 0x04
+BAUD_CONFIRM = 0x05
+BAUD_DONE = 0x06
+
+# the firmware only looks for proposals between frames, so keep proposing for a while
+BAUD_SWITCH_TIMEOUT = 10.0
+BAUD_REPLY_TIMEOUT = 0.5
+# how long the firmware waits at a new rate before falling back (BAUD_TRIAL_TIMEOUT), plus some margin
+BAUD_FALLBACK_TIME = 1.5
+# test patterns echoed at the new rate, chosen to exercise every bit in both states
+BAUD_ECHO_PATTERNS = [0x55AA55AA, 0x00FF00FF, 0xFFFFFFFF, 0x00000000, 0x12345678]
+
+
+def baud_msg(cmd, value):
+    msg = bytearray(BAUD_MSG.pack(b"BD", cmd, 0, value))
+    msg[3] = -sum(msg) & 0xFF
+    return bytes(msg)
+
+
+def wait_baud_msg(port, timeout):
+    # scan everything coming in (which may be frame data) for a valid message
+    buf = b""
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        buf += port.read(max(1, port.in_waiting))
+
+        start = buf.find(b"BD")
+        while start != -1 and start + BAUD_MSG.size <= len(buf):
+            msg = buf[start:start + BAUD_MSG.size]
+            if sum(msg) & 0xFF == 0:
+                _, cmd, _, value = BAUD_MSG.unpack(msg)
+                return cmd, value
+            start = buf.find(b"BD", start + 1)
+
+        # keep a possible partial message for the next read
+        buf = buf[start:] if start != -1 else buf[-1:]
+    return None
+
+
+def try_baudrate(port, rate):
+    # propose the rate at the current rate, until the firmware answers
+    # returns None if it never does, so the remaining rates aren't worth trying either
+    reply = None
+    deadline = time.monotonic() + BAUD_SWITCH_TIMEOUT
+    while time.monotonic() < deadline and reply not in ((BAUD_ACK, rate), (BAUD_NAK, rate)):
+        port.write(baud_msg(BAUD_SWITCH, rate))
+        reply = wait_baud_msg(port, BAUD_REPLY_TIMEOUT)
+    if reply is None:
+        return None
+    if reply != (BAUD_ACK, rate):
+        return False
+
+    # both sides are at the new rate now, check that it actually works before committing to it
+    previous = port.baudrate
+    port.baudrate = rate
+    port.reset_input_buffer()
+
+    for pattern in BAUD_ECHO_PATTERNS:
+        port.write(baud_msg(BAUD_ECHO, pattern))
+        if wait_baud_msg(port, BAUD_REPLY_TIMEOUT) != (BAUD_ECHO, pattern):
+            break
+    else:
+        port.write(baud_msg(BAUD_CONFIRM, rate))
+        if wait_baud_msg(port, BAUD_REPLY_TIMEOUT) == (BAUD_DONE, rate):
+            return True
+
+    # fall back and give the firmware time to do the same
+    port.baudrate = previous
+    time.sleep(BAUD_FALLBACK_TIME)
+    port.reset_input_buffer()
+    return False
+
+
+def negotiate_baudrate(port, rates):
+    # fastest rate that passes the echo test wins
+    for rate in sorted(rates, reverse=True):
+        if rate == port.baudrate:
+            continue
+        result = try_baudrate(port, rate)
+        if result is None:
+            print("no answer from the firmware, not negotiating")
+            break
+        if result:
+            break
+    print(f"link running at {port.baudrate} baud")
+
+
+def decode_chunk(coded, raw_length):
+    # undo the run-length coding, giving the differences between each byte and the one CHUNK_DELTA_STRIDE before it
+    deltas = bytearray()
+    pos = 0
+    while pos < len(coded):
+        token = coded[pos]
+        if token & 0x80:
+            deltas += coded[pos + 1:pos + 2] * (token - 0x80 + CHUNK_MIN_RUN)
+            pos += 2
+        else:
+            deltas += coded[pos + 1:pos + 2 + token]
+            pos += 2 + token
+    if len(deltas) != raw_length:
+        return None
+
+    # then undo the differences, one interleaved stride at a time (running sums mod 256) so no Python code runs per byte
+    raw = bytearray(raw_length)
+    for phase in range(CHUNK_DELTA_STRIDE):
+        raw[phase::CHUNK_DELTA_STRIDE] = bytes(map((0xFF).__and__, accumulate(deltas[phase::CHUNK_DELTA_STRIDE])))
+    return bytes(raw)
+
+
+# mcu_stamps are the firmware's (trigger, captured, first out, last out) in ms or None,
+# first_in_ns/last_in_ns are host times (time.time_ns) of the reads that brought in the header and the trailer
+ReceivedFrame = namedtuple("ReceivedFrame", "seq res flags payload mcu_stamps first_in_ns last_in_ns")
+
+
+class FrameReader:
+    # Streaming frame parser: pulls everything the port has off it into one buffer and parses frames out of it,
+    # so resyncing, headers and payloads cost a buffer search or slice rather than a port read each.
+
+    def __init__(self, port):
+        self.port = port
+        self.buf = bytearray()
+        self.pos = 0
+        # bytes pulled off the port so far, for throughput reports, and when the last read returned
+        self.received = 0
+        self.read_time_ns = 0
+
+    def _read_more(self):
+        # drop what's been parsed already, then append whatever the port has, waiting only for the first byte if it has
+        # nothing: waiting for more than is there would hold the read (and its time stamp) up until the port timeout
+        if self.pos:
+            del self.buf[:self.pos]
+            self.pos = 0
+        data = self.port.read(max(1, self.port.in_waiting))
+        self.received += len(data)
+        self.read_time_ns = time.time_ns()
+        self.buf += data
+
+    def _take(self, size):
+        while len(self.buf) - self.pos < size:
+            self._read_more()
+        data = bytes(self.buf[self.pos:self.pos + size])
+        self.pos += size
+        return data
+
+    def _find_sync(self):
+        # search the buffer for the sync word, keeping a possible partial one at the end for the next read
+        while True:
+            start = self.buf.find(FRAME_SYNC, self.pos)
+            if start != -1:
+                self.pos = start
+                return
+            self.pos = max(self.pos, len(self.buf) - len(FRAME_SYNC) + 1)
+            self._read_more()
 
-        elif len(byte) == 2:
-            currByte = unhexlify(byte)
+    def _take_compressed(self, length):
+        # coded chunks until they add up to the payload length, None if one doesn't decode
+        payload = bytearray()
+        while len(payload) < length:
+            raw_length, coded_length = CHUNK_HEADER.unpack(self._take(CHUNK_HEADER.size))
+            coded = self._take(coded_length)
+            raw = coded if coded_length == raw_length else decode_chunk(coded, raw_length)
+            if raw is None or raw_length == 0 or len(payload) + raw_length > length:
+                return None
+            payload += raw
+        return bytes(payload)
 
-            # handle start of image pattern by discarding current image and starting a new one
-            if (prevByte == b"\xff" and currByte == b"\xd8"):
-                img = [b"\xff", b"\xd8"]
+    def read_frame(self):
+        # keep looking until a frame with a valid header and CRC comes in
+        while True:
+            self._find_sync()
+            header = self._take(FRAME_HEADER.size)
+            first_in_ns = self.read_time_ns
+            _, version, flags, res, _, seq, length = FRAME_HEADER.unpack(header)
+
+            # the header bytes after the sync word sum to zero, anything else is a false sync inside a payload;
+            # skip just past its sync word so a real frame starting inside it isn't missed
+            if version != FRAME_VERSION or sum(header[4:]) & 0xFF != 0 or length > FRAME_MAX_LENGTH:
+                self.pos -= FRAME_HEADER.size - len(FRAME_SYNC)
+                continue
+
+            if flags & FRAME_FLAG_COMPRESSED:
+                payload = self._take_compressed(length)
+                if payload is None:
+                    print(f"frame {seq}: bad compressed chunk, dropped")
+                    continue
             else:
-                img.append(currByte)
+                payload = self._take(length)
+            crc = zlib.crc32(payload, zlib.crc32(header[4:]))
+
+            mcu_stamps = None
+            if flags & FRAME_FLAG_TIMESTAMPS:
+                block = self._take(FRAME_TIMESTAMPS.size)
+                mcu_stamps = FRAME_TIMESTAMPS.unpack(block)
+                crc = zlib.crc32(block, crc)
+
+            (trailer_crc,) = FRAME_TRAILER.unpack(self._take(FRAME_TRAILER.size))
+            if crc != trailer_crc:
+                print(f"frame {seq}: CRC mismatch, dropped")
+                continue
+
+            return ReceivedFrame(seq, res, flags, payload, mcu_stamps, first_in_ns, self.read_time_ns)
+
+
+class DumpSource:
+    # Stands in for the serial port when replaying a dump made with --record; raises EOFError once it runs out.
+    # The whole dump has already arrived, so there's always a block waiting.
+    in_waiting = READ_BLOCK_SIZE
+
+    def __init__(self, path):
+        self.f = open(path, "rb")
+
+    def read(self, size):
+        data = self.f.read(size)
+        if not data:
+            raise EOFError
+        return data
+
+    def close(self):
+        self.f.close()
+
+
+class RecordingSource:
+    # Passes reads through from the serial port, saving everything that comes in to a dump for DumpSource.
+
+    def __init__(self, port, path):
+        self.port = port
+        self.f = open(path, "wb")
+
+    @property
+    def in_waiting(self):
+        return self.port.in_waiting
+
+    def read(self, size):
+        data = self.port.read(size)
+        self.f.write(data)
+        return data
+
+    def close(self):
+        self.f.close()
+        self.port.close()
+
+
+class LatencyLog:
+    # Per-frame latency breakdown as CSV: the raw MCU (ms since boot) and host (ns) timestamps, then intervals in ms.
+    # capture/prepare/send are measured by the MCU, receive/parse/store by the host. The two clocks aren't synced,
+    # so link is how much later the last byte arrived than on the quickest frame so far (which sets the clock offset).
+    COLUMNS = ("seq,trigger_ms,captured_ms,first_out_ms,last_out_ms,first_in_ns,last_in_ns,parsed_ns,written_ns,"
+               "capture_ms,prepare_ms,send_ms,link_ms,receive_ms,parse_ms,store_ms")
+
+    def __init__(self, path):
+        self.f = open(path, "w")
+        self.f.write(self.COLUMNS + "\n")
+        self.offset_ms = None
+        # MCU ticks unwrapped past 32 bits, so the clock offset survives a wrap
+        self.last_out_ms = None
+        self.wraps = 0
+
+    def log(self, frame, parsed_ns, written_ns):
+        if frame.mcu_stamps is None:
+            return
+        trigger, captured, first_out, last_out = frame.mcu_stamps
+        if self.last_out_ms is not None and last_out < self.last_out_ms:
+            self.wraps += 1
+        self.last_out_ms = last_out
+        offset_ms = frame.last_in_ns / 1e6 - (last_out + (self.wraps << 32))
+        self.offset_ms = offset_ms if self.offset_ms is None else min(self.offset_ms, offset_ms)
+
+        # MCU ticks are 32-bit and wrap, so take their differences mod 2^32
+        intervals = ((captured - trigger) & 0xFFFFFFFF,
+                     (first_out - captured) & 0xFFFFFFFF,
+                     (last_out - first_out) & 0xFFFFFFFF,
+                     offset_ms - self.offset_ms,
+                     (frame.last_in_ns - frame.first_in_ns) / 1e6,
+                     (parsed_ns - frame.last_in_ns) / 1e6,
+                     (written_ns - parsed_ns) / 1e6)
+        stamps = (frame.seq, trigger, captured, first_out, last_out, frame.first_in_ns, frame.last_in_ns, parsed_ns,
+                  written_ns)
+        self.f.write(",".join(map(str, stamps)) + "," + ",".join(f"{ms:.3f}" for ms in intervals) + "\n")
+
+    def close(self):
+        self.f.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Receive captures from the camera over serial and store them.")
+    parser.add_argument("--port", default=PORT, help=f"serial port the camera is on (default {PORT})")
+    parser.add_argument("--record", metavar="DUMP", help="also save the raw serial stream (after baud rate negotiation) to DUMP")
+    parser.add_argument("--replay", metavar="DUMP", help="parse a dump made with --record as fast as possible instead of the serial port")
+    parser.add_argument("--store", default=STORE_NAME, help=f"frame store to append to (default {STORE_NAME})")
+    parser.add_argument("--no-store", action="store_true", help="don't store frames, e.g. to benchmark just the parser")
+    parser.add_argument("--latency-log", metavar="CSV", help="write a per-frame latency breakdown to CSV")
+    parser.add_argument("--preview", metavar="HTTP_PORT", type=int,
+                        help="serve JPEG frames live as MJPEG on http://localhost:HTTP_PORT/")
+    args = parser.parse_args()
+
+    # what ends the stream: the dump running out, ctrl-c, or (on a live port) the port going away
+    end_of_stream = (EOFError, KeyboardInterrupt)
+    if args.replay:
+        source = DumpSource(args.replay)
+    else:
+        # only needed for a live port, so replays run on hosts without pyserial
+        import serial
+        port = serial.Serial(port=args.port, baudrate=BASE_BAUDRATE, bytesize=8, timeout=0.1)
+        negotiate_baudrate(port, BAUDRATES)
+        source = RecordingSource(port, args.record) if args.record else port
+        end_of_stream += (serial.SerialException,)
+
+    reader = FrameReader(source)
+    store = None if args.no_store else FrameStoreWriter(args.store)
+    latency = LatencyLog(args.latency_log) if args.latency_log else None
+    preview = PreviewServer(args.preview) if args.preview else None
+
+    # continuously read in images (until the stream ends) and append them to the store
+    frames = 0
+    start = time.perf_counter()
+    try:
+        while True:
+            frame = reader.read_frame()
+            parsed_ns = time.time_ns()
+            frames += 1
+            if not args.replay:
+                print(f"frame {frame.seq}: {RESOLUTIONS.get(frame.res, 'unknown')}, {len(frame.payload)} bytes")
+
+            # compressed frames carry uncompressed (raw) captures rather than JPEG; the flags are kept to tell them apart
+            if store is not None:
+                store.append(frame.seq, parsed_ns, frame.res, frame.flags, frame.payload)
+
+            if latency is not None:
+                latency.log(frame, parsed_ns, time.time_ns())
+
+            # compressed frames aren't JPEG, so there's nothing a browser could show
+            if preview is not None and not frame.flags & FRAME_FLAG_COMPRESSED:
+                preview.publish(frame.payload)
+    except end_of_stream:
+        pass
+    elapsed = max(time.perf_counter() - start, 1e-9)
+
+    megabytes = reader.received / 1e6
+    print(f"{frames} frames, {megabytes:.2f} MB in {elapsed:.2f} s: "
+          f"{frames / elapsed:.1f} frames/s, {megabytes / elapsed:.2f} MB/s")
 
-        # print the current byte to show progress, comes out REALLY fast though
-        print(currByte)
-    
+    if store is not None:
+        store.close()
+    if latency is not None:
+        latency.close()
+    if preview is not None:
+        preview.close()
+    source.close()
 
-    # convert array of bytes into a byte string for writing
-    data = b"".join(img)
 
-    # write current image
-    with open(f"test_images/recv_image_{i}.jpg", "wb") as f:
-        f.write(data)
-    i = i+1
- 
-camera.close()
\ No newline at end of file
+if __name__ == "__main__":
+    main()
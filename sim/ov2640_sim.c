@@ -0,0 +1,457 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ov2640_sim.h"
+
+// What the next SPI bytes are: a command (register address with the write bit), the data of a register write,
+// the reply to a register read, or FIFO data
+#define SIM_SPI_COMMAND		0
+#define SIM_SPI_WRITE		1
+#define SIM_SPI_READ		2
+#define SIM_SPI_FIFO_SINGLE	3
+#define SIM_SPI_FIFO_BURST	4
+
+// Sensor bank registers (bank 1)
+#define SIM_SENSOR_CLKRC	0x11
+#define SIM_SENSOR_COM7		0x12
+#define SIM_COM7_SRST		0x80
+#define SIM_COM7_SVGA		0x40
+
+// DSP bank registers (bank 0) holding the output size, in units of 4 pixels
+#define SIM_DSP_ZMOW		0x5A
+#define SIM_DSP_ZMOH		0x5B
+#define SIM_DSP_ZMHH		0x5C
+
+// CPLD FIFO control bits besides clear and start
+#define SIM_FIFO_RDPTR_RST	0x10
+#define SIM_FIFO_WRPTR_RST	0x20
+
+// Puts the sensor registers back to their power-on values (only the IDs are modelled, everything else reads 0)
+static void sensor_reset(ov2640_sim * sim)
+{
+	memset(sim->sensor_regs, 0, sizeof(sim->sensor_regs));
+	sim->sensor_regs[1][OV2640_CHIPID_HIGH] = 0x26;
+	sim->sensor_regs[1][OV2640_CHIPID_LOW] = 0x42;
+	sim->sensor_regs[1][0x1C] = 0x7F;	// Manufacturer ID
+	sim->sensor_regs[1][0x1D] = 0xA2;
+}
+
+// Puts the CPLD back to its power-on state, dropping anything in the FIFO
+static void cpld_reset(ov2640_sim * sim)
+{
+	memset(sim->cpld_regs, 0, sizeof(sim->cpld_regs));
+	sim->spi_phase = SIM_SPI_COMMAND;
+	sim->fifo = NULL;
+	sim->fifo_length = 0;
+	sim->fifo_read = 0;
+	sim->capturing = 0;
+	sim->capture_done = 0;
+}
+
+// Finds the size of a JPEG image from its start of frame segment.
+// Returns 1 if the data starts like a JPEG and has one.
+static uint8_t jpeg_size(const uint8_t data[], uint32_t length, uint16_t * width, uint16_t * height)
+{
+	if ((length < 4) || (data[0] != 0xFF) || (data[1] != 0xD8)) {
+		return 0;
+	}
+
+	uint32_t i = 2;
+	while ((i + 4) <= length) {
+		if (data[i] != 0xFF) {
+			return 0;
+		}
+		uint8_t marker = data[i + 1];
+		uint16_t segment_length = (data[i + 2] << 8) | data[i + 3];
+
+		// Image data comes after the frame header, so there's no point looking further
+		if ((marker == 0xD9) || (marker == 0xDA)) {
+			return 0;
+		}
+
+		// SOF0 to SOF15, apart from DHT (C4), JPG (C8) and DAC (CC)
+		if ((marker >= 0xC0) && (marker <= 0xCF) && (marker != 0xC4) && (marker != 0xC8) && (marker != 0xCC)) {
+			if ((i + 9) > length) {
+				return 0;
+			}
+			*height = (data[i + 5] << 8) | data[i + 6];
+			*width = (data[i + 7] << 8) | data[i + 8];
+			return 1;
+		}
+
+		i += 2 + segment_length;
+	}
+
+	return 0;
+}
+
+// Makes a JPEG-shaped frame (SOI, filler that never contains a marker, EOI) of the size the OV2640 would give
+static const ov2640_sim_frame * synthetic_frame(ov2640_sim * sim, uint16_t width, uint16_t height)
+{
+	uint32_t length = ((uint32_t)width * height) / OV2640_SIM_SYNTHETIC_PIXELS_PER_BYTE;
+	if (length < 4) {
+		length = 4;
+	}
+	if (length > OV2640_SIM_FIFO_SIZE) {
+		length = OV2640_SIM_FIFO_SIZE;
+	}
+
+	if (sim->synthetic.data == NULL) {
+		sim->synthetic.data = malloc(OV2640_SIM_FIFO_SIZE);
+		if (sim->synthetic.data == NULL) {
+			return NULL;
+		}
+	}
+
+	uint8_t * data = sim->synthetic.data;
+	data[0] = 0xFF;
+	data[1] = 0xD8;
+	for (uint32_t i = 2; i < (length - 2); i++) {
+		data[i] = (i * 7) & 0x7F;
+	}
+	data[length - 2] = 0xFF;
+	data[length - 1] = 0xD9;
+
+	sim->synthetic.length = length;
+	sim->synthetic.width = width;
+	sim->synthetic.height = height;
+	return &sim->synthetic;
+}
+
+// Starts a capture: picks the frame for the configured output size and works out when the ArduCAM has it in the FIFO
+static void capture_start(ov2640_sim * sim)
+{
+	uint16_t width, height;
+	ov2640_sim_output_size(sim, &width, &height);
+
+	// Loaded frames of the right size take turns, so successive captures differ like a live scene would
+	uint8_t matches = 0;
+	for (uint8_t i = 0; i < sim->frame_count; i++) {
+		if ((sim->frames[i].width == width) && (sim->frames[i].height == height)) {
+			matches++;
+		}
+	}
+
+	sim->capture_frame = NULL;
+	if (matches > 0) {
+		uint8_t pick = sim->capture_count % matches;
+		for (uint8_t i = 0; i < sim->frame_count; i++) {
+			if ((sim->frames[i].width == width) && (sim->frames[i].height == height)) {
+				if (pick == 0) {
+					sim->capture_frame = &sim->frames[i];
+					break;
+				}
+				pick--;
+			}
+		}
+	}
+	else {
+		sim->capture_frame = synthetic_frame(sim, width, height);
+	}
+	sim->capture_count++;
+
+	// Wait for the next frame to start, then take one full frame
+	uint32_t period = ov2640_sim_frame_period(sim);
+	uint32_t now = HAL_GetTick();
+	sim->capture_done_tick = ((now / period) + 2) * period;
+	sim->capturing = 1;
+	sim->capture_done = 0;
+	sim->fifo_length = 0;
+	sim->fifo_read = 0;
+}
+
+// Brings a capture in progress up to the current tick
+static void capture_update(ov2640_sim * sim)
+{
+	if (sim->capturing && ((int32_t)(HAL_GetTick() - sim->capture_done_tick) >= 0)) {
+		sim->capturing = 0;
+		sim->capture_done = 1;
+		if (sim->capture_frame != NULL) {
+			sim->fifo = sim->capture_frame->data;
+			sim->fifo_length = sim->capture_frame->length;
+		}
+		sim->fifo_read = 0;
+	}
+}
+
+static uint8_t fifo_next(ov2640_sim * sim)
+{
+	if ((sim->fifo == NULL) || (sim->fifo_read >= sim->fifo_length)) {
+		return 0x00;
+	}
+	return sim->fifo[sim->fifo_read++];
+}
+
+static void cpld_write(ov2640_sim * sim, uint8_t addr, uint8_t data)
+{
+	if (addr == OV2640_CPLD_ADDR) {
+		if (data & OV2640_CPLD_REG) {
+			cpld_reset(sim);
+		}
+		sim->cpld_regs[addr] = data;
+		return;
+	}
+
+	if (addr == OV2640_FIFO_CONTROL) {
+		// Clearing drops the done flag along with whatever capture is in the FIFO or in progress
+		if (data & OV2640_FIFO_CLEAR_MASK) {
+			sim->capturing = 0;
+			sim->capture_done = 0;
+			sim->fifo_length = 0;
+			sim->fifo_read = 0;
+		}
+		if (data & SIM_FIFO_WRPTR_RST) {
+			sim->fifo_length = 0;
+		}
+		if (data & SIM_FIFO_RDPTR_RST) {
+			sim->fifo_read = 0;
+		}
+		if (data & OV2640_FIFO_START_MASK) {
+			capture_start(sim);
+		}
+		return;
+	}
+
+	sim->cpld_regs[addr] = data;
+}
+
+static uint8_t cpld_read(ov2640_sim * sim, uint8_t addr)
+{
+	capture_update(sim);
+
+	switch (addr)
+	{
+		case OV2640_CAPTURE_TRIGGER:
+			return sim->capture_done ? OV2640_CAPTURE_DONE_MASK : 0;
+		case OV2640_FIFO_SIZE1:
+			return (sim->fifo_length >> 0) & 0xFF;
+		case OV2640_FIFO_SIZE2:
+			return (sim->fifo_length >> 8) & 0xFF;
+		case OV2640_FIFO_SIZE3:
+			return (sim->fifo_length >> 16) & 0x7F;
+		default:
+			return sim->cpld_regs[addr];
+	}
+}
+
+// SPI chip select: releasing it ends whatever command was going on (e.g. a burst read)
+static void sim_spi_cs(void * context, uint8_t selected)
+{
+	ov2640_sim * sim = context;
+	if (!selected) {
+		sim->spi_phase = SIM_SPI_COMMAND;
+	}
+}
+
+static void sim_spi_write(void * context, const uint8_t * data, uint16_t size)
+{
+	ov2640_sim * sim = context;
+
+	for (uint16_t i = 0; i < size; i++) {
+		if (sim->spi_phase == SIM_SPI_WRITE) {
+			cpld_write(sim, sim->spi_addr, data[i]);
+			sim->spi_phase = SIM_SPI_COMMAND;
+			continue;
+		}
+
+		// Anything else written is a new command
+		sim->spi_addr = data[i] & 0x7F;
+		if (data[i] & 0x80) {
+			sim->spi_phase = SIM_SPI_WRITE;
+		}
+		else if (sim->spi_addr == OV2640_FIFO_BURST_READ) {
+			capture_update(sim);
+			sim->spi_phase = SIM_SPI_FIFO_BURST;
+		}
+		else if (sim->spi_addr == OV2640_FIFO_SINGLE_READ) {
+			capture_update(sim);
+			sim->spi_phase = SIM_SPI_FIFO_SINGLE;
+		}
+		else {
+			sim->spi_phase = SIM_SPI_READ;
+		}
+	}
+}
+
+static void sim_spi_read(void * context, uint8_t * data, uint16_t size)
+{
+	ov2640_sim * sim = context;
+
+	// A burst read streams straight out of the captured frame
+	if (sim->spi_phase == SIM_SPI_FIFO_BURST) {
+		uint32_t available = (sim->fifo_read < sim->fifo_length) ? (sim->fifo_length - sim->fifo_read) : 0;
+		uint32_t copied = (size < available) ? size : available;
+		if (copied > 0) {
+			memcpy(data, &sim->fifo[sim->fifo_read], copied);
+			sim->fifo_read += copied;
+		}
+		memset(&data[copied], 0x00, size - copied);
+		return;
+	}
+
+	for (uint16_t i = 0; i < size; i++) {
+		switch (sim->spi_phase)
+		{
+			case SIM_SPI_READ:
+				data[i] = cpld_read(sim, sim->spi_addr);
+				break;
+			case SIM_SPI_FIFO_SINGLE:
+				data[i] = fifo_next(sim);
+				break;
+			default:
+				data[i] = 0x00;
+				break;
+		}
+		sim->spi_phase = SIM_SPI_COMMAND;
+	}
+}
+
+static const Mock_SPI_SlaveTypeDef sim_spi_slave = {
+	.on_cs = sim_spi_cs,
+	.on_write = sim_spi_write,
+	.on_read = sim_spi_read,
+};
+
+static uint8_t sensor_read(ov2640_sim * sim, uint8_t reg)
+{
+	if (reg == OV2640_SENSOR_BANK_SELECT) {
+		return sim->bank_select;
+	}
+	return sim->sensor_regs[sim->bank_select & 0x01][reg];
+}
+
+static void sensor_write(ov2640_sim * sim, uint8_t reg, uint8_t data)
+{
+	uint8_t bank = sim->bank_select & 0x01;
+
+	if (reg == OV2640_SENSOR_BANK_SELECT) {
+		sim->bank_select = data;
+	}
+	else if ((bank == 1) && (reg == SIM_SENSOR_COM7) && (data & SIM_COM7_SRST)) {
+		sensor_reset(sim);
+	}
+	else {
+		sim->sensor_regs[bank][reg] = data;
+	}
+}
+
+// SCCB writes are a register address, optionally followed by one byte to write to it; reads come from that address
+static HAL_StatusTypeDef sim_i2c_write(void * context, const uint8_t * data, uint16_t size)
+{
+	ov2640_sim * sim = context;
+
+	if ((size == 0) || (size > 2)) {
+		return HAL_ERROR;
+	}
+
+	sim->sensor_reg = data[0];
+	if (size == 2) {
+		sensor_write(sim, data[0], data[1]);
+	}
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef sim_i2c_read(void * context, uint8_t * data, uint16_t size)
+{
+	ov2640_sim * sim = context;
+
+	for (uint16_t i = 0; i < size; i++) {
+		data[i] = sensor_read(sim, sim->sensor_reg);
+	}
+	return HAL_OK;
+}
+
+static const Mock_I2C_SlaveTypeDef sim_i2c_slave = {
+	.on_write = sim_i2c_write,
+	.on_read = sim_i2c_read,
+};
+
+// Powers the simulated camera on, without any frames loaded
+void ov2640_sim_init(ov2640_sim * sim)
+{
+	memset(sim, 0, sizeof(*sim));
+	sensor_reset(sim);
+	cpld_reset(sim);
+}
+
+// Frees the loaded and synthetic frames; detach the simulator from the mock HAL handles first
+void ov2640_sim_deinit(ov2640_sim * sim)
+{
+	for (uint8_t i = 0; i < sim->frame_count; i++) {
+		free(sim->frames[i].data);
+	}
+	free(sim->synthetic.data);
+	memset(sim, 0, sizeof(*sim));
+}
+
+// Attaches the simulated camera to the mock SPI (with its chip select) and I2C handles the driver is registered with
+HAL_StatusTypeDef ov2640_sim_attach(ov2640_sim * sim, SPI_HandleTypeDef * spi_handler, GPIO_TypeDef * spi_cs_port, uint16_t spi_cs_pin, I2C_HandleTypeDef * i2c_handler)
+{
+	if (Mock_SPI_Attach_Slave(spi_handler, &sim_spi_slave, sim, spi_cs_port, spi_cs_pin) != HAL_OK) {
+		return HAL_ERROR;
+	}
+	return Mock_I2C_Attach_Slave(i2c_handler, OV2640_SENSOR_ADDR, &sim_i2c_slave, sim);
+}
+
+// Loads a JPEG file to be captured whenever the configured output size matches the size in its frame header.
+// Fails if the file can't be read, isn't a JPEG, doesn't fit in the FIFO or there's no room for more frames.
+HAL_StatusTypeDef ov2640_sim_load_jpeg(ov2640_sim * sim, const char * path)
+{
+	if (sim->frame_count >= OV2640_SIM_MAX_FRAMES) {
+		return HAL_ERROR;
+	}
+
+	FILE * file = fopen(path, "rb");
+	if (file == NULL) {
+		return HAL_ERROR;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if ((length <= 0) || (length > OV2640_SIM_FIFO_SIZE)) {
+		fclose(file);
+		return HAL_ERROR;
+	}
+
+	uint8_t * data = malloc(length);
+	if ((data == NULL) || (fread(data, 1, length, file) != (size_t)length)) {
+		free(data);
+		fclose(file);
+		return HAL_ERROR;
+	}
+	fclose(file);
+
+	ov2640_sim_frame * frame = &sim->frames[sim->frame_count];
+	if (!jpeg_size(data, length, &frame->width, &frame->height)) {
+		free(data);
+		return HAL_ERROR;
+	}
+	frame->data = data;
+	frame->length = length;
+	sim->frame_count++;
+
+	return HAL_OK;
+}
+
+// Output size set in the DSP bank; falls back to the full sensor mode size while it hasn't been set
+void ov2640_sim_output_size(const ov2640_sim * sim, uint16_t * width, uint16_t * height)
+{
+	uint8_t zmhh = sim->sensor_regs[0][SIM_DSP_ZMHH];
+	*width = (sim->sensor_regs[0][SIM_DSP_ZMOW] | ((zmhh & 0x03) << 8)) * 4;
+	*height = (sim->sensor_regs[0][SIM_DSP_ZMOH] | (((zmhh >> 2) & 0x01) << 8)) * 4;
+
+	if ((*width == 0) || (*height == 0)) {
+		uint8_t svga = sim->sensor_regs[1][SIM_SENSOR_COM7] & SIM_COM7_SVGA;
+		*width = svga ? 800 : 1600;
+		*height = svga ? 600 : 1200;
+	}
+}
+
+// Time between frames (in ms) for the configured sensor mode and clock divider
+uint32_t ov2640_sim_frame_period(const ov2640_sim * sim)
+{
+	uint32_t base = (sim->sensor_regs[1][SIM_SENSOR_COM7] & SIM_COM7_SVGA) ? OV2640_SIM_SVGA_FRAME_MS : OV2640_SIM_UXGA_FRAME_MS;
+	return base * ((sim->sensor_regs[1][SIM_SENSOR_CLKRC] & 0x3F) + 1);
+}
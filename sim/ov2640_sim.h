@@ -0,0 +1,81 @@
+#ifndef OV2640_SIM_H
+#define OV2640_SIM_H
+
+#include <stdint.h>
+
+#include "../ov2640/ov2640.h"
+
+// Behavioural model of an ArduCAM Mini 2MP (OV2640 sensor + CPLD + FIFO) for running the driver against the mock HAL.
+//
+// The simulator attaches to the mock SPI and I2C handles as a slave device, so it answers the driver from within the
+// HAL calls (no slave threads):
+//   I2C (SCCB, address OV2640_SENSOR_ADDR): two register banks (0 = DSP, 1 = sensor) selected through 0xFF,
+//     with the chip IDs in place and a software reset through COM7.
+//   SPI: the CPLD register set (test register, FIFO control, CPLD reset, capture status and FIFO size), single and
+//     burst FIFO reads. The FIFO is read straight from the captured frame.
+//
+// A capture fills the FIFO with a JPEG frame of the output size configured in the DSP bank (ZMOW/ZMOH/ZMHH):
+// one loaded from disk with ov2640_sim_load_jpeg if any has that size (cycling through them on successive captures),
+// or a synthetic JPEG-shaped frame otherwise.
+// Like the ArduCAM, a capture waits for the next frame to start and is done once that frame is out. Frames run from
+// HAL tick 0 with a period set by the sensor mode (COM7: UXGA 15 fps, SVGA 30 fps) and the clock divider (CLKRC),
+// so captures take realistic (virtual) time.
+
+#define OV2640_SIM_FIFO_SIZE			0x60000	// 384 KB FIFO of the ArduCAM Mini 2MP
+#define OV2640_SIM_MAX_FRAMES			16
+#define OV2640_SIM_CPLD_REGS			0x80
+
+// Frame periods at CLKRC = 0, in ms
+#define OV2640_SIM_UXGA_FRAME_MS		67
+#define OV2640_SIM_SVGA_FRAME_MS		33
+
+// Synthetic frames take this many pixels per byte, close to what the OV2640 gives at its default JPEG quality
+#define OV2640_SIM_SYNTHETIC_PIXELS_PER_BYTE	10
+
+typedef struct ov2640_sim_frame {
+	uint8_t * data;
+	uint32_t length;
+	uint16_t width;
+	uint16_t height;
+} ov2640_sim_frame;
+
+typedef struct ov2640_sim {
+	// Sensor (I2C) side: both register banks, the raw bank select and the register pointer for reads
+	uint8_t sensor_regs[2][256];
+	uint8_t bank_select;
+	uint8_t sensor_reg;
+
+	// CPLD (SPI) side: plain registers, and what the next bytes on the bus are (see ov2640_sim.c)
+	uint8_t cpld_regs[OV2640_SIM_CPLD_REGS];
+	uint8_t spi_phase;
+	uint8_t spi_addr;
+
+	// FIFO: the captured frame and the read pointer into it
+	const uint8_t * fifo;
+	uint32_t fifo_length;
+	uint32_t fifo_read;
+
+	// Capture in progress: the frame it will leave in the FIFO, and the tick it is done at
+	uint8_t capturing;
+	uint8_t capture_done;
+	const ov2640_sim_frame * capture_frame;
+	uint32_t capture_done_tick;
+	uint32_t capture_count;
+
+	// Frames loaded from disk, and the buffer synthetic frames are made in
+	ov2640_sim_frame frames[OV2640_SIM_MAX_FRAMES];
+	uint8_t frame_count;
+	ov2640_sim_frame synthetic;
+} ov2640_sim;
+
+// Setup functions
+void ov2640_sim_init(ov2640_sim * sim);
+void ov2640_sim_deinit(ov2640_sim * sim);
+HAL_StatusTypeDef ov2640_sim_attach(ov2640_sim * sim, SPI_HandleTypeDef * spi_handler, GPIO_TypeDef * spi_cs_port, uint16_t spi_cs_pin, I2C_HandleTypeDef * i2c_handler);
+HAL_StatusTypeDef ov2640_sim_load_jpeg(ov2640_sim * sim, const char * path);
+
+// Model state, as the driver would find it
+void ov2640_sim_output_size(const ov2640_sim * sim, uint16_t * width, uint16_t * height);
+uint32_t ov2640_sim_frame_period(const ov2640_sim * sim);
+
+#endif // OV2640_SIM_H
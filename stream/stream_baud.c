@@ -0,0 +1,93 @@
+#include "stream_baud.h"
+
+// Builds a message with the given command and value.
+void stream_baud_encode(uint8_t msg[STREAM_BAUD_MSG_SIZE], uint8_t cmd, uint32_t value)
+{
+	msg[0] = STREAM_BAUD_MAGIC0;
+	msg[1] = STREAM_BAUD_MAGIC1;
+	msg[2] = cmd;
+	msg[3] = 0;
+	msg[4] = (value >> 0) & 0xFF;
+	msg[5] = (value >> 8) & 0xFF;
+	msg[6] = (value >> 16) & 0xFF;
+	msg[7] = (value >> 24) & 0xFF;
+
+	uint8_t sum = 0;
+	for (uint8_t i = 0; i < STREAM_BAUD_MSG_SIZE; ++i) {
+		sum += msg[i];
+	}
+	msg[3] = (uint8_t)(-sum);
+}
+
+// Checks a message and extracts its command and value.
+// Returns 1 if the message is valid, 0 otherwise.
+uint8_t stream_baud_decode(const uint8_t msg[STREAM_BAUD_MSG_SIZE], uint8_t * cmd, uint32_t * value)
+{
+	if ((msg[0] != STREAM_BAUD_MAGIC0) || (msg[1] != STREAM_BAUD_MAGIC1)) {
+		return 0;
+	}
+
+	uint8_t sum = 0;
+	for (uint8_t i = 0; i < STREAM_BAUD_MSG_SIZE; ++i) {
+		sum += msg[i];
+	}
+	if (sum != 0) {
+		return 0;
+	}
+
+	*cmd = msg[2];
+	*value = msg[4] | (msg[5] << 8) | (msg[6] << 16) | ((uint32_t)msg[7] << 24);
+
+	return 1;
+}
+
+// Forgets any partially received message, e.g. after the baud rate changes.
+void stream_baud_parser_reset(stream_baud_parser * parser)
+{
+	parser->length = 0;
+}
+
+// Feeds one received byte to the parser.
+// Returns 1 once the last STREAM_BAUD_MSG_SIZE bytes form a valid message, which is written to cmd and value.
+uint8_t stream_baud_parse(stream_baud_parser * parser, uint8_t byte, uint8_t * cmd, uint32_t * value)
+{
+	// Slide the window by one byte when it's full, so a message is found no matter where it starts.
+	if (parser->length == STREAM_BAUD_MSG_SIZE) {
+		for (uint8_t i = 1; i < STREAM_BAUD_MSG_SIZE; ++i) {
+			parser->buffer[i - 1] = parser->buffer[i];
+		}
+		parser->length--;
+	}
+	parser->buffer[parser->length++] = byte;
+
+	if ((parser->length == STREAM_BAUD_MSG_SIZE) && stream_baud_decode(parser->buffer, cmd, value)) {
+		parser->length = 0;
+		return 1;
+	}
+
+	return 0;
+}
+
+// The UART divider is pclk / rate (in 1/16ths or 1/8ths of a bit time depending on oversampling),
+// so only rates that round to a divider close enough to the requested rate are usable.
+// 16x oversampling is preferred since it tolerates more noise; 8x doubles the highest rate.
+uint8_t stream_baud_supported(uint32_t pclk, uint32_t rate, uint8_t * over8)
+{
+	if (rate == 0) {
+		return 0;
+	}
+
+	uint32_t divider = (pclk + (rate / 2)) / rate;
+	if (divider < 8) {
+		return 0;
+	}
+
+	uint32_t actual = pclk / divider;
+	uint32_t error = (actual > rate) ? (actual - rate) : (rate - actual);
+	if (((uint64_t)error * 1000) > ((uint64_t)rate * STREAM_BAUD_MAX_ERROR_PERMILLE)) {
+		return 0;
+	}
+
+	*over8 = (divider < 16);
+	return 1;
+}
@@ -0,0 +1,54 @@
+#ifndef STREAM_BAUD_H
+#define STREAM_BAUD_H
+
+#include <stdint.h>
+
+// Baud rate negotiation messages exchanged between the firmware and read_image.py.
+//
+// Every message is 8 bytes: magic ('B', 'D'), command, check, value (LE32).
+// The check is the two's complement of the sum of the other bytes, so a message can be picked
+// out of a stream of frame data without being confused by payload bytes.
+//
+// Negotiation is driven by the host, one candidate rate at a time (highest first):
+//   host SWITCH(rate) -> firmware ACK(rate) (or NAK(rate) if the UART can't do it), both switch to rate
+//   host ECHO(pattern) -> firmware ECHO(pattern), repeated for a few patterns
+//   host CONFIRM(rate) -> firmware DONE(rate), the new rate is kept
+// If the echo test or the confirmation doesn't arrive in time, both sides fall back to the rate they were at before the
+// SWITCH (the base rate at boot, otherwise the last rate kept), and the host may go on with the next candidate.
+// Independently, firmware that sees repeated UART receive errors at a negotiated rate assumes the host lost it and drops
+// straight to the base rate, where the host can start negotiating again.
+
+#define STREAM_BAUD_MAGIC0				'B'
+#define STREAM_BAUD_MAGIC1				'D'
+
+#define STREAM_BAUD_MSG_SIZE			8
+
+#define STREAM_BAUD_CMD_SWITCH			0x01
+#define STREAM_BAUD_CMD_ACK				0x02
+#define STREAM_BAUD_CMD_NAK				0x03
+#define STREAM_BAUD_CMD_ECHO			0x04
+#define STREAM_BAUD_CMD_CONFIRM			0x05
+#define STREAM_BAUD_CMD_DONE			0x06
+
+// Rate the link starts at, and drops back to after repeated receive errors
+#define STREAM_BAUD_BASE_RATE			115200
+
+// Maximum difference between the requested and the actual baud rate, in tenths of a percent
+#define STREAM_BAUD_MAX_ERROR_PERMILLE	20
+
+// Collects incoming bytes until they form a valid message
+typedef struct stream_baud_parser {
+	uint8_t buffer[STREAM_BAUD_MSG_SIZE];
+	uint8_t length;
+} stream_baud_parser;
+
+// Message functions
+void stream_baud_encode(uint8_t msg[STREAM_BAUD_MSG_SIZE], uint8_t cmd, uint32_t value);
+uint8_t stream_baud_decode(const uint8_t msg[STREAM_BAUD_MSG_SIZE], uint8_t * cmd, uint32_t * value);
+void stream_baud_parser_reset(stream_baud_parser * parser);
+uint8_t stream_baud_parse(stream_baud_parser * parser, uint8_t byte, uint8_t * cmd, uint32_t * value);
+
+// Checks whether a UART clocked at pclk can run at rate, and whether it needs 8x oversampling to do so
+uint8_t stream_baud_supported(uint32_t pclk, uint32_t rate, uint8_t * over8);
+
+#endif // STREAM_BAUD_H
@@ -0,0 +1,125 @@
+#include "stream_compress.h"
+
+#include <string.h>
+
+// Difference between a byte and the one STREAM_COMPRESS_DELTA_STRIDE bytes before it.
+static uint8_t delta_at(const uint8_t src[], uint16_t i)
+{
+	uint8_t previous = (i >= STREAM_COMPRESS_DELTA_STRIDE) ? src[i - STREAM_COMPRESS_DELTA_STRIDE] : 0;
+	return (uint8_t)(src[i] - previous);
+}
+
+// Writes a chunk header for a chunk of raw length size and coded length coded.
+static void put_chunk_header(uint8_t dest[], uint16_t size, uint16_t coded)
+{
+	dest[0] = size & 0xFF;
+	dest[1] = (size >> 8) & 0xFF;
+	dest[2] = coded & 0xFF;
+	dest[3] = (coded >> 8) & 0xFF;
+}
+
+// Codes a chunk of raw capture data into dest (chunk header included), which must hold STREAM_COMPRESS_BOUND(size) bytes.
+// Returns the number of bytes written to dest, or 0 if dest is too small.
+uint16_t stream_compress_chunk(const uint8_t src[], uint16_t size, uint8_t dest[], uint16_t dest_size)
+{
+	if (dest_size < STREAM_COMPRESS_BOUND(size)) {
+		return 0;
+	}
+
+	// Coded bytes have to stay below the raw length to be worth sending, which also keeps them inside dest.
+	uint16_t out = STREAM_COMPRESS_CHUNK_HEADER_SIZE;
+	uint16_t limit = STREAM_COMPRESS_CHUNK_HEADER_SIZE + size;
+	uint16_t literal_token = 0;
+	uint8_t literal_length = 0;
+	uint16_t i = 0;
+
+	while ((i < size) && (out < limit)) {
+		// Measure the run of identical differences starting here.
+		uint8_t delta = delta_at(src, i);
+		uint8_t run = 1;
+		while (((i + run) < size) && (run < STREAM_COMPRESS_MAX_RUN) && (delta_at(src, i + run) == delta)) {
+			run++;
+		}
+
+		if (run >= STREAM_COMPRESS_MIN_RUN) {
+			// Runs need two bytes of room; the literal (if any) before this run is already complete.
+			if ((out + 2) > limit) {
+				out = limit;
+				break;
+			}
+			literal_length = 0;
+			dest[out++] = 0x80 | (run - STREAM_COMPRESS_MIN_RUN);
+			dest[out++] = delta;
+			i += run;
+		}
+		else {
+			// Start a new literal (reserving its token) or extend the current one.
+			if (literal_length == 0) {
+				literal_token = out++;
+				if (out >= limit) {
+					break;
+				}
+			}
+			dest[out++] = delta;
+			dest[literal_token] = literal_length;
+			literal_length++;
+			if (literal_length == STREAM_COMPRESS_MAX_LITERAL) {
+				literal_length = 0;
+			}
+			i++;
+		}
+	}
+
+	// Coding didn't pay off, so send the raw bytes.
+	if ((i < size) || (out >= limit)) {
+		memcpy(&dest[STREAM_COMPRESS_CHUNK_HEADER_SIZE], src, size);
+		put_chunk_header(dest, size, size);
+		return STREAM_COMPRESS_BOUND(size);
+	}
+
+	put_chunk_header(dest, size, out - STREAM_COMPRESS_CHUNK_HEADER_SIZE);
+	return out;
+}
+
+// Decodes a chunk made by stream_compress_chunk (chunk header included) into dest.
+// Returns the raw length of the chunk, or 0 if the chunk is malformed or doesn't fit in dest.
+uint16_t stream_decompress_chunk(const uint8_t src[], uint16_t size, uint8_t dest[], uint16_t dest_size)
+{
+	if (size < STREAM_COMPRESS_CHUNK_HEADER_SIZE) {
+		return 0;
+	}
+
+	uint16_t raw = src[0] | (src[1] << 8);
+	uint16_t coded = src[2] | (src[3] << 8);
+	if ((raw > dest_size) || ((STREAM_COMPRESS_CHUNK_HEADER_SIZE + coded) > size)) {
+		return 0;
+	}
+
+	const uint8_t * in = &src[STREAM_COMPRESS_CHUNK_HEADER_SIZE];
+
+	// Raw chunk, sent as-is.
+	if (coded == raw) {
+		memcpy(dest, in, raw);
+		return raw;
+	}
+
+	uint16_t in_pos = 0;
+	uint16_t out = 0;
+	while (in_pos < coded) {
+		uint8_t token = in[in_pos++];
+		uint8_t count = (token & 0x80) ? (token - 0x80 + STREAM_COMPRESS_MIN_RUN) : (token + 1);
+
+		if (((out + count) > raw) || ((in_pos + ((token & 0x80) ? 1 : count)) > coded)) {
+			return 0;
+		}
+
+		for (uint8_t j = 0; j < count; ++j) {
+			uint8_t delta = (token & 0x80) ? in[in_pos] : in[in_pos + j];
+			uint8_t previous = (out >= STREAM_COMPRESS_DELTA_STRIDE) ? dest[out - STREAM_COMPRESS_DELTA_STRIDE] : 0;
+			dest[out++] = (uint8_t)(previous + delta);
+		}
+		in_pos += (token & 0x80) ? 1 : count;
+	}
+
+	return (out == raw) ? raw : 0;
+}
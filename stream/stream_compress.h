@@ -0,0 +1,32 @@
+#ifndef STREAM_COMPRESS_H
+#define STREAM_COMPRESS_H
+
+#include <stdint.h>
+
+// Lightweight lossless codec for the payload of uncompressed (raw/YUV) captures, applied to each transfer chunk on its own.
+// It needs no RAM beyond the input and output buffers, so it can run between SPI reads on the MCU.
+//
+// Each chunk is sent as a chunk header followed by its coded bytes:
+//   raw length (LE16), coded length (LE16), coded bytes
+// If coding wouldn't make the chunk smaller (e.g. JPEG data), the raw bytes are sent instead and both lengths are equal.
+//
+// Coding works on the difference between each byte and the one STREAM_COMPRESS_DELTA_STRIDE bytes before it
+// (bytes before the start of the chunk count as 0), which turns smooth image areas into runs of small values.
+// The differences are then run-length coded with tokens:
+//   0x00-0x7F: the next (token + 1) bytes are literal differences
+//   0x80-0xFF: the next byte is a difference repeated (token - 0x80 + 3) times
+
+#define STREAM_COMPRESS_CHUNK_HEADER_SIZE	4
+#define STREAM_COMPRESS_DELTA_STRIDE		2
+
+#define STREAM_COMPRESS_MAX_LITERAL			128
+#define STREAM_COMPRESS_MIN_RUN				3
+#define STREAM_COMPRESS_MAX_RUN				130
+
+// Largest possible coded chunk (chunk header + raw bytes) for a given raw length
+#define STREAM_COMPRESS_BOUND(size)			((size) + STREAM_COMPRESS_CHUNK_HEADER_SIZE)
+
+uint16_t stream_compress_chunk(const uint8_t src[], uint16_t size, uint8_t dest[], uint16_t dest_size);
+uint16_t stream_decompress_chunk(const uint8_t src[], uint16_t size, uint8_t dest[], uint16_t dest_size);
+
+#endif // STREAM_COMPRESS_H
@@ -0,0 +1,74 @@
+#ifndef STREAM_FRAME_H
+#define STREAM_FRAME_H
+
+#include <stdint.h>
+
+// Binary frame protocol used to send captures over UART.
+//
+// A frame is a header, the payload (capture data, sent in as many chunks as needed) and a trailer:
+//   header  (16 bytes): sync word, version, flags, resolution, header check, sequence (LE32), payload length (LE32)
+//   payload (length bytes)
+//   trailer (4 bytes):  CRC32 (LE32) over the header after the sync word and the payload
+// The header check is the two's complement of the sum of the other header bytes after the sync word,
+// so a receiver can reject a false sync inside the payload without waiting for the payload to arrive.
+//
+// With STREAM_FRAME_FLAG_COMPRESSED set, the payload is sent as coded chunks (see stream_compress.h) that decode
+// to length bytes; the length and the CRC32 still refer to the decoded payload.
+//
+// With STREAM_FRAME_FLAG_TIMESTAMPS set, a timestamp block goes between the payload and the trailer and is covered by
+// the CRC32: STREAM_FRAME_STAMP_COUNT MCU timestamps (LE32, ms since boot), indexed by the STREAM_FRAME_STAMP_* defines.
+
+#define STREAM_FRAME_SYNC0				0xA5
+#define STREAM_FRAME_SYNC1				0x5A
+#define STREAM_FRAME_SYNC2				0x0F
+#define STREAM_FRAME_SYNC3				0xF0
+
+#define STREAM_FRAME_VERSION			1
+
+// Header flags
+#define STREAM_FRAME_FLAG_COMPRESSED	0x01
+#define STREAM_FRAME_FLAG_TIMESTAMPS	0x02
+
+// Timestamps in the timestamp block
+#define STREAM_FRAME_STAMP_TRIGGER		0	// capture requested
+#define STREAM_FRAME_STAMP_CAPTURED		1	// capture in the FIFO
+#define STREAM_FRAME_STAMP_FIRST_OUT	2	// header started going out
+#define STREAM_FRAME_STAMP_LAST_OUT		3	// last payload byte gone out
+#define STREAM_FRAME_STAMP_COUNT		4
+#define STREAM_FRAME_TIMESTAMPS_SIZE	(STREAM_FRAME_STAMP_COUNT * 4)
+
+#define STREAM_FRAME_HEADER_SIZE		16
+#define STREAM_FRAME_TRAILER_SIZE		4
+
+// Offsets of the header fields
+#define STREAM_FRAME_OFFSET_VERSION		4
+#define STREAM_FRAME_OFFSET_FLAGS		5
+#define STREAM_FRAME_OFFSET_RES			6
+#define STREAM_FRAME_OFFSET_CHECK		7
+#define STREAM_FRAME_OFFSET_SEQUENCE	8
+#define STREAM_FRAME_OFFSET_LENGTH		12
+
+typedef struct stream_frame {
+	// Running CRC32 over the header and the payload sent so far
+	uint32_t crc;
+
+	// Payload length promised in the header, and how much of it has been passed to stream_frame_update
+	uint32_t length;
+	uint32_t sent;
+
+	// Set by stream_frame_abort: the trailer is made not to match, so the receiver drops the frame
+	uint8_t lost;
+} stream_frame;
+
+// CRC32 (IEEE 802.3, same as zlib's crc32) functions
+uint32_t stream_crc32_update(uint32_t crc, const uint8_t data[], uint32_t size);
+uint32_t stream_crc32(const uint8_t data[], uint32_t size);
+
+// Framing functions
+void stream_frame_begin(stream_frame * frame, uint8_t header[STREAM_FRAME_HEADER_SIZE], uint8_t flags, uint8_t resolution, uint32_t sequence, uint32_t length);
+void stream_frame_update(stream_frame * frame, const uint8_t data[], uint16_t size);
+void stream_frame_abort(stream_frame * frame);
+void stream_frame_timestamps(stream_frame * frame, uint8_t block[STREAM_FRAME_TIMESTAMPS_SIZE], const uint32_t stamps[STREAM_FRAME_STAMP_COUNT]);
+void stream_frame_end(stream_frame * frame, uint8_t trailer[STREAM_FRAME_TRAILER_SIZE]);
+
+#endif // STREAM_FRAME_H
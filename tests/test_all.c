@@ -1,13 +1,24 @@
 #include "tests_hal_mock/tests_hal_mock.h"
 #include "tests_ov2640/test_ov2640.h"
+#include "tests_sim/test_ov2640_sim.h"
+#include "tests_stream/test_stream_baud.h"
+#include "tests_stream/test_stream_compress.h"
+#include "tests_stream/test_stream_frame.h"
 
 int main(void) {    
     run_hal_mock_general_tests();
+    run_hal_mock_dma_tests();
     run_hal_mock_gpio_tests();
     run_hal_mock_i2c_tests();
     run_hal_mock_spi_tests();
+    run_hal_mock_uart_tests();
 
     run_ov2640_tests();
+    run_ov2640_sim_tests();
+
+    run_stream_baud_tests();
+    run_stream_compress_tests();
+    run_stream_frame_tests();
 
     return 0;
 }
\ No newline at end of file
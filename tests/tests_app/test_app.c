@@ -0,0 +1,197 @@
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test_app.h"
+
+// The camera application (app.c) run against the mock HAL and the OV2640 simulator like app_host runs it, with its
+// UART sending into a pipe that the tests read the frames back from.
+// It's an executable of its own, as the application owns the UART callbacks that test_all's mock HAL tests define.
+
+// The board's peripherals, set up like app_host does
+static I2C_HandleTypeDef hi2c1;
+static SPI_HandleTypeDef hspi1;
+static DMA_HandleTypeDef hdma_spi1_rx;
+static DMA_HandleTypeDef hdma_spi1_tx;
+static UART_HandleTypeDef huart2;
+static DMA_HandleTypeDef hdma_usart2_tx;
+static GPIO_TypeDef gpioa;
+static ov2640_sim camera_sim;
+
+// Pipe the UART sends into, and what has been read out of it
+static int uart_pipe[2];
+static uint8_t uart_data[65536];
+static size_t uart_length = 0;
+
+// Faults injected into the camera's SPI once fault_after_dma_reads more DMA reads have completed (0: never)
+static Mock_HAL_FaultsTypeDef spi_faults;
+static uint32_t fault_after_dma_reads = 0;
+
+// A frame as the receiver sees it
+typedef struct {
+    uint32_t sequence;
+    uint32_t length;
+    const uint8_t * payload;
+    uint8_t crc_ok;
+} received_frame;
+
+void Error_Handler(void) {
+    fprintf(stderr, "test_app: peripheral setup failed\n");
+    exit(EXIT_FAILURE);
+}
+
+// A DMA read of the camera's FIFO is done; arms the faults once enough of them are
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi) {
+    if((hspi == &hspi1) && (fault_after_dma_reads > 0)) {
+        fault_after_dma_reads--;
+        if(fault_after_dma_reads == 0) {
+            Mock_SPI_Set_Faults(&hspi1, &spi_faults);
+        }
+    }
+}
+
+static uint32_t get_le32(const uint8_t * src) {
+    return src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+// Sets up the peripherals like app_host, with the simulated camera attached and the UART sending into the pipe
+static void setup_board(void) {
+    HAL_Init();
+
+    hi2c1.Init.ClockSpeed = 100000;
+    HAL_I2C_Init(&hi2c1);
+
+    hspi1.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+    HAL_SPI_Init(&hspi1);
+    __HAL_LINKDMA(&hspi1, hdmarx, hdma_spi1_rx);
+    __HAL_LINKDMA(&hspi1, hdmatx, hdma_spi1_tx);
+
+    assert_int_equal(pipe(uart_pipe), 0);
+    fcntl(uart_pipe[0], F_SETFL, O_NONBLOCK);
+    huart2.Init.BaudRate = 115200;
+    huart2.Init.WordLength = UART_WORDLENGTH_8B;
+    huart2.Init.StopBits = UART_STOPBITS_1;
+    huart2.Init.Parity = UART_PARITY_NONE;
+    huart2.Init.Mode = UART_MODE_TX_RX;
+    huart2.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+    huart2.Init.OverSampling = UART_OVERSAMPLING_16;
+    Mock_UART_Attach_Fd(&huart2, uart_pipe[1], -1);
+    HAL_UART_Init(&huart2);
+    __HAL_LINKDMA(&huart2, hdmatx, hdma_usart2_tx);
+
+    hdma_spi1_rx.State = HAL_DMA_STATE_READY;
+    hdma_spi1_tx.State = HAL_DMA_STATE_READY;
+    hdma_usart2_tx.State = HAL_DMA_STATE_READY;
+
+    ov2640_sim_init(&camera_sim);
+    assert_int_equal(ov2640_sim_attach(&camera_sim, &hspi1, &gpioa, GPIO_PIN_8, &hi2c1), HAL_OK);
+
+    app_config config = {
+        .i2c = &hi2c1,
+        .spi = &hspi1,
+        .spi_dma_rx = &hdma_spi1_rx,
+        .spi_cs_port = &gpioa,
+        .spi_cs_pin = GPIO_PIN_8,
+        .uart = &huart2,
+        .capture_interval = 0,
+    };
+    app_setup(&config);
+}
+
+// Lets what the application queued go out on the line, then reads it all from the pipe
+static void drain_uart(void) {
+    while((hdma_usart2_tx.State == HAL_DMA_STATE_BUSY) && Mock_HAL_Run_Next_Event());
+
+    ssize_t got;
+    while((got = read(uart_pipe[0], &uart_data[uart_length], sizeof(uart_data) - uart_length)) > 0) {
+        uart_length += (size_t)got;
+    }
+}
+
+// Parses the frame at offset in what the UART sent, checking its trailer like the receiver does
+// Returns the offset of the next frame.
+static size_t parse_frame(size_t offset, received_frame * frame) {
+    const uint8_t * header = &uart_data[offset];
+    assert_true(offset + STREAM_FRAME_HEADER_SIZE <= uart_length);
+    assert_int_equal(header[0], STREAM_FRAME_SYNC0);
+    assert_int_equal(header[1], STREAM_FRAME_SYNC1);
+    assert_int_equal(header[2], STREAM_FRAME_SYNC2);
+    assert_int_equal(header[3], STREAM_FRAME_SYNC3);
+    assert_int_equal(header[STREAM_FRAME_OFFSET_FLAGS], STREAM_FRAME_FLAG_TIMESTAMPS);
+
+    frame->sequence = get_le32(&header[STREAM_FRAME_OFFSET_SEQUENCE]);
+    frame->length = get_le32(&header[STREAM_FRAME_OFFSET_LENGTH]);
+    frame->payload = &header[STREAM_FRAME_HEADER_SIZE];
+
+    // The CRC covers the header after the sync word, the payload and the timestamp block
+    size_t covered = STREAM_FRAME_HEADER_SIZE - STREAM_FRAME_OFFSET_VERSION + frame->length + STREAM_FRAME_TIMESTAMPS_SIZE;
+    assert_true(offset + STREAM_FRAME_OFFSET_VERSION + covered + STREAM_FRAME_TRAILER_SIZE <= uart_length);
+    uint32_t crc = stream_crc32(&header[STREAM_FRAME_OFFSET_VERSION], covered);
+    frame->crc_ok = (get_le32(&header[STREAM_FRAME_OFFSET_VERSION + covered]) == crc);
+
+    return offset + STREAM_FRAME_OFFSET_VERSION + covered + STREAM_FRAME_TRAILER_SIZE;
+}
+
+// Test Case: Verify that a DMA read of the capture failing reaches the receiver as a lost frame, with the link in sync
+void test_app_dma_read_fault_loses_frame(void **state) {
+    // Arrange: The application set up with the simulated camera (7680 byte frames at 320x240, read 1000 bytes at a time)
+    setup_board();
+
+    // Act: Send a frame whose second DMA read of the capture fails, then one without faults
+    spi_faults.ErrorPpm[MOCK_HAL_FAULT_READ] = 1000000;
+    fault_after_dma_reads = 1;
+    app_loop();
+    Mock_SPI_Set_Faults(&hspi1, NULL);
+    app_loop();
+    drain_uart();
+
+    // Assert: The failed read should be the only fault injected
+    assert_int_equal(spi_faults.Errors, 1);
+
+    // Assert: The first frame should keep its promised length (the chunk before the fault, then padding) but not
+    // match its trailer, so the receiver drops it
+    received_frame lost;
+    received_frame whole;
+    size_t next = parse_frame(0, &lost);
+    assert_int_equal(lost.sequence, 0);
+    assert_int_equal(lost.length, 7680);
+    assert_false(lost.crc_ok);
+    assert_memory_equal(lost.payload, camera_sim.capture_frame->data, 1000);
+    for(uint32_t i = 1000; i < lost.length; i++) {
+        assert_int_equal(lost.payload[i], 0);
+    }
+
+    // Assert: The receiver should still be in sync for the next frame, which comes through whole
+    next = parse_frame(next, &whole);
+    assert_int_equal(whole.sequence, 1);
+    assert_int_equal(whole.length, 7680);
+    assert_true(whole.crc_ok);
+    assert_memory_equal(whole.payload, camera_sim.capture_frame->data, whole.length);
+    assert_int_equal(next, uart_length);
+
+    ov2640_sim_deinit(&camera_sim);
+    close(uart_pipe[0]);
+    close(uart_pipe[1]);
+}
+
+const struct CMUnitTest app_frame_tests[NUM_APP_FRAME_TESTS] = {
+    cmocka_unit_test(test_app_dma_read_fault_loses_frame),
+};
+
+void run_app_tests(void) {
+    int status = 0;
+
+    status += cmocka_run_group_tests(app_frame_tests, NULL, NULL);
+
+    assert_int_equal(status, 0);
+}
+
+int main(void) {
+    run_app_tests();
+
+    return 0;
+}
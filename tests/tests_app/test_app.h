@@ -0,0 +1,28 @@
+#ifndef TEST_APP_H
+#define TEST_APP_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <cmocka.h>
+
+#include "../../app/app.h"
+#include "../../sim/ov2640_sim.h"
+#include "../../stream/stream_frame.h"
+
+// Defines (number of tests, change as more are added)
+#define NUM_APP_FRAME_TESTS 1
+
+// Global test arrays
+extern const struct CMUnitTest app_frame_tests[NUM_APP_FRAME_TESTS];
+
+// Declaration of test functions
+
+// Running all tests
+void run_app_tests(void);
+
+// Frame Tests
+void test_app_dma_read_fault_loses_frame(void **state);
+
+#endif // TEST_APP_H
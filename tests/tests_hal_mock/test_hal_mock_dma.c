@@ -0,0 +1,100 @@
+#include "test_hal_mock_dma.h"
+
+// Definition of test arrays
+
+// HAL_DMA_GetState Tests
+const struct CMUnitTest hal_dma_get_state_tests[NUM_HAL_DMA_GET_STATE_TESTS] = {
+    cmocka_unit_test(test_hal_dma_get_state_ready_keeps_time),
+    cmocka_unit_test(test_hal_dma_get_state_busy_runs_to_completion),
+};
+
+// HAL_DMA_Abort Tests
+const struct CMUnitTest hal_dma_abort_tests[NUM_HAL_DMA_ABORT_TESTS] = {
+    cmocka_unit_test(test_hal_dma_abort_stops_transfer),
+    cmocka_unit_test(test_hal_dma_abort_not_busy),
+};
+
+// Transfer complete callback for the tests: counts completions of the stream
+static uint8_t test_dma_completions = 0;
+
+static void test_dma_xfer_cplt(DMA_HandleTypeDef *hdma) {
+    test_dma_completions++;
+}
+
+void run_hal_mock_dma_tests(void) {
+    int status = 0;
+
+    status += cmocka_run_group_tests(hal_dma_get_state_tests, NULL, NULL);
+    status += cmocka_run_group_tests(hal_dma_abort_tests, NULL, NULL);
+
+    assert_int_equal(status, 0);
+}
+
+// Test Case: Verify that polling a ready stream returns straight away, without moving time on
+void test_hal_dma_get_state_ready_keeps_time(void **state) {
+    // Arrange: Initialize HAL, create a ready stream
+    HAL_Init();
+    DMA_HandleTypeDef hdma = {0};
+    hdma.State = HAL_DMA_STATE_READY;
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Call HAL_DMA_GetState
+    HAL_DMA_StateTypeDef dma_state = HAL_DMA_GetState(&hdma);
+
+    // Assert: The stream should be ready, with no time passed
+    assert_int_equal(dma_state, HAL_DMA_STATE_READY);
+    assert_int_equal(Mock_HAL_GetTimeNs(), ns_start);
+}
+
+// Test Case: Verify that polling a busy stream until it's ready takes the transfer's time and completes it once
+void test_hal_dma_get_state_busy_runs_to_completion(void **state) {
+    // Arrange: Initialize HAL, start a 300 us transfer on a stream
+    HAL_Init();
+    DMA_HandleTypeDef hdma = {0};
+    hdma.XferCpltCallback = test_dma_xfer_cplt;
+    test_dma_completions = 0;
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+    Mock_DMA_Start(&hdma, 300000U);
+
+    // Act: Poll the stream until it's ready
+    HAL_DMA_StateTypeDef busy_state = hdma.State;
+    while(HAL_DMA_GetState(&hdma) != HAL_DMA_STATE_READY);
+
+    // Assert: The transfer should have taken its time and completed through the callback
+    assert_int_equal(busy_state, HAL_DMA_STATE_BUSY);
+    assert_int_equal(Mock_HAL_GetTimeNs() - ns_start, 300000U);
+    assert_int_equal(test_dma_completions, 1);
+}
+
+// Test Case: Verify that an aborted transfer never completes
+void test_hal_dma_abort_stops_transfer(void **state) {
+    // Arrange: Initialize HAL, start a transfer on a stream
+    HAL_Init();
+    DMA_HandleTypeDef hdma = {0};
+    hdma.XferCpltCallback = test_dma_xfer_cplt;
+    test_dma_completions = 0;
+    Mock_DMA_Start(&hdma, 300000U);
+
+    // Act: Abort the transfer, then delay past its completion
+    HAL_StatusTypeDef rc = HAL_DMA_Abort(&hdma);
+    HAL_Delay(1);
+
+    // Assert: The stream should be ready without having completed the transfer
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(hdma.State, HAL_DMA_STATE_READY);
+    assert_int_equal(test_dma_completions, 0);
+}
+
+// Test Case: Verify that aborting a stream without a transfer in flight fails
+void test_hal_dma_abort_not_busy(void **state) {
+    // Arrange: Initialize HAL, create a ready stream
+    HAL_Init();
+    DMA_HandleTypeDef hdma = {0};
+    hdma.State = HAL_DMA_STATE_READY;
+
+    // Act: Call HAL_DMA_Abort
+    HAL_StatusTypeDef rc = HAL_DMA_Abort(&hdma);
+
+    // Assert: The function should fail
+    assert_int_equal(rc, HAL_ERROR);
+}
@@ -0,0 +1,33 @@
+#ifndef TEST_HAL_MOCK_DMA_H
+#define TEST_HAL_MOCK_DMA_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <cmocka.h>
+
+#include "../../mocks/hal_mock_dma.h"
+
+// Defines (number of tests, change as more are added)
+#define NUM_HAL_DMA_GET_STATE_TESTS 2
+#define NUM_HAL_DMA_ABORT_TESTS 2
+
+// Global test arrays
+extern const struct CMUnitTest hal_dma_get_state_tests[NUM_HAL_DMA_GET_STATE_TESTS];
+extern const struct CMUnitTest hal_dma_abort_tests[NUM_HAL_DMA_ABORT_TESTS];
+
+// Declaration of test functions
+
+// Running all tests
+void run_hal_mock_dma_tests(void);
+
+// HAL_DMA_GetState Tests
+void test_hal_dma_get_state_ready_keeps_time(void **state);
+void test_hal_dma_get_state_busy_runs_to_completion(void **state);
+
+// HAL_DMA_Abort Tests
+void test_hal_dma_abort_stops_transfer(void **state);
+void test_hal_dma_abort_not_busy(void **state);
+
+#endif // TEST_HAL_MOCK_DMA_H
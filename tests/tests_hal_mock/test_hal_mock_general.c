@@ -1,4 +1,57 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
 #include "test_hal_mock_general.h"
+#include "test_hal_mock_trace.h"
+
+// Real time elapsed since start_ts, in ms
+static uint32_t real_ms_since(const struct timespec *start_ts) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start_ts->tv_sec) * 1000 + (now.tv_nsec - start_ts->tv_nsec) / 1000000;
+}
+
+// Signals the condition passed as argument once twice the virtual wait limit has passed in real time
+static void *wake_after_wait_limit(void *cond) {
+    struct timespec delay = {0, 2 * MOCK_HAL_VIRTUAL_WAIT_LIMIT * 1000000L};
+    nanosleep(&delay, NULL);
+    pthread_cond_broadcast((pthread_cond_t *)cond);
+    return NULL;
+}
+
+// A board run on its own thread by test_mock_hal_board_threads_run_separately, delaying delays times by delay
+typedef struct {
+    Mock_HAL_BoardTypeDef board;
+    uint32_t delay;
+    uint32_t delays;
+    uint32_t tick;
+} test_board_run;
+
+static void *run_board_delays(void *arg) {
+    test_board_run *run = (test_board_run *)arg;
+    Mock_HAL_Board_Select(&run->board);
+    HAL_Init();
+    for(uint32_t i = 0; i < run->delays; i++) {
+        HAL_Delay(run->delay);
+    }
+    run->tick = HAL_GetTick();
+    return NULL;
+}
+
+// Event for the Mock_HAL_Event tests: records the tick it ran at, in the order of all test events run
+typedef struct {
+    uint32_t tick;
+    uint8_t order;
+} test_event_record;
+
+static uint8_t test_events_run = 0;
+
+static void test_event_fire(void *context) {
+    test_event_record *record = context;
+    record->tick = HAL_GetTick();
+    record->order = ++test_events_run;
+}
 
 // HAL_Init Tests
 const struct CMUnitTest hal_mock_hal_init_tests[NUM_HAL_MOCK_HAL_INIT_TESTS] = {
@@ -13,6 +66,53 @@ const struct CMUnitTest hal_mock_delay_tests[NUM_HAL_MOCK_DELAY_TESTS] = {
     cmocka_unit_test(test_hal_mock_delay_long_duration),
     cmocka_unit_test(test_hal_mock_delay_consecutive),
     cmocka_unit_test(test_hal_mock_delay_no_hal_init),
+    cmocka_unit_test(test_hal_mock_delay_virtual_does_not_sleep),
+    cmocka_unit_test(test_hal_mock_delay_real_time_sleeps),
+};
+
+// HAL_GetTick Tests
+const struct CMUnitTest hal_mock_get_tick_tests[NUM_HAL_MOCK_GET_TICK_TESTS] = {
+    cmocka_unit_test(test_hal_mock_get_tick_is_current_time),
+    cmocka_unit_test(test_hal_mock_get_tick_follows_delay),
+};
+
+// Mock_HAL_Wait Tests
+const struct CMUnitTest mock_hal_wait_tests[NUM_MOCK_HAL_WAIT_TESTS] = {
+    cmocka_unit_test(test_mock_hal_wait_timeout_charges_virtual_time),
+    cmocka_unit_test(test_mock_hal_wait_max_delay_keeps_waiting),
+};
+
+// Mock_HAL_Bus_Time Tests
+const struct CMUnitTest mock_hal_bus_time_tests[NUM_MOCK_HAL_BUS_TIME_TESTS] = {
+    cmocka_unit_test(test_mock_hal_bus_time_adds_up_to_ticks),
+    cmocka_unit_test(test_mock_hal_bus_time_untimed_bus),
+};
+
+// Mock_HAL_Event Tests
+const struct CMUnitTest mock_hal_event_tests[NUM_MOCK_HAL_EVENT_TESTS] = {
+    cmocka_unit_test(test_mock_hal_event_delay_runs_due_events_in_order),
+    cmocka_unit_test(test_mock_hal_event_run_next_moves_time_on),
+    cmocka_unit_test(test_mock_hal_event_cancelled_does_not_run),
+};
+
+// Mock_HAL_Faults Tests
+const struct CMUnitTest mock_hal_fault_tests[NUM_MOCK_HAL_FAULT_TESTS] = {
+    cmocka_unit_test(test_mock_hal_fault_same_seed_same_faults),
+    cmocka_unit_test(test_mock_hal_fault_roll_rate_limits),
+    cmocka_unit_test(test_mock_hal_fault_flip_bits_counts_flips),
+};
+
+// Mock_HAL_Trace Tests
+const struct CMUnitTest mock_hal_trace_tests[NUM_MOCK_HAL_TRACE_TESTS] = {
+    cmocka_unit_test(test_mock_hal_trace_records_delays),
+    cmocka_unit_test(test_mock_hal_trace_names_phases_once),
+    cmocka_unit_test(test_mock_hal_trace_stopped_records_nothing),
+};
+
+// Mock_HAL_Board Tests
+const struct CMUnitTest mock_hal_board_tests[NUM_MOCK_HAL_BOARD_TESTS] = {
+    cmocka_unit_test(test_mock_hal_board_keeps_own_state),
+    cmocka_unit_test(test_mock_hal_board_threads_run_separately),
 };
 
 // Running all tests
@@ -28,76 +128,109 @@ void run_hal_mock_general_tests(void) {
         cmocka_unit_test(test_hal_mock_delay_long_duration),
         cmocka_unit_test(test_hal_mock_delay_consecutive),
         cmocka_unit_test(test_hal_mock_delay_no_hal_init),
+        cmocka_unit_test(test_hal_mock_delay_virtual_does_not_sleep),
+        cmocka_unit_test(test_hal_mock_delay_real_time_sleeps),
+
+        // HAL_GetTick Tests
+        cmocka_unit_test(test_hal_mock_get_tick_is_current_time),
+        cmocka_unit_test(test_hal_mock_get_tick_follows_delay),
+
+        // Mock_HAL_Wait Tests
+        cmocka_unit_test(test_mock_hal_wait_timeout_charges_virtual_time),
+        cmocka_unit_test(test_mock_hal_wait_max_delay_keeps_waiting),
+
+        // Mock_HAL_Bus_Time Tests
+        cmocka_unit_test(test_mock_hal_bus_time_adds_up_to_ticks),
+        cmocka_unit_test(test_mock_hal_bus_time_untimed_bus),
+
+        // Mock_HAL_Event Tests
+        cmocka_unit_test(test_mock_hal_event_delay_runs_due_events_in_order),
+        cmocka_unit_test(test_mock_hal_event_run_next_moves_time_on),
+        cmocka_unit_test(test_mock_hal_event_cancelled_does_not_run),
+
+        // Mock_HAL_Faults Tests
+        cmocka_unit_test(test_mock_hal_fault_same_seed_same_faults),
+        cmocka_unit_test(test_mock_hal_fault_roll_rate_limits),
+        cmocka_unit_test(test_mock_hal_fault_flip_bits_counts_flips),
+
+        // Mock_HAL_Trace Tests
+        cmocka_unit_test(test_mock_hal_trace_records_delays),
+        cmocka_unit_test(test_mock_hal_trace_names_phases_once),
+        cmocka_unit_test(test_mock_hal_trace_stopped_records_nothing),
+
+        // Mock_HAL_Board Tests
+        cmocka_unit_test(test_mock_hal_board_keeps_own_state),
+        cmocka_unit_test(test_mock_hal_board_threads_run_separately),
     };
 
     cmocka_run_group_tests(hal_mock_general_tests, NULL, NULL);
 }
 
-// Test case: Verify that hal_initialized starts at 0
+// Test case: Verify that the board's Initialized flag starts at 0
 void test_hal_mock_hal_init_starts_at_zero(void **state) {
-    // Arrange: No specific arrangement needed, as the default value of hal_initialized is 0
+    // Arrange: No specific arrangement needed, as the default value of the board's Initialized flag is 0
 
     // Act: No specific action needed for this test case
 
-    // Assert: Verify that hal_initialized is 0
-    assert_int_equal(hal_initialized, 0);
+    // Assert: Verify that the board's Initialized flag is 0
+    assert_int_equal(hal_board->Initialized, 0);
 }
 
-// Test case: Verify that calling HAL_Init changes hal_initialized from 0 to 1
+// Test case: Verify that calling HAL_Init changes the board's Initialized flag from 0 to 1
 void test_hal_mock_hal_init_changes_initialized(void **state) {
-    // Arrange: Set hal_initialized to 0 to simulate uninitialized state
-    hal_initialized = 0;
+    // Arrange: Set the board's Initialized flag to 0 to simulate uninitialized state
+    hal_board->Initialized = 0;
 
     // Act: Initialize HAL
     HAL_Init();
 
-    // Assert: Verify that hal_initialized is changed to 1
-    assert_int_equal(hal_initialized, 1);
+    // Assert: Verify that the board's Initialized flag is changed to 1
+    assert_int_equal(hal_board->Initialized, 1);
 }
 
 // Test Case: Delay for 0 milliseconds
 void test_hal_mock_delay_zero(void **state) {
     // Arrange: Record the current time
-    uint32_t t_start = hal_current_time;
+    uint32_t t_start = hal_board->CurrentTime;
 
     // Act: Initialize HAL and perform delay for 0 milliseconds
     HAL_Init();
     HAL_Delay(0);
 
     // Assert: Verify that time remains unchanged
-    assert_int_equal(hal_current_time, t_start);
+    assert_int_equal(hal_board->CurrentTime, t_start);
 }
 
 // Test Case: Delay for a short duration
 void test_hal_mock_delay_short_duration(void **state) {
     // Arrange: Record the current time
-    uint32_t t_start = hal_current_time;
+    uint32_t t_start = hal_board->CurrentTime;
 
     // Act: Initialize HAL and perform delay for 10 milliseconds
     HAL_Init();
     HAL_Delay(10);
 
     // Assert: Verify that time has advanced by 10 milliseconds
-    assert_int_equal(hal_current_time, t_start + 10);
+    assert_int_equal(hal_board->CurrentTime, t_start + 10);
 }
 
 // Test Case: Delay for a longer duration
 void test_hal_mock_delay_long_duration(void **state) {
     // Arrange: Record the current time
-    uint32_t t_start = hal_current_time;
+    uint32_t t_start = hal_board->CurrentTime;
 
     // Act: Initialize HAL and perform delay for 1000 milliseconds
     HAL_Init();
     HAL_Delay(1000);
 
     // Assert: Verify that time has advanced by 1000 milliseconds
-    assert_int_equal(hal_current_time, t_start + 1000);
+    assert_int_equal(hal_board->CurrentTime, t_start + 1000);
 }
 
 // Test Case: Call delay consecutively
 void test_hal_mock_delay_consecutive(void **state) {
     // Arrange: Record the current time
-    uint32_t t_start = hal_current_time;
+    uint32_t t_start = hal_board->CurrentTime;
 
     // Act: Initialize HAL and perform two consecutive delays for 10 milliseconds each
     HAL_Init();
@@ -105,18 +238,452 @@ void test_hal_mock_delay_consecutive(void **state) {
     HAL_Delay(10);
 
     // Assert: Verify that time has advanced by 20 milliseconds
-    assert_int_equal(hal_current_time, t_start + 20);
+    assert_int_equal(hal_board->CurrentTime, t_start + 20);
 }
 
 // Test Case: Call delay before initializing HAL (No delay should happen)
 void test_hal_mock_delay_no_hal_init(void **state) {
-    // Arrange: Set hal_initialized to 0 to simulate uninitialized state, Record the current time
-    hal_initialized = 0;
-    uint32_t t_start = hal_current_time;
+    // Arrange: Set the board's Initialized flag to 0 to simulate uninitialized state, Record the current time
+    hal_board->Initialized = 0;
+    uint32_t t_start = hal_board->CurrentTime;
 
     // Act: Attempt to perform a delay without initializing HAL
     HAL_Delay(100);
 
     // Assert: Verify that time remains unchanged
-    assert_int_equal(hal_current_time, t_start);
+    assert_int_equal(hal_board->CurrentTime, t_start);
+}
+
+// Test Case: Verify that a delay in virtual time (the default) doesn't really sleep
+void test_hal_mock_delay_virtual_does_not_sleep(void **state) {
+    // Arrange: Record the current simulated and real time
+    uint32_t t_start = hal_board->CurrentTime;
+    struct timespec real_start;
+    clock_gettime(CLOCK_MONOTONIC, &real_start);
+
+    // Act: Initialize HAL and perform a delay for 5 seconds
+    HAL_Init();
+    HAL_Delay(5000);
+
+    // Assert: Verify that simulated time has advanced by 5 seconds, but (next to) no real time has passed
+    assert_int_equal(hal_board->CurrentTime, t_start + 5000);
+    assert_true(real_ms_since(&real_start) < 100);
+}
+
+// Test Case: Verify that a delay really sleeps when real time is opted into
+void test_hal_mock_delay_real_time_sleeps(void **state) {
+    // Arrange: Opt into real time, Record the current simulated and real time
+    hal_board->RealTime = 1;
+    uint32_t t_start = hal_board->CurrentTime;
+    struct timespec real_start;
+    clock_gettime(CLOCK_MONOTONIC, &real_start);
+
+    // Act: Initialize HAL and perform a delay for 20 milliseconds
+    HAL_Init();
+    HAL_Delay(20);
+    hal_board->RealTime = 0;
+
+    // Assert: Verify that both simulated and real time have advanced by at least 20 milliseconds
+    assert_int_equal(hal_board->CurrentTime, t_start + 20);
+    assert_true(real_ms_since(&real_start) >= 20);
+}
+
+// Test Case: Verify that HAL_GetTick gives the simulated time
+void test_hal_mock_get_tick_is_current_time(void **state) {
+    // Arrange: Set the simulated time
+    hal_board->CurrentTime = 1234;
+
+    // Act: Get the tick
+    uint32_t tick = HAL_GetTick();
+
+    // Assert: Verify that the tick is the simulated time
+    assert_int_equal(tick, 1234);
+}
+
+// Test Case: Verify that HAL_GetTick moves along with delays
+void test_hal_mock_get_tick_follows_delay(void **state) {
+    // Arrange: Record the current tick
+    HAL_Init();
+    uint32_t tick_start = HAL_GetTick();
+
+    // Act: Perform a delay for 250 milliseconds
+    HAL_Delay(250);
+
+    // Assert: Verify that the tick has advanced by 250 milliseconds
+    assert_int_equal(HAL_GetTick() - tick_start, 250);
+}
+
+// Test Case: Verify that a wait nothing answers times out quickly, and costs its full timeout in virtual time
+void test_mock_hal_wait_timeout_charges_virtual_time(void **state) {
+    // Arrange: Record the current simulated and real time, start a wait with a long timeout
+    uint32_t t_start = hal_board->CurrentTime;
+    struct timespec real_start;
+    clock_gettime(CLOCK_MONOTONIC, &real_start);
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    pthread_mutex_lock(&lock);
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, 10000);
+
+    // Act: Step the wait until it times out, with nothing ever signalling the condition
+    HAL_StatusTypeDef rc;
+    do {
+        rc = Mock_HAL_Wait_Step(&wait, &cond, &lock);
+    } while(rc == HAL_OK);
+    pthread_mutex_unlock(&lock);
+
+    // Assert: Verify that the timeout was charged to simulated time while real time stayed short
+    assert_int_equal(rc, HAL_TIMEOUT);
+    assert_int_equal(hal_board->CurrentTime, t_start + 10000);
+    assert_true(real_ms_since(&real_start) < 1000);
+}
+
+// Test Case: Verify that a wait with HAL_MAX_DELAY doesn't time out
+void test_mock_hal_wait_max_delay_keeps_waiting(void **state) {
+    // Arrange: Record the current simulated and real time, start a wait without timeout
+    uint32_t t_start = hal_board->CurrentTime;
+    struct timespec real_start;
+    clock_gettime(CLOCK_MONOTONIC, &real_start);
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    pthread_t waker;
+    pthread_create(&waker, NULL, wake_after_wait_limit, &cond);
+    pthread_mutex_lock(&lock);
+    Mock_HAL_WaitTypeDef wait;
+    Mock_HAL_Wait_Start(&wait, HAL_MAX_DELAY);
+
+    // Act: Step the wait once, which only returns when the condition is signalled (after longer than any timeout would take in virtual time)
+    HAL_StatusTypeDef rc = Mock_HAL_Wait_Step(&wait, &cond, &lock);
+    pthread_mutex_unlock(&lock);
+    pthread_join(waker, NULL);
+
+    // Assert: Verify that the wait kept going until woken, without costing simulated time
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(hal_board->CurrentTime, t_start);
+    assert_true(real_ms_since(&real_start) >= 2 * MOCK_HAL_VIRTUAL_WAIT_LIMIT);
+}
+
+// Test Case: Verify that bus transfers shorter than a tick add up to whole ticks
+void test_mock_hal_bus_time_adds_up_to_ticks(void **state) {
+    // Arrange: Record the current simulated time
+    uint32_t tick_start = HAL_GetTick();
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Charge 250 bits at 1 Mbit/s (250 us) once, then three more times
+    Mock_HAL_Bus_Time(250, 1000000, 0);
+    uint64_t ns_first = Mock_HAL_GetTimeNs();
+    for(int i = 0; i < 3; i++) {
+        Mock_HAL_Bus_Time(250, 1000000, 0);
+    }
+
+    // Assert: Verify that a single transfer shows in ns only, while four of them add up to a tick
+    assert_int_equal(ns_first - ns_start, 250000);
+    assert_int_equal(Mock_HAL_GetTimeNs() - ns_start, 1000000);
+    assert_int_equal(HAL_GetTick() - tick_start, 1);
+}
+
+// Test Case: Verify that a bus without a bit rate takes no time
+void test_mock_hal_bus_time_untimed_bus(void **state) {
+    // Arrange: Record the current simulated time
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Charge a transfer with a bit rate of 0, overhead included
+    Mock_HAL_Bus_Time(1000, 0, 5000);
+
+    // Assert: Verify that no time has passed
+    assert_int_equal(Mock_HAL_GetTimeNs(), ns_start);
+}
+
+// Test Case: Verify that a delay runs the events due meanwhile at their own time and in order, but not later ones
+void test_mock_hal_event_delay_runs_due_events_in_order(void **state) {
+    // Arrange: Schedule events 30, 10 and 80 ms from now
+    HAL_Init();
+    uint32_t tick_start = HAL_GetTick();
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+    test_events_run = 0;
+    test_event_record records[3] = {0};
+    Mock_HAL_EventTypeDef events[3] = {
+        {.Fire = test_event_fire, .Context = &records[0]},
+        {.Fire = test_event_fire, .Context = &records[1]},
+        {.Fire = test_event_fire, .Context = &records[2]},
+    };
+    Mock_HAL_Event_Schedule(&events[0], ns_start + 30000000U);
+    Mock_HAL_Event_Schedule(&events[1], ns_start + 10000000U);
+    Mock_HAL_Event_Schedule(&events[2], ns_start + 80000000U);
+
+    // Act: Delay for 50 milliseconds
+    HAL_Delay(50);
+
+    // Assert: The first two events should have run at their time in order of it, the last one should still be scheduled
+    assert_int_equal(records[1].order, 1);
+    assert_int_equal(records[1].tick - tick_start, 10);
+    assert_int_equal(records[0].order, 2);
+    assert_int_equal(records[0].tick - tick_start, 30);
+    assert_int_equal(records[2].order, 0);
+    assert_int_equal(events[2].Scheduled, 1);
+    assert_int_equal(HAL_GetTick() - tick_start, 50);
+    Mock_HAL_Event_Cancel(&events[2]);
+}
+
+// Test Case: Verify that running the next event moves time on to it, and that nothing runs once no event is left
+void test_mock_hal_event_run_next_moves_time_on(void **state) {
+    // Arrange: Schedule an event 2.5 ms from now
+    HAL_Init();
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+    test_event_record record = {0};
+    Mock_HAL_EventTypeDef event = {.Fire = test_event_fire, .Context = &record};
+    Mock_HAL_Event_Schedule(&event, ns_start + 2500000U);
+
+    // Act: Run events due now, then the next event, then the next event again
+    Mock_HAL_Run_Events();
+    uint8_t ran_due = (record.order != 0);
+    uint8_t ran_first = Mock_HAL_Run_Next_Event();
+    uint8_t ran_second = Mock_HAL_Run_Next_Event();
+
+    // Assert: The event should only have run when time was moved on to it
+    assert_int_equal(ran_due, 0);
+    assert_int_equal(ran_first, 1);
+    assert_int_equal(ran_second, 0);
+    assert_int_equal(Mock_HAL_GetTimeNs() - ns_start, 2500000U);
+    assert_int_equal(event.Scheduled, 0);
+}
+
+// Test Case: Verify that a cancelled event doesn't run
+void test_mock_hal_event_cancelled_does_not_run(void **state) {
+    // Arrange: Schedule an event 1 ms from now
+    HAL_Init();
+    test_event_record record = {0};
+    Mock_HAL_EventTypeDef event = {.Fire = test_event_fire, .Context = &record};
+    Mock_HAL_Event_Schedule(&event, Mock_HAL_GetTimeNs() + 1000000U);
+
+    // Act: Cancel it, then delay past its time
+    Mock_HAL_Event_Cancel(&event);
+    HAL_Delay(2);
+
+    // Assert: The event shouldn't have run
+    assert_int_equal(record.order, 0);
+    assert_int_equal(event.Scheduled, 0);
+}
+
+// Test Case: Verify that faults drawn after a reset repeat for the same seed, and differ for another seed
+void test_mock_hal_fault_same_seed_same_faults(void **state) {
+    // Arrange: Two fault sets with the same seed and one with another
+    Mock_HAL_FaultsTypeDef first = {.Seed = 42};
+    Mock_HAL_FaultsTypeDef second = {.Seed = 42};
+    Mock_HAL_FaultsTypeDef other = {.Seed = 43};
+    Mock_HAL_Faults_Reset(&first);
+    Mock_HAL_Faults_Reset(&second);
+    Mock_HAL_Faults_Reset(&other);
+
+    // Act: Draw 1000 faults at 50% from each
+    uint8_t rolls_first[1000];
+    uint8_t rolls_second[1000];
+    uint8_t rolls_other[1000];
+    for(uint16_t i = 0; i < 1000; i++) {
+        rolls_first[i] = Mock_HAL_Fault_Roll(&first, 500000);
+        rolls_second[i] = Mock_HAL_Fault_Roll(&second, 500000);
+        rolls_other[i] = Mock_HAL_Fault_Roll(&other, 500000);
+    }
+
+    // Assert: The same seed should give the same faults, another seed other faults, both at about the rate asked for
+    uint32_t fired = 0;
+    uint32_t differ = 0;
+    for(uint16_t i = 0; i < 1000; i++) {
+        fired += rolls_first[i];
+        differ += (rolls_first[i] != rolls_other[i]);
+    }
+    assert_memory_equal(rolls_first, rolls_second, sizeof(rolls_first));
+    assert_true(differ > 0);
+    assert_in_range(fired, 400, 600);
+}
+
+// Test Case: Verify that a rate of 0 never fires (without drawing from the generator) and a rate of 1000000 always does
+void test_mock_hal_fault_roll_rate_limits(void **state) {
+    // Arrange: A fault set with a known generator state
+    Mock_HAL_FaultsTypeDef faults = {.Seed = 7};
+    Mock_HAL_Faults_Reset(&faults);
+    uint32_t rand_start = faults.Rand;
+
+    // Act: Draw at 0 ppm, then at 1000000 ppm
+    uint8_t never = 0;
+    for(uint16_t i = 0; i < 100; i++) {
+        never |= Mock_HAL_Fault_Roll(&faults, 0);
+    }
+    uint32_t rand_after_never = faults.Rand;
+    uint8_t always = 1;
+    for(uint16_t i = 0; i < 100; i++) {
+        always &= Mock_HAL_Fault_Roll(&faults, 1000000);
+    }
+
+    // Assert: 0 ppm should never fire nor move the generator on, 1000000 ppm should always fire
+    assert_int_equal(never, 0);
+    assert_int_equal(rand_after_never, rand_start);
+    assert_int_equal(always, 1);
+}
+
+// Test Case: Verify that flipping bits at 1000000 ppm inverts the data and counts every bit flipped
+void test_mock_hal_fault_flip_bits_counts_flips(void **state) {
+    // Arrange: A fault set flipping every bit, and some data
+    Mock_HAL_FaultsTypeDef faults = {.BitFlipPpm = 1000000};
+    Mock_HAL_Faults_Reset(&faults);
+    uint8_t pData[4] = {0x00, 0xFF, 0xA5, 0x3C};
+
+    // Act: Flip the bits of the data
+    Mock_HAL_Faults_Flip_Bits(&faults, pData, sizeof(pData));
+
+    // Assert: Every bit should be inverted and counted
+    uint8_t expected[4] = {0xFF, 0x00, 0x5A, 0xC3};
+    assert_memory_equal(pData, expected, sizeof(pData));
+    assert_int_equal(faults.BitFlips, 32);
+}
+
+// Test Case: Verify that delays are recorded with their simulated start and duration, splitting ones too long for a record
+void test_mock_hal_trace_records_delays(void **state) {
+    // Arrange: Initialize HAL, start a trace
+    HAL_Init();
+    char path[32];
+    test_trace_start(path);
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Delay for 5 ms, then for 5 s
+    HAL_Delay(5);
+    HAL_Delay(5000);
+    Mock_HAL_TraceRecordTypeDef records[4];
+    size_t count = test_trace_stop(path, records, 4);
+
+    // Assert: The 5 s delay should take two records, one the most a record holds and one the rest, following on
+    assert_int_equal(count, 3);
+    assert_int_equal(records[0].Type, MOCK_HAL_TRACE_DELAY);
+    assert_int_equal(records[0].TimeNs, ns_start);
+    assert_int_equal(records[0].DurationNs, 5000000);
+    assert_int_equal(records[1].Type, MOCK_HAL_TRACE_DELAY);
+    assert_int_equal(records[1].TimeNs, ns_start + 5000000);
+    assert_int_equal(records[1].DurationNs, UINT32_MAX);
+    assert_int_equal(records[2].TimeNs, records[1].TimeNs + UINT32_MAX);
+    assert_int_equal((uint64_t)records[1].DurationNs + records[2].DurationNs, 5000000000ULL);
+}
+
+// Test Case: Verify that phases are numbered by name the first time they're seen, and their marks refer to that number
+void test_mock_hal_trace_names_phases_once(void **state) {
+    // Arrange: Initialize HAL, start a trace
+    HAL_Init();
+    char path[32];
+    test_trace_start(path);
+
+    // Act: Mark a phase with another nested in it, then the first one again
+    Mock_HAL_Trace_Phase_Begin("outer");
+    Mock_HAL_Trace_Phase_Begin("inner");
+    HAL_Delay(1);
+    Mock_HAL_Trace_Phase_End("inner");
+    Mock_HAL_Trace_Phase_End("outer");
+    Mock_HAL_Trace_Phase_Begin("outer");
+    Mock_HAL_Trace_Phase_End("outer");
+    Mock_HAL_Trace_Stop();
+
+    // Assert: Each name should be written once, before the first mark of its phase
+    FILE *f = fopen(path, "rb");
+    char header[8];
+    uint32_t version[2];
+    assert_int_equal(fread(header, sizeof(header), 1, f), 1);
+    assert_int_equal(fread(version, sizeof(version), 1, f), 1);
+    assert_memory_equal(header, MOCK_HAL_TRACE_MAGIC, sizeof(header));
+    assert_int_equal(version[0], MOCK_HAL_TRACE_VERSION);
+    assert_int_equal(version[1], sizeof(Mock_HAL_TraceRecordTypeDef));
+
+    const uint8_t expected_types[] = {MOCK_HAL_TRACE_PHASE_NAME, MOCK_HAL_TRACE_PHASE_BEGIN, MOCK_HAL_TRACE_PHASE_NAME,
+                                      MOCK_HAL_TRACE_PHASE_BEGIN, MOCK_HAL_TRACE_DELAY, MOCK_HAL_TRACE_PHASE_END,
+                                      MOCK_HAL_TRACE_PHASE_END, MOCK_HAL_TRACE_PHASE_BEGIN, MOCK_HAL_TRACE_PHASE_END};
+    const uint8_t expected_phases[] = {0, 0, 1, 1, HAL_OK, 1, 0, 0, 0};
+    const char *expected_names[] = {"outer", NULL, "inner"};
+    for(size_t i = 0; i < sizeof(expected_types); i++) {
+        Mock_HAL_TraceRecordTypeDef record;
+        assert_int_equal(fread(&record, sizeof(record), 1, f), 1);
+        assert_int_equal(record.Type, expected_types[i]);
+        assert_int_equal(record.Status, expected_phases[i]);
+        if(record.Type == MOCK_HAL_TRACE_PHASE_NAME) {
+            char name[8] = {0};
+            assert_int_equal(record.Size, strlen(expected_names[i]));
+            assert_int_equal(fread(name, 1, record.Size, f), record.Size);
+            assert_string_equal(name, expected_names[i]);
+        }
+    }
+    char extra;
+    assert_int_equal(fread(&extra, 1, 1, f), 0);
+    fclose(f);
+    unlink(path);
+}
+
+// Test Case: Verify that nothing is recorded once the trace is stopped
+void test_mock_hal_trace_stopped_records_nothing(void **state) {
+    // Arrange: Initialize HAL, start a trace
+    HAL_Init();
+    char path[32];
+    test_trace_start(path);
+
+    // Act: Delay, stop the trace, then delay and mark a phase
+    HAL_Delay(1);
+    Mock_HAL_Trace_Stop();
+    HAL_Delay(1);
+    Mock_HAL_Trace_Phase_Begin("after");
+    Mock_HAL_Trace_Phase_End("after");
+    Mock_HAL_TraceRecordTypeDef records[4];
+    size_t count = test_trace_stop(path, records, 4);
+
+    // Assert: Only the first delay should be in the trace
+    assert_int_equal(count, 1);
+    assert_int_equal(records[0].Type, MOCK_HAL_TRACE_DELAY);
+}
+
+// Test Case: Verify that a board keeps its own initialization and time, leaving the default board's alone
+void test_mock_hal_board_keeps_own_state(void **state) {
+    // Arrange: Initialize HAL on the default board and move its time on, set up a second board
+    HAL_Init();
+    uint32_t default_tick = HAL_GetTick();
+    HAL_Delay(10);
+    Mock_HAL_BoardTypeDef board;
+    Mock_HAL_Board_Init(&board);
+
+    // Act: Select the second board, check it's uninitialized, then initialize it and delay on it
+    Mock_HAL_Board_Select(&board);
+    uint8_t initialized_before = hal_board->Initialized;
+    HAL_Init();
+    HAL_Delay(500);
+    uint32_t board_tick = HAL_GetTick();
+    Mock_HAL_Board_Select(NULL);
+
+    // Assert: The board should have started from scratch, and the default board not moved on with it
+    assert_int_equal(initialized_before, 0);
+    assert_int_equal(board_tick, 500);
+    assert_int_equal(hal_board->Initialized, 1);
+    assert_int_equal(HAL_GetTick(), default_tick + 10);
+    Mock_HAL_Board_DeInit(&board);
+}
+
+// Test Case: Verify that boards run on separate threads at the same time each keep their own time
+void test_mock_hal_board_threads_run_separately(void **state) {
+    // Arrange: Three boards delaying by different amounts
+    test_board_run runs[3] = {
+        {.delay = 1, .delays = 1000},
+        {.delay = 3, .delays = 1000},
+        {.delay = 7, .delays = 1000},
+    };
+    pthread_t threads[3];
+    HAL_Init();
+    uint32_t default_tick = HAL_GetTick();
+
+    // Act: Run each board on its own thread
+    for(int i = 0; i < 3; i++) {
+        Mock_HAL_Board_Init(&runs[i].board);
+        pthread_create(&threads[i], NULL, run_board_delays, &runs[i]);
+    }
+    for(int i = 0; i < 3; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Assert: Each board should have only counted its own delays, and the default board none of them
+    for(int i = 0; i < 3; i++) {
+        assert_int_equal(runs[i].tick, runs[i].delay * runs[i].delays);
+        Mock_HAL_Board_DeInit(&runs[i].board);
+    }
+    assert_int_equal(HAL_GetTick(), default_tick);
 }
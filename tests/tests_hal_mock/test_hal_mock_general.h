@@ -11,11 +11,25 @@
 
 // Defines (number of tests, change as more are added)
 #define NUM_HAL_MOCK_HAL_INIT_TESTS 2
-#define NUM_HAL_MOCK_DELAY_TESTS 5
+#define NUM_HAL_MOCK_DELAY_TESTS 7
+#define NUM_HAL_MOCK_GET_TICK_TESTS 2
+#define NUM_MOCK_HAL_WAIT_TESTS 2
+#define NUM_MOCK_HAL_BUS_TIME_TESTS 2
+#define NUM_MOCK_HAL_EVENT_TESTS 3
+#define NUM_MOCK_HAL_FAULT_TESTS 3
+#define NUM_MOCK_HAL_TRACE_TESTS 3
+#define NUM_MOCK_HAL_BOARD_TESTS 2
 
 // Global test arrays
 extern const struct CMUnitTest hal_mock_hal_init_tests[NUM_HAL_MOCK_HAL_INIT_TESTS];
 extern const struct CMUnitTest hal_mock_delay_tests[NUM_HAL_MOCK_DELAY_TESTS];
+extern const struct CMUnitTest hal_mock_get_tick_tests[NUM_HAL_MOCK_GET_TICK_TESTS];
+extern const struct CMUnitTest mock_hal_wait_tests[NUM_MOCK_HAL_WAIT_TESTS];
+extern const struct CMUnitTest mock_hal_bus_time_tests[NUM_MOCK_HAL_BUS_TIME_TESTS];
+extern const struct CMUnitTest mock_hal_event_tests[NUM_MOCK_HAL_EVENT_TESTS];
+extern const struct CMUnitTest mock_hal_fault_tests[NUM_MOCK_HAL_FAULT_TESTS];
+extern const struct CMUnitTest mock_hal_trace_tests[NUM_MOCK_HAL_TRACE_TESTS];
+extern const struct CMUnitTest mock_hal_board_tests[NUM_MOCK_HAL_BOARD_TESTS];
 
 // Declaration of test functions
 
@@ -32,5 +46,38 @@ void test_hal_mock_delay_short_duration(void **state);
 void test_hal_mock_delay_long_duration(void **state);
 void test_hal_mock_delay_consecutive(void **state);
 void test_hal_mock_delay_no_hal_init(void **state);
+void test_hal_mock_delay_virtual_does_not_sleep(void **state);
+void test_hal_mock_delay_real_time_sleeps(void **state);
+
+// HAL_GetTick Tests
+void test_hal_mock_get_tick_is_current_time(void **state);
+void test_hal_mock_get_tick_follows_delay(void **state);
+
+// Mock_HAL_Wait Tests
+void test_mock_hal_wait_timeout_charges_virtual_time(void **state);
+void test_mock_hal_wait_max_delay_keeps_waiting(void **state);
+
+// Mock_HAL_Bus_Time Tests
+void test_mock_hal_bus_time_adds_up_to_ticks(void **state);
+void test_mock_hal_bus_time_untimed_bus(void **state);
+
+// Mock_HAL_Event Tests
+void test_mock_hal_event_delay_runs_due_events_in_order(void **state);
+void test_mock_hal_event_run_next_moves_time_on(void **state);
+void test_mock_hal_event_cancelled_does_not_run(void **state);
+
+// Mock_HAL_Faults Tests
+void test_mock_hal_fault_same_seed_same_faults(void **state);
+void test_mock_hal_fault_roll_rate_limits(void **state);
+void test_mock_hal_fault_flip_bits_counts_flips(void **state);
+
+// Mock_HAL_Trace Tests
+void test_mock_hal_trace_records_delays(void **state);
+void test_mock_hal_trace_names_phases_once(void **state);
+void test_mock_hal_trace_stopped_records_nothing(void **state);
+
+// Mock_HAL_Board Tests
+void test_mock_hal_board_keeps_own_state(void **state);
+void test_mock_hal_board_threads_run_separately(void **state);
 
 #endif // TEST_HAL_MOCK_GENERAL_H
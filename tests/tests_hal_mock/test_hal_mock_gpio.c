@@ -1,4 +1,8 @@
+#include <stdlib.h>
+#include <string.h>
+
 #include "test_hal_mock_gpio.h"
+#include "test_hal_mock_trace.h"
 
 // Definition of test arrays
 
@@ -28,6 +32,7 @@ const struct CMUnitTest hal_mock_write_pin_tests[NUM_HAL_MOCK_WRITE_PIN_TESTS] =
     cmocka_unit_test(test_hal_mock_write_pin_invalid_pin),
     cmocka_unit_test(test_hal_mock_write_pin_null_input),
     cmocka_unit_test(test_hal_mock_write_pin_no_hal_init),
+    cmocka_unit_test(test_hal_mock_write_pin_traces_edges),
 };
 
 // Required structs for GPIO
@@ -47,7 +52,7 @@ void run_hal_mock_gpio_tests(void) {
 // Test case: Verify that GPIO initialization returns HAL_OK when HAL is initialized first
 void test_hal_mock_gpio_init_returns_ok(void **state) {
     // Arrange: Initialize the Hardware Abstraction Layer (HAL)
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
 
     // Act: Attempt to initialize GPIO
     HAL_StatusTypeDef rc = HAL_GPIO_Init(&GPIO_Port, &GPIO_InitStruct);
@@ -59,7 +64,7 @@ void test_hal_mock_gpio_init_returns_ok(void **state) {
 // Test case: Verify that GPIO initialization sets the expected initial values for IDR, ODR, and BSRR
 void test_hal_mock_gpio_init_sets_regs(void **state) {
     // Arrange: Initialize HAL and set initial values for GPIO registers
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     GPIO_Port.IDR = 1;
     GPIO_Port.ODR = 1;
     GPIO_Port.BSRR = 1;
@@ -76,7 +81,7 @@ void test_hal_mock_gpio_init_sets_regs(void **state) {
 // Test case: Verify behavior for null GPIO_TypeDef or GPIO_InitTypeDef in HAL_GPIO_Init
 void test_hal_mock_gpio_init_null_input(void **state) {
     // Arrange: Initialize HAL
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
 
     // Act & Assert: Test with null GPIO_TypeDef
     assert_int_equal(HAL_GPIO_Init(NULL, &GPIO_InitStruct), HAL_ERROR);
@@ -88,7 +93,7 @@ void test_hal_mock_gpio_init_null_input(void **state) {
 // Test case: Attempt to initialize GPIO before initializing HAL (Should return HAL_ERROR and IDR/ODR/BSRR are unchanged)
 void test_hal_mock_gpio_init_no_hal_init(void **state) {
     // Arrange: Set HAL as uninitialized and set initial values for GPIO registers
-    hal_initialized = 0;
+    hal_board->Initialized = 0;
     GPIO_Port.IDR = 1;
     GPIO_Port.ODR = 1;
     GPIO_Port.BSRR = 1;
@@ -106,7 +111,7 @@ void test_hal_mock_gpio_init_no_hal_init(void **state) {
 // Test case: Verify correct reads for a pin in the reset state
 void test_hal_mock_read_pin_reset_state(void **state) {
     // Arrange: Set a specific GPIO pin to the reset state in the mock
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     HAL_GPIO_Init(&GPIO_Port, &GPIO_InitStruct);
 
     // Act: Read the state of the specified GPIO pin
@@ -119,7 +124,7 @@ void test_hal_mock_read_pin_reset_state(void **state) {
 // Test case: Verify correct reads for a pin in the set state
 void test_hal_mock_read_pin_set_state(void **state) {
     // Arrange: Set a specific GPIO pin to the set state in the mock
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     HAL_GPIO_Init(&GPIO_Port, &GPIO_InitStruct);
     GPIO_Port.IDR |= GPIO_PIN_5;
 
@@ -133,7 +138,7 @@ void test_hal_mock_read_pin_set_state(void **state) {
 // Test case: Verify reads for multiple GPIO pins in different states simultaneously
 void test_hal_mock_read_pin_multiple(void **state) {
     // Arrange: Set various GPIO pins to different states in the mock
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     HAL_GPIO_Init(&GPIO_Port, &GPIO_InitStruct);
     GPIO_Port.IDR |= GPIO_PIN_0;
     GPIO_Port.IDR |= GPIO_PIN_2;
@@ -153,7 +158,7 @@ void test_hal_mock_read_pin_multiple(void **state) {
 // Test case: Verify reads for an invalid GPIO pin
 void test_hal_mock_read_pin_invalid_pin(void **state) {
     // Arrange: Initialize HAL and set initial values for GPIO registers
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     GPIO_Port.IDR = GPIO_PIN_All;
     GPIO_Port.ODR = GPIO_PIN_All;
     GPIO_Port.BSRR = GPIO_PIN_0;
@@ -169,7 +174,7 @@ void test_hal_mock_read_pin_invalid_pin(void **state) {
 // Test case: Verify behavior for null GPIO_TypeDef in HAL_GPIO_ReadPin
 void test_hal_mock_read_pin_null_input(void **state) {
     // Arrange: Initialize HAL and set initial values for GPIO registers
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     GPIO_Port.IDR = GPIO_PIN_All;
     GPIO_Port.ODR = GPIO_PIN_All;
     GPIO_Port.BSRR = GPIO_PIN_0;
@@ -184,7 +189,7 @@ void test_hal_mock_read_pin_null_input(void **state) {
 // Test case: Verify behavior when reading a pin with uninitialized HAL
 void test_hal_mock_read_pin_no_hal_init(void **state) {
     // Arrange: Set HAL as uninitialized and set initial values for GPIO registers
-    hal_initialized = 0;
+    hal_board->Initialized = 0;
     GPIO_Port.IDR = GPIO_PIN_All;
     GPIO_Port.ODR = GPIO_PIN_All;
     GPIO_Port.BSRR = GPIO_PIN_0;
@@ -199,7 +204,7 @@ void test_hal_mock_read_pin_no_hal_init(void **state) {
 // Test case: Set pin state from reset to set
 void test_hal_mock_write_pin_set_state(void **state) {
     // Arrange: Initialize HAL and set the pin state to reset
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     GPIO_Port.IDR = 0;            // Initial state: reset (Assumed)
     GPIO_Port.ODR = 0;            // Initial state: reset (Assumed)
     GPIO_Port.BSRR = 0;           // Initial state: reset (Assumed)
@@ -216,7 +221,7 @@ void test_hal_mock_write_pin_set_state(void **state) {
 // Test case: Set pin state from set to reset
 void test_hal_mock_write_pin_reset_state(void **state) {
     // Arrange: Initialize HAL and set the pin state to set
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     GPIO_Port.IDR = GPIO_PIN_5;   // Initial state: set (Assumed)
     GPIO_Port.ODR = GPIO_PIN_5;   // Initial state: set (Assumed)
     GPIO_Port.BSRR = GPIO_PIN_5;  // Initial state: set (Assumed)
@@ -234,7 +239,7 @@ void test_hal_mock_write_pin_reset_state(void **state) {
 // Test case: Write to multiple pins in a GPIO port
 void test_hal_mock_write_pin_multiple(void **state) {
     // Arrange: Initialize HAL and set the GPIO port to reset
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     GPIO_Port.IDR = 0;            // Initial state: reset
     GPIO_Port.ODR = 0;            // Initial state: reset
     GPIO_Port.BSRR = 0;           // Initial state: reset
@@ -254,7 +259,7 @@ void test_hal_mock_write_pin_multiple(void **state) {
 // Test case: Attempt to write to an invalid GPIO pin
 void test_hal_mock_write_pin_invalid_pin(void **state) {
     // Arrange: Initialize HAL and set initial values for GPIO registers
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     GPIO_Port.IDR = GPIO_PIN_RESET;
     GPIO_Port.ODR = GPIO_PIN_RESET;
     GPIO_Port.BSRR = GPIO_PIN_0;
@@ -272,7 +277,7 @@ void test_hal_mock_write_pin_invalid_pin(void **state) {
 // Test case: Verify behavior for null GPIO_TypeDef in HAL_GPIO_WritePin
 void test_hal_mock_write_pin_null_input(void **state) {
     // Arrange: Initialize HAL and set initial values for GPIO registers
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     GPIO_Port.IDR = GPIO_PIN_RESET;
     GPIO_Port.ODR = GPIO_PIN_RESET;
     GPIO_Port.BSRR = GPIO_PIN_0;
@@ -289,7 +294,7 @@ void test_hal_mock_write_pin_null_input(void **state) {
 // Test case: Write to a GPIO pin with uninitialized HAL
 void test_hal_mock_write_pin_no_hal_init(void **state) {
     // Arrange: Set HAL as uninitialized and set initial values for GPIO registers
-    hal_initialized = 0;
+    hal_board->Initialized = 0;
     GPIO_Port.IDR = GPIO_PIN_RESET;
     GPIO_Port.ODR = GPIO_PIN_RESET;
     GPIO_Port.BSRR = GPIO_PIN_0;
@@ -302,3 +307,30 @@ void test_hal_mock_write_pin_no_hal_init(void **state) {
     assert_int_equal(GPIO_Port.ODR, GPIO_PIN_RESET);
     assert_int_equal(GPIO_Port.BSRR, GPIO_PIN_0);
 }
+
+// Test case: Only writes that change a pin's level are recorded in the bus trace, as edges
+void test_hal_mock_write_pin_traces_edges(void **state) {
+    // Arrange: Initialize HAL with a pin set, start a trace
+    hal_board->Initialized = 1;
+    GPIO_Port.IDR = GPIO_PIN_5;
+    GPIO_Port.ODR = GPIO_PIN_5;
+    GPIO_Port.BSRR = 0;
+    char path[32];
+    test_trace_start(path);
+
+    // Act: Set the pin again, reset it twice, then set it
+    HAL_GPIO_WritePin(&GPIO_Port, GPIO_PIN_5, GPIO_PIN_SET);
+    HAL_GPIO_WritePin(&GPIO_Port, GPIO_PIN_5, GPIO_PIN_RESET);
+    HAL_GPIO_WritePin(&GPIO_Port, GPIO_PIN_5, GPIO_PIN_RESET);
+    HAL_GPIO_WritePin(&GPIO_Port, GPIO_PIN_5, GPIO_PIN_SET);
+    Mock_HAL_TraceRecordTypeDef records[4];
+    size_t count = test_trace_stop(path, records, 4);
+
+    // Assert: Verify that only the falling and the rising edge are recorded
+    assert_int_equal(count, 2);
+    assert_int_equal(records[0].Type, MOCK_HAL_TRACE_GPIO);
+    assert_int_equal(records[0].Size, GPIO_PIN_5);
+    assert_int_equal(records[0].Status, GPIO_PIN_RESET);
+    assert_int_equal(records[1].Type, MOCK_HAL_TRACE_GPIO);
+    assert_int_equal(records[1].Status, GPIO_PIN_SET);
+}
@@ -12,7 +12,7 @@
 // Defines (number of tests, change as more are added)
 #define NUM_HAL_MOCK_GPIO_INIT_TESTS 4
 #define NUM_HAL_MOCK_READ_PIN_TESTS 6
-#define NUM_HAL_MOCK_WRITE_PIN_TESTS 6
+#define NUM_HAL_MOCK_WRITE_PIN_TESTS 7
 
 // Global test arrays
 extern const struct CMUnitTest hal_mock_gpio_init_tests[NUM_HAL_MOCK_GPIO_INIT_TESTS];
@@ -45,5 +45,6 @@ void test_hal_mock_write_pin_multiple(void **state);
 void test_hal_mock_write_pin_invalid_pin(void **state);
 void test_hal_mock_write_pin_null_input(void **state);
 void test_hal_mock_write_pin_no_hal_init(void **state);
+void test_hal_mock_write_pin_traces_edges(void **state);
 
 #endif // TEST_HAL_MOCK_GPIO_H
\ No newline at end of file
@@ -55,6 +55,50 @@ const struct CMUnitTest mock_i2c_slave_receive_tests[NUM_MOCK_I2C_SLAVE_RECEIVE_
     cmocka_unit_test(test_mock_i2c_slave_receive_timeout),
 };
 
+// Mock_I2C_Attach_Slave Tests
+const struct CMUnitTest mock_i2c_attach_slave_tests[NUM_MOCK_I2C_ATTACH_SLAVE_TESTS] = {
+    cmocka_unit_test(test_mock_i2c_attach_slave_transmit_calls_on_write),
+    cmocka_unit_test(test_mock_i2c_attach_slave_receive_calls_on_read),
+    cmocka_unit_test(test_mock_i2c_attach_slave_wrong_address_nacks),
+    cmocka_unit_test(test_mock_i2c_transfer_takes_bus_time),
+    cmocka_unit_test(test_mock_i2c_transfers_are_counted),
+};
+
+// Mock_I2C_Set_Faults Tests
+const struct CMUnitTest mock_i2c_fault_tests[NUM_MOCK_I2C_FAULT_TESTS] = {
+    cmocka_unit_test(test_mock_i2c_fault_error_nacks_transmit),
+    cmocka_unit_test(test_mock_i2c_fault_stall_times_out),
+};
+
+// Slave device for the Mock_I2C_Attach_Slave tests: a bank of registers written as (register, value) pairs,
+// read back from the last register written
+typedef struct {
+    uint8_t regs[256];
+    uint8_t reg;
+} test_i2c_device;
+
+static HAL_StatusTypeDef test_i2c_device_on_write(void *context, const uint8_t *pData, uint16_t Size)
+{
+    test_i2c_device *device = context;
+    device->reg = pData[0];
+    if(Size == 2) {
+        device->regs[pData[0]] = pData[1];
+    }
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef test_i2c_device_on_read(void *context, uint8_t *pData, uint16_t Size)
+{
+    test_i2c_device *device = context;
+    memcpy(pData, &device->regs[device->reg], Size);
+    return HAL_OK;
+}
+
+static const Mock_I2C_SlaveTypeDef test_i2c_slave = {
+    .on_write = test_i2c_device_on_write,
+    .on_read = test_i2c_device_on_read,
+};
+
 // Run all I2C tests
 void run_hal_mock_i2c_tests()
 {
@@ -68,6 +112,8 @@ void run_hal_mock_i2c_tests()
     status += cmocka_run_group_tests(hal_mock_master_receive_tests, NULL, NULL);
     status += cmocka_run_group_tests(mock_i2c_slave_transmit_tests, NULL, NULL);
     status += cmocka_run_group_tests(mock_i2c_slave_receive_tests, NULL, NULL);
+    status += cmocka_run_group_tests(mock_i2c_attach_slave_tests, NULL, NULL);
+    status += cmocka_run_group_tests(mock_i2c_fault_tests, NULL, NULL);
 
     assert_int_equal(status, 0);
 }
@@ -76,8 +122,8 @@ void run_hal_mock_i2c_tests()
 void test_common_i2c_checks_returns_ok(void **state)
 {
     // Arrange: Initialize HAL and create I2C handle to pass in
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
 
     // Act: Call a function that uses the private common_i2c_checks function
     HAL_StatusTypeDef rc = HAL_I2C_Init(&hi2c);
@@ -90,7 +136,7 @@ void test_common_i2c_checks_returns_ok(void **state)
 void test_common_i2c_checks_null_input(void **state)
 {
     // Arrange: Initialize HAL and create I2C handle to pass in
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
     I2C_HandleTypeDef *hi2c = NULL;
 
     // Act: Call a function that uses the private common_i2c_checks function
@@ -104,8 +150,8 @@ void test_common_i2c_checks_null_input(void **state)
 void test_common_i2c_checks_no_hal_init(void **state)
 {
     // Arrange: Uninitialize HAL and create I2C handle to pass in
-    hal_initialized = 0;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 0;
+    I2C_HandleTypeDef hi2c = {0};
 
     // Act: Call a function that uses the private common_i2c_checks function
     HAL_StatusTypeDef rc = HAL_I2C_Init(&hi2c);
@@ -118,8 +164,8 @@ void test_common_i2c_checks_no_hal_init(void **state)
 void test_common_i2c_master_transaction_checks_returns_ok(void **state)
 {
     // Arrange: Initialize HAL, create a I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     hi2c.State = HAL_I2C_STATE_READY;
     
     uint16_t DevAddress = 0x01;
@@ -138,8 +184,8 @@ void test_common_i2c_master_transaction_checks_returns_ok(void **state)
 void test_common_i2c_master_transaction_checks_null_pdata(void **state)
 {
     // Arrange: Initialize HAL, create a I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     hi2c.State = HAL_I2C_STATE_READY;
     
     uint16_t DevAddress = 0x01;
@@ -158,8 +204,8 @@ void test_common_i2c_master_transaction_checks_null_pdata(void **state)
 void test_common_i2c_master_transaction_checks_non_ready_state(void **state)
 {
     // Arrange: Initialize HAL, create I2C handles and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c1, hi2c2;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c1 = {0}, hi2c2 = {0};
     hi2c1.State = HAL_I2C_STATE_RESET;
     hi2c2.State = HAL_I2C_STATE_ERROR;
 
@@ -182,8 +228,8 @@ void test_common_i2c_master_transaction_checks_non_ready_state(void **state)
 void test_common_i2c_master_transaction_checks_msg_too_big(void **state)
 {
     // Arrange: Initialize HAL, create I2C handles and prepare for transaction with an oversized message
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     hi2c.State = HAL_I2C_STATE_READY;
 
     uint16_t DevAddress = 0x01;
@@ -202,8 +248,8 @@ void test_common_i2c_master_transaction_checks_msg_too_big(void **state)
 void test_hal_i2c_init_sets_values(void **state)
 {
     // Arrange: Initialize HAL and create a I2C handle with values different from initialized
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     hi2c.State = HAL_I2C_STATE_RESET;
     hi2c.ErrorCode = HAL_I2C_ERROR_UNINITIALIZED;
     hi2c.XferAddress = 0x01;
@@ -228,8 +274,8 @@ void test_hal_i2c_init_sets_values(void **state)
 void test_hal_i2c_deinit_sets_values(void **state)
 {
     // Arrange: Initialize HAL and create a I2C handle with values different from reset
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     hi2c.State = HAL_I2C_STATE_READY;
     hi2c.ErrorCode = HAL_I2C_ERROR_UNINITIALIZED;
     hi2c.XferAddress = 0x01;
@@ -254,8 +300,8 @@ void test_hal_i2c_deinit_sets_values(void **state)
 void test_hal_i2c_master_transmit_transfers_data(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     hi2c.State = HAL_I2C_STATE_READY;
     
     uint16_t DevAddress = 0x01;
@@ -274,8 +320,8 @@ void test_hal_i2c_master_transmit_transfers_data(void **state)
 void test_hal_i2c_master_transmit_sets_values(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     hi2c.State = HAL_I2C_STATE_READY;
     
     uint16_t DevAddress = 0x01;
@@ -297,8 +343,8 @@ void test_hal_i2c_master_transmit_sets_values(void **state)
 void test_hal_i2c_master_transmit_timeout(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     
     // Transmit should time out if I2C is held at a busy state (Another transaction is ongoing)
     hi2c.State = HAL_I2C_STATE_BUSY_TX;
@@ -319,8 +365,8 @@ void test_hal_i2c_master_transmit_timeout(void **state)
 void test_hal_i2c_master_receive_transfers_data(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     hi2c.State = HAL_I2C_STATE_READY;
     
     uint16_t DevAddress = 0x01;
@@ -343,8 +389,8 @@ void test_hal_i2c_master_receive_transfers_data(void **state)
 void test_hal_i2c_master_receive_sets_values(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     hi2c.State = HAL_I2C_STATE_READY;
     
     uint16_t DevAddress = 0x01;
@@ -369,8 +415,8 @@ void test_hal_i2c_master_receive_sets_values(void **state)
 void test_hal_i2c_master_receive_timeout(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     
     // Receive should time out if I2C is held at a ready state (No data sent from slave to receive)
     hi2c.State = HAL_I2C_STATE_READY;
@@ -391,8 +437,8 @@ void test_hal_i2c_master_receive_timeout(void **state)
 void test_mock_i2c_slave_transmit_transfers_data(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     
     // Simulate 10-element message requested by HAL_I2C_Master_Receive
     hi2c.State = HAL_I2C_STATE_READY;
@@ -413,8 +459,8 @@ void test_mock_i2c_slave_transmit_transfers_data(void **state)
 void test_mock_i2c_slave_transmit_sets_values(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
 
     // Simulate 10-element message requested by HAL_I2C_Master_Receive
     hi2c.State = HAL_I2C_STATE_READY;
@@ -437,8 +483,8 @@ void test_mock_i2c_slave_transmit_sets_values(void **state)
 void test_mock_i2c_slave_transmit_timeout(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     
     // Transmit should time out if I2C is held at a busy state (Another transaction is ongoing)
     hi2c.State = HAL_I2C_STATE_BUSY_TX;
@@ -458,8 +504,8 @@ void test_mock_i2c_slave_transmit_timeout(void **state)
 void test_mock_i2c_slave_transmit_msg_size_mismatch(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     
     // Simulate 5-element message requested by HAL_I2C_Master_Receive
     hi2c.State = HAL_I2C_STATE_READY;
@@ -480,8 +526,8 @@ void test_mock_i2c_slave_transmit_msg_size_mismatch(void **state)
 void test_mock_i2c_slave_receive_transfers_data(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     
     uint8_t pData[10];
     uint16_t Size = 10;
@@ -503,8 +549,8 @@ void test_mock_i2c_slave_receive_transfers_data(void **state)
 void test_mock_i2c_slave_receive_sets_values(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     hi2c.State = HAL_I2C_STATE_READY;
     
     uint8_t pData[10];
@@ -528,8 +574,8 @@ void test_mock_i2c_slave_receive_sets_values(void **state)
 void test_mock_i2c_slave_receive_timeout(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     
     // Receive should time out if I2C is held at a ready state (No data sent from master to receive)
     hi2c.State = HAL_I2C_STATE_READY;
@@ -550,8 +596,8 @@ void test_mock_i2c_slave_receive_timeout(void **state)
 void test_mock_i2c_slave_receive_msg_size_mismatch(void **state)
 {
     // Arrange: Initialize HAL, create I2C handle and prepare for transaction
-    hal_initialized = 1;
-    I2C_HandleTypeDef hi2c;
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
     
     uint8_t pData[10];
     uint16_t Size = 10;
@@ -567,4 +613,176 @@ void test_mock_i2c_slave_receive_msg_size_mismatch(void **state)
     // Assert: The function should return an error
     assert_int_equal(rc, HAL_ERROR);
     assert_int_equal(hi2c.ErrorCode, HAL_I2C_ERROR_SIZE_MISMATCH);
-}
\ No newline at end of file
+}
+
+// Test Case: Verify that HAL_I2C_Master_Transmit hands the data to an attached slave device without a slave thread
+void test_mock_i2c_attach_slave_transmit_calls_on_write(void **state)
+{
+    // Arrange: Initialize HAL and I2C, attach a slave device
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
+    HAL_I2C_Init(&hi2c);
+    test_i2c_device device = {0};
+    Mock_I2C_Attach_Slave(&hi2c, 0x60, &test_i2c_slave, &device);
+
+    uint8_t pData[2] = {0x12, 0x80};
+
+    // Act: Call HAL_I2C_Master_Transmit
+    HAL_StatusTypeDef rc = HAL_I2C_Master_Transmit(&hi2c, 0x60, pData, 2, HAL_MAX_DELAY);
+
+    // Assert: The device should have taken the register write, leaving the I2C ready for the next transaction
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(device.regs[0x12], 0x80);
+    assert_int_equal(hi2c.State, HAL_I2C_STATE_READY);
+    assert_int_equal(hi2c.ErrorCode, HAL_I2C_ERROR_NONE);
+}
+
+// Test Case: Verify that HAL_I2C_Master_Receive gets its data from an attached slave device without a slave thread
+void test_mock_i2c_attach_slave_receive_calls_on_read(void **state)
+{
+    // Arrange: Initialize HAL and I2C, attach a slave device with a register set
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
+    HAL_I2C_Init(&hi2c);
+    test_i2c_device device = {0};
+    device.regs[0x0A] = 0x26;
+    Mock_I2C_Attach_Slave(&hi2c, 0x60, &test_i2c_slave, &device);
+
+    uint8_t reg = 0x0A;
+    uint8_t data = 0;
+
+    // Act: Select the register, then read it
+    HAL_StatusTypeDef rc_transmit = HAL_I2C_Master_Transmit(&hi2c, 0x60, &reg, 1, HAL_MAX_DELAY);
+    HAL_StatusTypeDef rc_receive = HAL_I2C_Master_Receive(&hi2c, 0x60, &data, 1, HAL_MAX_DELAY);
+
+    // Assert: The register value should come from the device
+    assert_int_equal(rc_transmit, HAL_OK);
+    assert_int_equal(rc_receive, HAL_OK);
+    assert_int_equal(data, 0x26);
+}
+
+// Test Case: Verify that transfers to an address the attached slave device doesn't answer to are NACKed
+void test_mock_i2c_attach_slave_wrong_address_nacks(void **state)
+{
+    // Arrange: Initialize HAL and I2C, attach a slave device
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
+    HAL_I2C_Init(&hi2c);
+    test_i2c_device device = {0};
+    Mock_I2C_Attach_Slave(&hi2c, 0x60, &test_i2c_slave, &device);
+
+    uint8_t pData[2] = {0x12, 0x80};
+
+    // Act: Call HAL_I2C_Master_Transmit for another address
+    HAL_StatusTypeDef rc = HAL_I2C_Master_Transmit(&hi2c, 0x42, pData, 2, 100);
+
+    // Assert: The transfer should fail without reaching the device
+    assert_int_equal(rc, HAL_ERROR);
+    assert_int_equal(hi2c.ErrorCode, HAL_I2C_ERROR_NACK);
+    assert_int_equal(device.regs[0x12], 0);
+}
+
+// Test Case: Verify that a transfer takes the time its clocks need at the configured clock speed
+void test_mock_i2c_transfer_takes_bus_time(void **state)
+{
+    // Arrange: Initialize HAL and I2C at 100 kHz (as set up in main.c), attach a slave device
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
+    hi2c.Init.ClockSpeed = 100000;
+    HAL_I2C_Init(&hi2c);
+    test_i2c_device device = {0};
+    Mock_I2C_Attach_Slave(&hi2c, 0x60, &test_i2c_slave, &device);
+
+    uint8_t pData[2] = {0x12, 0x80};
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Write a register
+    HAL_StatusTypeDef rc = HAL_I2C_Master_Transmit(&hi2c, 0x60, pData, 2, HAL_MAX_DELAY);
+
+    // Assert: Address and 2 data bytes with their ACKs plus start and stop (29 clocks) at 10 us each, plus the transaction overhead
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(Mock_HAL_GetTimeNs() - ns_start, 290000 + MOCK_I2C_TRANSACTION_NS);
+}
+
+// Test Case: Verify that the handle counts the transfers made, by direction, failed ones included
+void test_mock_i2c_transfers_are_counted(void **state)
+{
+    // Arrange: Initialize HAL and I2C, attach a slave device
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
+    HAL_I2C_Init(&hi2c);
+    test_i2c_device device = {0};
+    Mock_I2C_Attach_Slave(&hi2c, 0x60, &test_i2c_slave, &device);
+
+    uint8_t pData[2] = {0x12, 0x80};
+
+    // Act: Write a register, address it and read it back, then write to an address nothing answers to
+    HAL_I2C_Master_Transmit(&hi2c, 0x60, pData, 2, 100);
+    HAL_I2C_Master_Transmit(&hi2c, 0x60, pData, 1, 100);
+    HAL_I2C_Master_Receive(&hi2c, 0x60, &pData[1], 1, 100);
+    HAL_I2C_Master_Transmit(&hi2c, 0x42, pData, 2, 100);
+
+    // Assert: All four transfers should be counted, the NACKed one as failed
+    assert_int_equal(hi2c.Stats.Transfers[MOCK_HAL_FAULT_WRITE], 3);
+    assert_int_equal(hi2c.Stats.Bytes[MOCK_HAL_FAULT_WRITE], 5);
+    assert_int_equal(hi2c.Stats.Transfers[MOCK_HAL_FAULT_READ], 1);
+    assert_int_equal(hi2c.Stats.Bytes[MOCK_HAL_FAULT_READ], 1);
+    assert_int_equal(hi2c.Stats.Failed, 1);
+}
+
+// Test Case: Verify that an injected write error NACKs a transfer the attached slave device would have taken
+void test_mock_i2c_fault_error_nacks_transmit(void **state)
+{
+    // Arrange: Initialize HAL and I2C, attach a slave device, fail every write
+    hal_board->Initialized = 1;
+    I2C_HandleTypeDef hi2c = {0};
+    HAL_I2C_Init(&hi2c);
+    test_i2c_device device = {0};
+    Mock_I2C_Attach_Slave(&hi2c, 0x60, &test_i2c_slave, &device);
+    Mock_HAL_FaultsTypeDef faults = {0};
+    faults.ErrorPpm[MOCK_HAL_FAULT_WRITE] = 1000000;
+    Mock_I2C_Set_Faults(&hi2c, &faults);
+
+    uint8_t pData[2] = {0x12, 0x80};
+
+    // Act: Write a register
+    HAL_StatusTypeDef rc = HAL_I2C_Master_Transmit(&hi2c, 0x60, pData, 2, 100);
+
+    // Assert: The transfer should be NACKed without reaching the device
+    assert_int_equal(rc, HAL_ERROR);
+    assert_int_equal(hi2c.ErrorCode, HAL_I2C_ERROR_NACK);
+    assert_int_equal(device.regs[0x12], 0);
+    assert_int_equal(faults.Errors, 1);
+    Mock_I2C_Set_Faults(&hi2c, NULL);
+}
+
+// Test Case: Verify that a slave device stalling a transfer makes it time out after the master's timeout
+void test_mock_i2c_fault_stall_times_out(void **state)
+{
+    // Arrange: Initialize HAL and I2C, attach a slave device, stall every transfer for a second
+    HAL_Init();
+    I2C_HandleTypeDef hi2c = {0};
+    HAL_I2C_Init(&hi2c);
+    test_i2c_device device = {0};
+    device.regs[0x0A] = 0x26;
+    device.reg = 0x0A;
+    Mock_I2C_Attach_Slave(&hi2c, 0x60, &test_i2c_slave, &device);
+    Mock_HAL_FaultsTypeDef faults = {0};
+    faults.StallPpm = 1000000;
+    faults.StallMs = 1000;
+    Mock_I2C_Set_Faults(&hi2c, &faults);
+
+    uint8_t pData[1] = {0};
+    uint32_t start = HAL_GetTick();
+
+    // Act: Read a register with a 100 ms timeout
+    HAL_StatusTypeDef rc = HAL_I2C_Master_Receive(&hi2c, 0x60, pData, 1, 100);
+
+    // Assert: The transfer should time out after 100 ms without any data
+    assert_int_equal(rc, HAL_ERROR);
+    assert_int_equal(hi2c.ErrorCode, HAL_I2C_ERROR_TIMEOUT);
+    assert_int_equal(HAL_GetTick() - start, 100);
+    assert_int_equal(pData[0], 0);
+    assert_int_equal(faults.Stalls, 1);
+    Mock_I2C_Set_Faults(&hi2c, NULL);
+}
@@ -19,6 +19,8 @@
 #define NUM_HAL_I2C_MASTER_RECEIVE_TESTS 3
 #define NUM_MOCK_I2C_SLAVE_TRANSMIT_TESTS 4
 #define NUM_MOCK_I2C_SLAVE_RECEIVE_TESTS 4
+#define NUM_MOCK_I2C_ATTACH_SLAVE_TESTS 5
+#define NUM_MOCK_I2C_FAULT_TESTS 2
 
 // Global test arrays
 extern const struct CMUnitTest common_i2c_checks_tests[NUM_COMMON_I2C_CHECKS_TESTS];
@@ -29,6 +31,8 @@ extern const struct CMUnitTest hal_i2c_master_transmit_tests[NUM_HAL_I2C_MASTER_
 extern const struct CMUnitTest hal_i2c_master_receive_tests[NUM_HAL_I2C_MASTER_RECEIVE_TESTS];
 extern const struct CMUnitTest mock_i2c_slave_transmit_tests[NUM_MOCK_I2C_SLAVE_TRANSMIT_TESTS];
 extern const struct CMUnitTest mock_i2c_slave_receive_tests[NUM_MOCK_I2C_SLAVE_RECEIVE_TESTS];
+extern const struct CMUnitTest mock_i2c_attach_slave_tests[NUM_MOCK_I2C_ATTACH_SLAVE_TESTS];
+extern const struct CMUnitTest mock_i2c_fault_tests[NUM_MOCK_I2C_FAULT_TESTS];
 
 // Declaration of test functions
 
@@ -74,4 +78,15 @@ void test_mock_i2c_slave_receive_sets_values(void **state);
 void test_mock_i2c_slave_receive_timeout(void **state);
 void test_mock_i2c_slave_receive_size_mismatch(void **state);
 
+// Mock_I2C_Attach_Slave Tests
+void test_mock_i2c_attach_slave_transmit_calls_on_write(void **state);
+void test_mock_i2c_attach_slave_receive_calls_on_read(void **state);
+void test_mock_i2c_attach_slave_wrong_address_nacks(void **state);
+void test_mock_i2c_transfer_takes_bus_time(void **state);
+void test_mock_i2c_transfers_are_counted(void **state);
+
+// Mock_I2C_Set_Faults Tests
+void test_mock_i2c_fault_error_nacks_transmit(void **state);
+void test_mock_i2c_fault_stall_times_out(void **state);
+
 #endif // TEST_HAL_MOCK_I2C_H
\ No newline at end of file
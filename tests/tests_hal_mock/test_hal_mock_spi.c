@@ -1,4 +1,7 @@
+#include <stdlib.h>
+
 #include "test_hal_mock_spi.h"
+#include "test_hal_mock_trace.h"
 
 // Definition of test arrays
 
@@ -13,8 +16,8 @@ const struct CMUnitTest common_spi_checks_tests[NUM_COMMON_SPI_CHECKS_TESTS] = {
 const struct CMUnitTest common_spi_transaction_checks_tests[NUM_COMMON_SPI_TRANSACTION_CHECKS_TESTS] = {
     cmocka_unit_test(test_common_spi_transaction_checks_returns_ok),
     cmocka_unit_test(test_common_spi_transaction_checks_null_pdata),
-    cmocka_unit_test(test_common_spi_transaction_checks_non_ready_state),
-    cmocka_unit_test(test_common_spi_master_transaction_checks_msg_too_big)
+    cmocka_unit_test(test_common_spi_transaction_checks_zero_size),
+    cmocka_unit_test(test_common_spi_transaction_checks_non_ready_state)
 };
 
 // HAL_SPI_Init Tests
@@ -32,12 +35,14 @@ const struct CMUnitTest hal_mock_transmit_tests[NUM_HAL_MOCK_TRANSMIT_TESTS] = {
     cmocka_unit_test(test_hal_spi_transmit_transfers_data),
     cmocka_unit_test(test_hal_spi_transmit_sets_values),
     cmocka_unit_test(test_hal_spi_transmit_timeout),
+    cmocka_unit_test(test_hal_spi_transmit_large_transfer),
 };
 
 // HAL_SPI_Transmit_DMA Tests
 const struct CMUnitTest hal_mock_transmit_dma_tests[NUM_HAL_MOCK_TRANSMIT_DMA_TESTS] = {
     cmocka_unit_test(test_hal_spi_transmit_dma_transfers_data),
     cmocka_unit_test(test_hal_spi_transmit_dma_sets_values),
+    cmocka_unit_test(test_hal_spi_transmit_dma_completes_in_background),
 };
 
 // HAL_SPI_Receive Tests
@@ -45,12 +50,15 @@ const struct CMUnitTest hal_mock_receive_tests[NUM_HAL_MOCK_RECEIVE_TESTS] = {
     cmocka_unit_test(test_hal_spi_receive_transfers_data),
     cmocka_unit_test(test_hal_spi_receive_sets_values),
     cmocka_unit_test(test_hal_spi_receive_timeout),
+    cmocka_unit_test(test_hal_spi_receive_large_transfer),
 };
 
 // HAL_SPI_Receive_DMA Tests
 const struct CMUnitTest hal_mock_receive_dma_tests[NUM_HAL_MOCK_RECEIVE_DMA_TESTS] = {
     cmocka_unit_test(test_hal_spi_receive_dma_transfers_data),
     cmocka_unit_test(test_hal_spi_receive_dma_sets_values),
+    cmocka_unit_test(test_hal_spi_receive_dma_completes_in_background),
+    cmocka_unit_test(test_hal_spi_receive_dma_busy_until_complete),
 };
 
 // Mock_SPI_Slave_Transmit Tests
@@ -69,6 +77,93 @@ const struct CMUnitTest mock_spi_slave_receive_tests[NUM_MOCK_SPI_SLAVE_RECEIVE_
     cmocka_unit_test(test_mock_spi_slave_receive_size_mismatch),
 };
 
+// Mock_SPI_Attach_Slave Tests
+const struct CMUnitTest mock_spi_attach_slave_tests[NUM_MOCK_SPI_ATTACH_SLAVE_TESTS] = {
+    cmocka_unit_test(test_mock_spi_attach_slave_transmit_calls_on_write),
+    cmocka_unit_test(test_mock_spi_attach_slave_receive_calls_on_read),
+    cmocka_unit_test(test_mock_spi_attach_slave_cs_calls_on_cs),
+    cmocka_unit_test(test_mock_spi_transfer_takes_bus_time),
+    cmocka_unit_test(test_mock_spi_transfers_are_traced),
+    cmocka_unit_test(test_mock_spi_transfers_are_counted),
+};
+
+// Mock_SPI_Set_Faults Tests
+const struct CMUnitTest mock_spi_fault_tests[NUM_MOCK_SPI_FAULT_TESTS] = {
+    cmocka_unit_test(test_mock_spi_fault_error_fails_receive),
+    cmocka_unit_test(test_mock_spi_fault_bit_flips_corrupt_receive),
+    cmocka_unit_test(test_mock_spi_fault_stall_times_out),
+};
+
+// Slave device for the Mock_SPI_Attach_Slave tests: records what the master did and answers reads with a counter
+typedef struct {
+    uint8_t selected;
+    uint8_t written[10];
+    uint16_t written_size;
+    uint8_t next_read;
+} test_spi_device;
+
+static void test_spi_device_on_cs(void *context, uint8_t selected) {
+    ((test_spi_device *)context)->selected = selected;
+}
+
+static void test_spi_device_on_write(void *context, const uint8_t *pData, uint16_t Size) {
+    test_spi_device *device = context;
+    memcpy(device->written, pData, Size);
+    device->written_size = Size;
+}
+
+static void test_spi_device_on_read(void *context, uint8_t *pData, uint16_t Size) {
+    test_spi_device *device = context;
+    for(uint16_t i = 0; i < Size; i++) {
+        pData[i] = device->next_read++;
+    }
+}
+
+static const Mock_SPI_SlaveTypeDef test_spi_slave = {
+    .on_cs = test_spi_device_on_cs,
+    .on_write = test_spi_device_on_write,
+    .on_read = test_spi_device_on_read,
+};
+
+// Transfer complete callbacks of the HAL (overriding the mock's weak ones): count completions of each direction
+static uint8_t test_spi_tx_cplt = 0;
+static uint8_t test_spi_rx_cplt = 0;
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+    test_spi_tx_cplt++;
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi) {
+    test_spi_rx_cplt++;
+}
+
+// Slave thread for the master transfer tests: moves Size bytes of pData through the SPI, Piece bytes at a time
+typedef struct {
+    SPI_HandleTypeDef *hspi;
+    uint8_t *pData;
+    uint16_t Size;
+    uint16_t Piece;
+    HAL_StatusTypeDef rc;
+} test_spi_slave_thread;
+
+static void *test_spi_slave_receive_thread(void *arg) {
+    test_spi_slave_thread *slave = arg;
+    for(uint16_t done = 0; (done < slave->Size) && (slave->rc == HAL_OK); done += slave->Piece) {
+        uint16_t piece = (slave->Size - done < slave->Piece) ? (slave->Size - done) : slave->Piece;
+        slave->rc = Mock_SPI_Slave_Receive(slave->hspi, &slave->pData[done], piece, HAL_MAX_DELAY);
+    }
+    return NULL;
+}
+
+static void *test_spi_slave_transmit_thread(void *arg) {
+    test_spi_slave_thread *slave = arg;
+    for(uint16_t done = 0; (done < slave->Size) && (slave->rc == HAL_OK); done += slave->Piece) {
+        uint16_t piece = (slave->Size - done < slave->Piece) ? (slave->Size - done) : slave->Piece;
+        slave->rc = Mock_SPI_Slave_Transmit(slave->hspi, &slave->pData[done], piece, HAL_MAX_DELAY);
+    }
+    return NULL;
+}
+
 void run_hal_mock_spi_tests(void) {
     int status = 0;
     
@@ -82,6 +177,8 @@ void run_hal_mock_spi_tests(void) {
     status += cmocka_run_group_tests(hal_mock_receive_dma_tests, NULL, NULL);
     status += cmocka_run_group_tests(mock_spi_slave_transmit_tests, NULL, NULL);
     status += cmocka_run_group_tests(mock_spi_slave_receive_tests, NULL, NULL);
+    status += cmocka_run_group_tests(mock_spi_attach_slave_tests, NULL, NULL);
+    status += cmocka_run_group_tests(mock_spi_fault_tests, NULL, NULL);
 
     assert_int_equal(status, 0);
 }
@@ -89,8 +186,8 @@ void run_hal_mock_spi_tests(void) {
 // Test Case: Verify that common_spi_checks passes for an appropriately configured SPI handle
 void test_common_spi_checks_returns_ok(void **state) {
     // Arrange: Initialize HAL and create SPI handle to pass in
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
 
     // Act: Call a function that uses the private common_spi_checks
     HAL_StatusTypeDef rc = HAL_SPI_Init(&hspi);
@@ -103,7 +200,7 @@ void test_common_spi_checks_returns_ok(void **state) {
 // Test Case: Verify that common_spi_checks fails for a null SPI handle
 void test_common_spi_checks_null_input(void **state) {
     // Arrange: Initialize HAL and create SPI handle to pass in
-    hal_initialized = 1;
+    hal_board->Initialized = 1;
 
     // Act: Call a function that uses the private common_spi_checks
     HAL_StatusTypeDef rc = HAL_SPI_Init(NULL);
@@ -115,8 +212,8 @@ void test_common_spi_checks_null_input(void **state) {
 // Test Case: Verify that common_spi_checks fails for an uninitialized HAL
 void test_common_spi_checks_no_hal_init(void **state) {
     // Arrange: Uninitialize HAL and create SPI handle to pass in
-    hal_initialized = 0;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 0;
+    SPI_HandleTypeDef hspi = {0};
 
     // Act: Call a function that uses the private common_spi_checks
     HAL_StatusTypeDef rc = HAL_SPI_Init(&hspi);
@@ -128,16 +225,22 @@ void test_common_spi_checks_no_hal_init(void **state) {
 
 // Test Case: Verify that common_spi_transaction_checks passes for an appropriately configured SPI handle
 void test_common_spi_transaction_checks_returns_ok(void **state) {
-    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction, with a slave thread to take the data
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
     hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10];
     uint16_t Size = 10;
 
+    uint8_t received[10];
+    test_spi_slave_thread slave = {&hspi, received, Size, Size};
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_spi_slave_receive_thread, &slave);
+
     // Act: Call a function that uses the private common_spi_transaction_checks
     HAL_StatusTypeDef rc = HAL_SPI_Transmit(&hspi, pData, Size, HAL_MAX_DELAY);
+    pthread_join(thread, NULL);
 
     // Assert: The function should succeed
     assert_int_equal(rc, HAL_OK);
@@ -147,8 +250,8 @@ void test_common_spi_transaction_checks_returns_ok(void **state) {
 // Test Case: Verify that common_spi_transaction_checks fails for a null pData pointer
 void test_common_spi_transaction_checks_null_pdata(void **state) {
     // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
     hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10];
@@ -162,11 +265,28 @@ void test_common_spi_transaction_checks_null_pdata(void **state) {
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NULL_PARAM);
 }
 
+// Test Case: Verify that common_spi_transaction_checks fails for a transaction of no bytes
+void test_common_spi_transaction_checks_zero_size(void **state) {
+    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    hspi.State = HAL_SPI_STATE_READY;
+
+    uint8_t pData[10];
+
+    // Act: Call a function that uses the private common_spi_transaction_checks, but with a size of 0
+    HAL_StatusTypeDef rc = HAL_SPI_Transmit(&hspi, pData, 0, HAL_MAX_DELAY);
+
+    // Assert: common_spi_transaction_checks should catch the empty transaction and return an error
+    assert_int_equal(rc, HAL_ERROR);
+    assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NULL_PARAM);
+}
+
 // Test Case: Verify that common_spi_transaction_checks fails for all non-ready states
 void test_common_spi_transaction_checks_non_ready_state(void **state) {
     // Arrange: Initialize HAL, create uninitialized, busy and erronous SPI handles and prepare for transactions with them
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi1, hspi2;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi1 = {0}, hspi2 = {0};
     hspi1.State = HAL_SPI_STATE_RESET;
     hspi2.State = HAL_SPI_STATE_ERROR;
 
@@ -184,122 +304,123 @@ void test_common_spi_transaction_checks_non_ready_state(void **state) {
     assert_int_equal(hspi2.ErrorCode, HAL_SPI_ERROR_FAILSTATE);
 }
 
-// Test Case: Verify that common_spi_master_transaction_checks fails for message that's too big
-void test_common_spi_master_transaction_checks_msg_too_big(void **state)
-{
-    // Arrange: Initialize HAL, create SPI handles and prepare for transaction with an oversized message
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
-    hspi.State = HAL_SPI_STATE_READY;
-
-    uint8_t pData[MOCK_SPI_MAX_MSG_SIZE+1];
-    uint16_t Size = MOCK_SPI_MAX_MSG_SIZE+1;
-
-    // Act: Call a function that uses the private common_i2c_master_transaction_checks function
-    HAL_StatusTypeDef rc = HAL_SPI_Transmit(&hspi, pData, Size, HAL_MAX_DELAY);
-
-    // Assert: common_spi_master_transaction_checks should catch oversized message and return a corresponding error
-    assert_int_equal(rc, HAL_ERROR);
-    assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_MSG_TOO_BIG);
-}
-
 // Test Case: Verify that HAL_SPI_Init sets the SPI handle to a ready state
 void test_hal_spi_init_sets_values(void **state) {
     // Arrange: Initialize HAL and create a SPI handle with values different from initialized
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    uint8_t buff[10];
     hspi.State = HAL_SPI_STATE_RESET;
     hspi.ErrorCode = 32;
-    memset(hspi.TxMsgBuff, 1, MOCK_SPI_MAX_MSG_SIZE);
-    hspi.TxMsgSize = MOCK_SPI_MAX_MSG_SIZE;
-    memset(hspi.RxMsgBuff, 2, MOCK_SPI_MAX_MSG_SIZE);
-    hspi.RxMsgSize = MOCK_SPI_MAX_MSG_SIZE;
+    hspi.pTxBuffPtr = buff;
+    hspi.TxXferSize = 10;
+    hspi.TxXferCount = 10;
+    hspi.pRxBuffPtr = buff;
+    hspi.RxXferSize = 10;
+    hspi.RxXferCount = 10;
 
     // Act: Call HAL_SPI_Init
     HAL_StatusTypeDef rc = HAL_SPI_Init(&hspi);
 
-    // Assert: The SPI handle should be set to a ready state
-    uint8_t expected_buff[MOCK_SPI_MAX_MSG_SIZE] = {0};
-
+    // Assert: The SPI handle should be set to a ready state, without any transfer
     assert_int_equal(rc, HAL_OK);
     assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NONE);
-    assert_memory_equal(hspi.TxMsgBuff, expected_buff, MOCK_SPI_MAX_MSG_SIZE);
-    assert_int_equal(hspi.TxMsgSize, 0);
-    assert_memory_equal(hspi.RxMsgBuff, expected_buff, MOCK_SPI_MAX_MSG_SIZE);
-    assert_int_equal(hspi.RxMsgSize, 0);
+    assert_null(hspi.pTxBuffPtr);
+    assert_int_equal(hspi.TxXferSize, 0);
+    assert_int_equal(hspi.TxXferCount, 0);
+    assert_null(hspi.pRxBuffPtr);
+    assert_int_equal(hspi.RxXferSize, 0);
+    assert_int_equal(hspi.RxXferCount, 0);
 }
 
 // Test Case: Verify that HAL_SPI_DeInit sets the state of the SPI handle to reset
 void test_hal_spi_deinit_sets_values(void **state) {
     // Arrange: Initialize HAL and create SPI handle with values different from reset
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    uint8_t buff[10];
     hspi.State = HAL_SPI_STATE_ERROR;
     hspi.ErrorCode = HAL_SPI_ERROR_HAL_UNINITIALIZED;
-    memset(hspi.TxMsgBuff, 1, MOCK_SPI_MAX_MSG_SIZE);
-    hspi.TxMsgSize = MOCK_SPI_MAX_MSG_SIZE;
-    memset(hspi.RxMsgBuff, 2, MOCK_SPI_MAX_MSG_SIZE);
-    hspi.RxMsgSize = MOCK_SPI_MAX_MSG_SIZE;
+    hspi.pTxBuffPtr = buff;
+    hspi.TxXferSize = 10;
+    hspi.TxXferCount = 10;
+    hspi.pRxBuffPtr = buff;
+    hspi.RxXferSize = 10;
+    hspi.RxXferCount = 10;
 
     // Act: Call HAL_SPI_DeInit
     HAL_StatusTypeDef rc = HAL_SPI_DeInit(&hspi);
 
-    // Assert: The SPI handle should be set to a reset state
-    uint8_t expected_buff[MOCK_SPI_MAX_MSG_SIZE] = {0};
-
+    // Assert: The SPI handle should be set to a reset state, without any transfer
     assert_int_equal(rc, HAL_OK);
     assert_int_equal(hspi.State, HAL_SPI_STATE_RESET);
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NONE);
-    assert_memory_equal(hspi.TxMsgBuff, expected_buff, MOCK_SPI_MAX_MSG_SIZE);
-    assert_int_equal(hspi.TxMsgSize, 0);
-    assert_memory_equal(hspi.RxMsgBuff, expected_buff, MOCK_SPI_MAX_MSG_SIZE);
-    assert_int_equal(hspi.RxMsgSize, 0);
+    assert_null(hspi.pTxBuffPtr);
+    assert_int_equal(hspi.TxXferSize, 0);
+    assert_int_equal(hspi.TxXferCount, 0);
+    assert_null(hspi.pRxBuffPtr);
+    assert_int_equal(hspi.RxXferSize, 0);
+    assert_int_equal(hspi.RxXferCount, 0);
 }
 
 // Test Case: Verify that HAL_SPI_Transmit transfers data correctly
 void test_hal_spi_transmit_transfers_data(void **state) {
-    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction, with a slave thread to take the data
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
     hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
     uint16_t Size = 10;
 
+    uint8_t received[10] = {0};
+    test_spi_slave_thread slave = {&hspi, received, Size, Size};
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_spi_slave_receive_thread, &slave);
+
     // Act: Call HAL_SPI_Transmit
     HAL_StatusTypeDef rc = HAL_SPI_Transmit(&hspi, pData, Size, HAL_MAX_DELAY);
+    pthread_join(thread, NULL);
 
     // Assert: The data should be transferred correctly
     assert_int_equal(rc, HAL_OK);
-    assert_memory_equal(hspi.TxMsgBuff, pData, Size);
+    assert_int_equal(slave.rc, HAL_OK);
+    assert_memory_equal(received, pData, Size);
 }
 
 // Test Case: Verify that HAL_SPI_Transmit sets expected values in the SPI handle
 void test_hal_spi_transmit_sets_values(void **state) {
-    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction, with a slave thread to take the data
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
     hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
     uint16_t Size = 10;
 
+    uint8_t received[10];
+    test_spi_slave_thread slave = {&hspi, received, Size, Size};
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_spi_slave_receive_thread, &slave);
+
     // Act: Call HAL_SPI_Transmit
     HAL_StatusTypeDef rc = HAL_SPI_Transmit(&hspi, pData, Size, HAL_MAX_DELAY);
+    pthread_join(thread, NULL);
 
-    // Assert: Values in SPI handle should be set correctly according to current state
+    // Assert: Values in SPI handle should show that the slave has taken all the data
     assert_int_equal(rc, HAL_OK);
-    assert_int_equal(hspi.State, HAL_SPI_STATE_BUSY_TX);
+    assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NONE);
-    assert_int_equal(hspi.TxMsgSize, Size);
+    assert_int_equal(hspi.TxXferSize, Size);
+    assert_int_equal(hspi.TxXferCount, 0);
 }
 
 // Test Case: Verify that HAL_SPI_Transmit times out correctly when SPI stays at improper state
 void test_hal_spi_transmit_timeout(void **state) {
     // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
 
     // Transmit should time out if SPI is held at a busy state (Another transaction is ongoing)
     hspi.State = HAL_SPI_STATE_BUSY_TX;
@@ -315,95 +436,146 @@ void test_hal_spi_transmit_timeout(void **state) {
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_TIMEOUT);
 }
 
+// Test Case: Verify that HAL_SPI_Transmit streams a frame-sized transfer to a slave taking it in pieces
+void test_hal_spi_transmit_large_transfer(void **state) {
+    // Arrange: Initialize HAL, create SPI handle and prepare for a large transaction, with a slave thread to take the data in pieces
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    hspi.State = HAL_SPI_STATE_READY;
+
+    static uint8_t pData[30000], received[30000];
+    uint16_t Size = 30000;
+    for(uint16_t i = 0; i < Size; i++) {
+        pData[i] = i * 7;
+    }
+
+    test_spi_slave_thread slave = {&hspi, received, Size, 4096};
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_spi_slave_receive_thread, &slave);
+
+    // Act: Call HAL_SPI_Transmit
+    HAL_StatusTypeDef rc = HAL_SPI_Transmit(&hspi, pData, Size, HAL_MAX_DELAY);
+    pthread_join(thread, NULL);
+
+    // Assert: The whole transfer should have reached the slave
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(slave.rc, HAL_OK);
+    assert_memory_equal(received, pData, Size);
+    assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
+}
+
 // Test Case: Verify that HAL_SPI_Transmit_DMA transfers data correctly
 void test_hal_spi_transmit_dma_transfers_data(void **state) {
-    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction, with a slave thread to take the data
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
     hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
     uint16_t Size = 10;
 
+    uint8_t received[10] = {0};
+    test_spi_slave_thread slave = {&hspi, received, Size, Size};
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_spi_slave_receive_thread, &slave);
+
     // Act: Call HAL_SPI_Transmit_DMA
     HAL_StatusTypeDef rc = HAL_SPI_Transmit_DMA(&hspi, pData, Size);
+    pthread_join(thread, NULL);
 
     // Assert: The data should be transferred correctly
     assert_int_equal(rc, HAL_OK);
-    assert_memory_equal(hspi.TxMsgBuff, pData, Size);
+    assert_memory_equal(received, pData, Size);
 }
 
 // Test Case: Verify that HAL_SPI_Transmit_DMA sets expected values in the SPI handle
 void test_hal_spi_transmit_dma_sets_values(void **state) {
-    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction, with a slave thread to take the data
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
     hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
     uint16_t Size = 10;
 
+    uint8_t received[10];
+    test_spi_slave_thread slave = {&hspi, received, Size, Size};
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_spi_slave_receive_thread, &slave);
+
     // Act: Call HAL_SPI_Transmit_DMA
     HAL_StatusTypeDef rc = HAL_SPI_Transmit_DMA(&hspi, pData, Size);
+    pthread_join(thread, NULL);
 
-    // Assert: Values in SPI handle should be set correctly according to current state
+    // Assert: Values in SPI handle should show that the slave has taken all the data
     assert_int_equal(rc, HAL_OK);
-    assert_int_equal(hspi.State, HAL_SPI_STATE_BUSY_TX);
+    assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NONE);
-    assert_int_equal(hspi.TxMsgSize, Size);
+    assert_int_equal(hspi.TxXferSize, Size);
+    assert_int_equal(hspi.TxXferCount, 0);
 }
 
 // Test Case: Verify that HAL_SPI_Receive transfers data correctly
 void test_hal_spi_receive_transfers_data(void **state) {
-    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction, with a slave thread to send the data
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10];
     uint16_t Size = 10;
 
-    // Data sent from slave to receive
-    hspi.State = HAL_SPI_STATE_BUSY_RX;
-    memset(hspi.RxMsgBuff, 2, Size);
+    uint8_t sent[10];
+    memset(sent, 2, Size);
+    test_spi_slave_thread slave = {&hspi, sent, Size, Size};
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_spi_slave_transmit_thread, &slave);
 
     // Act: Call HAL_SPI_Receive
     HAL_StatusTypeDef rc = HAL_SPI_Receive(&hspi, pData, Size, HAL_MAX_DELAY);
+    pthread_join(thread, NULL);
 
     // Assert: The data should be transferred correctly
     assert_int_equal(rc, HAL_OK);
-    assert_memory_equal(pData, hspi.RxMsgBuff, Size);
+    assert_int_equal(slave.rc, HAL_OK);
+    assert_memory_equal(pData, sent, Size);
 }
 
 // Test Case: Verify that HAL_SPI_Receive sets expected values in the SPI handle
 void test_hal_spi_receive_sets_values(void **state) {
-    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction, with a slave thread to send the data
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10];
     uint16_t Size = 10;
 
-    // Data sent from slave to receive
-    hspi.State = HAL_SPI_STATE_BUSY_RX;
-    memset(hspi.RxMsgBuff, 2, Size);
-    
+    uint8_t sent[10];
+    memset(sent, 2, Size);
+    test_spi_slave_thread slave = {&hspi, sent, Size, Size};
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_spi_slave_transmit_thread, &slave);
+
     // Act: Call HAL_SPI_Receive
     HAL_StatusTypeDef rc = HAL_SPI_Receive(&hspi, pData, Size, HAL_MAX_DELAY);
+    pthread_join(thread, NULL);
 
-    // Assert: Values in SPI handle should be set correctly according to current state
+    // Assert: Values in SPI handle should show that the slave has sent all the data
     assert_int_equal(rc, HAL_OK);
     assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NONE);
-    assert_int_equal(hspi.RxMsgSize, 0);
+    assert_int_equal(hspi.RxXferSize, Size);
+    assert_int_equal(hspi.RxXferCount, 0);
 }
 
-// Test Case: Verify that HAL_SPI_Receive times out correctly when SPI stays at improper state
+// Test Case: Verify that HAL_SPI_Receive times out correctly when no slave answers
 void test_hal_spi_receive_timeout(void **state) {
     // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
 
-    // Receive should time out if SPI is held at a ready state (No data sent from slave to receive)
+    // Receive should time out if no slave sends the data requested
     hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10];
@@ -412,49 +584,87 @@ void test_hal_spi_receive_timeout(void **state) {
     // Act: Call HAL_SPI_Receive
     HAL_StatusTypeDef rc = HAL_SPI_Receive(&hspi, pData, Size, 100);
 
-    // Assert: The function should time out
+    // Assert: The function should time out, withdrawing the request
     assert_int_equal(rc, HAL_ERROR);
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_TIMEOUT);
+    assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
+    assert_null(hspi.pRxBuffPtr);
+}
+
+// Test Case: Verify that HAL_SPI_Receive fills a frame-sized buffer from a slave sending it in pieces
+void test_hal_spi_receive_large_transfer(void **state) {
+    // Arrange: Initialize HAL, create SPI handle and prepare for a large transaction, with a slave thread to send the data in pieces
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    hspi.State = HAL_SPI_STATE_READY;
+
+    static uint8_t pData[30000], sent[30000];
+    uint16_t Size = 30000;
+    for(uint16_t i = 0; i < Size; i++) {
+        sent[i] = i * 7;
+    }
+
+    test_spi_slave_thread slave = {&hspi, sent, Size, 4096};
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_spi_slave_transmit_thread, &slave);
+
+    // Act: Call HAL_SPI_Receive
+    HAL_StatusTypeDef rc = HAL_SPI_Receive(&hspi, pData, Size, HAL_MAX_DELAY);
+    pthread_join(thread, NULL);
+
+    // Assert: The whole transfer should have reached the master
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(slave.rc, HAL_OK);
+    assert_memory_equal(pData, sent, Size);
+    assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
 }
 
 // Test Case: Verify that HAL_SPI_Receive_DMA transfers data correctly
 void test_hal_spi_receive_dma_transfers_data(void **state) {
-    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction, with a slave thread to send the data
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10];
     uint16_t Size = 10;
 
-    // Data sent from slave to receive
-    hspi.State = HAL_SPI_STATE_BUSY_RX;
-    memset(hspi.RxMsgBuff, 2, Size);
+    uint8_t sent[10];
+    memset(sent, 2, Size);
+    test_spi_slave_thread slave = {&hspi, sent, Size, Size};
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_spi_slave_transmit_thread, &slave);
 
-    // Act: Call HAL_SPI_Receive
+    // Act: Call HAL_SPI_Receive_DMA
     HAL_StatusTypeDef rc = HAL_SPI_Receive_DMA(&hspi, pData, Size);
+    pthread_join(thread, NULL);
 
     // Assert: The data should be transferred correctly
     assert_int_equal(rc, HAL_OK);
-    assert_memory_equal(pData, hspi.RxMsgBuff, Size);
+    assert_memory_equal(pData, sent, Size);
 }
 
 // Test Case: Verify that HAL_SPI_Receive_DMA sets expected values in the SPI handle
 void test_hal_spi_receive_dma_sets_values(void **state) {
-    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    // Arrange: Initialize HAL, create SPI handle and prepare for a transaction, with a slave thread to send the data
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10];
     uint16_t Size = 10;
 
-    // Data sent from slave to receive
-    hspi.State = HAL_SPI_STATE_BUSY_RX;
-    memset(hspi.RxMsgBuff, 2, Size);
+    uint8_t sent[10];
+    memset(sent, 2, Size);
+    test_spi_slave_thread slave = {&hspi, sent, Size, Size};
+    pthread_t thread;
+    pthread_create(&thread, NULL, test_spi_slave_transmit_thread, &slave);
 
-    // Act: Call HAL_SPI_Receive
+    // Act: Call HAL_SPI_Receive_DMA
     HAL_StatusTypeDef rc = HAL_SPI_Receive_DMA(&hspi, pData, Size);
+    pthread_join(thread, NULL);
 
-    // Assert: Values in SPI handle should be set correctly according to current state
+    // Assert: Values in SPI handle should show that the slave has sent all the data
     assert_int_equal(rc, HAL_OK);
     assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NONE);
@@ -463,12 +673,15 @@ void test_hal_spi_receive_dma_sets_values(void **state) {
 // Test Case: Verify that Mock_SPI_Slave_Transmit transfers data correctly
 void test_mock_spi_slave_transmit_transfers_data(void **state) {
     // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
 
-    // Simulate 10-element message buffer requested by HAL_SPI_Receive
-    hspi.State = HAL_SPI_STATE_READY;
-    hspi.RxMsgSize = 10;
+    // Simulate 10-element buffer requested by HAL_SPI_Receive
+    uint8_t master_buff[10] = {0};
+    hspi.State = HAL_SPI_STATE_BUSY_RX;
+    hspi.pRxBuffPtr = master_buff;
+    hspi.RxXferSize = 10;
+    hspi.RxXferCount = 10;
 
     uint8_t pData[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
     uint16_t Size = 10;
@@ -478,41 +691,46 @@ void test_mock_spi_slave_transmit_transfers_data(void **state) {
 
     // Assert: The data should be transferred correctly
     assert_int_equal(rc, HAL_OK);
-    assert_memory_equal(hspi.RxMsgBuff, pData, Size);
+    assert_memory_equal(master_buff, pData, Size);
 }
 
-// Test Case: Verify that Mock_SPI_Slave_Transmit sets the SPI handler to a busy state
+// Test Case: Verify that Mock_SPI_Slave_Transmit hands the SPI back to the master once its request is filled, and not before
 void test_mock_spi_slave_transmit_sets_values(void **state) {
     // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
-    hspi.State = HAL_SPI_STATE_READY;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
 
-    // Simulate 10-element message buffer requested by HAL_SPI_Receive
-    hspi.State = HAL_SPI_STATE_READY;
-    hspi.RxMsgSize = 10;
+    // Simulate 10-element buffer requested by HAL_SPI_Receive
+    uint8_t master_buff[10] = {0};
+    hspi.State = HAL_SPI_STATE_BUSY_RX;
+    hspi.pRxBuffPtr = master_buff;
+    hspi.RxXferSize = 10;
+    hspi.RxXferCount = 10;
 
     uint8_t pData[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
-    uint16_t Size = 10;
 
-    // Act: Call Mock_SPI_Slave_Transmit
-    HAL_StatusTypeDef rc = Mock_SPI_Slave_Transmit(&hspi, pData, Size, HAL_MAX_DELAY);
-
-    // Assert: Values in SPI handle should be set correctly according to current state
+    // Act and Assert: Send the data in two pieces, the second one picking up where the first one stopped
+    HAL_StatusTypeDef rc = Mock_SPI_Slave_Transmit(&hspi, pData, 4, HAL_MAX_DELAY);
     assert_int_equal(rc, HAL_OK);
     assert_int_equal(hspi.State, HAL_SPI_STATE_BUSY_RX);
+    assert_int_equal(hspi.RxXferCount, 6);
+
+    rc = Mock_SPI_Slave_Transmit(&hspi, &pData[4], 6, HAL_MAX_DELAY);
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NONE);
-    assert_int_equal(hspi.RxMsgSize, Size);
+    assert_int_equal(hspi.RxXferCount, 0);
+    assert_memory_equal(master_buff, pData, 10);
 }
 
 // Test Case: Verify that Mock_SPI_Slave_Transmit times out correctly when SPI stays at improper state
 void test_mock_spi_slave_transmit_timeout(void **state) {
     // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
 
-    // Transmit should time out if SPI is held at a busy state (Another transaction is ongoing)
-    hspi.State = HAL_SPI_STATE_BUSY_RX;
+    // Transmit should time out if the master never asks for data
+    hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
     uint16_t Size = 10;
@@ -525,18 +743,21 @@ void test_mock_spi_slave_transmit_timeout(void **state) {
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_TIMEOUT);
 }
 
-// Test Case: Verify that Mock_SPI_Slave_Transmit fails for a message size not promised by HAL_SPI_Receive
+// Test Case: Verify that Mock_SPI_Slave_Transmit fails for more data than requested by HAL_SPI_Receive
 void test_mock_spi_slave_transmit_size_mismatch(void **state) {
     // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
 
-    // Transmit should fail if the size of the message to be sent is different from the one requested by the master
-    hspi.State = HAL_SPI_STATE_READY;
-    hspi.RxMsgSize = 10;
+    // Transmit should fail if the message to be sent is bigger than what the master has left to receive
+    uint8_t master_buff[5];
+    hspi.State = HAL_SPI_STATE_BUSY_RX;
+    hspi.pRxBuffPtr = master_buff;
+    hspi.RxXferSize = 5;
+    hspi.RxXferCount = 5;
 
-    uint8_t pData[5] = {0, 1, 2, 3, 4};
-    uint16_t Size = 5;
+    uint8_t pData[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint16_t Size = 10;
 
     // Act: Call Mock_SPI_Slave_Transmit
     HAL_StatusTypeDef rc = Mock_SPI_Slave_Transmit(&hspi, pData, Size, HAL_MAX_DELAY);
@@ -549,60 +770,68 @@ void test_mock_spi_slave_transmit_size_mismatch(void **state) {
 // Test Case: Verify that Mock_SPI_Slave_Receive transfers data correctly
 void test_mock_spi_slave_receive_transfers_data(void **state) {
     // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
 
     uint8_t pData[10];
     uint16_t Size = 10;
 
     // Data sent from master to receive
+    uint8_t master_buff[10];
+    memset(master_buff, 2, Size);
     hspi.State = HAL_SPI_STATE_BUSY_TX;
-    hspi.TxMsgSize = 10;
-    memset(hspi.TxMsgBuff, 2, Size);
+    hspi.pTxBuffPtr = master_buff;
+    hspi.TxXferSize = 10;
+    hspi.TxXferCount = 10;
 
     // Act: Call Mock_SPI_Slave_Receive
     HAL_StatusTypeDef rc = Mock_SPI_Slave_Receive(&hspi, pData, Size, HAL_MAX_DELAY);
 
     // Assert: The data should be transferred correctly
     assert_int_equal(rc, HAL_OK);
-    assert_memory_equal(pData, hspi.TxMsgBuff, Size);
+    assert_memory_equal(pData, master_buff, Size);
 }
 
-// Test Case: Verify that Mock_SPI_Slave_Receive sets expected values in the SPI handle
+// Test Case: Verify that Mock_SPI_Slave_Receive hands the SPI back to the master once all its data is taken, and not before
 void test_mock_spi_slave_receive_sets_values(void **state) {
     // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
 
     uint8_t pData[10];
-    uint16_t Size = 10;
 
     // Data sent from master to receive
+    uint8_t master_buff[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
     hspi.State = HAL_SPI_STATE_BUSY_TX;
-    hspi.TxMsgSize = 10;
-    memset(hspi.TxMsgBuff, 2, Size);
-    
-    // Act: Call Mock_SPI_Slave_Receive
-    HAL_StatusTypeDef rc = Mock_SPI_Slave_Receive(&hspi, pData, Size, HAL_MAX_DELAY);
+    hspi.pTxBuffPtr = master_buff;
+    hspi.TxXferSize = 10;
+    hspi.TxXferCount = 10;
+
+    // Act and Assert: Take the data in two pieces, the second one picking up where the first one stopped
+    HAL_StatusTypeDef rc = Mock_SPI_Slave_Receive(&hspi, pData, 4, HAL_MAX_DELAY);
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(hspi.State, HAL_SPI_STATE_BUSY_TX);
+    assert_int_equal(hspi.TxXferCount, 6);
 
-    // Assert: Values in SPI handle should be set correctly according to current state
+    rc = Mock_SPI_Slave_Receive(&hspi, &pData[4], 6, HAL_MAX_DELAY);
     assert_int_equal(rc, HAL_OK);
     assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NONE);
+    assert_int_equal(hspi.TxXferCount, 0);
+    assert_memory_equal(pData, master_buff, 10);
 }
 
 // Test Case: Verify that Mock_SPI_Slave_Receive times out correctly when SPI stays at improper state
 void test_mock_spi_slave_receive_timeout(void **state) {
     // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
 
     // Receive should time out if SPI is held at a ready state (No data sent from master to receive)
     hspi.State = HAL_SPI_STATE_READY;
 
     uint8_t pData[10];
     uint16_t Size = 10;
-    hspi.TxMsgSize = 10;
 
     // Act: Call Mock_SPI_Slave_Receive
     HAL_StatusTypeDef rc = Mock_SPI_Slave_Receive(&hspi, pData, Size, 100);
@@ -612,18 +841,21 @@ void test_mock_spi_slave_receive_timeout(void **state) {
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_TIMEOUT);
 }
 
-// Test Case: Verify that Mock_SPI_Slave_Receive fails for a message size not promised by HAL_SPI_Transmit
+// Test Case: Verify that Mock_SPI_Slave_Receive fails for more data than sent by HAL_SPI_Transmit
 void test_mock_spi_slave_receive_size_mismatch(void **state) {
     // Arrange: Initialize HAL, create SPI handle and prepare for a transaction
-    hal_initialized = 1;
-    SPI_HandleTypeDef hspi;
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
 
-    // Receive should fail if the size of the message to be received is different from the one promised by the master
+    // Receive should fail if the message to be received is bigger than what the master has left to send
+    uint8_t master_buff[5] = {0};
     hspi.State = HAL_SPI_STATE_BUSY_TX;
-    hspi.TxMsgSize = 10;
+    hspi.pTxBuffPtr = master_buff;
+    hspi.TxXferSize = 5;
+    hspi.TxXferCount = 5;
 
-    uint8_t pData[5];
-    uint16_t Size = 5;
+    uint8_t pData[10];
+    uint16_t Size = 10;
 
     // Act: Call Mock_SPI_Slave_Receive
     HAL_StatusTypeDef rc = Mock_SPI_Slave_Receive(&hspi, pData, Size, HAL_MAX_DELAY);
@@ -631,4 +863,378 @@ void test_mock_spi_slave_receive_size_mismatch(void **state) {
     // Assert: The function should fail
     assert_int_equal(rc, HAL_ERROR);
     assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_SIZE_MISMATCH);
-}
\ No newline at end of file
+}
+
+// Test Case: Verify that HAL_SPI_Transmit hands the data to an attached slave device without a slave thread
+void test_mock_spi_attach_slave_transmit_calls_on_write(void **state) {
+    // Arrange: Initialize HAL and SPI, attach a slave device
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    HAL_SPI_Init(&hspi);
+    test_spi_device device = {0};
+    Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, NULL, 0);
+
+    uint8_t pData[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint16_t Size = 10;
+
+    // Act: Call HAL_SPI_Transmit
+    HAL_StatusTypeDef rc = HAL_SPI_Transmit(&hspi, pData, Size, HAL_MAX_DELAY);
+
+    // Assert: The device should have received the data, leaving the SPI ready for the next transaction
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(device.written_size, Size);
+    assert_memory_equal(device.written, pData, Size);
+    assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
+    assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NONE);
+}
+
+// Test Case: Verify that HAL_SPI_Receive gets its data from an attached slave device without a slave thread
+void test_mock_spi_attach_slave_receive_calls_on_read(void **state) {
+    // Arrange: Initialize HAL and SPI, attach a slave device
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    HAL_SPI_Init(&hspi);
+    test_spi_device device = {0};
+    device.next_read = 5;
+    Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, NULL, 0);
+
+    uint8_t pData[3];
+    uint8_t expected[3] = {5, 6, 7};
+
+    // Act: Call HAL_SPI_Receive
+    HAL_StatusTypeDef rc = HAL_SPI_Receive(&hspi, pData, 3, HAL_MAX_DELAY);
+
+    // Assert: The data should come from the device, leaving the SPI ready for the next transaction
+    assert_int_equal(rc, HAL_OK);
+    assert_memory_equal(pData, expected, 3);
+    assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
+}
+
+// Test Case: Verify that an attached slave device sees writes to its (active-low) chip select until detached
+void test_mock_spi_attach_slave_cs_calls_on_cs(void **state) {
+    // Arrange: Initialize HAL, a CS pin and SPI, attach a slave device on that pin
+    hal_board->Initialized = 1;
+    GPIO_TypeDef cs_port;
+    GPIO_InitTypeDef cs_init;
+    HAL_GPIO_Init(&cs_port, &cs_init);
+    SPI_HandleTypeDef hspi = {0};
+    HAL_SPI_Init(&hspi);
+    test_spi_device device = {0};
+    HAL_StatusTypeDef rc = Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, &cs_port, GPIO_PIN_4);
+
+    // Act and Assert: Selecting and deselecting should reach the device, other pins and a detached device shouldn't
+    assert_int_equal(rc, HAL_OK);
+    HAL_GPIO_WritePin(&cs_port, GPIO_PIN_4, GPIO_PIN_RESET);
+    assert_int_equal(device.selected, 1);
+    HAL_GPIO_WritePin(&cs_port, GPIO_PIN_5, GPIO_PIN_SET);
+    assert_int_equal(device.selected, 1);
+    HAL_GPIO_WritePin(&cs_port, GPIO_PIN_4, GPIO_PIN_SET);
+    assert_int_equal(device.selected, 0);
+
+    Mock_SPI_Detach_Slave(&hspi);
+    HAL_GPIO_WritePin(&cs_port, GPIO_PIN_4, GPIO_PIN_RESET);
+    assert_int_equal(device.selected, 0);
+}
+
+// Test Case: Verify that a transfer takes the time its bytes need at the bit rate set by the prescaler
+void test_mock_spi_transfer_takes_bus_time(void **state) {
+    // Arrange: Initialize HAL and SPI at PCLK2 / 16 (3.75 Mbit/s, as set up in main.c), attach a slave device
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    hspi.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+    HAL_SPI_Init(&hspi);
+    test_spi_device device = {0};
+    Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, NULL, 0);
+
+    uint8_t pData[1000] = {0};
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Receive 1000 bytes
+    HAL_StatusTypeDef rc = HAL_SPI_Receive(&hspi, pData, sizeof(pData), HAL_MAX_DELAY);
+
+    // Assert: The transfer should have taken 8000 bits at 3.75 Mbit/s, plus the transaction overhead
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(Mock_HAL_GetTimeNs() - ns_start, 8000ULL * 1000000000ULL / 3750000ULL + MOCK_SPI_TRANSACTION_NS);
+}
+
+// Test Case: Verify that chip select edges and transfers are recorded in the bus trace with their time on the bus
+void test_mock_spi_transfers_are_traced(void **state) {
+    // Arrange: Initialize HAL and SPI at 3.75 Mbit/s, attach a slave device with a chip select, start a trace
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    hspi.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+    HAL_SPI_Init(&hspi);
+    GPIO_TypeDef cs_port = {0};
+    cs_port.ODR = GPIO_PIN_4;
+    test_spi_device device = {0};
+    Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, &cs_port, GPIO_PIN_4);
+    char path[32];
+    test_trace_start(path);
+
+    uint8_t command = 0x3D;
+    uint8_t pData[100];
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Select the device, transmit a command byte, receive 100 bytes, deselect it
+    HAL_GPIO_WritePin(&cs_port, GPIO_PIN_4, GPIO_PIN_RESET);
+    HAL_SPI_Transmit(&hspi, &command, 1, HAL_MAX_DELAY);
+    HAL_SPI_Receive(&hspi, pData, sizeof(pData), HAL_MAX_DELAY);
+    HAL_GPIO_WritePin(&cs_port, GPIO_PIN_4, GPIO_PIN_SET);
+    Mock_HAL_TraceRecordTypeDef records[5];
+    size_t count = test_trace_stop(path, records, 5);
+
+    // Assert: Both edges and both transfers should be recorded in order, each transfer starting where the last one ended
+    uint64_t ns_command = 8ULL * 1000000000ULL / 3750000ULL + MOCK_SPI_TRANSACTION_NS;
+    uint64_t ns_data = 800ULL * 1000000000ULL / 3750000ULL + MOCK_SPI_TRANSACTION_NS;
+    assert_int_equal(count, 4);
+    assert_int_equal(records[0].Type, MOCK_HAL_TRACE_GPIO);
+    assert_int_equal(records[0].Size, GPIO_PIN_4);
+    assert_int_equal(records[0].Status, GPIO_PIN_RESET);
+    assert_int_equal(records[1].Type, MOCK_HAL_TRACE_SPI_TX);
+    assert_int_equal(records[1].Size, 1);
+    assert_int_equal(records[1].TimeNs, ns_start);
+    assert_int_equal(records[1].DurationNs, ns_command);
+    assert_int_equal(records[2].Type, MOCK_HAL_TRACE_SPI_RX);
+    assert_int_equal(records[2].Size, 100);
+    assert_int_equal(records[2].Status, HAL_OK);
+    assert_int_equal(records[2].TimeNs, ns_start + ns_command);
+    assert_int_equal(records[2].DurationNs, ns_data);
+    assert_int_equal(records[3].Type, MOCK_HAL_TRACE_GPIO);
+    assert_int_equal(records[3].Status, GPIO_PIN_SET);
+    Mock_SPI_Detach_Slave(&hspi);
+}
+
+// Test Case: Verify that the handle counts the transfers made since HAL_SPI_Init, by direction
+void test_mock_spi_transfers_are_counted(void **state) {
+    // Arrange: Initialize HAL and SPI at 3.75 Mbit/s, attach a slave device, make a transfer before initializing again
+    hal_board->Initialized = 1;
+    SPI_HandleTypeDef hspi = {0};
+    hspi.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+    test_spi_device device = {0};
+    Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, NULL, 0);
+    uint8_t command = 0x3D;
+    uint8_t pData[100];
+    HAL_SPI_Init(&hspi);
+    HAL_SPI_Transmit(&hspi, &command, 1, HAL_MAX_DELAY);
+    HAL_SPI_Init(&hspi);
+
+    // Act: Transmit a command byte twice and receive 100 bytes
+    HAL_SPI_Transmit(&hspi, &command, 1, HAL_MAX_DELAY);
+    HAL_SPI_Transmit(&hspi, &command, 1, HAL_MAX_DELAY);
+    HAL_SPI_Receive(&hspi, pData, sizeof(pData), HAL_MAX_DELAY);
+
+    // Assert: Only the transfers since the last HAL_SPI_Init should be counted, with the bus time they took
+    uint64_t ns_command = 8ULL * 1000000000ULL / 3750000ULL + MOCK_SPI_TRANSACTION_NS;
+    uint64_t ns_data = 800ULL * 1000000000ULL / 3750000ULL + MOCK_SPI_TRANSACTION_NS;
+    assert_int_equal(hspi.Stats.Transfers[MOCK_HAL_FAULT_WRITE], 2);
+    assert_int_equal(hspi.Stats.Bytes[MOCK_HAL_FAULT_WRITE], 2);
+    assert_int_equal(hspi.Stats.Transfers[MOCK_HAL_FAULT_READ], 1);
+    assert_int_equal(hspi.Stats.Bytes[MOCK_HAL_FAULT_READ], 100);
+    assert_int_equal(hspi.Stats.Failed, 0);
+    assert_int_equal(hspi.Stats.BusNs, 2 * ns_command + ns_data);
+    Mock_SPI_Detach_Slave(&hspi);
+}
+
+// Test Case: Verify that HAL_SPI_Transmit_DMA with a stream linked returns before the transfer is done, and completes it in the background
+void test_hal_spi_transmit_dma_completes_in_background(void **state) {
+    // Arrange: Initialize HAL and SPI at 3.75 Mbit/s with a Tx stream linked, attach a slave device
+    HAL_Init();
+    SPI_HandleTypeDef hspi = {0};
+    DMA_HandleTypeDef hdma_tx = {0};
+    hspi.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+    __HAL_LINKDMA(&hspi, hdmatx, hdma_tx);
+    HAL_SPI_Init(&hspi);
+    test_spi_device device = {0};
+    Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, NULL, 0);
+    test_spi_tx_cplt = 0;
+
+    uint8_t pData[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Call HAL_SPI_Transmit_DMA, then poll the stream until it's done
+    HAL_StatusTypeDef rc = HAL_SPI_Transmit_DMA(&hspi, pData, 10);
+    HAL_SPI_StateTypeDef started_state = hspi.State;
+    uint64_t started_ns = Mock_HAL_GetTimeNs() - ns_start;
+    uint8_t started_cplt = test_spi_tx_cplt;
+    while(HAL_DMA_GetState(&hdma_tx) != HAL_DMA_STATE_READY);
+
+    // Assert: The transfer should have started without taking time, then completed after its bus time through the callback
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(started_state, HAL_SPI_STATE_BUSY_TX);
+    assert_int_equal(started_ns, 0);
+    assert_int_equal(started_cplt, 0);
+    assert_memory_equal(device.written, pData, 10);
+    assert_int_equal(Mock_HAL_GetTimeNs() - ns_start, 80ULL * 1000000000ULL / 3750000ULL + MOCK_SPI_TRANSACTION_NS);
+    assert_int_equal(test_spi_tx_cplt, 1);
+    assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
+}
+
+// Test Case: Verify that HAL_SPI_Receive_DMA with a stream linked completes in the background, while the caller gets on with other work
+void test_hal_spi_receive_dma_completes_in_background(void **state) {
+    // Arrange: Initialize HAL and SPI at 3.75 Mbit/s with an Rx stream linked, attach a slave device
+    HAL_Init();
+    SPI_HandleTypeDef hspi = {0};
+    DMA_HandleTypeDef hdma_rx = {0};
+    hspi.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+    __HAL_LINKDMA(&hspi, hdmarx, hdma_rx);
+    HAL_SPI_Init(&hspi);
+    test_spi_device device = {0};
+    device.next_read = 5;
+    Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, NULL, 0);
+    test_spi_rx_cplt = 0;
+
+    static uint8_t pData[4096];
+    uint32_t tick_start = HAL_GetTick();
+
+    // Act: Start receiving 4096 bytes (about 8.7 ms), then delay for 5 and 5 more milliseconds
+    HAL_StatusTypeDef rc = HAL_SPI_Receive_DMA(&hspi, pData, sizeof(pData));
+    HAL_Delay(5);
+    uint8_t cplt_during = test_spi_rx_cplt;
+    HAL_DMA_StateTypeDef dma_during = hdma_rx.State;
+    HAL_Delay(5);
+
+    // Assert: The transfer should still be going halfway through the delays, and have completed by the end of them
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(cplt_during, 0);
+    assert_int_equal(dma_during, HAL_DMA_STATE_BUSY);
+    assert_int_equal(test_spi_rx_cplt, 1);
+    assert_int_equal(hdma_rx.State, HAL_DMA_STATE_READY);
+    assert_int_equal(hspi.State, HAL_SPI_STATE_READY);
+    assert_int_equal(pData[0], 5);
+    assert_int_equal(HAL_GetTick() - tick_start, 10);
+}
+
+// Test Case: Verify that the SPI refuses other transfers until a DMA transfer is done
+void test_hal_spi_receive_dma_busy_until_complete(void **state) {
+    // Arrange: Initialize HAL and SPI with an Rx stream linked, attach a slave device, start a DMA receive
+    HAL_Init();
+    SPI_HandleTypeDef hspi = {0};
+    DMA_HandleTypeDef hdma_rx = {0};
+    __HAL_LINKDMA(&hspi, hdmarx, hdma_rx);
+    HAL_SPI_Init(&hspi);
+    test_spi_device device = {0};
+    Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, NULL, 0);
+
+    uint8_t pData[10];
+    uint8_t more[10];
+    HAL_SPI_Receive_DMA(&hspi, pData, 10);
+
+    // Act: Receive again, blocking and through DMA, before and after the transfer is done
+    HAL_StatusTypeDef rc_blocking = HAL_SPI_Receive(&hspi, more, 10, HAL_MAX_DELAY);
+    HAL_StatusTypeDef rc_dma = HAL_SPI_Receive_DMA(&hspi, more, 10);
+    while(HAL_DMA_GetState(&hdma_rx) != HAL_DMA_STATE_READY);
+    HAL_StatusTypeDef rc_after = HAL_SPI_Receive(&hspi, more, 10, HAL_MAX_DELAY);
+
+    // Assert: The SPI should be busy while the transfer is in flight, then take transfers again
+    assert_int_equal(rc_blocking, HAL_BUSY);
+    assert_int_equal(rc_dma, HAL_BUSY);
+    assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_NONE);
+    assert_int_equal(rc_after, HAL_OK);
+}
+
+// Test Case: Verify that an injected error fails a receive on the bus: it takes its bus time, but the device never sees it
+void test_mock_spi_fault_error_fails_receive(void **state) {
+    // Arrange: Initialize HAL and SPI at 3.75 Mbit/s, attach a slave device, fail every receive
+    HAL_Init();
+    SPI_HandleTypeDef hspi = {0};
+    hspi.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+    HAL_SPI_Init(&hspi);
+    test_spi_device device = {0};
+    device.next_read = 5;
+    Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, NULL, 0);
+    Mock_HAL_FaultsTypeDef faults = {0};
+    faults.ErrorPpm[MOCK_HAL_FAULT_READ] = 1000000;
+    Mock_SPI_Set_Faults(&hspi, &faults);
+
+    uint8_t pData[100] = {0};
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Receive, then transmit (which has no errors set)
+    HAL_StatusTypeDef rc_receive = HAL_SPI_Receive(&hspi, pData, sizeof(pData), HAL_MAX_DELAY);
+    uint32_t error_receive = hspi.ErrorCode;
+    uint64_t ns_receive = Mock_HAL_GetTimeNs() - ns_start;
+    HAL_StatusTypeDef rc_transmit = HAL_SPI_Transmit(&hspi, pData, 2, HAL_MAX_DELAY);
+
+    // Assert: Only the receive should have failed, after clocking its 800 bits, without reading from the device
+    assert_int_equal(rc_receive, HAL_ERROR);
+    assert_int_equal(error_receive, HAL_SPI_ERROR_FAULT);
+    assert_int_equal(ns_receive, 800ULL * 1000000000ULL / 3750000ULL + MOCK_SPI_TRANSACTION_NS);
+    assert_int_equal(device.next_read, 5);
+    assert_int_equal(rc_transmit, HAL_OK);
+    assert_int_equal(device.written_size, 2);
+    assert_int_equal(faults.Errors, 1);
+    Mock_SPI_Set_Faults(&hspi, NULL);
+}
+
+// Test Case: Verify that injected bit flips corrupt the data the master receives, the same way for the same seed
+void test_mock_spi_fault_bit_flips_corrupt_receive(void **state) {
+    // Arrange: Initialize HAL and SPI, attach a slave device, flip about 1 in 100 bits
+    HAL_Init();
+    SPI_HandleTypeDef hspi = {0};
+    HAL_SPI_Init(&hspi);
+    test_spi_device device = {0};
+    Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, NULL, 0);
+    Mock_HAL_FaultsTypeDef faults = {0};
+    faults.BitFlipPpm = 10000;
+    faults.Seed = 1234;
+
+    uint8_t first[250];
+    uint8_t second[250];
+    uint8_t expected[250];
+    for(uint16_t i = 0; i < sizeof(expected); i++) {
+        expected[i] = (uint8_t)i;
+    }
+
+    // Act: Receive the same data twice, starting the faults over from the seed each time
+    Mock_SPI_Set_Faults(&hspi, &faults);
+    HAL_StatusTypeDef rc_first = HAL_SPI_Receive(&hspi, first, sizeof(first), HAL_MAX_DELAY);
+    uint32_t flips_first = faults.BitFlips;
+    device.next_read = 0;
+    Mock_SPI_Set_Faults(&hspi, &faults);
+    HAL_StatusTypeDef rc_second = HAL_SPI_Receive(&hspi, second, sizeof(second), HAL_MAX_DELAY);
+
+    // Assert: Both receives should succeed with the same bits of the 2000 flipped, as counted
+    uint32_t flipped = 0;
+    for(uint16_t i = 0; i < sizeof(first); i++) {
+        flipped += (uint32_t)__builtin_popcount(first[i] ^ expected[i]);
+    }
+    assert_int_equal(rc_first, HAL_OK);
+    assert_int_equal(rc_second, HAL_OK);
+    assert_memory_equal(first, second, sizeof(first));
+    assert_int_equal(flipped, flips_first);
+    assert_in_range(flipped, 1, 100);
+    Mock_SPI_Set_Faults(&hspi, NULL);
+}
+
+// Test Case: Verify that a stalled slave makes a transfer time out after the stall, or its own timeout if shorter
+void test_mock_spi_fault_stall_times_out(void **state) {
+    // Arrange: Initialize HAL and SPI, attach a slave device, stall every transfer for 50 ms
+    HAL_Init();
+    SPI_HandleTypeDef hspi = {0};
+    HAL_SPI_Init(&hspi);
+    test_spi_device device = {0};
+    Mock_SPI_Attach_Slave(&hspi, &test_spi_slave, &device, NULL, 0);
+    Mock_HAL_FaultsTypeDef faults = {0};
+    faults.StallPpm = 1000000;
+    faults.StallMs = 50;
+    Mock_SPI_Set_Faults(&hspi, &faults);
+
+    uint8_t pData[2] = {1, 2};
+    uint32_t start = HAL_GetTick();
+
+    // Act: Transmit with a 10 ms timeout, then without a timeout
+    HAL_StatusTypeDef rc_short = HAL_SPI_Transmit(&hspi, pData, sizeof(pData), 10);
+    uint32_t ticks_short = HAL_GetTick() - start;
+    HAL_StatusTypeDef rc_long = HAL_SPI_Transmit(&hspi, pData, sizeof(pData), HAL_MAX_DELAY);
+    uint32_t ticks_long = HAL_GetTick() - start - ticks_short;
+
+    // Assert: Both should time out, taking 10 ms then the full stall, without the device seeing any data
+    assert_int_equal(rc_short, HAL_ERROR);
+    assert_int_equal(rc_long, HAL_ERROR);
+    assert_int_equal(hspi.ErrorCode, HAL_SPI_ERROR_TIMEOUT);
+    assert_int_equal(ticks_short, 10);
+    assert_int_equal(ticks_long, 50);
+    assert_int_equal(device.written_size, 0);
+    assert_int_equal(faults.Stalls, 2);
+    Mock_SPI_Set_Faults(&hspi, NULL);
+}
@@ -15,12 +15,14 @@
 #define NUM_COMMON_SPI_TRANSACTION_CHECKS_TESTS 4
 #define NUM_HAL_MOCK_INIT_TESTS 1
 #define NUM_HAL_MOCK_DEINIT_TESTS 1
-#define NUM_HAL_MOCK_TRANSMIT_TESTS 3
-#define NUM_HAL_MOCK_TRANSMIT_DMA_TESTS 2
-#define NUM_HAL_MOCK_RECEIVE_TESTS 3
-#define NUM_HAL_MOCK_RECEIVE_DMA_TESTS 2
+#define NUM_HAL_MOCK_TRANSMIT_TESTS 4
+#define NUM_HAL_MOCK_TRANSMIT_DMA_TESTS 3
+#define NUM_HAL_MOCK_RECEIVE_TESTS 4
+#define NUM_HAL_MOCK_RECEIVE_DMA_TESTS 4
 #define NUM_MOCK_SPI_SLAVE_TRANSMIT_TESTS 4
 #define NUM_MOCK_SPI_SLAVE_RECEIVE_TESTS 4
+#define NUM_MOCK_SPI_ATTACH_SLAVE_TESTS 6
+#define NUM_MOCK_SPI_FAULT_TESTS 3
 
 // Global test arrays
 extern const struct CMUnitTest common_spi_checks_tests[NUM_COMMON_SPI_CHECKS_TESTS];
@@ -33,6 +35,8 @@ extern const struct CMUnitTest hal_mock_receive_tests[NUM_HAL_MOCK_RECEIVE_TESTS
 extern const struct CMUnitTest hal_mock_receive_dma_tests[NUM_HAL_MOCK_RECEIVE_DMA_TESTS];
 extern const struct CMUnitTest mock_spi_slave_transmit_tests[NUM_MOCK_SPI_SLAVE_TRANSMIT_TESTS];
 extern const struct CMUnitTest mock_spi_slave_receive_tests[NUM_MOCK_SPI_SLAVE_RECEIVE_TESTS];
+extern const struct CMUnitTest mock_spi_attach_slave_tests[NUM_MOCK_SPI_ATTACH_SLAVE_TESTS];
+extern const struct CMUnitTest mock_spi_fault_tests[NUM_MOCK_SPI_FAULT_TESTS];
 
 // Declaration of test functions
 
@@ -47,8 +51,8 @@ void test_common_spi_checks_no_hal_init(void **state);
 // common_spi_transaction_checks Tests
 void test_common_spi_transaction_checks_returns_ok(void **state);
 void test_common_spi_transaction_checks_null_pdata(void **state);
+void test_common_spi_transaction_checks_zero_size(void **state);
 void test_common_spi_transaction_checks_non_ready_state(void **state);
-void test_common_spi_master_transaction_checks_msg_too_big(void **state);
 
 // HAL_SPI_Init Tests
 void test_hal_spi_init_sets_values(void **state);
@@ -60,19 +64,24 @@ void test_hal_spi_deinit_sets_values(void **state);
 void test_hal_spi_transmit_transfers_data(void **state);
 void test_hal_spi_transmit_sets_values(void **state);
 void test_hal_spi_transmit_timeout(void **state);
+void test_hal_spi_transmit_large_transfer(void **state);
 
 // HAL_SPI_Transmit_DMA Tests
 void test_hal_spi_transmit_dma_transfers_data(void **state);
 void test_hal_spi_transmit_dma_sets_values(void **state);
+void test_hal_spi_transmit_dma_completes_in_background(void **state);
 
 // HAL_SPI_Receive Tests
 void test_hal_spi_receive_transfers_data(void **state);
 void test_hal_spi_receive_sets_values(void **state);
 void test_hal_spi_receive_timeout(void **state);
+void test_hal_spi_receive_large_transfer(void **state);
 
 // HAL_SPI_Receive_DMA Tests
 void test_hal_spi_receive_dma_transfers_data(void **state);
 void test_hal_spi_receive_dma_sets_values(void **state);
+void test_hal_spi_receive_dma_completes_in_background(void **state);
+void test_hal_spi_receive_dma_busy_until_complete(void **state);
 
 // Mock_SPI_Slave_Transmit Tests
 void test_mock_spi_slave_transmit_transfers_data(void **state);
@@ -86,4 +95,17 @@ void test_mock_spi_slave_receive_sets_values(void **state);
 void test_mock_spi_slave_receive_timeout(void **state);
 void test_mock_spi_slave_receive_size_mismatch(void **state);
 
+// Mock_SPI_Attach_Slave Tests
+void test_mock_spi_attach_slave_transmit_calls_on_write(void **state);
+void test_mock_spi_attach_slave_receive_calls_on_read(void **state);
+void test_mock_spi_attach_slave_cs_calls_on_cs(void **state);
+void test_mock_spi_transfer_takes_bus_time(void **state);
+void test_mock_spi_transfers_are_traced(void **state);
+void test_mock_spi_transfers_are_counted(void **state);
+
+// Mock_SPI_Set_Faults Tests
+void test_mock_spi_fault_error_fails_receive(void **state);
+void test_mock_spi_fault_bit_flips_corrupt_receive(void **state);
+void test_mock_spi_fault_stall_times_out(void **state);
+
 #endif // TEST_HAL_MOCK_SPI_H
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test_hal_mock_trace.h"
+
+void test_trace_start(char *path) {
+    strcpy(path, "/tmp/test_traceXXXXXX");
+    close(mkstemp(path));
+    Mock_HAL_Trace_Start(path);
+}
+
+size_t test_trace_stop(const char *path, Mock_HAL_TraceRecordTypeDef *records, size_t max) {
+    Mock_HAL_Trace_Stop();
+    FILE *f = fopen(path, "rb");
+    fseek(f, (long)strlen(MOCK_HAL_TRACE_MAGIC) + 2 * sizeof(uint32_t), SEEK_SET);
+    size_t count = 0;
+    while((count < max) && (fread(&records[count], sizeof(records[count]), 1, f) == 1)) {
+        if(records[count].Type == MOCK_HAL_TRACE_PHASE_NAME) {
+            fseek(f, records[count].Size, SEEK_CUR);
+        }
+        else {
+            count++;
+        }
+    }
+    fclose(f);
+    unlink(path);
+    return count;
+}
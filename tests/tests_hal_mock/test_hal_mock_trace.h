@@ -0,0 +1,17 @@
+#ifndef TEST_HAL_MOCK_TRACE_H
+#define TEST_HAL_MOCK_TRACE_H
+
+#include <stddef.h>
+
+#include "../../mocks/hal_mock_general.h"
+
+// Helpers for the tests recording a bus trace, shared by the mock HAL tests
+
+// Records a bus trace to a temporary file, returning its path through path (at least 32 bytes)
+void test_trace_start(char *path);
+
+// Stops the bus trace started with test_trace_start and reads back up to max of its records (leaving out phase names),
+// then removes the file
+size_t test_trace_stop(const char *path, Mock_HAL_TraceRecordTypeDef *records, size_t max);
+
+#endif // TEST_HAL_MOCK_TRACE_H
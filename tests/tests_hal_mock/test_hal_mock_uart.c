@@ -0,0 +1,363 @@
+#include <fcntl.h>
+
+#include "test_hal_mock_uart.h"
+
+// Definition of test arrays
+
+// HAL_UART_Init Tests
+const struct CMUnitTest hal_uart_init_tests[NUM_HAL_UART_INIT_TESTS] = {
+    cmocka_unit_test(test_hal_uart_init_sets_values),
+    cmocka_unit_test(test_hal_uart_init_no_hal_init),
+};
+
+// HAL_UART_Transmit Tests
+const struct CMUnitTest hal_uart_transmit_tests[NUM_HAL_UART_TRANSMIT_TESTS] = {
+    cmocka_unit_test(test_hal_uart_transmit_writes_fd),
+    cmocka_unit_test(test_hal_uart_transmit_takes_frame_time),
+    cmocka_unit_test(test_hal_uart_transmit_uninitialized),
+};
+
+// HAL_UART_Transmit_IT Tests
+const struct CMUnitTest hal_uart_transmit_it_tests[NUM_HAL_UART_TRANSMIT_IT_TESTS] = {
+    cmocka_unit_test(test_hal_uart_transmit_it_completes_in_background),
+    cmocka_unit_test(test_hal_uart_transmit_it_busy_until_complete),
+};
+
+// HAL_UART_Transmit_DMA Tests
+const struct CMUnitTest hal_uart_transmit_dma_tests[NUM_HAL_UART_TRANSMIT_DMA_TESTS] = {
+    cmocka_unit_test(test_hal_uart_transmit_dma_completes_through_stream),
+};
+
+// HAL_UART_Receive Tests
+const struct CMUnitTest hal_uart_receive_tests[NUM_HAL_UART_RECEIVE_TESTS] = {
+    cmocka_unit_test(test_hal_uart_receive_reads_fd),
+    cmocka_unit_test(test_hal_uart_receive_timeout),
+};
+
+// HAL_UART_Receive_IT Tests
+const struct CMUnitTest hal_uart_receive_it_tests[NUM_HAL_UART_RECEIVE_IT_TESTS] = {
+    cmocka_unit_test(test_hal_uart_receive_it_takes_bytes_as_they_come),
+};
+
+// HAL_UART_Abort Tests
+const struct CMUnitTest hal_uart_abort_tests[NUM_HAL_UART_ABORT_TESTS] = {
+    cmocka_unit_test(test_hal_uart_abort_drops_transmit),
+};
+
+// Transfer complete callbacks of the HAL (overriding the mock's weak ones): count completions of each direction
+static uint8_t test_uart_tx_cplt = 0;
+static uint8_t test_uart_rx_cplt = 0;
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    test_uart_tx_cplt++;
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
+    test_uart_rx_cplt++;
+}
+
+// Initializes HAL and a UART at 115200 baud 8N1 (as set up in main.c), connected to the host through a pipe each way
+// host_rx reads what the UART sent, host_tx writes what the UART receives; both are non-blocking
+static void test_uart_setup(UART_HandleTypeDef *huart, int *host_rx, int *host_tx) {
+    int to_host[2], from_host[2];
+    assert_int_equal(pipe(to_host), 0);
+    assert_int_equal(pipe(from_host), 0);
+    fcntl(to_host[0], F_SETFL, O_NONBLOCK);
+
+    HAL_Init();
+    huart->Init.BaudRate = 115200;
+    huart->Init.WordLength = UART_WORDLENGTH_8B;
+    huart->Init.StopBits = UART_STOPBITS_1;
+    huart->Init.Parity = UART_PARITY_NONE;
+    huart->Init.Mode = UART_MODE_TX_RX;
+    HAL_UART_Init(huart);
+    Mock_UART_Attach_Fd(huart, to_host[1], from_host[0]);
+
+    *host_rx = to_host[0];
+    *host_tx = from_host[1];
+}
+
+static void test_uart_teardown(UART_HandleTypeDef *huart, int host_rx, int host_tx) {
+    HAL_UART_DeInit(huart);
+    close(huart->TxFd);
+    close(huart->RxFd);
+    close(host_rx);
+    close(host_tx);
+}
+
+void run_hal_mock_uart_tests(void) {
+    int status = 0;
+
+    status += cmocka_run_group_tests(hal_uart_init_tests, NULL, NULL);
+    status += cmocka_run_group_tests(hal_uart_transmit_tests, NULL, NULL);
+    status += cmocka_run_group_tests(hal_uart_transmit_it_tests, NULL, NULL);
+    status += cmocka_run_group_tests(hal_uart_transmit_dma_tests, NULL, NULL);
+    status += cmocka_run_group_tests(hal_uart_receive_tests, NULL, NULL);
+    status += cmocka_run_group_tests(hal_uart_receive_it_tests, NULL, NULL);
+    status += cmocka_run_group_tests(hal_uart_abort_tests, NULL, NULL);
+
+    assert_int_equal(status, 0);
+}
+
+// Test Case: Verify that HAL_UART_Init readies both directions
+void test_hal_uart_init_sets_values(void **state) {
+    // Arrange: Initialize HAL, create a UART handle
+    HAL_Init();
+    UART_HandleTypeDef huart = {0};
+    huart.Init.BaudRate = 115200;
+
+    // Act: Call HAL_UART_Init
+    HAL_StatusTypeDef rc = HAL_UART_Init(&huart);
+
+    // Assert: Both directions should be ready
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(huart.gState, HAL_UART_STATE_READY);
+    assert_int_equal(huart.RxState, HAL_UART_STATE_READY);
+    assert_int_equal(huart.ErrorCode, HAL_UART_ERROR_NONE);
+}
+
+// Test Case: Verify that HAL_UART_Init fails when HAL isn't initialized
+void test_hal_uart_init_no_hal_init(void **state) {
+    // Arrange: Leave HAL uninitialized, create a UART handle
+    hal_board->Initialized = 0;
+    UART_HandleTypeDef huart = {0};
+
+    // Act: Call HAL_UART_Init
+    HAL_StatusTypeDef rc = HAL_UART_Init(&huart);
+
+    // Assert: The function should fail
+    assert_int_equal(rc, HAL_ERROR);
+    assert_int_equal(huart.ErrorCode, HAL_UART_ERROR_HAL_UNINITIALIZED);
+}
+
+// Test Case: Verify that HAL_UART_Transmit writes the data to the attached file descriptor
+void test_hal_uart_transmit_writes_fd(void **state) {
+    // Arrange: Set up a UART connected to the host
+    UART_HandleTypeDef huart = {0};
+    int host_rx, host_tx;
+    test_uart_setup(&huart, &host_rx, &host_tx);
+    uint8_t pData[5] = {'h', 'e', 'l', 'l', 'o'};
+
+    // Act: Call HAL_UART_Transmit, then read what the host got
+    HAL_StatusTypeDef rc = HAL_UART_Transmit(&huart, pData, sizeof(pData), HAL_MAX_DELAY);
+    uint8_t received[8];
+    ssize_t received_size = read(host_rx, received, sizeof(received));
+
+    // Assert: The host should have got exactly the data
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(received_size, sizeof(pData));
+    assert_memory_equal(received, pData, sizeof(pData));
+    test_uart_teardown(&huart, host_rx, host_tx);
+}
+
+// Test Case: Verify that HAL_UART_Transmit takes 10 bits per byte at the baud rate
+void test_hal_uart_transmit_takes_frame_time(void **state) {
+    // Arrange: Set up a UART connected to the host
+    UART_HandleTypeDef huart = {0};
+    int host_rx, host_tx;
+    test_uart_setup(&huart, &host_rx, &host_tx);
+    static uint8_t pData[1152];
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Transmit 1152 bytes
+    HAL_StatusTypeDef rc = HAL_UART_Transmit(&huart, pData, sizeof(pData), HAL_MAX_DELAY);
+
+    // Assert: 11520 bits at 115200 baud should take 100 ms, plus the transaction overhead
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(Mock_UART_Frame_Bits(&huart), 10);
+    assert_int_equal(Mock_HAL_GetTimeNs() - ns_start, 100000000ULL + MOCK_UART_TRANSACTION_NS);
+    test_uart_teardown(&huart, host_rx, host_tx);
+}
+
+// Test Case: Verify that HAL_UART_Transmit fails on an uninitialized UART
+void test_hal_uart_transmit_uninitialized(void **state) {
+    // Arrange: Initialize HAL, leave the UART uninitialized
+    HAL_Init();
+    UART_HandleTypeDef huart = {0};
+    uint8_t pData[1] = {0};
+
+    // Act: Call HAL_UART_Transmit
+    HAL_StatusTypeDef rc = HAL_UART_Transmit(&huart, pData, 1, HAL_MAX_DELAY);
+
+    // Assert: The function should fail
+    assert_int_equal(rc, HAL_ERROR);
+    assert_int_equal(huart.ErrorCode, HAL_UART_ERROR_UNINITIALIZED);
+}
+
+// Test Case: Verify that HAL_UART_Transmit_IT returns straight away and sends the data once its frames are out
+void test_hal_uart_transmit_it_completes_in_background(void **state) {
+    // Arrange: Set up a UART connected to the host
+    UART_HandleTypeDef huart = {0};
+    int host_rx, host_tx;
+    test_uart_setup(&huart, &host_rx, &host_tx);
+    test_uart_tx_cplt = 0;
+    static uint8_t pData[1152];
+    memset(pData, 0x55, sizeof(pData));
+    uint32_t tick_start = HAL_GetTick();
+
+    // Act: Start the transmit, look at the line halfway through its 100 ms, then after it
+    HAL_StatusTypeDef rc = HAL_UART_Transmit_IT(&huart, pData, sizeof(pData));
+    HAL_Delay(50);
+    uint8_t received[2000];
+    ssize_t received_during = read(host_rx, received, sizeof(received));
+    uint8_t cplt_during = test_uart_tx_cplt;
+    HAL_Delay(51);
+    ssize_t received_after = read(host_rx, received, sizeof(received));
+
+    // Assert: Nothing should be out halfway, all of it (and the callback) after
+    assert_int_equal(rc, HAL_OK);
+    assert_true(received_during < 0);
+    assert_int_equal(cplt_during, 0);
+    assert_int_equal(received_after, sizeof(pData));
+    assert_memory_equal(received, pData, sizeof(pData));
+    assert_int_equal(test_uart_tx_cplt, 1);
+    assert_int_equal(huart.gState, HAL_UART_STATE_READY);
+    assert_int_equal(HAL_GetTick() - tick_start, 101);
+    test_uart_teardown(&huart, host_rx, host_tx);
+}
+
+// Test Case: Verify that the UART refuses other transmits while one is going on in the background
+void test_hal_uart_transmit_it_busy_until_complete(void **state) {
+    // Arrange: Set up a UART connected to the host, start a background transmit
+    UART_HandleTypeDef huart = {0};
+    int host_rx, host_tx;
+    test_uart_setup(&huart, &host_rx, &host_tx);
+    uint8_t pData[10] = {0};
+    HAL_UART_Transmit_IT(&huart, pData, sizeof(pData));
+
+    // Act: Transmit again, blocking and in the background, before and after the first transmit is done
+    HAL_StatusTypeDef rc_blocking = HAL_UART_Transmit(&huart, pData, sizeof(pData), HAL_MAX_DELAY);
+    HAL_StatusTypeDef rc_it = HAL_UART_Transmit_IT(&huart, pData, sizeof(pData));
+    HAL_Delay(1);
+    HAL_StatusTypeDef rc_after = HAL_UART_Transmit(&huart, pData, sizeof(pData), HAL_MAX_DELAY);
+
+    // Assert: The UART should be busy until the first transmit is done
+    assert_int_equal(rc_blocking, HAL_BUSY);
+    assert_int_equal(rc_it, HAL_BUSY);
+    assert_int_equal(rc_after, HAL_OK);
+    test_uart_teardown(&huart, host_rx, host_tx);
+}
+
+// Test Case: Verify that HAL_UART_Transmit_DMA keeps the linked stream busy until the transmit is done
+void test_hal_uart_transmit_dma_completes_through_stream(void **state) {
+    // Arrange: Set up a UART connected to the host, with a Tx stream linked
+    UART_HandleTypeDef huart = {0};
+    DMA_HandleTypeDef hdma_tx = {0};
+    int host_rx, host_tx;
+    test_uart_setup(&huart, &host_rx, &host_tx);
+    __HAL_LINKDMA(&huart, hdmatx, hdma_tx);
+    test_uart_tx_cplt = 0;
+    uint8_t pData[115] = {0};
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Start the transmit, then poll the stream until it's done
+    HAL_StatusTypeDef rc = HAL_UART_Transmit_DMA(&huart, pData, sizeof(pData));
+    HAL_DMA_StateTypeDef started_state = hdma_tx.State;
+    while(HAL_DMA_GetState(&hdma_tx) != HAL_DMA_STATE_READY);
+    uint8_t received[200];
+    ssize_t received_size = read(host_rx, received, sizeof(received));
+
+    // Assert: The stream should have been busy for the 1150 bits at 115200 baud (plus overhead), then the data sent
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(started_state, HAL_DMA_STATE_BUSY);
+    assert_int_equal(Mock_HAL_GetTimeNs() - ns_start, 1150ULL * 1000000000ULL / 115200ULL + MOCK_UART_TRANSACTION_NS);
+    assert_int_equal(received_size, sizeof(pData));
+    assert_int_equal(test_uart_tx_cplt, 1);
+    test_uart_teardown(&huart, host_rx, host_tx);
+}
+
+// Test Case: Verify that HAL_UART_Receive reads what the host sent, a frame time per byte
+void test_hal_uart_receive_reads_fd(void **state) {
+    // Arrange: Set up a UART connected to the host, which has sent 4 bytes
+    UART_HandleTypeDef huart = {0};
+    int host_rx, host_tx;
+    test_uart_setup(&huart, &host_rx, &host_tx);
+    uint8_t sent[4] = {0xA5, 0x5A, 0x00, 0xFF};
+    assert_int_equal(write(host_tx, sent, sizeof(sent)), sizeof(sent));
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Call HAL_UART_Receive
+    uint8_t pData[4];
+    HAL_StatusTypeDef rc = HAL_UART_Receive(&huart, pData, sizeof(pData), 100);
+
+    // Assert: The data should be what the host sent, having taken 4 frames
+    assert_int_equal(rc, HAL_OK);
+    assert_memory_equal(pData, sent, sizeof(sent));
+    assert_int_equal(Mock_HAL_GetTimeNs() - ns_start, 4 * (10ULL * 1000000000ULL / 115200ULL));
+    test_uart_teardown(&huart, host_rx, host_tx);
+}
+
+// Test Case: Verify that HAL_UART_Receive times out when the host doesn't send enough, costing its timeout in virtual time
+void test_hal_uart_receive_timeout(void **state) {
+    // Arrange: Set up a UART connected to the host, which has sent 1 byte
+    UART_HandleTypeDef huart = {0};
+    int host_rx, host_tx;
+    test_uart_setup(&huart, &host_rx, &host_tx);
+    uint8_t sent = 0x42;
+    assert_int_equal(write(host_tx, &sent, 1), 1);
+    uint64_t ns_start = Mock_HAL_GetTimeNs();
+
+    // Act: Receive 2 bytes with a 500 ms timeout
+    uint8_t pData[2];
+    HAL_StatusTypeDef rc = HAL_UART_Receive(&huart, pData, sizeof(pData), 500);
+
+    // Assert: The function should time out, having taken a frame for the first byte and the timeout for the second
+    assert_int_equal(rc, HAL_TIMEOUT);
+    assert_int_equal(huart.ErrorCode, HAL_UART_ERROR_TIMEOUT);
+    assert_int_equal(Mock_HAL_GetTimeNs() - ns_start, 10ULL * 1000000000ULL / 115200ULL + 500000000ULL);
+    test_uart_teardown(&huart, host_rx, host_tx);
+}
+
+// Test Case: Verify that HAL_UART_Receive_IT takes bytes in the background as they come from the host
+void test_hal_uart_receive_it_takes_bytes_as_they_come(void **state) {
+    // Arrange: Set up a UART connected to the host, start receiving 2 bytes
+    UART_HandleTypeDef huart = {0};
+    int host_rx, host_tx;
+    test_uart_setup(&huart, &host_rx, &host_tx);
+    test_uart_rx_cplt = 0;
+    uint8_t pData[2] = {0};
+    HAL_StatusTypeDef rc = HAL_UART_Receive_IT(&huart, pData, sizeof(pData));
+
+    // Act: Let time pass with nothing sent, then with one byte sent, then with the other byte sent
+    HAL_Delay(5);
+    uint8_t cplt_idle = test_uart_rx_cplt;
+    uint8_t sent[2] = {0x12, 0x34};
+    assert_int_equal(write(host_tx, &sent[0], 1), 1);
+    HAL_Delay(5);
+    uint8_t cplt_first = test_uart_rx_cplt;
+    assert_int_equal(write(host_tx, &sent[1], 1), 1);
+    HAL_Delay(5);
+
+    // Assert: The receive should only complete once both bytes came in
+    assert_int_equal(rc, HAL_OK);
+    assert_int_equal(cplt_idle, 0);
+    assert_int_equal(cplt_first, 0);
+    assert_int_equal(test_uart_rx_cplt, 1);
+    assert_memory_equal(pData, sent, sizeof(sent));
+    assert_int_equal(huart.RxState, HAL_UART_STATE_READY);
+    test_uart_teardown(&huart, host_rx, host_tx);
+}
+
+// Test Case: Verify that HAL_UART_Abort drops a background transmit without sending it or calling back
+void test_hal_uart_abort_drops_transmit(void **state) {
+    // Arrange: Set up a UART connected to the host, start a background transmit
+    UART_HandleTypeDef huart = {0};
+    int host_rx, host_tx;
+    test_uart_setup(&huart, &host_rx, &host_tx);
+    test_uart_tx_cplt = 0;
+    uint8_t pData[10] = {0};
+    HAL_UART_Transmit_IT(&huart, pData, sizeof(pData));
+
+    // Act: Abort, then let the transmit's time pass
+    HAL_StatusTypeDef rc = HAL_UART_Abort(&huart);
+    HAL_Delay(5);
+    uint8_t received[10];
+    ssize_t received_size = read(host_rx, received, sizeof(received));
+
+    // Assert: Nothing should have been sent, and the UART should be ready again
+    assert_int_equal(rc, HAL_OK);
+    assert_true(received_size < 0);
+    assert_int_equal(test_uart_tx_cplt, 0);
+    assert_int_equal(huart.gState, HAL_UART_STATE_READY);
+    test_uart_teardown(&huart, host_rx, host_tx);
+}
@@ -0,0 +1,61 @@
+#ifndef TEST_HAL_MOCK_UART_H
+#define TEST_HAL_MOCK_UART_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <cmocka.h>
+
+#include "../../mocks/hal_mock_uart.h"
+
+// Defines (number of tests, change as more are added)
+#define NUM_HAL_UART_INIT_TESTS 2
+#define NUM_HAL_UART_TRANSMIT_TESTS 3
+#define NUM_HAL_UART_TRANSMIT_IT_TESTS 2
+#define NUM_HAL_UART_TRANSMIT_DMA_TESTS 1
+#define NUM_HAL_UART_RECEIVE_TESTS 2
+#define NUM_HAL_UART_RECEIVE_IT_TESTS 1
+#define NUM_HAL_UART_ABORT_TESTS 1
+
+// Global test arrays
+extern const struct CMUnitTest hal_uart_init_tests[NUM_HAL_UART_INIT_TESTS];
+extern const struct CMUnitTest hal_uart_transmit_tests[NUM_HAL_UART_TRANSMIT_TESTS];
+extern const struct CMUnitTest hal_uart_transmit_it_tests[NUM_HAL_UART_TRANSMIT_IT_TESTS];
+extern const struct CMUnitTest hal_uart_transmit_dma_tests[NUM_HAL_UART_TRANSMIT_DMA_TESTS];
+extern const struct CMUnitTest hal_uart_receive_tests[NUM_HAL_UART_RECEIVE_TESTS];
+extern const struct CMUnitTest hal_uart_receive_it_tests[NUM_HAL_UART_RECEIVE_IT_TESTS];
+extern const struct CMUnitTest hal_uart_abort_tests[NUM_HAL_UART_ABORT_TESTS];
+
+// Declaration of test functions
+
+// Running all tests
+void run_hal_mock_uart_tests(void);
+
+// HAL_UART_Init Tests
+void test_hal_uart_init_sets_values(void **state);
+void test_hal_uart_init_no_hal_init(void **state);
+
+// HAL_UART_Transmit Tests
+void test_hal_uart_transmit_writes_fd(void **state);
+void test_hal_uart_transmit_takes_frame_time(void **state);
+void test_hal_uart_transmit_uninitialized(void **state);
+
+// HAL_UART_Transmit_IT Tests
+void test_hal_uart_transmit_it_completes_in_background(void **state);
+void test_hal_uart_transmit_it_busy_until_complete(void **state);
+
+// HAL_UART_Transmit_DMA Tests
+void test_hal_uart_transmit_dma_completes_through_stream(void **state);
+
+// HAL_UART_Receive Tests
+void test_hal_uart_receive_reads_fd(void **state);
+void test_hal_uart_receive_timeout(void **state);
+
+// HAL_UART_Receive_IT Tests
+void test_hal_uart_receive_it_takes_bytes_as_they_come(void **state);
+
+// HAL_UART_Abort Tests
+void test_hal_uart_abort_drops_transmit(void **state);
+
+#endif // TEST_HAL_MOCK_UART_H
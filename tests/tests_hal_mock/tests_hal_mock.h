@@ -2,7 +2,9 @@
 #define TESTS_HAL_MOCK_H
 
 #include "test_hal_mock_general.h"
+#include "test_hal_mock_dma.h"
 #include "test_hal_mock_gpio.h"
 #include "test_hal_mock_i2c.h"
+#include "test_hal_mock_uart.h"
 
 #endif // TESTS_HAL_MOCK_H
@@ -1,228 +1,609 @@
-#include <pthread.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "test_ov2640.h"
 
-GPIO_TypeDef spi_cs_port;
-GPIO_InitTypeDef spi_cs_init;
-uint16_t spi_cs_pin = 0;
-SPI_HandleTypeDef spi_handler;
-I2C_HandleTypeDef i2c_handler;
-
-#define FIFO_BUFFER_SIZE 100
-
-uint8_t regs[256];
-uint8_t fifo_buffer[FIFO_BUFFER_SIZE] = {5};
-volatile uint8_t fifo_size1, fifo_size2, fifo_size3;
-volatile uint8_t use_camera = 0;
-
-// Thread function that mocks OV2640 camera I2C from the slave end
-void * ov2640_i2c_handler(void * arg) {
-    while(use_camera == 1) {
-        // I2C: Will either write a value to a reg (msg size of 2) or read from a requested reg (msg size of 1)
-        if(i2c_handler.State == HAL_I2C_STATE_BUSY_TX) {
-            // Correct slave address for OV2640 must be given
-            if(i2c_handler.XferAddress == 0x60) {
-                // Register write
-                if(i2c_handler.MsgSize == 2) {
-                    // Receive data of register data pair from I2C master
-                    uint8_t reg_data[2];
-                    
-                    Mock_I2C_Slave_Receive(&i2c_handler, reg_data, 2, HAL_MAX_DELAY);
-
-                    // Write to regs accordingly
-                    uint8_t reg = reg_data[0];
-                    uint8_t data = reg_data[1];
-                    regs[reg] = data;
-                }
-            }
-        }
-    }
+// A board with a camera on it: its mock peripherals, the driver and the simulated camera, and what it received
+typedef struct {
+    Mock_HAL_BoardTypeDef board;
+    GPIO_TypeDef spi_cs_port;
+    GPIO_InitTypeDef spi_cs_init;
+    SPI_HandleTypeDef spi_handler;
+    DMA_HandleTypeDef spi_dma_rx;
+    I2C_HandleTypeDef i2c_handler;
+    ov2640 camera;
+    ov2640_sim sim;
+    uint8_t resolution;
+    uint8_t camera_data[OV2640_SIM_FIFO_SIZE];  // A buffer holding all FIFO data is used for easier debugging
+    uint32_t camera_data_index;
+    uint32_t capture_length;
+    uint32_t expected_length;
+    uint32_t tick;
+    uint8_t test_result;
+} camera_board;
+
+static const uint16_t spi_cs_pin = GPIO_PIN_4;
+
+// Sets up a board to capture at resolution, expecting a synthetic frame of width by height
+static camera_board * camera_board_new(uint8_t resolution, uint32_t width, uint32_t height) {
+    camera_board * cb = calloc(1, sizeof(camera_board));
+    Mock_HAL_Board_Init(&cb->board);
+    cb->resolution = resolution;
+    cb->expected_length = (width * height) / OV2640_SIM_SYNTHETIC_PIXELS_PER_BYTE;
+    return cb;
 }
 
-// Thread function that mocks OV2640 camera SPI from the slave end
-void * ov2640_spi_handler(void * arg) {
-    while(use_camera == 1) {
-        // SPI: Do things based on the received messages (we could also write to the registers like with I2C, but we're more interested in the resulting actions)
-        if(spi_handler.State == HAL_SPI_STATE_BUSY_TX) {
-            // CS pin must be pulled low
-            if(HAL_GPIO_ReadPin(&spi_cs_port, spi_cs_pin) == GPIO_PIN_RESET) {
-                // Receive command from SPI master and do things based on that
-                if(spi_handler.TxMsgSize == 1) {
-                    uint8_t cmd;
-                    Mock_SPI_Slave_Receive(&spi_handler, &cmd, 1, HAL_MAX_DELAY);
-
-                    // Burst read from the FIFO buffer
-                    if(cmd == OV2640_FIFO_BURST_READ) {
-                        // Transfer FIFO buffer to master in chunks that it requests
-                        // Should terminate if ov2640_clear_fifo is called
-                        uint16_t fifo_index = 0;
-                        while(fifo_index < FIFO_BUFFER_SIZE) {
-                            if(spi_handler.RxMsgSize > 0) {
-                                uint16_t to_transmit = spi_handler.RxMsgSize;
-                                Mock_SPI_Slave_Transmit(&spi_handler, &fifo_buffer[fifo_index], to_transmit, HAL_MAX_DELAY);
-                                fifo_index += to_transmit;
-                            }
-                        }
-                    }
-                    // Write (determined based on set write bit at 0x80)
-                    else if(cmd & 0x80) {
-                        // Register to write to
-                        uint8_t reg = cmd & 0x7F;
-                        
-                        // Receive the data to write to the register
-                        uint8_t data;
-                        Mock_SPI_Slave_Receive(&spi_handler, &data, 1, HAL_MAX_DELAY);
-
-                        // Do stuff based on register/data writing
-
-                        // Clear FIFO buffer
-                        if(reg == OV2640_FIFO_CONTROL && data == OV2640_FIFO_CLEAR_MASK) {
-                            for(int i = 0; i < FIFO_BUFFER_SIZE; i++) {
-                                fifo_buffer[i] = 0;
-                            }
-
-                            // Set FIFO length to 0 (size1 is LSB)
-                            fifo_size1 = 0;
-                            fifo_size2 = 0;
-                            fifo_size3 = 0;
-                        }
-                        // Start FIFO capture (fill with dummy data)
-                        else if(reg == OV2640_FIFO_CONTROL && data == OV2640_FIFO_START_MASK) {
-                            for(int i = 0; i < 256; i++) {
-                                fifo_buffer[i] = i;
-                            }
-
-                            // Set FIFO length to FIFO_BUFFER_SIZE (size1 is LSB)
-                            fifo_size1 = (FIFO_BUFFER_SIZE >> 0) & 0xFF;
-                            fifo_size2 = (FIFO_BUFFER_SIZE >> 8) & 0xFF;
-                            fifo_size3 = (FIFO_BUFFER_SIZE >> 16) & 0xFF;
-                        }
-                        // Resetting CPLD (I don't think it's necessary to implement in a mock)
-                        else if(reg == OV2640_CPLD_REG) {
-                            // Do nothing
-                        }
-                        else if(reg == OV2640_CPLD_RESET) {
-                            // Do nothing
-                        }
-
-                        // SPI message processed, master can now initiate another transaction
-                        spi_handler.State = HAL_SPI_STATE_READY;
-                    }
-                    // Read (determined based on cleared write bit at 0x80)
-                    else if(!(cmd & 0x80)) {
-                        // Register to read from
-                        uint8_t reg = cmd;
-
-                        // Register data to send back to master
-                        uint8_t data;
-
-                        // Mocking the register read
-                        if(reg == OV2640_FIFO_SIZE1) {
-                            data = fifo_size1;
-                        }
-                        else if(reg == OV2640_FIFO_SIZE2) {
-                            data = fifo_size2;
-                        }
-                        else if(reg == OV2640_FIFO_SIZE3) {
-                            data = fifo_size3;
-                        }
-                        else if(reg == OV2640_CAPTURE_TRIGGER) {
-                            if(fifo_size1 == 0 && fifo_size2 == 0 && fifo_size3 == 0) {
-                                data = 0;
-                            }
-                            else {
-                                data = OV2640_CAPTURE_DONE_MASK;
-                            }
-                        }
-
-                        // Send the register data back to the master
-                        Mock_SPI_Slave_Transmit(&spi_handler, &data, 1, HAL_MAX_DELAY);
-                    }
-                }
-            }
-        }
-    }
+static void camera_board_free(camera_board * cb) {
+    Mock_HAL_Board_DeInit(&cb->board);
+    free(cb);
 }
 
-void ov2640_usage_test() {
+// Selects the board for the calling thread and sets up its peripherals and camera, ready for the driver
+static void camera_board_setup(camera_board * cb) {
+    Mock_HAL_Board_Select(&cb->board);
+
     // Initialize the mock GPIO, SPI and I2C handlers
     HAL_Init();
-    HAL_StatusTypeDef gpio_init_status = HAL_GPIO_Init(&spi_cs_port, &spi_cs_init);
-    HAL_StatusTypeDef spi_init_status = HAL_SPI_Init(&spi_handler);
-    HAL_StatusTypeDef i2c_init_status = HAL_I2C_Init(&i2c_handler);
+    HAL_GPIO_Init(&cb->spi_cs_port, &cb->spi_cs_init);
+    HAL_SPI_Init(&cb->spi_handler);
+    HAL_I2C_Init(&cb->i2c_handler);
+    __HAL_LINKDMA(&cb->spi_handler, hdmarx, cb->spi_dma_rx);
+    cb->spi_dma_rx.State = HAL_DMA_STATE_READY;
 
     // Create camera inst and register handlers to it
-    ov2640 camera;
-    ov2640_register(&camera, &spi_cs_port, spi_cs_pin, &spi_handler, &i2c_handler);
+    ov2640_register(&cb->camera, &cb->spi_cs_port, spi_cs_pin, &cb->spi_handler, &cb->i2c_handler);
 
-    // Set the use_camera flag to 0 to start the threads
-    use_camera = 1;
-    // Create a thread to mock the camera
-    pthread_t mock_thread1, mock_thread2;
-    pthread_create(&mock_thread1, NULL, ov2640_i2c_handler, NULL);
-    pthread_create(&mock_thread2, NULL, ov2640_spi_handler, NULL);
+    // Attach a simulated camera to the handlers; without JPEG files loaded, it captures synthetic frames
+    ov2640_sim_init(&cb->sim);
+    ov2640_sim_attach(&cb->sim, &cb->spi_handler, &cb->spi_cs_port, spi_cs_pin, &cb->i2c_handler);
+}
+
+static void camera_board_teardown(camera_board * cb) {
+    Mock_SPI_Detach_Slave(&cb->spi_handler);
+    Mock_I2C_Detach_Slave(&cb->i2c_handler);
+    ov2640_sim_deinit(&cb->sim);
+    Mock_HAL_Board_Select(NULL);
+}
+
+// Runs the driver through a capture on its board, from the calling thread
+static void * camera_board_run(void * arg) {
+    camera_board * cb = (camera_board *)arg;
+    camera_board_setup(cb);
+    ov2640 * camera = &cb->camera;
 
     // Initialize camera and set resolution
-    ov2640_jpeg_init(&camera);
-    ov2640_jpeg_set_res(&camera, OV2640_RES_320x240);
+    ov2640_jpeg_init(camera);
+    ov2640_jpeg_set_res(camera, cb->resolution);
 
     // Keep trying until a valid capture is taken.
-	while(camera.fifo_length == 0) {
-	  ov2640_get_capture(&camera);
+	while(camera->fifo_length == 0) {
+	  ov2640_get_capture(camera);
 	}
 
-    // Transfer and print out capture data, one buffer at a time.
-	ov2640_transfer_start(&camera);
+    // Transfer capture data, one buffer at a time.
+    cb->capture_length = camera->fifo_length;
+	ov2640_transfer_start(camera);
 
 	// Buffer approach is done for the case where there isn't enough memory to hold the entire image at once.
-    uint16_t buffer_length = 10;
-
-    // A buffer holding all FIFO data is used for easier debugging
-    uint8_t camera_data[FIFO_BUFFER_SIZE];
-    uint16_t camera_data_index = 0;
+    uint16_t buffer_length = 8192;
 
     // Transfer all data from the camera FIFO to the camera_data buffer
-	while(camera.fifo_length > 0) {
+	while(camera->fifo_length > 0) {
 		uint16_t buffer_filled;
 
-		ov2640_transfer_step(&camera, &camera_data[camera_data_index], buffer_length, &buffer_filled);
+		ov2640_transfer_step(camera, &cb->camera_data[cb->camera_data_index], buffer_length, &buffer_filled);
 
-        camera_data_index += buffer_filled;
+        cb->camera_data_index += buffer_filled;
 	}
 
-	ov2640_transfer_stop(&camera);
+	ov2640_transfer_stop(camera);
+    cb->tick = HAL_GetTick();
 
-    // Set the use_camera flag to 1 to terminate the threads
-    use_camera = 0;
+    // Should have received the frame the simulated camera captured, sized for the resolution
+    cb->test_result = 0;
+    if((cb->capture_length != cb->expected_length) || (cb->camera_data_index != cb->capture_length)) {
+        cb->test_result = 1;
+    }
+    else if(memcmp(cb->camera_data, cb->sim.capture_frame->data, cb->capture_length) != 0) {
+        cb->test_result = 1;
+    }
 
-    // Wait for threads to terminate
-    pthread_join(mock_thread1, NULL);
-    pthread_join(mock_thread2, NULL);
+    camera_board_teardown(cb);
+    return NULL;
+}
 
-    // Should have received camera data iterating up to from 0 to (FIFO_BUFFER_SIZE-1)
-    uint8_t test_result = 0;
-    for(int i = 0; i < FIFO_BUFFER_SIZE; i++) {
-        if(camera_data[i] != i) {
-            test_result = 1;
-        }
-    }
+// Starts counting the transfers on the board's buses over, so what the next driver calls make can be checked on its own
+static void bus_counts_clear(camera_board * cb) {
+    memset(&cb->i2c_handler.Stats, 0, sizeof(cb->i2c_handler.Stats));
+    memset(&cb->spi_handler.Stats, 0, sizeof(cb->spi_handler.Stats));
+}
 
-    if(test_result == 0) {
+// Checks the transfers made on the board's buses since bus_counts_clear, by direction, and that none of them failed
+static void assert_bus_counts(camera_board * cb, uint32_t i2c_writes, uint32_t i2c_reads, uint32_t spi_writes, uint32_t spi_reads) {
+    assert_int_equal(cb->i2c_handler.Stats.Transfers[MOCK_HAL_FAULT_WRITE], i2c_writes);
+    assert_int_equal(cb->i2c_handler.Stats.Transfers[MOCK_HAL_FAULT_READ], i2c_reads);
+    assert_int_equal(cb->spi_handler.Stats.Transfers[MOCK_HAL_FAULT_WRITE], spi_writes);
+    assert_int_equal(cb->spi_handler.Stats.Transfers[MOCK_HAL_FAULT_READ], spi_reads);
+    assert_int_equal(cb->i2c_handler.Stats.Failed + cb->spi_handler.Stats.Failed, 0);
+}
+
+void ov2640_usage_test() {
+    camera_board * cb = camera_board_new(OV2640_RES_320x240, 320, 240);
+    camera_board_run(cb);
+
+    if(cb->test_result == 0) {
         printf("Camera data received correctly\n");
     }
     else {
-        printf("Camera data received incorrectly\n");
+        printf("Camera data received incorrectly (%u of %u bytes)\n", (unsigned)cb->camera_data_index, (unsigned)cb->capture_length);
+    }
+
+    camera_board_free(cb);
+}
+
+// Test Case: Verify that cameras on several boards, each run on its own thread at the same time, all capture correctly
+void test_ov2640_boards_capture_concurrently(void **state) {
+    // Arrange: Boards in pairs at two resolutions, and a board run alone for each resolution to compare them with
+    camera_board * alone[2] = {
+        camera_board_new(OV2640_RES_160x120, 160, 120),
+        camera_board_new(OV2640_RES_320x240, 320, 240),
+    };
+    camera_board * boards[4];
+    pthread_t threads[4];
+    for(int i = 0; i < 4; i++) {
+        boards[i] = camera_board_new(alone[i % 2]->resolution, (i % 2) ? 320 : 160, (i % 2) ? 240 : 120);
+    }
+    camera_board_run(alone[0]);
+    camera_board_run(alone[1]);
+    uint32_t default_tick = HAL_GetTick();
+
+    // Act: Run the four boards at once
+    for(int i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, camera_board_run, boards[i]);
+    }
+    for(int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Assert: Every board should have received its frame in the simulated time it takes on a board of its own
+    for(int i = 0; i < 4; i++) {
+        assert_int_equal(boards[i]->test_result, 0);
+        assert_int_equal(boards[i]->tick, alone[i % 2]->tick);
+        camera_board_free(boards[i]);
+    }
+    assert_int_equal(alone[0]->test_result, 0);
+    assert_int_equal(alone[1]->test_result, 0);
+    assert_true(alone[0]->tick > 0);
+    assert_int_equal(HAL_GetTick(), default_tick);
+    camera_board_free(alone[0]);
+    camera_board_free(alone[1]);
+}
+
+// Test Case: Verify the bus transactions ov2640_jpeg_init makes
+void test_ov2640_jpeg_init_bus_counts(void **state) {
+    // Arrange: A board with a camera on it
+    camera_board * cb = camera_board_new(OV2640_RES_320x240, 320, 240);
+    camera_board_setup(cb);
+    bus_counts_clear(cb);
+
+    // Act: Initialize the camera
+    ov2640_jpeg_init(&cb->camera);
+
+    // Assert: Three CPLD register writes (address and data byte each) over SPI, and one I2C write per sensor register:
+    // the reset, the JPEG, YUV422 and output format reglists, the register overwrite and the default 320x240 reglist
+    assert_bus_counts(cb, 254, 0, 6, 0);
+    camera_board_teardown(cb);
+    camera_board_free(cb);
+}
+
+// Test Case: Verify the bus transactions ov2640_jpeg_set_res makes for each resolution
+void test_ov2640_jpeg_set_res_bus_counts(void **state) {
+    // Arrange: An initialized camera, and the I2C writes each resolution's reglist takes
+    const struct {
+        ov2640_image_res_t res;
+        uint32_t i2c_writes;
+    } expected[] = {
+        {OV2640_RES_160x120, 40},
+        {OV2640_RES_176x144, 40},
+        {OV2640_RES_320x240, 40},
+        {OV2640_RES_352x288, 40},
+        {OV2640_RES_640x480, 41},
+        {OV2640_RES_800x600, 41},
+        {OV2640_RES_1024x768, 39},
+        {OV2640_RES_1280x1024, 41},
+        {OV2640_RES_1600x1200, 41},
+    };
+    camera_board * cb = camera_board_new(OV2640_RES_320x240, 320, 240);
+    camera_board_setup(cb);
+    ov2640_jpeg_init(&cb->camera);
+
+    for(size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        // Act: Switch to the resolution
+        bus_counts_clear(cb);
+        ov2640_jpeg_set_res(&cb->camera, expected[i].res);
+
+        // Assert: Only the resolution's sensor registers should be written, over I2C, with nothing read back
+        assert_bus_counts(cb, expected[i].i2c_writes, 0, 0, 0);
+    }
+    camera_board_teardown(cb);
+    camera_board_free(cb);
+}
 
-        for(int i = 0; i < FIFO_BUFFER_SIZE; i++) {
-            printf("%d ", camera_data[i]);
+// Test Case: Verify the bus transactions of a full capture cycle: taking a capture and transferring it
+void test_ov2640_capture_cycle_bus_counts(void **state) {
+    // Arrange: An initialized camera at 320x240 (a 7680 byte synthetic frame), read 4096 bytes at a time
+    camera_board * cb = camera_board_new(OV2640_RES_320x240, 320, 240);
+    camera_board_setup(cb);
+    ov2640_jpeg_init(&cb->camera);
+    ov2640_jpeg_set_res(&cb->camera, OV2640_RES_320x240);
+    bus_counts_clear(cb);
+
+    // Act: Take a capture
+    ov2640_get_capture(&cb->camera);
+
+    // Assert: FIFO clear and start (a register write each), one poll of the capture done bit (the simulated capture is
+    // done by the first one) and a single read of the three length registers: no I2C, 8 SPI writes and 4 SPI reads
+    assert_int_equal(cb->camera.fifo_length, 7680);
+    assert_bus_counts(cb, 0, 0, 8, 4);
+
+    // Act: Transfer the capture
+    bus_counts_clear(cb);
+    uint16_t buffer_filled;
+    ov2640_transfer_start(&cb->camera);
+    while(cb->camera.fifo_length > 0) {
+        ov2640_transfer_step(&cb->camera, &cb->camera_data[cb->camera_data_index], 4096, &buffer_filled);
+        cb->camera_data_index += buffer_filled;
+    }
+    ov2640_transfer_stop(&cb->camera);
+
+    // Assert: The burst read command, one SPI read per buffer, then the FIFO clear
+    assert_int_equal(cb->camera_data_index, 7680);
+    assert_bus_counts(cb, 0, 0, 3, 2);
+    camera_board_teardown(cb);
+    camera_board_free(cb);
+}
+
+// Test Case: Verify that ov2640_transfer_step_dma reads the capture, one DMA transfer per buffer
+void test_ov2640_transfer_step_dma(void **state) {
+    // Arrange: A 320x240 capture (a 7680 byte synthetic frame) in the FIFO, read 4096 bytes at a time
+    camera_board * cb = camera_board_new(OV2640_RES_320x240, 320, 240);
+    camera_board_setup(cb);
+    ov2640_jpeg_init(&cb->camera);
+    ov2640_get_capture(&cb->camera);
+    uint32_t capture_length = cb->camera.fifo_length;
+
+    // Act: Transfer the capture, waiting for each DMA transfer before taking its data off the FIFO length
+    uint16_t buffer_filled;
+    uint8_t reads = 0;
+    ov2640_transfer_start(&cb->camera);
+    while(cb->camera.fifo_length > 0) {
+        assert_int_equal(ov2640_transfer_step_dma(&cb->camera, &cb->camera_data[cb->camera_data_index], 4096, &buffer_filled), 1);
+        while(HAL_DMA_GetState(&cb->spi_dma_rx) != HAL_DMA_STATE_READY);
+        cb->camera.fifo_length -= buffer_filled;
+        cb->camera_data_index += buffer_filled;
+        reads++;
+    }
+    ov2640_transfer_stop(&cb->camera);
+
+    // Assert: Two transfers should have brought in the frame the simulated camera captured
+    assert_int_equal(capture_length, 7680);
+    assert_int_equal(reads, 2);
+    assert_int_equal(cb->camera_data_index, capture_length);
+    assert_memory_equal(cb->camera_data, cb->sim.capture_frame->data, capture_length);
+    camera_board_teardown(cb);
+    camera_board_free(cb);
+}
+
+// Test Case: Verify that a DMA read that fails to start throws the capture out and reports it, with nothing to wait for
+void test_ov2640_transfer_step_dma_read_fault(void **state) {
+    // Arrange: A capture in the FIFO, with every SPI read failing from the burst read on
+    camera_board * cb = camera_board_new(OV2640_RES_320x240, 320, 240);
+    camera_board_setup(cb);
+    ov2640_jpeg_init(&cb->camera);
+    ov2640_get_capture(&cb->camera);
+    Mock_HAL_FaultsTypeDef faults = {.ErrorPpm = {[MOCK_HAL_FAULT_READ] = 1000000}};
+    Mock_SPI_Set_Faults(&cb->spi_handler, &faults);
+
+    // Act: Read the first buffer
+    uint16_t buffer_filled = 0xFFFF;
+    ov2640_transfer_start(&cb->camera);
+    uint8_t read = ov2640_transfer_step_dma(&cb->camera, cb->camera_data, 4096, &buffer_filled);
+
+    // Assert: The read should fail with nothing filled, no DMA transfer left in flight and the capture thrown out
+    assert_int_equal(read, 0);
+    assert_int_equal(buffer_filled, 0);
+    assert_int_equal(faults.Errors, 1);
+    assert_int_equal(HAL_DMA_GetState(&cb->spi_dma_rx), HAL_DMA_STATE_READY);
+    assert_int_equal(cb->camera.fifo_length, 0);
+
+    ov2640_transfer_stop(&cb->camera);
+    Mock_SPI_Set_Faults(&cb->spi_handler, NULL);
+    camera_board_teardown(cb);
+    camera_board_free(cb);
+}
+
+// Loads JPEG-shaped preview (160x120) frames of the given lengths into the board's simulated camera, which then
+// captures them in turn, so the preview size can be stepped as a test needs
+static void load_preview_frames(camera_board * cb, const uint32_t lengths[], uint8_t count) {
+    // SOI, SOF0 (160x120) and SOS, then scan data that never contains a marker, and EOI
+    static const uint8_t header[] = {
+        0xFF, 0xD8,
+        0xFF, 0xC0, 0x00, 0x11, 0x08, 0x00, 0x78, 0x00, 0xA0, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01,
+        0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00
+    };
+
+    for(uint8_t i = 0; i < count; i++) {
+        uint8_t * data = calloc(1, lengths[i]);
+        memcpy(data, header, sizeof(header));
+        data[lengths[i] - 2] = 0xFF;
+        data[lengths[i] - 1] = 0xD9;
+
+        // A temporary file of its own, so tests running in parallel don't load each other's frames
+        char path[] = "/tmp/test_ov2640_previewXXXXXX";
+        FILE * file = fdopen(mkstemp(path), "wb");
+        assert_non_null(file);
+        assert_int_equal(fwrite(data, 1, lengths[i], file), lengths[i]);
+        fclose(file);
+        assert_int_equal(ov2640_sim_load_jpeg(&cb->sim, path), HAL_OK);
+        remove(path);
+        free(data);
+    }
+}
+
+// Sets up a board whose camera captures the given preview frames in turn, initialized and watching for motion with
+// threshold, to capture at 1600x1200
+static camera_board * motion_board_new(const uint32_t lengths[], uint8_t count, ov2640_motion * motion, uint8_t threshold) {
+    camera_board * cb = camera_board_new(OV2640_RES_1600x1200, 1600, 1200);
+    camera_board_setup(cb);
+    load_preview_frames(cb, lengths, count);
+    ov2640_jpeg_init(&cb->camera);
+    ov2640_motion_init(&cb->camera, motion, OV2640_RES_1600x1200, threshold);
+    return cb;
+}
+
+// Test Case: Verify that motion is detected once the preview size changes by more than the threshold, either way
+void test_ov2640_motion_watch_threshold(void **state) {
+    // Arrange: A 1000 byte preview to set the baseline, then one 15% (the threshold) off it, and one a byte further
+    const struct {
+        uint32_t step;
+        uint8_t motion;
+    } cases[] = {
+        {1150, 0},
+        {1151, 1},
+        {850, 0},
+        {849, 1},
+    };
+
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const uint32_t lengths[] = {1000, cases[i].step};
+        ov2640_motion motion;
+        camera_board * cb = motion_board_new(lengths, 2, &motion, 15);
+
+        // Act: Watch the first preview, then the step
+        uint8_t seeded = ov2640_motion_watch(&cb->camera, &motion);
+        uint8_t detected = ov2640_motion_watch(&cb->camera, &motion);
+
+        // Assert: Only a change past the threshold should count as motion; the previews are never transferred
+        assert_int_equal(seeded, 0);
+        assert_int_equal(detected, cases[i].motion);
+        assert_int_equal(cb->camera.fifo_length, 0);
+        camera_board_teardown(cb);
+        camera_board_free(cb);
+    }
+}
+
+// Test Case: Verify that the first preview seeds the baseline, which then follows changes under the threshold
+void test_ov2640_motion_watch_baseline(void **state) {
+    // Arrange: Previews growing by less than the threshold off the baseline each time, up to 25% past the first one
+    const uint32_t lengths[] = {1000, 1100, 1150, 1200, 1250};
+    const uint32_t baselines[] = {1000, 1025, 1056, 1092, 1131};
+    ov2640_motion motion;
+    camera_board * cb = motion_board_new(lengths, 5, &motion, 15);
+    assert_int_equal(motion.baseline_length, 0);
+
+    for(uint8_t i = 0; i < 5; i++) {
+        // Act: Watch the next preview
+        uint8_t detected = ov2640_motion_watch(&cb->camera, &motion);
+
+        // Assert: No motion; the first preview should become the baseline, then each one move it a quarter of the way
+        assert_int_equal(detected, 0);
+        assert_int_equal(motion.baseline_length, baselines[i]);
+    }
+    camera_board_teardown(cb);
+    camera_board_free(cb);
+}
+
+// Test Case: Verify that resuming after a capture re-learns the baseline from the next preview
+void test_ov2640_motion_resume_resets_baseline(void **state) {
+    // Arrange: A camera that has seen motion (a 1000 byte preview, then a 2000 byte one) and taken its capture.
+    // The previews take turns with the high-res capture counted in, so the next one after it is 2000 bytes again.
+    const uint32_t lengths[] = {1000, 2000};
+    ov2640_motion motion;
+    camera_board * cb = motion_board_new(lengths, 2, &motion, 15);
+    ov2640_motion_watch(&cb->camera, &motion);
+    assert_int_equal(ov2640_motion_watch(&cb->camera, &motion), 1);
+    ov2640_motion_capture(&cb->camera, &motion);
+    assert_int_equal(cb->camera.fifo_length, (1600 * 1200) / OV2640_SIM_SYNTHETIC_PIXELS_PER_BYTE);
+
+    // Act: Resume watching, and watch the next two previews
+    ov2640_motion_resume(&cb->camera, &motion);
+    uint32_t resumed_baseline = motion.baseline_length;
+    uint8_t seeded = ov2640_motion_watch(&cb->camera, &motion);
+    uint32_t seeded_baseline = motion.baseline_length;
+    uint8_t detected = ov2640_motion_watch(&cb->camera, &motion);
+
+    // Assert: The 2000 byte preview should seed the new baseline rather than count as motion against the old one,
+    // and the 1000 byte one after it should count as motion against the new one
+    assert_int_equal(resumed_baseline, 0);
+    assert_int_equal(seeded, 0);
+    assert_int_equal(seeded_baseline, 2000);
+    assert_int_equal(detected, 1);
+    assert_int_equal(cb->camera.image_res, OV2640_MOTION_PREVIEW_RES);
+    camera_board_teardown(cb);
+    camera_board_free(cb);
+}
+
+// Test Case: Verify the I2C writes of switching between preview and capture: the delta when it fits, else the full reglist
+void test_ov2640_motion_switch_bus_counts(void **state) {
+    // Arrange: A camera watching for motion to capture at 1600x1200 (a full reglist of 41 writes, 160x120's of 40)
+    const uint32_t lengths[] = {1000};
+    ov2640_motion motion;
+    camera_board * cb = motion_board_new(lengths, 1, &motion, 15);
+    uint16_t width, height;
+    assert_true(motion.preview_to_capture_length > 0);
+    assert_true(motion.preview_to_capture_length + 1 < 41);
+    assert_true(motion.capture_to_preview_length > 0);
+    assert_true(motion.capture_to_preview_length + 1 < 40);
+
+    // Act: Capture, then resume
+    bus_counts_clear(cb);
+    ov2640_motion_capture(&cb->camera, &motion);
+    uint32_t capture_writes = cb->i2c_handler.Stats.Transfers[MOCK_HAL_FAULT_WRITE];
+    ov2640_sim_output_size(&cb->sim, &width, &height);
+
+    // Assert: Switching to capture should write the delta (and its terminator) and nothing else over I2C
+    assert_int_equal(capture_writes, motion.preview_to_capture_length + 1);
+    assert_int_equal(cb->i2c_handler.Stats.Transfers[MOCK_HAL_FAULT_READ], 0);
+    assert_int_equal(width, 1600);
+    assert_int_equal(height, 1200);
+
+    bus_counts_clear(cb);
+    ov2640_motion_resume(&cb->camera, &motion);
+    ov2640_sim_output_size(&cb->sim, &width, &height);
+
+    // Assert: Switching back should only write the delta back
+    assert_bus_counts(cb, motion.capture_to_preview_length + 1, 0, 0, 0);
+    assert_int_equal(width, 160);
+    assert_int_equal(height, 120);
+
+    // Act: Switch both ways again, as if the deltas hadn't fit
+    motion.preview_to_capture_length = 0;
+    motion.capture_to_preview_length = 0;
+    bus_counts_clear(cb);
+    ov2640_motion_capture(&cb->camera, &motion);
+    capture_writes = cb->i2c_handler.Stats.Transfers[MOCK_HAL_FAULT_WRITE];
+    bus_counts_clear(cb);
+    ov2640_motion_resume(&cb->camera, &motion);
+
+    // Assert: Both switches should fall back to the full reglists
+    assert_int_equal(capture_writes, 41);
+    assert_bus_counts(cb, 40, 0, 0, 0);
+    camera_board_teardown(cb);
+    camera_board_free(cb);
+}
+
+// Replays a reglist into a mock banked register file, the same way the OV2640 would apply it
+static void apply_reglist(uint8_t bank_regs[2][256], uint8_t * bank, const struct sensor_reg reglist[]) {
+    for(const struct sensor_reg * next = reglist; (next->reg != 0xff) || (next->val != 0xff); next++) {
+        if(next->reg == OV2640_SENSOR_BANK_SELECT) {
+            *bank = next->val & 0x01;
         }
-        printf("\n");
+        else {
+            bank_regs[*bank][next->reg] = next->val;
+        }
+    }
+}
+
+// Test Case: Verify that the delta between two resolutions leaves the sensor in the same state as the full reglist
+void test_ov2640_reglist_delta_matches_full_reglist(void **state) {
+    // Arrange: Two register files that start from the same state, with the preview resolution applied
+    uint8_t full_regs[2][256] = {{0}};
+    uint8_t delta_regs[2][256] = {{0}};
+    uint8_t full_bank = 0;
+    uint8_t delta_bank = 0;
+    apply_reglist(full_regs, &full_bank, OV2640_160x120_JPEG);
+    apply_reglist(delta_regs, &delta_bank, OV2640_160x120_JPEG);
+
+    struct sensor_reg delta[OV2640_DELTA_MAX_LENGTH];
+
+    // Act: Compute the delta to the highest resolution, apply it to one file and the full reglist to the other
+    uint16_t length = ov2640_sensor_reglist_delta(OV2640_160x120_JPEG, OV2640_1600x1200_JPEG, delta, OV2640_DELTA_MAX_LENGTH);
+    apply_reglist(full_regs, &full_bank, OV2640_1600x1200_JPEG);
+    apply_reglist(delta_regs, &delta_bank, delta);
+
+    // Assert: The delta should be shorter than the full reglist and end in the same register state
+    uint16_t full_length = 0;
+    while((OV2640_1600x1200_JPEG[full_length].reg != 0xff) || (OV2640_1600x1200_JPEG[full_length].val != 0xff)) {
+        full_length++;
     }
+
+    assert_true(length > 0);
+    assert_true(length < full_length);
+    assert_int_equal(delta[length].reg, 0xff);
+    assert_int_equal(delta[length].val, 0xff);
+    assert_memory_equal(full_regs, delta_regs, sizeof(full_regs));
+}
+
+// Test Case: Verify that the delta only writes registers that change, keeping the DSP reset around them
+void test_ov2640_reglist_delta_only_changed_regs(void **state) {
+    // Arrange: Buffer to hold the delta, 160x120 and 320x240 only differ in DSP output size registers
+    struct sensor_reg delta[OV2640_DELTA_MAX_LENGTH];
+    const struct sensor_reg expected[] = {
+        {0xff, 0x00}, {0xe0, 0x04}, {0x50, 0x89}, {0x5a, 0x50}, {0x5b, 0x3c}, {0xe0, 0x00}, {0xff, 0xff}
+    };
+
+    // Act: Compute the delta between the two resolutions
+    uint16_t length = ov2640_sensor_reglist_delta(OV2640_160x120_JPEG, OV2640_320x240_JPEG, delta, OV2640_DELTA_MAX_LENGTH);
+
+    // Assert: Only the changed registers (and the bank select) should be written
+    assert_int_equal(length, 6);
+    assert_memory_equal(delta, expected, sizeof(expected));
+}
+
+// Test Case: Verify that a delta which doesn't fit in the given buffer is rejected
+void test_ov2640_reglist_delta_too_big(void **state) {
+    // Arrange: Buffer that is too small to hold the delta
+    struct sensor_reg delta[4];
+
+    // Act: Compute the delta between two very different resolutions
+    uint16_t length = ov2640_sensor_reglist_delta(OV2640_160x120_JPEG, OV2640_1600x1200_JPEG, delta, 4);
+
+    // Assert: The delta should be rejected so the full reglist gets used instead
+    assert_int_equal(length, 0);
 }
 
+const struct CMUnitTest ov2640_reglist_delta_tests[NUM_OV2640_REGLIST_DELTA_TESTS] = {
+    cmocka_unit_test(test_ov2640_reglist_delta_matches_full_reglist),
+    cmocka_unit_test(test_ov2640_reglist_delta_only_changed_regs),
+    cmocka_unit_test(test_ov2640_reglist_delta_too_big),
+};
+
+const struct CMUnitTest ov2640_board_tests[NUM_OV2640_BOARD_TESTS] = {
+    cmocka_unit_test(test_ov2640_boards_capture_concurrently),
+};
+
+const struct CMUnitTest ov2640_bus_count_tests[NUM_OV2640_BUS_COUNT_TESTS] = {
+    cmocka_unit_test(test_ov2640_jpeg_init_bus_counts),
+    cmocka_unit_test(test_ov2640_jpeg_set_res_bus_counts),
+    cmocka_unit_test(test_ov2640_capture_cycle_bus_counts),
+};
+
+const struct CMUnitTest ov2640_transfer_tests[NUM_OV2640_TRANSFER_TESTS] = {
+    cmocka_unit_test(test_ov2640_transfer_step_dma),
+    cmocka_unit_test(test_ov2640_transfer_step_dma_read_fault),
+};
+
+const struct CMUnitTest ov2640_motion_tests[NUM_OV2640_MOTION_TESTS] = {
+    cmocka_unit_test(test_ov2640_motion_watch_threshold),
+    cmocka_unit_test(test_ov2640_motion_watch_baseline),
+    cmocka_unit_test(test_ov2640_motion_resume_resets_baseline),
+    cmocka_unit_test(test_ov2640_motion_switch_bus_counts),
+};
+
 void run_ov2640_tests(void) {
+    int status = 0;
+
+    status += cmocka_run_group_tests(ov2640_reglist_delta_tests, NULL, NULL);
+    status += cmocka_run_group_tests(ov2640_board_tests, NULL, NULL);
+    status += cmocka_run_group_tests(ov2640_bus_count_tests, NULL, NULL);
+    status += cmocka_run_group_tests(ov2640_transfer_tests, NULL, NULL);
+    status += cmocka_run_group_tests(ov2640_motion_tests, NULL, NULL);
+
+    assert_int_equal(status, 0);
+
     // I didn't want to deal with stack errors so this test is done without cmocka
     ov2640_usage_test();
 }
\ No newline at end of file
@@ -9,7 +9,46 @@
 
 #include "../../ov2640/ov2640.h"
 #include "../../mocks/hal_mock.h"
+#include "../../sim/ov2640_sim.h"
 
+// Defines (number of tests, change as more are added)
+#define NUM_OV2640_REGLIST_DELTA_TESTS 3
+#define NUM_OV2640_BOARD_TESTS 1
+#define NUM_OV2640_BUS_COUNT_TESTS 3
+#define NUM_OV2640_TRANSFER_TESTS 2
+#define NUM_OV2640_MOTION_TESTS 4
+
+// Global test arrays
+extern const struct CMUnitTest ov2640_reglist_delta_tests[NUM_OV2640_REGLIST_DELTA_TESTS];
+extern const struct CMUnitTest ov2640_board_tests[NUM_OV2640_BOARD_TESTS];
+extern const struct CMUnitTest ov2640_bus_count_tests[NUM_OV2640_BUS_COUNT_TESTS];
+extern const struct CMUnitTest ov2640_transfer_tests[NUM_OV2640_TRANSFER_TESTS];
+extern const struct CMUnitTest ov2640_motion_tests[NUM_OV2640_MOTION_TESTS];
+
+// Running all tests
 void run_ov2640_tests(void);
 
+// ov2640_sensor_reglist_delta Tests
+void test_ov2640_reglist_delta_matches_full_reglist(void **state);
+void test_ov2640_reglist_delta_only_changed_regs(void **state);
+void test_ov2640_reglist_delta_too_big(void **state);
+
+// Several boards Tests
+void test_ov2640_boards_capture_concurrently(void **state);
+
+// Bus transaction count Tests
+void test_ov2640_jpeg_init_bus_counts(void **state);
+void test_ov2640_jpeg_set_res_bus_counts(void **state);
+void test_ov2640_capture_cycle_bus_counts(void **state);
+
+// Transfer Tests
+void test_ov2640_transfer_step_dma(void **state);
+void test_ov2640_transfer_step_dma_read_fault(void **state);
+
+// Preview/trigger (motion) pipeline Tests
+void test_ov2640_motion_watch_threshold(void **state);
+void test_ov2640_motion_watch_baseline(void **state);
+void test_ov2640_motion_resume_resets_baseline(void **state);
+void test_ov2640_motion_switch_bus_counts(void **state);
+
 #endif // TEST_OV2640
\ No newline at end of file
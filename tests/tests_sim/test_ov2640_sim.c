@@ -0,0 +1,275 @@
+#include <stdio.h>
+
+#include "test_ov2640_sim.h"
+
+// Handles the driver under test is registered with, and the simulated camera is attached to
+static GPIO_TypeDef sim_cs_port;
+static GPIO_InitTypeDef sim_cs_init;
+static SPI_HandleTypeDef sim_spi;
+static I2C_HandleTypeDef sim_i2c;
+
+// Smallest JPEG-shaped files with a 320x240 frame header (SOI, APP0, SOF0, SOS, scan data, EOI)
+#define TEST_JPEG_HEADER \
+    0xFF, 0xD8, \
+    0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00, 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, \
+    0xFF, 0xC0, 0x00, 0x11, 0x08, 0x00, 0xF0, 0x01, 0x40, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01, \
+    0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00
+
+static const uint8_t test_jpeg_a[] = {TEST_JPEG_HEADER, 0x12, 0x34, 0x56, 0xFF, 0xD9};
+static const uint8_t test_jpeg_b[] = {TEST_JPEG_HEADER, 0x65, 0x43, 0x21, 0x0F, 0xED, 0xCB, 0xFF, 0xD9};
+
+// Register Tests
+const struct CMUnitTest ov2640_sim_register_tests[NUM_OV2640_SIM_REGISTER_TESTS] = {
+    cmocka_unit_test(test_ov2640_sim_who_am_i),
+    cmocka_unit_test(test_ov2640_sim_banks_kept_apart),
+    cmocka_unit_test(test_ov2640_sim_software_reset),
+    cmocka_unit_test(test_ov2640_sim_cpld_test_register),
+};
+
+// Capture Tests
+const struct CMUnitTest ov2640_sim_capture_tests[NUM_OV2640_SIM_CAPTURE_TESTS] = {
+    cmocka_unit_test(test_ov2640_sim_capture_takes_frame_time),
+    cmocka_unit_test(test_ov2640_sim_synthetic_frame_sized_by_resolution),
+    cmocka_unit_test(test_ov2640_sim_loaded_jpeg_for_matching_resolution),
+    cmocka_unit_test(test_ov2640_sim_load_jpeg_rejects_non_jpeg),
+};
+
+void run_ov2640_sim_tests(void) {
+    int status = 0;
+
+    status += cmocka_run_group_tests(ov2640_sim_register_tests, NULL, NULL);
+    status += cmocka_run_group_tests(ov2640_sim_capture_tests, NULL, NULL);
+
+    assert_int_equal(status, 0);
+}
+
+// Initializes the mock HAL, registers the driver with it and attaches a freshly powered-on simulated camera
+static void attach_camera(ov2640 *camera, ov2640_sim *sim) {
+    HAL_Init();
+    HAL_GPIO_Init(&sim_cs_port, &sim_cs_init);
+    HAL_SPI_Init(&sim_spi);
+    HAL_I2C_Init(&sim_i2c);
+
+    ov2640_register(camera, &sim_cs_port, GPIO_PIN_4, &sim_spi, &sim_i2c);
+    ov2640_sim_init(sim);
+    assert_int_equal(ov2640_sim_attach(sim, &sim_spi, &sim_cs_port, GPIO_PIN_4, &sim_i2c), HAL_OK);
+}
+
+static void detach_camera(ov2640_sim *sim) {
+    Mock_SPI_Detach_Slave(&sim_spi);
+    Mock_I2C_Detach_Slave(&sim_i2c);
+    ov2640_sim_deinit(sim);
+}
+
+static void write_file(const char *path, const uint8_t *data, size_t size) {
+    FILE *file = fopen(path, "wb");
+    assert_non_null(file);
+    assert_int_equal(fwrite(data, 1, size, file), size);
+    fclose(file);
+}
+
+// Reads out the whole capture in the FIFO
+static void transfer_capture(ov2640 *camera, uint8_t *buffer, uint16_t buffer_size) {
+    uint16_t index = 0;
+
+    ov2640_transfer_start(camera);
+    while((camera->fifo_length > 0) && (index < buffer_size)) {
+        uint16_t buffer_filled;
+        ov2640_transfer_step(camera, &buffer[index], buffer_size - index, &buffer_filled);
+        index += buffer_filled;
+    }
+    ov2640_transfer_stop(camera);
+}
+
+// Test Case: Verify that the chip IDs can be read from the sensor bank
+void test_ov2640_sim_who_am_i(void **state) {
+    // Arrange: Attach a simulated camera
+    ov2640 camera = {0};
+    ov2640_sim sim;
+    attach_camera(&camera, &sim);
+
+    // Act: Read the chip IDs through the driver
+    ov2640_test_who_am_i(&camera);
+
+    // Assert: The IDs should be the OV2640's
+    assert_int_equal(camera.vid, 0x26);
+    assert_int_equal(camera.pid, 0x42);
+
+    detach_camera(&sim);
+}
+
+// Test Case: Verify that the same register address in the two banks holds separate values
+void test_ov2640_sim_banks_kept_apart(void **state) {
+    // Arrange: Attach a simulated camera
+    ov2640 camera = {0};
+    ov2640_sim sim;
+    attach_camera(&camera, &sim);
+
+    // Act: Write different values to register 0x5A of each bank, then read both back
+    uint8_t dsp_value, sensor_value, bank_value;
+    ov2640_sensor_write_byte(&camera, OV2640_SENSOR_BANK_SELECT, 0x00);
+    ov2640_sensor_write_byte(&camera, 0x5A, 0x11);
+    ov2640_sensor_write_byte(&camera, OV2640_SENSOR_BANK_SELECT, 0x01);
+    ov2640_sensor_write_byte(&camera, 0x5A, 0x22);
+    ov2640_sensor_read_byte(&camera, 0x5A, &sensor_value);
+    ov2640_sensor_write_byte(&camera, OV2640_SENSOR_BANK_SELECT, 0x00);
+    ov2640_sensor_read_byte(&camera, 0x5A, &dsp_value);
+    ov2640_sensor_read_byte(&camera, OV2640_SENSOR_BANK_SELECT, &bank_value);
+
+    // Assert: Each bank should keep its own value, and the bank select should read back
+    assert_int_equal(dsp_value, 0x11);
+    assert_int_equal(sensor_value, 0x22);
+    assert_int_equal(bank_value, 0x00);
+
+    detach_camera(&sim);
+}
+
+// Test Case: Verify that a software reset through COM7 puts the sensor registers back to their power-on values
+void test_ov2640_sim_software_reset(void **state) {
+    // Arrange: Attach a simulated camera and change a sensor register
+    ov2640 camera = {0};
+    ov2640_sim sim;
+    attach_camera(&camera, &sim);
+    ov2640_sensor_write_byte(&camera, OV2640_SENSOR_BANK_SELECT, 0x01);
+    ov2640_sensor_write_byte(&camera, 0x2A, 0x55);
+
+    // Act: Reset the sensor, then read the changed register and a chip ID
+    uint8_t changed_value, id_value;
+    ov2640_sensor_write_byte(&camera, 0x12, 0x80);
+    ov2640_sensor_read_byte(&camera, 0x2A, &changed_value);
+    ov2640_sensor_read_byte(&camera, OV2640_CHIPID_HIGH, &id_value);
+
+    // Assert: The register should be back to 0, with the chip ID still in place
+    assert_int_equal(changed_value, 0x00);
+    assert_int_equal(id_value, 0x26);
+
+    detach_camera(&sim);
+}
+
+// Test Case: Verify that the CPLD test register passes the driver's SPI sanity check
+void test_ov2640_sim_cpld_test_register(void **state) {
+    // Arrange: Attach a simulated camera
+    ov2640 camera = {0};
+    ov2640_sim sim;
+    attach_camera(&camera, &sim);
+
+    // Act: Run the driver's SPI test
+    uint8_t rc = ov2640_test_spi(&camera);
+
+    // Assert: The value written to the test register should have been read back
+    assert_true(rc);
+
+    detach_camera(&sim);
+}
+
+// Test Case: Verify that a capture is only done once the next full frame is out
+void test_ov2640_sim_capture_takes_frame_time(void **state) {
+    // Arrange: Attach a simulated camera, left in UXGA mode at full size after power-on
+    ov2640 camera = {0};
+    ov2640_sim sim;
+    attach_camera(&camera, &sim);
+    uint32_t period = ov2640_sim_frame_period(&sim);
+
+    // Act: Start a capture, check for it right away and again two frame periods later
+    ov2640_fifo_clear(&camera);
+    ov2640_fifo_start(&camera);
+    uint8_t done_early = ov2640_fifo_check_bit(&camera, OV2640_CAPTURE_TRIGGER, OV2640_CAPTURE_DONE_MASK);
+    HAL_Delay(2 * period);
+    uint8_t done_later = ov2640_fifo_check_bit(&camera, OV2640_CAPTURE_TRIGGER, OV2640_CAPTURE_DONE_MASK);
+    ov2640_fifo_read_length(&camera);
+
+    // Assert: The capture should take a frame (15 fps in UXGA), and hold a full size synthetic frame
+    assert_int_equal(period, OV2640_SIM_UXGA_FRAME_MS);
+    assert_int_equal(done_early, 0);
+    assert_true(done_later);
+    assert_int_equal(camera.fifo_length, (1600 * 1200) / OV2640_SIM_SYNTHETIC_PIXELS_PER_BYTE);
+
+    detach_camera(&sim);
+}
+
+// Test Case: Verify that synthetic frames follow the resolution the driver configures, and look like JPEGs
+void test_ov2640_sim_synthetic_frame_sized_by_resolution(void **state) {
+    // Arrange: Attach a simulated camera and initialize it through the driver
+    ov2640 camera = {0};
+    ov2640_sim sim;
+    attach_camera(&camera, &sim);
+    ov2640_jpeg_init(&camera);
+    static uint8_t buffer[(640 * 480) / OV2640_SIM_SYNTHETIC_PIXELS_PER_BYTE];
+
+    // Act: Capture at two resolutions, transferring the second capture
+    ov2640_jpeg_set_res(&camera, OV2640_RES_160x120);
+    ov2640_get_capture(&camera);
+    uint32_t small_length = camera.fifo_length;
+
+    ov2640_jpeg_set_res(&camera, OV2640_RES_640x480);
+    ov2640_get_capture(&camera);
+    uint32_t large_length = camera.fifo_length;
+    transfer_capture(&camera, buffer, sizeof(buffer));
+
+    // Assert: The capture sizes should follow the resolution, and the data should start and end like a JPEG
+    assert_int_equal(small_length, (160 * 120) / OV2640_SIM_SYNTHETIC_PIXELS_PER_BYTE);
+    assert_int_equal(large_length, sizeof(buffer));
+    assert_int_equal(buffer[0], 0xFF);
+    assert_int_equal(buffer[1], 0xD8);
+    assert_int_equal(buffer[sizeof(buffer) - 2], 0xFF);
+    assert_int_equal(buffer[sizeof(buffer) - 1], 0xD9);
+
+    detach_camera(&sim);
+}
+
+// Test Case: Verify that JPEG files loaded from disk are captured (taking turns) when the resolution matches
+void test_ov2640_sim_loaded_jpeg_for_matching_resolution(void **state) {
+    // Arrange: Attach a simulated camera, load two 320x240 JPEG files, and initialize it (to 320x240) through the driver
+    ov2640 camera = {0};
+    ov2640_sim sim;
+    attach_camera(&camera, &sim);
+    write_file("test_ov2640_sim_a.jpg", test_jpeg_a, sizeof(test_jpeg_a));
+    write_file("test_ov2640_sim_b.jpg", test_jpeg_b, sizeof(test_jpeg_b));
+    HAL_StatusTypeDef rc_a = ov2640_sim_load_jpeg(&sim, "test_ov2640_sim_a.jpg");
+    HAL_StatusTypeDef rc_b = ov2640_sim_load_jpeg(&sim, "test_ov2640_sim_b.jpg");
+    remove("test_ov2640_sim_a.jpg");
+    remove("test_ov2640_sim_b.jpg");
+    ov2640_jpeg_init(&camera);
+
+    uint8_t first[sizeof(test_jpeg_a)], second[sizeof(test_jpeg_b)];
+
+    // Act: Capture and transfer twice
+    ov2640_get_capture(&camera);
+    uint32_t first_length = camera.fifo_length;
+    transfer_capture(&camera, first, sizeof(first));
+
+    ov2640_get_capture(&camera);
+    uint32_t second_length = camera.fifo_length;
+    transfer_capture(&camera, second, sizeof(second));
+
+    // Assert: Both files should have been loaded, and come out of the FIFO one after the other
+    assert_int_equal(rc_a, HAL_OK);
+    assert_int_equal(rc_b, HAL_OK);
+    assert_int_equal(first_length, sizeof(test_jpeg_a));
+    assert_memory_equal(first, test_jpeg_a, sizeof(test_jpeg_a));
+    assert_int_equal(second_length, sizeof(test_jpeg_b));
+    assert_memory_equal(second, test_jpeg_b, sizeof(test_jpeg_b));
+
+    detach_camera(&sim);
+}
+
+// Test Case: Verify that files which aren't JPEGs (or don't exist) aren't loaded
+void test_ov2640_sim_load_jpeg_rejects_non_jpeg(void **state) {
+    // Arrange: A simulated camera and a text file
+    ov2640_sim sim;
+    ov2640_sim_init(&sim);
+    const uint8_t text[] = "not a JPEG";
+    write_file("test_ov2640_sim.txt", text, sizeof(text));
+
+    // Act: Try to load the text file and a file that doesn't exist
+    HAL_StatusTypeDef rc_text = ov2640_sim_load_jpeg(&sim, "test_ov2640_sim.txt");
+    HAL_StatusTypeDef rc_missing = ov2640_sim_load_jpeg(&sim, "test_ov2640_sim_missing.jpg");
+    remove("test_ov2640_sim.txt");
+
+    // Assert: Neither should be loaded
+    assert_int_equal(rc_text, HAL_ERROR);
+    assert_int_equal(rc_missing, HAL_ERROR);
+    assert_int_equal(sim.frame_count, 0);
+
+    ov2640_sim_deinit(&sim);
+}
@@ -0,0 +1,38 @@
+#ifndef TEST_OV2640_SIM_H
+#define TEST_OV2640_SIM_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "../../sim/ov2640_sim.h"
+
+// Defines (number of tests, change as more are added)
+#define NUM_OV2640_SIM_REGISTER_TESTS 4
+#define NUM_OV2640_SIM_CAPTURE_TESTS 4
+
+// Global test arrays
+extern const struct CMUnitTest ov2640_sim_register_tests[NUM_OV2640_SIM_REGISTER_TESTS];
+extern const struct CMUnitTest ov2640_sim_capture_tests[NUM_OV2640_SIM_CAPTURE_TESTS];
+
+// Declaration of test functions
+
+// Running all tests
+void run_ov2640_sim_tests(void);
+
+// Register Tests
+void test_ov2640_sim_who_am_i(void **state);
+void test_ov2640_sim_banks_kept_apart(void **state);
+void test_ov2640_sim_software_reset(void **state);
+void test_ov2640_sim_cpld_test_register(void **state);
+
+// Capture Tests
+void test_ov2640_sim_capture_takes_frame_time(void **state);
+void test_ov2640_sim_synthetic_frame_sized_by_resolution(void **state);
+void test_ov2640_sim_loaded_jpeg_for_matching_resolution(void **state);
+void test_ov2640_sim_load_jpeg_rejects_non_jpeg(void **state);
+
+#endif // TEST_OV2640_SIM_H
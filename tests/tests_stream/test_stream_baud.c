@@ -0,0 +1,154 @@
+#include "test_stream_baud.h"
+
+// USART2 clock in main.c (APB1 = 60 MHz HCLK / 2)
+#define TEST_PCLK1 30000000U
+
+// Definition of test arrays
+
+// Message Tests
+const struct CMUnitTest stream_baud_msg_tests[NUM_STREAM_BAUD_MSG_TESTS] = {
+    cmocka_unit_test(test_stream_baud_encode_decode),
+    cmocka_unit_test(test_stream_baud_decode_bad_check),
+    cmocka_unit_test(test_stream_baud_parse_finds_message_in_noise),
+    cmocka_unit_test(test_stream_baud_parse_ignores_partial_message),
+};
+
+// stream_baud_supported Tests
+const struct CMUnitTest stream_baud_supported_tests[NUM_STREAM_BAUD_SUPPORTED_TESTS] = {
+    cmocka_unit_test(test_stream_baud_supported_base_rate),
+    cmocka_unit_test(test_stream_baud_supported_needs_over8),
+    cmocka_unit_test(test_stream_baud_supported_too_fast),
+};
+
+void run_stream_baud_tests(void) {
+    int status = 0;
+
+    status += cmocka_run_group_tests(stream_baud_msg_tests, NULL, NULL);
+    status += cmocka_run_group_tests(stream_baud_supported_tests, NULL, NULL);
+
+    assert_int_equal(status, 0);
+}
+
+// Test Case: Verify that an encoded message decodes to the same command and value
+void test_stream_baud_encode_decode(void **state) {
+    // Arrange: Message buffer and decoded fields
+    uint8_t msg[STREAM_BAUD_MSG_SIZE];
+    uint8_t cmd = 0;
+    uint32_t value = 0;
+
+    // Act: Encode and decode a switch request
+    stream_baud_encode(msg, STREAM_BAUD_CMD_SWITCH, 2000000);
+    uint8_t rc = stream_baud_decode(msg, &cmd, &value);
+
+    // Assert: The message should be valid and hold the same fields
+    assert_int_equal(rc, 1);
+    assert_int_equal(msg[0], STREAM_BAUD_MAGIC0);
+    assert_int_equal(msg[1], STREAM_BAUD_MAGIC1);
+    assert_int_equal(cmd, STREAM_BAUD_CMD_SWITCH);
+    assert_int_equal(value, 2000000);
+}
+
+// Test Case: Verify that a corrupted message is rejected
+void test_stream_baud_decode_bad_check(void **state) {
+    // Arrange: Valid message with a flipped bit in the value
+    uint8_t msg[STREAM_BAUD_MSG_SIZE];
+    uint8_t cmd = 0;
+    uint32_t value = 0;
+    stream_baud_encode(msg, STREAM_BAUD_CMD_ACK, 921600);
+    msg[5] ^= 0x10;
+
+    // Act: Decode the corrupted message
+    uint8_t rc = stream_baud_decode(msg, &cmd, &value);
+
+    // Assert: The message should be rejected
+    assert_int_equal(rc, 0);
+}
+
+// Test Case: Verify that the parser finds a message surrounded by other data
+void test_stream_baud_parse_finds_message_in_noise(void **state) {
+    // Arrange: Message preceded by frame-like data that includes a magic byte
+    stream_baud_parser parser;
+    stream_baud_parser_reset(&parser);
+
+    uint8_t stream[5 + STREAM_BAUD_MSG_SIZE] = {0xFF, 0xD8, 'B', 0x12, 0x34};
+    stream_baud_encode(&stream[5], STREAM_BAUD_CMD_ECHO, 0x55AA00FF);
+
+    // Act: Feed the stream to the parser one byte at a time
+    uint8_t found = 0;
+    uint8_t found_at = 0;
+    uint8_t cmd = 0;
+    uint32_t value = 0;
+    for(uint8_t i = 0; i < sizeof(stream); i++) {
+        if(stream_baud_parse(&parser, stream[i], &cmd, &value)) {
+            found++;
+            found_at = i;
+        }
+    }
+
+    // Assert: Exactly one message should be found, completing on its last byte
+    assert_int_equal(found, 1);
+    assert_int_equal(found_at, sizeof(stream) - 1);
+    assert_int_equal(cmd, STREAM_BAUD_CMD_ECHO);
+    assert_int_equal(value, 0x55AA00FF);
+}
+
+// Test Case: Verify that the parser doesn't report a message that was cut short
+void test_stream_baud_parse_ignores_partial_message(void **state) {
+    // Arrange: Message with its last byte missing
+    stream_baud_parser parser;
+    stream_baud_parser_reset(&parser);
+
+    uint8_t msg[STREAM_BAUD_MSG_SIZE];
+    stream_baud_encode(msg, STREAM_BAUD_CMD_CONFIRM, 460800);
+
+    // Act: Feed all but the last byte to the parser
+    uint8_t found = 0;
+    uint8_t cmd = 0;
+    uint32_t value = 0;
+    for(uint8_t i = 0; i < STREAM_BAUD_MSG_SIZE - 1; i++) {
+        found += stream_baud_parse(&parser, msg[i], &cmd, &value);
+    }
+
+    // Assert: No message should be found
+    assert_int_equal(found, 0);
+}
+
+// Test Case: Verify that the base rate is supported with 16x oversampling
+void test_stream_baud_supported_base_rate(void **state) {
+    // Arrange: Oversampling flag set to the opposite of what's expected
+    uint8_t over8 = 1;
+
+    // Act: Check the base rate
+    uint8_t rc = stream_baud_supported(TEST_PCLK1, STREAM_BAUD_BASE_RATE, &over8);
+
+    // Assert: The rate should be supported without 8x oversampling
+    assert_int_equal(rc, 1);
+    assert_int_equal(over8, 0);
+}
+
+// Test Case: Verify that rates above pclk / 16 are supported with 8x oversampling
+void test_stream_baud_supported_needs_over8(void **state) {
+    // Arrange: Oversampling flag set to the opposite of what's expected
+    uint8_t over8 = 0;
+
+    // Act: Check 2 Mbaud (divider of 15)
+    uint8_t rc = stream_baud_supported(TEST_PCLK1, 2000000, &over8);
+
+    // Assert: The rate should be supported with 8x oversampling
+    assert_int_equal(rc, 1);
+    assert_int_equal(over8, 1);
+}
+
+// Test Case: Verify that rates the UART can't reach closely enough are rejected
+void test_stream_baud_supported_too_fast(void **state) {
+    // Arrange: Oversampling flag
+    uint8_t over8 = 0;
+
+    // Act: Check 4 Mbaud (closest is 3.75 Mbaud) and 3 Mbaud (divider of 10, exact)
+    uint8_t rc_too_fast = stream_baud_supported(TEST_PCLK1, 4000000, &over8);
+    uint8_t rc_exact = stream_baud_supported(TEST_PCLK1, 3000000, &over8);
+
+    // Assert: Only the exact rate should be supported
+    assert_int_equal(rc_too_fast, 0);
+    assert_int_equal(rc_exact, 1);
+}
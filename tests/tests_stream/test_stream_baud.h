@@ -0,0 +1,37 @@
+#ifndef TEST_STREAM_BAUD_H
+#define TEST_STREAM_BAUD_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "../../stream/stream_baud.h"
+
+// Defines (number of tests, change as more are added)
+#define NUM_STREAM_BAUD_MSG_TESTS 4
+#define NUM_STREAM_BAUD_SUPPORTED_TESTS 3
+
+// Global test arrays
+extern const struct CMUnitTest stream_baud_msg_tests[NUM_STREAM_BAUD_MSG_TESTS];
+extern const struct CMUnitTest stream_baud_supported_tests[NUM_STREAM_BAUD_SUPPORTED_TESTS];
+
+// Declaration of test functions
+
+// Running all tests
+void run_stream_baud_tests(void);
+
+// Message Tests
+void test_stream_baud_encode_decode(void **state);
+void test_stream_baud_decode_bad_check(void **state);
+void test_stream_baud_parse_finds_message_in_noise(void **state);
+void test_stream_baud_parse_ignores_partial_message(void **state);
+
+// stream_baud_supported Tests
+void test_stream_baud_supported_base_rate(void **state);
+void test_stream_baud_supported_needs_over8(void **state);
+void test_stream_baud_supported_too_fast(void **state);
+
+#endif // TEST_STREAM_BAUD_H
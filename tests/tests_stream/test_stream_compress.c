@@ -0,0 +1,128 @@
+#include "test_stream_compress.h"
+
+// Definition of test arrays
+
+// stream_compress Tests
+const struct CMUnitTest stream_compress_tests[NUM_STREAM_COMPRESS_TESTS] = {
+    cmocka_unit_test(test_stream_compress_flat_chunk_shrinks),
+    cmocka_unit_test(test_stream_compress_gradient_round_trip),
+    cmocka_unit_test(test_stream_compress_noise_sent_raw),
+    cmocka_unit_test(test_stream_compress_dest_too_small),
+    cmocka_unit_test(test_stream_decompress_rejects_truncated_chunk),
+};
+
+void run_stream_compress_tests(void) {
+    int status = 0;
+
+    status += cmocka_run_group_tests(stream_compress_tests, NULL, NULL);
+
+    assert_int_equal(status, 0);
+}
+
+// Test Case: Verify that a flat YUV422 chunk (same pixel over and over) codes to a handful of bytes and decodes back
+void test_stream_compress_flat_chunk_shrinks(void **state) {
+    // Arrange: 1000 bytes of a single grey YUYV pixel
+    uint8_t raw[1000];
+    uint8_t coded[STREAM_COMPRESS_BOUND(1000)];
+    uint8_t decoded[1000];
+    for(int i = 0; i < 1000; i += 2) {
+        raw[i] = 0x80;
+        raw[i + 1] = 0x10;
+    }
+
+    // Act: Code and decode the chunk
+    uint16_t coded_length = stream_compress_chunk(raw, 1000, coded, sizeof(coded));
+    uint16_t decoded_length = stream_decompress_chunk(coded, coded_length, decoded, sizeof(decoded));
+
+    // Assert: The chunk header holds both lengths, the chunk shrinks a lot and decodes to the original bytes
+    assert_true(coded_length < 50);
+    assert_int_equal(coded[0] | (coded[1] << 8), 1000);
+    assert_int_equal(coded[2] | (coded[3] << 8), coded_length - STREAM_COMPRESS_CHUNK_HEADER_SIZE);
+    assert_int_equal(decoded_length, 1000);
+    assert_memory_equal(decoded, raw, 1000);
+}
+
+// Test Case: Verify that a chunk mixing gradients, flat areas and short literals decodes back to the same bytes
+void test_stream_compress_gradient_round_trip(void **state) {
+    // Arrange: Gradient, then a flat area, then a few isolated edges
+    uint8_t raw[700];
+    uint8_t coded[STREAM_COMPRESS_BOUND(700)];
+    uint8_t decoded[700];
+    for(int i = 0; i < 700; i++) {
+        if(i < 300) {
+            raw[i] = (i / 2) * 3;
+        }
+        else if(i < 600) {
+            raw[i] = 0x42;
+        }
+        else {
+            raw[i] = (i % 5 == 0) ? 0xF0 : 0x10;
+        }
+    }
+
+    // Act: Code and decode the chunk
+    uint16_t coded_length = stream_compress_chunk(raw, 700, coded, sizeof(coded));
+    uint16_t decoded_length = stream_decompress_chunk(coded, coded_length, decoded, sizeof(decoded));
+
+    // Assert: The chunk shrinks and decodes to the original bytes
+    assert_true(coded_length < 700);
+    assert_int_equal(decoded_length, 700);
+    assert_memory_equal(decoded, raw, 700);
+}
+
+// Test Case: Verify that data that doesn't code smaller (e.g. JPEG) is sent raw with equal lengths in the chunk header
+void test_stream_compress_noise_sent_raw(void **state) {
+    // Arrange: Pseudo-random bytes
+    uint8_t raw[256];
+    uint8_t coded[STREAM_COMPRESS_BOUND(256)];
+    uint8_t decoded[256];
+    uint32_t seed = 12345;
+    for(int i = 0; i < 256; i++) {
+        seed = seed * 1103515245 + 12345;
+        raw[i] = seed >> 16;
+    }
+
+    // Act: Code and decode the chunk
+    uint16_t coded_length = stream_compress_chunk(raw, 256, coded, sizeof(coded));
+    uint16_t decoded_length = stream_decompress_chunk(coded, coded_length, decoded, sizeof(decoded));
+
+    // Assert: The chunk is the raw bytes behind a chunk header
+    assert_int_equal(coded_length, STREAM_COMPRESS_BOUND(256));
+    assert_int_equal(coded[2] | (coded[3] << 8), 256);
+    assert_memory_equal(&coded[STREAM_COMPRESS_CHUNK_HEADER_SIZE], raw, 256);
+    assert_int_equal(decoded_length, 256);
+    assert_memory_equal(decoded, raw, 256);
+}
+
+// Test Case: Verify that stream_compress_chunk refuses an output buffer that can't hold a raw chunk
+void test_stream_compress_dest_too_small(void **state) {
+    // Arrange: Flat chunk and an output buffer without room for the chunk header
+    uint8_t raw[64];
+    uint8_t coded[64];
+    memset(raw, 0, sizeof(raw));
+
+    // Act: Code the chunk
+    uint16_t coded_length = stream_compress_chunk(raw, 64, coded, sizeof(coded));
+
+    // Assert: Nothing should be written
+    assert_int_equal(coded_length, 0);
+}
+
+// Test Case: Verify that stream_decompress_chunk rejects a chunk cut short or with a bad raw length
+void test_stream_decompress_rejects_truncated_chunk(void **state) {
+    // Arrange: Coded flat chunk
+    uint8_t raw[200];
+    uint8_t coded[STREAM_COMPRESS_BOUND(200)];
+    uint8_t decoded[201];
+    memset(raw, 0x55, sizeof(raw));
+    uint16_t coded_length = stream_compress_chunk(raw, 200, coded, sizeof(coded));
+
+    // Act: Decode with the last byte missing, and with the raw length claiming one byte more
+    uint16_t truncated_length = stream_decompress_chunk(coded, coded_length - 1, decoded, sizeof(decoded));
+    coded[0] += 1;
+    uint16_t mismatched_length = stream_decompress_chunk(coded, coded_length, decoded, sizeof(decoded));
+
+    // Assert: Both should fail
+    assert_int_equal(truncated_length, 0);
+    assert_int_equal(mismatched_length, 0);
+}
@@ -0,0 +1,31 @@
+#ifndef TEST_STREAM_COMPRESS_H
+#define TEST_STREAM_COMPRESS_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "../../stream/stream_compress.h"
+
+// Defines (number of tests, change as more are added)
+#define NUM_STREAM_COMPRESS_TESTS 5
+
+// Global test arrays
+extern const struct CMUnitTest stream_compress_tests[NUM_STREAM_COMPRESS_TESTS];
+
+// Declaration of test functions
+
+// Running all tests
+void run_stream_compress_tests(void);
+
+// stream_compress Tests
+void test_stream_compress_flat_chunk_shrinks(void **state);
+void test_stream_compress_gradient_round_trip(void **state);
+void test_stream_compress_noise_sent_raw(void **state);
+void test_stream_compress_dest_too_small(void **state);
+void test_stream_decompress_rejects_truncated_chunk(void **state);
+
+#endif // TEST_STREAM_COMPRESS_H
@@ -0,0 +1,192 @@
+#include "test_stream_frame.h"
+
+// Definition of test arrays
+
+// stream_crc32 Tests
+const struct CMUnitTest stream_crc32_tests[NUM_STREAM_CRC32_TESTS] = {
+    cmocka_unit_test(test_stream_crc32_check_value),
+    cmocka_unit_test(test_stream_crc32_update_in_chunks),
+};
+
+// stream_frame Tests
+const struct CMUnitTest stream_frame_tests[NUM_STREAM_FRAME_TESTS] = {
+    cmocka_unit_test(test_stream_frame_begin_sets_header),
+    cmocka_unit_test(test_stream_frame_header_check_sums_to_zero),
+    cmocka_unit_test(test_stream_frame_end_sets_trailer),
+    cmocka_unit_test(test_stream_frame_timestamps_in_crc),
+    cmocka_unit_test(test_stream_frame_abort_breaks_trailer),
+};
+
+void run_stream_frame_tests(void) {
+    int status = 0;
+
+    status += cmocka_run_group_tests(stream_crc32_tests, NULL, NULL);
+    status += cmocka_run_group_tests(stream_frame_tests, NULL, NULL);
+
+    assert_int_equal(status, 0);
+}
+
+// Test Case: Verify that stream_crc32 gives the standard CRC32 check value (same as zlib.crc32 on the host)
+void test_stream_crc32_check_value(void **state) {
+    // Arrange: Standard check input for CRC algorithms
+    const uint8_t data[] = "123456789";
+
+    // Act: Compute the CRC32 of the check input
+    uint32_t crc = stream_crc32(data, 9);
+
+    // Assert: The CRC should match the CRC32 check value
+    assert_int_equal(crc, 0xCBF43926);
+}
+
+// Test Case: Verify that computing a CRC32 in chunks gives the same result as computing it at once
+void test_stream_crc32_update_in_chunks(void **state) {
+    // Arrange: Data to be split into uneven chunks
+    uint8_t data[100];
+    for(int i = 0; i < 100; i++) {
+        data[i] = i * 7;
+    }
+
+    // Act: Compute the CRC32 at once and over three chunks
+    uint32_t crc_whole = stream_crc32(data, 100);
+    uint32_t crc_chunks = stream_crc32_update(0, data, 10);
+    crc_chunks = stream_crc32_update(crc_chunks, &data[10], 33);
+    crc_chunks = stream_crc32_update(crc_chunks, &data[43], 57);
+
+    // Assert: Both CRCs should match
+    assert_int_equal(crc_chunks, crc_whole);
+}
+
+// Test Case: Verify that stream_frame_begin lays out the header fields correctly
+void test_stream_frame_begin_sets_header(void **state) {
+    // Arrange: Frame and header buffer
+    stream_frame frame;
+    uint8_t header[STREAM_FRAME_HEADER_SIZE];
+
+    // Act: Begin a frame
+    stream_frame_begin(&frame, header, 0x00, 3, 0x01020304, 0x00054321);
+
+    // Assert: Sync word, fields (little-endian) and frame state should be set
+    const uint8_t expected_sync[4] = {STREAM_FRAME_SYNC0, STREAM_FRAME_SYNC1, STREAM_FRAME_SYNC2, STREAM_FRAME_SYNC3};
+    const uint8_t expected_sequence[4] = {0x04, 0x03, 0x02, 0x01};
+    const uint8_t expected_length[4] = {0x21, 0x43, 0x05, 0x00};
+
+    assert_memory_equal(header, expected_sync, 4);
+    assert_int_equal(header[STREAM_FRAME_OFFSET_VERSION], STREAM_FRAME_VERSION);
+    assert_int_equal(header[STREAM_FRAME_OFFSET_FLAGS], 0x00);
+    assert_int_equal(header[STREAM_FRAME_OFFSET_RES], 3);
+    assert_memory_equal(&header[STREAM_FRAME_OFFSET_SEQUENCE], expected_sequence, 4);
+    assert_memory_equal(&header[STREAM_FRAME_OFFSET_LENGTH], expected_length, 4);
+    assert_int_equal(frame.length, 0x00054321);
+    assert_int_equal(frame.sent, 0);
+}
+
+// Test Case: Verify that the header check makes the header bytes after the sync word sum to zero
+void test_stream_frame_header_check_sums_to_zero(void **state) {
+    // Arrange: Frame and header buffer
+    stream_frame frame;
+    uint8_t header[STREAM_FRAME_HEADER_SIZE];
+
+    // Act: Begin a frame with arbitrary field values
+    stream_frame_begin(&frame, header, 0x01, 9, 12345, 67890);
+
+    // Assert: The header bytes after the sync word should sum to zero
+    uint8_t sum = 0;
+    for(int i = STREAM_FRAME_OFFSET_VERSION; i < STREAM_FRAME_HEADER_SIZE; i++) {
+        sum += header[i];
+    }
+    assert_int_equal(sum, 0);
+}
+
+// Test Case: Verify that the trailer holds the CRC32 of the header (after the sync word) and the payload
+void test_stream_frame_end_sets_trailer(void **state) {
+    // Arrange: Frame with a payload sent in two chunks
+    stream_frame frame;
+    uint8_t header[STREAM_FRAME_HEADER_SIZE];
+    uint8_t trailer[STREAM_FRAME_TRAILER_SIZE];
+    uint8_t payload[20];
+    for(int i = 0; i < 20; i++) {
+        payload[i] = i;
+    }
+
+    // Act: Send the frame
+    stream_frame_begin(&frame, header, 0x00, 3, 7, 20);
+    stream_frame_update(&frame, payload, 8);
+    stream_frame_update(&frame, &payload[8], 12);
+    stream_frame_end(&frame, trailer);
+
+    // Assert: The trailer should hold the little-endian CRC32 of everything after the sync word
+    uint8_t covered[STREAM_FRAME_HEADER_SIZE - 4 + 20];
+    memcpy(covered, &header[4], STREAM_FRAME_HEADER_SIZE - 4);
+    memcpy(&covered[STREAM_FRAME_HEADER_SIZE - 4], payload, 20);
+    uint32_t expected_crc = stream_crc32(covered, sizeof(covered));
+
+    uint32_t trailer_crc = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((uint32_t)trailer[3] << 24);
+    assert_int_equal(trailer_crc, expected_crc);
+    assert_int_equal(frame.sent, 20);
+}
+
+// Test Case: Verify that stream_frame_timestamps lays out the timestamps and covers them with the CRC
+void test_stream_frame_timestamps_in_crc(void **state) {
+    // Arrange: Frame with a short payload and a set of timestamps
+    stream_frame frame;
+    uint8_t header[STREAM_FRAME_HEADER_SIZE];
+    uint8_t block[STREAM_FRAME_TIMESTAMPS_SIZE];
+    uint8_t trailer[STREAM_FRAME_TRAILER_SIZE];
+    uint8_t payload[5] = {1, 2, 3, 4, 5};
+    const uint32_t stamps[STREAM_FRAME_STAMP_COUNT] = {1000, 1250, 1260, 0x01020304};
+
+    // Act: Send the frame with its timestamp block
+    stream_frame_begin(&frame, header, STREAM_FRAME_FLAG_TIMESTAMPS, 3, 1, 5);
+    stream_frame_update(&frame, payload, 5);
+    stream_frame_timestamps(&frame, block, stamps);
+    stream_frame_end(&frame, trailer);
+
+    // Assert: Timestamps should be little-endian in order, and the CRC should cover header, payload and block
+    assert_int_equal(block[0] | (block[1] << 8), 1000);
+    assert_int_equal(block[STREAM_FRAME_STAMP_CAPTURED * 4] | (block[STREAM_FRAME_STAMP_CAPTURED * 4 + 1] << 8), 1250);
+    uint8_t expected_last[4] = {0x04, 0x03, 0x02, 0x01};
+    assert_memory_equal(&block[STREAM_FRAME_STAMP_LAST_OUT * 4], expected_last, 4);
+
+    uint8_t covered[STREAM_FRAME_HEADER_SIZE - 4 + 5 + STREAM_FRAME_TIMESTAMPS_SIZE];
+    memcpy(covered, &header[4], STREAM_FRAME_HEADER_SIZE - 4);
+    memcpy(&covered[STREAM_FRAME_HEADER_SIZE - 4], payload, 5);
+    memcpy(&covered[STREAM_FRAME_HEADER_SIZE - 4 + 5], block, STREAM_FRAME_TIMESTAMPS_SIZE);
+    uint32_t trailer_crc = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((uint32_t)trailer[3] << 24);
+    assert_int_equal(trailer_crc, stream_crc32(covered, sizeof(covered)));
+    assert_int_equal(frame.sent, 5);
+}
+
+// Test Case: Verify that an aborted frame's trailer never matches what was sent, so the receiver drops it
+void test_stream_frame_abort_breaks_trailer(void **state) {
+    // Arrange: Frame whose payload is cut short after a chunk and padded out to its length
+    stream_frame frame;
+    uint8_t header[STREAM_FRAME_HEADER_SIZE];
+    uint8_t trailer[STREAM_FRAME_TRAILER_SIZE];
+    uint8_t payload[20] = {0};
+    for(int i = 0; i < 8; i++) {
+        payload[i] = i + 1;
+    }
+
+    // Act: Send the frame, aborting it after the first chunk
+    stream_frame_begin(&frame, header, 0x00, 3, 2, 20);
+    stream_frame_update(&frame, payload, 8);
+    stream_frame_abort(&frame);
+    stream_frame_update(&frame, &payload[8], 12);
+    stream_frame_end(&frame, trailer);
+
+    // Assert: The trailer should differ from the CRC32 of everything sent, padding included
+    uint8_t covered[STREAM_FRAME_HEADER_SIZE - 4 + 20];
+    memcpy(covered, &header[4], STREAM_FRAME_HEADER_SIZE - 4);
+    memcpy(&covered[STREAM_FRAME_HEADER_SIZE - 4], payload, 20);
+    uint32_t trailer_crc = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((uint32_t)trailer[3] << 24);
+    assert_int_not_equal(trailer_crc, stream_crc32(covered, sizeof(covered)));
+    assert_int_equal(frame.sent, 20);
+
+    // Assert: The next frame should be whole again
+    stream_frame_begin(&frame, header, 0x00, 3, 3, 20);
+    stream_frame_update(&frame, payload, 20);
+    stream_frame_end(&frame, trailer);
+    memcpy(covered, &header[4], STREAM_FRAME_HEADER_SIZE - 4);
+    trailer_crc = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((uint32_t)trailer[3] << 24);
+    assert_int_equal(trailer_crc, stream_crc32(covered, sizeof(covered)));
+}
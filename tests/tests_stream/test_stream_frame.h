@@ -0,0 +1,37 @@
+#ifndef TEST_STREAM_FRAME_H
+#define TEST_STREAM_FRAME_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include "../../stream/stream_frame.h"
+
+// Defines (number of tests, change as more are added)
+#define NUM_STREAM_CRC32_TESTS 2
+#define NUM_STREAM_FRAME_TESTS 5
+
+// Global test arrays
+extern const struct CMUnitTest stream_crc32_tests[NUM_STREAM_CRC32_TESTS];
+extern const struct CMUnitTest stream_frame_tests[NUM_STREAM_FRAME_TESTS];
+
+// Declaration of test functions
+
+// Running all tests
+void run_stream_frame_tests(void);
+
+// stream_crc32 Tests
+void test_stream_crc32_check_value(void **state);
+void test_stream_crc32_update_in_chunks(void **state);
+
+// stream_frame Tests
+void test_stream_frame_begin_sets_header(void **state);
+void test_stream_frame_header_check_sums_to_zero(void **state);
+void test_stream_frame_end_sets_trailer(void **state);
+void test_stream_frame_timestamps_in_crc(void **state);
+void test_stream_frame_abort_breaks_trailer(void **state);
+
+#endif // TEST_STREAM_FRAME_H
@@ -0,0 +1,153 @@
+import argparse
+import struct
+from collections import defaultdict
+
+# Breaks a bus trace recorded by the mock HAL (app_host --trace, or Mock_HAL_Trace_Start) down by driver phase:
+# how much simulated time each phase took, and how much of it went on delays and on the SPI and I2C buses.
+#
+# Trace format, must match mocks/hal_mock_general.h:
+#   header  (16 bytes): magic, version (LE32), record size (LE32)
+#   records (16 bytes): start time in ns (LE64), duration in ns (LE32), size (LE16), type, status
+#   a phase name record is followed by its size bytes of name
+# Phases nest; time and transfers count towards the innermost phase they happen in, so a phase's figures leave out
+# the phases inside it.
+
+TRACE_MAGIC = b"HALTRACE"
+TRACE_VERSION = 1
+TRACE_HEADER = struct.Struct("<8sII")
+TRACE_RECORD = struct.Struct("<QIHBB")
+
+TRACE_DELAY = 1
+TRACE_GPIO = 2
+TRACE_SPI_TX = 3
+TRACE_SPI_RX = 4
+TRACE_SPI_TX_DMA = 5
+TRACE_SPI_RX_DMA = 6
+TRACE_I2C_TX = 7
+TRACE_I2C_RX = 8
+TRACE_PHASE_NAME = 9
+TRACE_PHASE_BEGIN = 10
+TRACE_PHASE_END = 11
+
+SPI_TYPES = (TRACE_SPI_TX, TRACE_SPI_RX, TRACE_SPI_TX_DMA, TRACE_SPI_RX_DMA)
+I2C_TYPES = (TRACE_I2C_TX, TRACE_I2C_RX)
+
+# HAL_OK, anything else is a failed transfer
+STATUS_OK = 0
+
+# what time spent outside any phase is reported as
+NO_PHASE = "(no phase)"
+
+
+class PhaseStats:
+    def __init__(self):
+        self.entered = 0
+        self.time_ns = 0
+        self.delay_ns = 0
+        self.delays = 0
+        self.spi_ns = 0
+        self.spi_bytes = 0
+        self.spi_transfers = 0
+        self.i2c_ns = 0
+        self.i2c_bytes = 0
+        self.i2c_transfers = 0
+        self.failed = 0
+        self.edges = 0
+
+
+def read_records(path):
+    with open(path, "rb") as f:
+        header = f.read(TRACE_HEADER.size)
+        if len(header) != TRACE_HEADER.size or TRACE_HEADER.unpack(header) != (TRACE_MAGIC, TRACE_VERSION, TRACE_RECORD.size):
+            raise ValueError(f"{path}: not a version {TRACE_VERSION} bus trace")
+
+        while True:
+            record = f.read(TRACE_RECORD.size)
+            # a trace cut short (e.g. the run was killed) just ends at its last whole record
+            if len(record) != TRACE_RECORD.size:
+                return
+            time_ns, duration_ns, size, type_, status = TRACE_RECORD.unpack(record)
+            name = f.read(size).decode(errors="replace") if type_ == TRACE_PHASE_NAME else None
+            yield time_ns, duration_ns, size, type_, status, name
+
+
+def summarize(path):
+    names = {}
+    stats = defaultdict(PhaseStats)
+    stack = []
+    first_ns = None
+    mark_ns = None
+    end_ns = 0
+
+    def current():
+        return stack[-1] if stack else NO_PHASE
+
+    for time_ns, duration_ns, size, type_, status, name in read_records(path):
+        if first_ns is None:
+            first_ns = mark_ns = time_ns
+        end_ns = max(end_ns, time_ns + duration_ns)
+
+        if type_ == TRACE_PHASE_NAME:
+            names[status] = name
+        elif type_ in (TRACE_PHASE_BEGIN, TRACE_PHASE_END):
+            stats[current()].time_ns += time_ns - mark_ns
+            mark_ns = time_ns
+            phase = names.get(status, f"phase {status}")
+            if type_ == TRACE_PHASE_BEGIN:
+                stack.append(phase)
+                stats[phase].entered += 1
+            elif phase in stack:
+                # an end without the ends of the phases begun inside it ends those too
+                del stack[stack.index(phase):]
+        else:
+            phase = stats[current()]
+            if type_ == TRACE_DELAY:
+                phase.delay_ns += duration_ns
+                phase.delays += 1
+            elif type_ == TRACE_GPIO:
+                phase.edges += 1
+            elif type_ in SPI_TYPES:
+                phase.spi_ns += duration_ns
+                phase.spi_bytes += size
+                phase.spi_transfers += 1
+            elif type_ in I2C_TYPES:
+                phase.i2c_ns += duration_ns
+                phase.i2c_bytes += size
+                phase.i2c_transfers += 1
+            if type_ in SPI_TYPES + I2C_TYPES and status != STATUS_OK:
+                phase.failed += 1
+
+    if first_ns is None:
+        return {}, 0
+    stats[current()].time_ns += max(end_ns - mark_ns, 0)
+    return stats, end_ns - first_ns
+
+
+def print_report(stats, total_ns):
+    columns = ("phase", "entered", "time ms", "share", "delay ms", "delays", "spi ms", "spi xfers", "spi bytes",
+               "i2c ms", "i2c xfers", "i2c bytes", "failed", "gpio edges")
+    print(f"{columns[0]:<14}" + "".join(f"{c:>11}" for c in columns[1:]))
+
+    # biggest time first, so where the time goes is at the top
+    for name, phase in sorted(stats.items(), key=lambda item: item[1].time_ns, reverse=True):
+        share = 100.0 * phase.time_ns / total_ns if total_ns else 0.0
+        row = (phase.entered, f"{phase.time_ns / 1e6:.3f}", f"{share:.1f}%", f"{phase.delay_ns / 1e6:.3f}", phase.delays,
+               f"{phase.spi_ns / 1e6:.3f}", phase.spi_transfers, phase.spi_bytes, f"{phase.i2c_ns / 1e6:.3f}",
+               phase.i2c_transfers, phase.i2c_bytes, phase.failed, phase.edges)
+        print(f"{name:<14}" + "".join(f"{v:>11}" for v in row))
+
+    print(f"{len(stats)} phases over {total_ns / 1e6:.3f} ms of simulated time "
+          f"(SPI DMA transfers count their bus time, which overlaps other work)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Break a mock HAL bus trace down by driver phase.")
+    parser.add_argument("trace", help="trace file written by app_host --trace")
+    args = parser.parse_args()
+
+    stats, total_ns = summarize(args.trace)
+    print_report(stats, total_ns)
+
+
+if __name__ == "__main__":
+    main()